@@ -0,0 +1,303 @@
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+#include <memory>
+#include <string>
+
+#include "gas_container.h"
+
+using idealgas::GasContainer;
+using idealgas::ParticleInitializer;
+
+namespace {
+
+// Same container layout as the Cinder app.
+const size_t kWindowLength = 800;
+const size_t kWindowWidth = static_cast<size_t>(1.6 * kWindowLength);
+const size_t kMargin = 80;
+
+void PrintUsage(const char *program) {
+  std::cerr << "Usage: " << program
+            << " <slow count> <medium count> <fast count> <steps> <seed>"
+               " [threads] [--event-driven] [--load <checkpoint>]"
+               " [--save <checkpoint>] [--record <trajectory>]"
+               " [--record-every <frames>] [--dt <time step>]"
+               " [--integrator euler|verlet|leapfrog] [--periodic]"
+               " [--init uniform|lattice|poisson] [--temperature <kT>]"
+               " [--stats] [--profile <trace.json>] [--skin <distance>]"
+               " [--monitor <tolerance>] [--monitor-every <frames>]"
+            << std::endl;
+}
+
+bool ParseCount(const char *argument, size_t &value) {
+  char *end = nullptr;
+  unsigned long long parsed = std::strtoull(argument, &end, 10);
+  if (end == argument || *end != '\0' || argument[0] == '-') {
+    return false;
+  }
+  value = static_cast<size_t>(parsed);
+  return true;
+}
+
+void PrintHistogram(const GasContainer &container, const char *name) {
+  std::cout << name << ":";
+  for (const auto &bin : container.GetMap(name)) {
+    std::cout << " " << bin.second;
+  }
+  std::cout << std::endl;
+}
+
+}  // namespace
+
+// Runs the simulation without a window and prints the final histograms.
+int main(int argc, char *argv[]) {
+  size_t counts[6] = {0, 0, 0, 0, 0, 0};
+  size_t count_arguments = 0;
+  bool event_driven = false;
+  bool periodic = false;
+  bool seeded_init = false;
+  bool print_statistics = false;
+  ParticleInitializer::Options init_options;
+  std::string load_path;
+  std::string save_path;
+  std::string record_path;
+  std::string profile_path;
+  size_t record_every = 1;
+  float time_step = 1;
+  double skin = 0;
+  bool monitor_conservation = false;
+  idealgas::ConservationMonitor::Options monitor_options;
+  idealgas::IntegratorKind integrator = idealgas::IntegratorKind::kEuler;
+  for (int i = 1; i < argc; ++i) {
+    std::string argument = argv[i];
+    if (argument == "--event-driven") {
+      event_driven = true;
+    } else if (argument == "--periodic") {
+      periodic = true;
+    } else if (argument == "--stats") {
+      print_statistics = true;
+    } else if (argument == "--init" && i + 1 < argc) {
+      std::string name = argv[++i];
+      if (name == "uniform") {
+        init_options.placement = ParticleInitializer::Placement::kUniform;
+      } else if (name == "lattice") {
+        init_options.placement = ParticleInitializer::Placement::kLattice;
+      } else if (name == "poisson") {
+        init_options.placement = ParticleInitializer::Placement::kPoissonDisk;
+      } else {
+        std::cerr << "Unknown placement: " << name << std::endl;
+        return 1;
+      }
+      seeded_init = true;
+    } else if (argument == "--temperature" && i + 1 < argc) {
+      char *end = nullptr;
+      init_options.temperature = std::strtod(argv[++i], &end);
+      if (end == argv[i] || *end != '\0' ||
+          !(init_options.temperature > 0)) {
+        std::cerr << "Invalid temperature: " << argv[i] << std::endl;
+        return 1;
+      }
+      init_options.maxwell_boltzmann = true;
+      seeded_init = true;
+    } else if ((argument == "--load" || argument == "--save") &&
+               i + 1 < argc) {
+      (argument == "--load" ? load_path : save_path) = argv[++i];
+    } else if (argument == "--record" && i + 1 < argc) {
+      record_path = argv[++i];
+    } else if (argument == "--profile" && i + 1 < argc) {
+      profile_path = argv[++i];
+    } else if (argument == "--record-every" && i + 1 < argc) {
+      if (!ParseCount(argv[++i], record_every) || record_every == 0) {
+        std::cerr << "Invalid frame count: " << argv[i] << std::endl;
+        return 1;
+      }
+    } else if (argument == "--dt" && i + 1 < argc) {
+      char *end = nullptr;
+      time_step = std::strtof(argv[++i], &end);
+      if (end == argv[i] || *end != '\0' || !(time_step > 0)) {
+        std::cerr << "Invalid time step: " << argv[i] << std::endl;
+        return 1;
+      }
+    } else if (argument == "--skin" && i + 1 < argc) {
+      char *end = nullptr;
+      skin = std::strtod(argv[++i], &end);
+      if (end == argv[i] || *end != '\0' || !(skin >= 0)) {
+        std::cerr << "Invalid skin: " << argv[i] << std::endl;
+        return 1;
+      }
+    } else if (argument == "--monitor" && i + 1 < argc) {
+      char *end = nullptr;
+      double tolerance = std::strtod(argv[++i], &end);
+      if (end == argv[i] || *end != '\0' || !(tolerance >= 0)) {
+        std::cerr << "Invalid tolerance: " << argv[i] << std::endl;
+        return 1;
+      }
+      monitor_options.energy_tolerance = tolerance;
+      monitor_options.momentum_tolerance = tolerance;
+      monitor_conservation = true;
+    } else if (argument == "--monitor-every" && i + 1 < argc) {
+      if (!ParseCount(argv[++i], monitor_options.sample_every) ||
+          monitor_options.sample_every == 0) {
+        std::cerr << "Invalid frame count: " << argv[i] << std::endl;
+        return 1;
+      }
+    } else if (argument == "--integrator" && i + 1 < argc) {
+      std::string name = argv[++i];
+      if (name == "euler") {
+        integrator = idealgas::IntegratorKind::kEuler;
+      } else if (name == "verlet") {
+        integrator = idealgas::IntegratorKind::kVelocityVerlet;
+      } else if (name == "leapfrog") {
+        integrator = idealgas::IntegratorKind::kLeapfrog;
+      } else {
+        std::cerr << "Unknown integrator: " << name << std::endl;
+        return 1;
+      }
+    } else if (count_arguments == 6 ||
+               !ParseCount(argv[i], counts[count_arguments++])) {
+      std::cerr << "Unexpected argument: " << argv[i] << std::endl;
+      PrintUsage(argv[0]);
+      return 1;
+    }
+  }
+  if (count_arguments < 5) {
+    PrintUsage(argv[0]);
+    return 1;
+  }
+  size_t steps = counts[3];
+  size_t thread_count = counts[5];
+
+  auto start = std::chrono::steady_clock::now();
+  srand(static_cast<unsigned int>(counts[4]));
+  idealgas::Boundary boundary = periodic ? idealgas::Boundary::kPeriodic
+                                         : idealgas::Boundary::kReflecting;
+  GasContainer container(kWindowLength, kWindowWidth, kMargin, "white",
+                         idealgas::Box::FromWindow(kWindowLength, kMargin,
+                                                   boundary),
+                         counts[0], counts[1], counts[2]);
+  if (!load_path.empty()) {
+    // Resume from the checkpoint instead of the generated particles.
+    container.LoadCheckpoint(load_path);
+  }
+
+  if (event_driven) {
+    container.SetEngineMode(idealgas::EngineMode::kEventDriven);
+  }
+  container.SetIntegrator(integrator);
+  container.SetTimeStep(time_step);
+  container.SetNeighborListSkin(skin);
+  container.SetStatisticsEnabled(print_statistics);
+
+  std::unique_ptr<idealgas::ThreadPool> pool;
+  if (thread_count > 0) {
+    pool.reset(new idealgas::ThreadPool(thread_count));
+    container.SetThreadPool(pool.get());
+  }
+  if (seeded_init && load_path.empty()) {
+    // Replaces the rand() particles with ones from the seed's own streams.
+    init_options.seed = counts[4];
+    container.InitializeParticles(ParticleInitializer(init_options),
+                                  counts[0], counts[1], counts[2]);
+  }
+
+  std::unique_ptr<idealgas::TrajectoryRecorder> recorder;
+  if (!record_path.empty()) {
+    idealgas::TrajectoryRecorder::Options options;
+    options.decimation = record_every;
+    recorder.reset(new idealgas::TrajectoryRecorder(record_path, options));
+    container.SetTrajectoryRecorder(recorder.get());
+  }
+
+  std::unique_ptr<idealgas::FrameProfiler> profiler;
+  if (!profile_path.empty()) {
+#if !IDEALGAS_PROFILING
+    std::cerr << "Built without IDEALGAS_PROFILING, so the trace will have "
+                 "no phases" << std::endl;
+#endif
+    const size_t kMaxProfiledFrames = 4096;
+    profiler.reset(new idealgas::FrameProfiler(
+        std::max<size_t>(1, std::min(steps, kMaxProfiledFrames))));
+    container.SetFrameProfiler(profiler.get());
+  }
+
+  std::unique_ptr<idealgas::ConservationMonitor> monitor;
+  if (monitor_conservation) {
+    monitor.reset(new idealgas::ConservationMonitor(
+        monitor_options, [](const idealgas::ConservationAlarm &alarm) {
+          std::cerr << "frame " << alarm.frame << ": "
+                    << (alarm.quantity ==
+                                idealgas::ConservedQuantity::kKineticEnergy
+                            ? "kinetic energy"
+                            : "momentum")
+                    << " drifted by " << alarm.drift << std::endl;
+        }));
+    container.SetConservationMonitor(monitor.get());
+  }
+
+  for (size_t step = 0; step < steps; ++step) {
+    container.AdvanceOneFrame();
+  }
+  container.UpdateHistograms();
+  if (!save_path.empty()) {
+    container.SaveCheckpoint(save_path);
+  }
+  if (recorder) {
+    recorder->Close();
+    std::cout << "recorded_frames: " << recorder->GetRecordedFrameCount()
+              << std::endl;
+    std::cout << "dropped_frames: " << recorder->GetDroppedFrameCount()
+              << std::endl;
+  }
+  auto elapsed = std::chrono::duration_cast<std::chrono::milliseconds>(
+      std::chrono::steady_clock::now() - start);
+
+  std::cout << "particles: " << container.GetParticles().Size() << std::endl;
+  std::cout << "steps: " << steps << std::endl;
+  std::cout << "elapsed_ms: " << elapsed.count() << std::endl;
+  std::cout << "max_speed: " << container.MaxParticleSpeed() << std::endl;
+  if (print_statistics && steps > 0) {
+    // Statistics of the last frame.
+    const idealgas::GasStatistics &statistics = container.GetStatistics();
+    std::cout << "kinetic_energy: " << statistics.kinetic_energy << std::endl;
+    std::cout << "temperature: " << statistics.temperature << std::endl;
+    std::cout << "momentum: " << statistics.momentum_x << " "
+              << statistics.momentum_y << std::endl;
+    std::cout << "pressure: " << statistics.pressure << std::endl;
+  }
+  if (monitor) {
+    std::cout << "max_energy_drift: " << monitor->GetMaxEnergyDrift()
+              << std::endl;
+    std::cout << "max_momentum_drift: " << monitor->GetMaxMomentumDrift()
+              << std::endl;
+    std::cout << "conservation_alarms: " << monitor->GetAlarmCount()
+              << std::endl;
+  }
+  if (profiler) {
+    std::ofstream trace(profile_path);
+    profiler->WriteChromeTrace(trace);
+    if (!trace) {
+      std::cerr << "Cannot write trace: " << profile_path << std::endl;
+      return 1;
+    }
+    // Mean time per frame of each phase, over the frames kept.
+    std::vector<idealgas::FrameMetrics> frames = profiler->GetRecentFrames();
+    for (size_t phase = 0; phase < idealgas::kFramePhaseCount; ++phase) {
+      double total_ns = 0;
+      for (const idealgas::FrameMetrics &metrics : frames) {
+        total_ns += static_cast<double>(metrics.phase_ns[phase]);
+      }
+      if (total_ns > 0) {
+        std::cout << "phase_ms "
+                  << idealgas::FrameProfiler::GetName(
+                         static_cast<idealgas::FramePhase>(phase))
+                  << ": " << total_ns / 1e6 / frames.size() << std::endl;
+      }
+    }
+  }
+  PrintHistogram(container, "green");
+  PrintHistogram(container, "red");
+  PrintHistogram(container, "orange");
+  return 0;
+}
@@ -0,0 +1,174 @@
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include "scaling_harness.h"
+
+using idealgas::ScalingHarness;
+using idealgas::ScalingOptions;
+using idealgas::ScalingResult;
+using idealgas::ScalingTolerance;
+
+namespace {
+
+void PrintUsage(const char *program) {
+  std::cerr << "Usage: " << program
+            << " [--particles <count,...>] [--threads <count,...>]"
+               " [--steps <count>] [--area-fraction <fraction>]"
+               " [--skin <distance>] [--seed <seed>] [--results <file>]"
+               " [--baseline <file>] [--tolerance <fraction>]"
+               " [--drift-tolerance <drift>]"
+            << std::endl;
+}
+
+/**
+ * @return if text is a whole number, stored in value
+ */
+bool ParseCount(const char *text, size_t &value) {
+  char *end = nullptr;
+  value = std::strtoul(text, &end, 10);
+  return end != text && *end == '\0' && text[0] != '-';
+}
+
+/**
+ * @return if text is a number, stored in value
+ */
+bool ParseNumber(const char *text, double &value) {
+  char *end = nullptr;
+  value = std::strtod(text, &end);
+  return end != text && *end == '\0';
+}
+
+/**
+ * @return if text is a comma-separated list of whole numbers, stored in
+ * values
+ */
+bool ParseCounts(const std::string &text, std::vector<size_t> &values) {
+  values.clear();
+  size_t begin = 0;
+  while (begin <= text.size()) {
+    size_t end = text.find(',', begin);
+    if (end == std::string::npos) {
+      end = text.size();
+    }
+    size_t value = 0;
+    if (!ParseCount(text.substr(begin, end - begin).c_str(), value)) {
+      return false;
+    }
+    values.push_back(value);
+    begin = end + 1;
+  }
+  return true;
+}
+
+}  // namespace
+
+// Runs the engine from thousands to millions of particles on different
+// numbers of threads, writes what each run measured and, given a baseline,
+// fails if any run is slower, larger or drifts more than the baseline
+// allows.
+int main(int argc, char *argv[]) {
+  ScalingOptions options;
+  ScalingTolerance tolerance;
+  std::string results_path;
+  std::string baseline_path;
+  for (int i = 1; i < argc; ++i) {
+    std::string argument = argv[i];
+    bool valid = true;
+    size_t count = 0;
+    if (i + 1 >= argc) {
+      valid = false;
+    } else if (argument == "--particles") {
+      valid = ParseCounts(argv[++i], options.particle_counts);
+    } else if (argument == "--threads") {
+      valid = ParseCounts(argv[++i], options.thread_counts);
+    } else if (argument == "--steps") {
+      valid = ParseCount(argv[++i], options.steps);
+    } else if (argument == "--area-fraction") {
+      valid = ParseNumber(argv[++i], options.area_fraction);
+    } else if (argument == "--skin") {
+      valid = ParseNumber(argv[++i], options.skin);
+    } else if (argument == "--seed") {
+      valid = ParseCount(argv[++i], count);
+      options.seed = count;
+    } else if (argument == "--results") {
+      results_path = argv[++i];
+    } else if (argument == "--baseline") {
+      baseline_path = argv[++i];
+    } else if (argument == "--tolerance") {
+      valid = ParseNumber(argv[++i], tolerance.throughput);
+      tolerance.peak_rss = tolerance.throughput;
+    } else if (argument == "--drift-tolerance") {
+      valid = ParseNumber(argv[++i], tolerance.energy_drift);
+    } else {
+      valid = false;
+    }
+    if (!valid) {
+      std::cerr << "Invalid argument: " << argument << std::endl;
+      PrintUsage(argv[0]);
+      return 1;
+    }
+  }
+
+  std::vector<ScalingResult> baseline;
+  if (!baseline_path.empty()) {
+    std::ifstream input(baseline_path);
+    if (!input) {
+      std::cerr << "Cannot read baseline: " << baseline_path << std::endl;
+      return 1;
+    }
+    try {
+      baseline = ScalingHarness::ReadResults(input, baseline_path);
+    } catch (const std::exception &error) {
+      std::cerr << error.what() << std::endl;
+      return 1;
+    }
+  }
+
+  std::vector<ScalingResult> results;
+  try {
+    ScalingHarness harness(options);
+    for (size_t particles : options.particle_counts) {
+      for (size_t threads : options.thread_counts) {
+        results.push_back(harness.Run(particles, threads));
+        const ScalingResult &result = results.back();
+        std::cerr << particles << " particles, " << threads << " threads: "
+                  << (result.succeeded
+                          ? std::to_string(result.particle_steps_per_second) +
+                                " particle-steps/s"
+                          : result.error)
+                  << std::endl;
+      }
+    }
+  } catch (const std::exception &error) {
+    std::cerr << error.what() << std::endl;
+    return 1;
+  }
+
+  if (results_path.empty()) {
+    ScalingHarness::WriteResults(std::cout, results);
+  } else {
+    std::ofstream output(results_path);
+    ScalingHarness::WriteResults(output, results);
+    if (!output) {
+      std::cerr << "Cannot write results: " << results_path << std::endl;
+      return 1;
+    }
+  }
+
+  int failed = 0;
+  for (const ScalingResult &result : results) {
+    failed += result.succeeded ? 0 : 1;
+  }
+  // Without a baseline there is nothing to compare with.
+  std::vector<std::string> regressions;
+  if (!baseline_path.empty()) {
+    regressions = ScalingHarness::FindRegressions(results, baseline, tolerance);
+  }
+  for (const std::string &regression : regressions) {
+    std::cerr << "Regression: " << regression << std::endl;
+  }
+  return failed == 0 && regressions.empty() ? 0 : 1;
+}
@@ -0,0 +1,100 @@
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "scenario.h"
+#include "sweep_runner.h"
+
+using idealgas::RunSummary;
+using idealgas::Scenario;
+using idealgas::ScenarioFile;
+using idealgas::SweepRunner;
+
+namespace {
+
+void PrintUsage(const char *program) {
+  std::cerr << "Usage: " << program
+            << " <scenario file>... [--threads <count>]"
+               " [--summary <file>] [--list]"
+            << std::endl;
+}
+
+}  // namespace
+
+// Runs every scenario of one or more scenario files, with their sweeps
+// expanded, and writes one summary row per run.
+int main(int argc, char *argv[]) {
+  std::vector<std::string> paths;
+  size_t thread_count = std::thread::hardware_concurrency();
+  std::string summary_path;
+  bool list_only = false;
+  for (int i = 1; i < argc; ++i) {
+    std::string argument = argv[i];
+    if (argument == "--threads" && i + 1 < argc) {
+      char *end = nullptr;
+      thread_count = std::strtoul(argv[++i], &end, 10);
+      if (end == argv[i] || *end != '\0' || argv[i][0] == '-') {
+        std::cerr << "Invalid thread count: " << argv[i] << std::endl;
+        return 1;
+      }
+    } else if (argument == "--summary" && i + 1 < argc) {
+      summary_path = argv[++i];
+    } else if (argument == "--list") {
+      list_only = true;
+    } else if (!argument.empty() && argument[0] == '-') {
+      std::cerr << "Unexpected argument: " << argument << std::endl;
+      PrintUsage(argv[0]);
+      return 1;
+    } else {
+      paths.push_back(argument);
+    }
+  }
+  if (paths.empty()) {
+    PrintUsage(argv[0]);
+    return 1;
+  }
+
+  std::vector<Scenario> scenarios;
+  try {
+    for (const std::string &path : paths) {
+      std::vector<Scenario> loaded = ScenarioFile::Load(path);
+      scenarios.insert(scenarios.end(), loaded.begin(), loaded.end());
+    }
+  } catch (const std::exception &error) {
+    std::cerr << error.what() << std::endl;
+    return 1;
+  }
+  if (list_only) {
+    for (const Scenario &scenario : scenarios) {
+      std::cout << scenario.name << std::endl;
+    }
+    return 0;
+  }
+
+  idealgas::ThreadPool pool(thread_count);
+  std::vector<RunSummary> summaries = SweepRunner(&pool).Run(scenarios);
+
+  if (summary_path.empty()) {
+    SweepRunner::WriteSummaries(std::cout, summaries);
+  } else {
+    std::ofstream summary(summary_path);
+    SweepRunner::WriteSummaries(summary, summaries);
+    if (!summary) {
+      std::cerr << "Cannot write summary: " << summary_path << std::endl;
+      return 1;
+    }
+  }
+
+  int failed = 0;
+  for (const RunSummary &run : summaries) {
+    if (!run.succeeded) {
+      std::cerr << run.name << ": " << run.error << std::endl;
+      ++failed;
+    }
+  }
+  return failed == 0 ? 0 : 1;
+}
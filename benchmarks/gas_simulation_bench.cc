@@ -0,0 +1,393 @@
+#include <benchmark/benchmark.h>
+
+#include <cmath>
+#include <cstdlib>
+#include <random>
+#include <thread>
+
+#include "event_driven_engine.h"
+#include "gas_container.h"
+#include "gas_statistics.h"
+#include "neighbor_list.h"
+#include "particle_initializer.h"
+#include "physics_engine.h"
+#include "spatial_grid.h"
+#include "thread_pool.h"
+
+using idealgas::DoubleParticleStore;
+using idealgas::EventDrivenEngine;
+using idealgas::GasContainer;
+using idealgas::NeighborList;
+using idealgas::Particle;
+using idealgas::ParticleStore;
+using idealgas::PhysicsEngine;
+using idealgas::SpatialGrid;
+using idealgas::ThreadPool;
+using glm::vec2;
+
+namespace {
+
+const double kPi = 3.14159265358979323846;
+
+// Radius of the particles in the physics benchmarks.
+const int kRadius = 4;
+
+// Mean of the squared radii of the slow, medium and fast container species.
+const double kContainerSquaredRadius = (18 * 18 + 12 * 12 + 6 * 6) / 3.0;
+const size_t kContainerMargin = 80;
+
+/**
+ * How the speeds of the particles are spread out.
+ */
+enum Speeds {
+  kEqualSpeeds,    // every particle at the same speed
+  kMaxwellSpeeds,  // normally distributed velocity components
+  kBimodalSpeeds   // half of the particles slow and half fast
+};
+
+/**
+ * @return length of a square box holding particles of a mean squared radius
+ * that cover a percentage of its area
+ */
+size_t BoxLength(size_t count, double squared_radius, int64_t density_pct) {
+  return static_cast<size_t>(std::ceil(
+      std::sqrt(count * kPi * squared_radius / (density_pct / 100.0))));
+}
+
+/**
+ * Fills a store with particles placed uniformly in a box. Float and double
+ * stores get the same particles.
+ * @return length of the box
+ */
+template <typename Store>
+size_t MakeParticles(Store &particles, size_t count,
+                     int64_t density_pct, int64_t speeds) {
+  size_t box_length = BoxLength(count, kRadius * kRadius, density_pct);
+  std::mt19937 random(42);
+  std::uniform_real_distribution<float> position(kRadius,
+                                                 box_length - kRadius);
+  std::uniform_real_distribution<float> angle(0, 2 * kPi);
+  std::normal_distribution<float> component(0, 2.8f);
+
+  particles.Clear();
+  particles.Reserve(count);
+  for (size_t i = 0; i < count; ++i) {
+    vec2 velocity;
+    if (speeds == kMaxwellSpeeds) {
+      velocity = vec2(component(random), component(random));
+    } else {
+      float speed = 4.0f;
+      if (speeds == kBimodalSpeeds) {
+        speed = i % 2 == 0 ? 1.0f : 8.0f;
+      }
+      float direction = angle(random);
+      velocity = vec2(speed * std::cos(direction), speed * std::sin(direction));
+    }
+    particles.Add(Particle(vec2(position(random), position(random)), velocity,
+                           1, kRadius, "orange"));
+  }
+  return box_length;
+}
+
+/**
+ * A container with a third of the particles of each species, sized so they
+ * cover a percentage of its area.
+ */
+GasContainer MakeContainer(size_t count, int64_t density_pct) {
+  size_t length =
+      BoxLength(count, kContainerSquaredRadius, density_pct) +
+      2 * kContainerMargin;
+  srand(42);
+  return GasContainer(length, length, kContainerMargin, "white", count / 3,
+                      count / 3, count - 2 * (count / 3));
+}
+
+void CollisionArgs(benchmark::internal::Benchmark *benchmark) {
+  benchmark->ArgNames({"particles", "density_pct", "speeds"})
+      ->ArgsProduct({{100, 1000, 10000, 100000, 1000000},
+                     {5, 20, 40},
+                     {kEqualSpeeds, kMaxwellSpeeds, kBimodalSpeeds}});
+}
+
+void ContainerArgs(benchmark::internal::Benchmark *benchmark) {
+  benchmark->ArgNames({"particles", "density_pct"})
+      ->ArgsProduct({{100, 1000, 10000, 100000, 1000000}, {5, 20, 40}});
+}
+
+void BM_AdjustVelocitiesBruteForce(benchmark::State &state) {
+  ParticleStore particles;
+  MakeParticles(particles, state.range(0), state.range(1), state.range(2));
+  for (auto _ : state) {
+    PhysicsEngine::AdjustVelocitiesOnCollision(particles);
+  }
+  state.SetItemsProcessed(state.iterations() * particles.Size());
+}
+// Quadratic, so only the small sizes.
+BENCHMARK(BM_AdjustVelocitiesBruteForce)
+    ->ArgNames({"particles", "density_pct", "speeds"})
+    ->ArgsProduct({{100, 1000, 10000}, {20}, {kMaxwellSpeeds}})
+    ->Unit(benchmark::kMicrosecond);
+
+void BM_GridRebuild(benchmark::State &state) {
+  ParticleStore particles;
+  MakeParticles(particles, state.range(0), state.range(1), state.range(2));
+  SpatialGrid grid;
+  for (auto _ : state) {
+    grid.Rebuild(particles);
+  }
+  state.SetItemsProcessed(state.iterations() * particles.Size());
+}
+BENCHMARK(BM_GridRebuild)->Apply(CollisionArgs)->Unit(benchmark::kMicrosecond);
+
+// Positions do not change between iterations, so after the first one this
+// measures the neighbour search with few velocity updates.
+template <typename Store>
+void BM_AdjustVelocitiesGrid(benchmark::State &state) {
+  Store particles;
+  MakeParticles(particles, state.range(0), state.range(1), state.range(2));
+  SpatialGrid grid;
+  grid.Rebuild(particles);
+  for (auto _ : state) {
+    PhysicsEngine::AdjustVelocitiesOnCollision(particles, grid);
+  }
+  state.SetItemsProcessed(state.iterations() * particles.Size());
+}
+BENCHMARK_TEMPLATE(BM_AdjustVelocitiesGrid, ParticleStore)
+    ->Apply(CollisionArgs)
+    ->Unit(benchmark::kMicrosecond);
+BENCHMARK_TEMPLATE(BM_AdjustVelocitiesGrid, DoubleParticleStore)
+    ->Apply(CollisionArgs)
+    ->Unit(benchmark::kMicrosecond);
+
+void BM_AdjustVelocitiesParallel(benchmark::State &state) {
+  ParticleStore particles;
+  MakeParticles(particles, state.range(0), state.range(1), state.range(2));
+  SpatialGrid grid;
+  grid.Rebuild(particles);
+  ThreadPool pool(std::thread::hardware_concurrency());
+  for (auto _ : state) {
+    PhysicsEngine::AdjustVelocitiesOnCollision(particles, grid, pool);
+  }
+  state.SetItemsProcessed(state.iterations() * particles.Size());
+  state.counters["threads"] = static_cast<double>(pool.GetThreadCount());
+}
+BENCHMARK(BM_AdjustVelocitiesParallel)
+    ->Apply(CollisionArgs)
+    ->Unit(benchmark::kMicrosecond)
+    ->UseRealTime();
+
+// Whole collision steps of a dense gas with a small time step, finding pairs
+// with a grid rebuilt every step (skin 0) or a neighbour list.
+void BM_CollisionStep(benchmark::State &state) {
+  ParticleStore particles;
+  size_t box_length = MakeParticles(particles, state.range(0),
+                                    state.range(1), kMaxwellSpeeds);
+  // A hundredth of the usual step, which MoveParticles takes as a unit step.
+  for (size_t i = 0; i < particles.Size(); ++i) {
+    particles.VelocityX()[i] /= 100;
+    particles.VelocityY()[i] /= 100;
+  }
+  idealgas::Box box(0, 0, box_length, box_length);
+  std::vector<idealgas::WallBounds> bounds = box.GetSpeciesBounds(particles);
+  double skin = state.range(2) / 10.0;
+  SpatialGrid grid;
+  NeighborList list(skin);
+  for (auto _ : state) {
+    if (skin == 0) {
+      grid.Rebuild(particles, box);
+      PhysicsEngine::AdjustVelocitiesOnCollision(particles, grid);
+    } else {
+      list.Update(particles, box);
+      PhysicsEngine::AdjustVelocitiesOnCollision(particles, list);
+    }
+    PhysicsEngine::MoveParticles(box, bounds, particles);
+  }
+  state.SetItemsProcessed(state.iterations() * particles.Size());
+  state.counters["rebuilds"] = static_cast<double>(list.GetRebuildCount());
+  state.counters["pairs"] = static_cast<double>(list.GetPairCount());
+}
+BENCHMARK(BM_CollisionStep)
+    ->ArgNames({"particles", "density_pct", "skin_tenths"})
+    ->ArgsProduct({{10000, 100000}, {20, 40}, {0, 5, 10, 20}})
+    ->Unit(benchmark::kMicrosecond);
+
+template <typename Store>
+void BM_MoveParticles(benchmark::State &state) {
+  Store particles;
+  size_t box_length =
+      MakeParticles(particles, state.range(0), state.range(1), state.range(2));
+  idealgas::Box box(0, 0, box_length, box_length);
+  std::vector<idealgas::WallBounds> bounds = box.GetSpeciesBounds(particles);
+  for (auto _ : state) {
+    PhysicsEngine::MoveParticles(box, bounds, particles);
+  }
+  state.SetItemsProcessed(state.iterations() * particles.Size());
+}
+BENCHMARK_TEMPLATE(BM_MoveParticles, ParticleStore)
+    ->Apply(CollisionArgs)
+    ->Unit(benchmark::kMicrosecond);
+BENCHMARK_TEMPLATE(BM_MoveParticles, DoubleParticleStore)
+    ->Apply(CollisionArgs)
+    ->Unit(benchmark::kMicrosecond);
+
+template <typename Integrator, typename Store = ParticleStore>
+void BM_IntegrateGravity(benchmark::State &state) {
+  Store particles;
+  size_t box_length =
+      MakeParticles(particles, state.range(0), state.range(1), state.range(2));
+  idealgas::UniformField gravity;
+  gravity.y = 0.01f;
+  idealgas::Box box(0, 0, box_length, box_length);
+  std::vector<idealgas::WallBounds> bounds = box.GetSpeciesBounds(particles);
+  for (auto _ : state) {
+    PhysicsEngine::MoveParticles<Integrator>(box, bounds, particles, gravity,
+                                             0.5f);
+  }
+  state.SetItemsProcessed(state.iterations() * particles.Size());
+}
+BENCHMARK_TEMPLATE(BM_IntegrateGravity, idealgas::EulerIntegrator)
+    ->Apply(CollisionArgs)
+    ->Unit(benchmark::kMicrosecond);
+BENCHMARK_TEMPLATE(BM_IntegrateGravity, idealgas::VelocityVerletIntegrator)
+    ->Apply(CollisionArgs)
+    ->Unit(benchmark::kMicrosecond);
+BENCHMARK_TEMPLATE(BM_IntegrateGravity, idealgas::LeapfrogIntegrator)
+    ->Apply(CollisionArgs)
+    ->Unit(benchmark::kMicrosecond);
+BENCHMARK_TEMPLATE(BM_IntegrateGravity, idealgas::VelocityVerletIntegrator,
+                   DoubleParticleStore)
+    ->Apply(CollisionArgs)
+    ->Unit(benchmark::kMicrosecond);
+
+void BM_EventDrivenAdvance(benchmark::State &state) {
+  ParticleStore particles;
+  size_t box_length =
+      MakeParticles(particles, state.range(0), state.range(1), state.range(2));
+  EventDrivenEngine engine(idealgas::Box(0, 0, box_length, box_length));
+  for (auto _ : state) {
+    engine.Advance(particles, 1.0);
+  }
+  state.SetItemsProcessed(state.iterations() * particles.Size());
+  state.counters["collisions"] = static_cast<double>(
+      engine.GetCollisionCount());
+}
+// Building the event queue dominates at a million particles.
+BENCHMARK(BM_EventDrivenAdvance)
+    ->ArgNames({"particles", "density_pct", "speeds"})
+    ->ArgsProduct({{100, 1000, 10000, 100000},
+                   {5, 20, 40},
+                   {kEqualSpeeds, kMaxwellSpeeds, kBimodalSpeeds}})
+    ->Unit(benchmark::kMicrosecond);
+
+void BM_AdvanceOneFrame(benchmark::State &state) {
+  GasContainer container = MakeContainer(state.range(0), state.range(1));
+  for (auto _ : state) {
+    container.AdvanceOneFrame();
+  }
+  state.SetItemsProcessed(state.iterations() *
+                          container.GetParticles().Size());
+}
+BENCHMARK(BM_AdvanceOneFrame)
+    ->Apply(ContainerArgs)
+    ->Unit(benchmark::kMicrosecond);
+
+void BM_UpdateHistogramsFull(benchmark::State &state) {
+  GasContainer container = MakeContainer(state.range(0), state.range(1));
+  for (auto _ : state) {
+    container.ResetHistograms();
+    container.UpdateHistograms();
+  }
+  state.SetItemsProcessed(state.iterations() *
+                          container.GetParticles().Size());
+}
+BENCHMARK(BM_UpdateHistogramsFull)
+    ->Apply(ContainerArgs)
+    ->Unit(benchmark::kMicrosecond);
+
+// Re-bins the particles that collided in one frame.
+void BM_UpdateHistogramsIncremental(benchmark::State &state) {
+  GasContainer container = MakeContainer(state.range(0), state.range(1));
+  container.UpdateHistograms();
+  for (auto _ : state) {
+    state.PauseTiming();
+    container.AdvanceOneFrame();
+    state.ResumeTiming();
+    container.UpdateHistograms();
+  }
+  state.SetItemsProcessed(state.iterations() *
+                          container.GetParticles().Size());
+}
+BENCHMARK(BM_UpdateHistogramsIncremental)
+    ->Apply(ContainerArgs)
+    ->Unit(benchmark::kMicrosecond);
+
+void BM_GenerateParticles(benchmark::State &state) {
+  size_t length = BoxLength(state.range(0), kContainerSquaredRadius,
+                            state.range(1)) + 2 * kContainerMargin;
+  GasContainer sized(length, length, kContainerMargin, "white", 0, 0, 0);
+  Particle particle(vec2(), vec2(3, 2), 12, 12, "red");
+  ParticleStore particles;
+  for (auto _ : state) {
+    particles.Clear();
+    sized.GenerateParticles(particles, particle, state.range(0));
+  }
+  state.SetItemsProcessed(state.iterations() * particles.Size());
+}
+BENCHMARK(BM_GenerateParticles)
+    ->Apply(ContainerArgs)
+    ->Unit(benchmark::kMicrosecond);
+
+// Arguments: particle count, placement, Maxwell-Boltzmann velocities.
+void BM_InitializeParticles(benchmark::State &state) {
+  size_t count = state.range(0);
+  idealgas::ParticleInitializer::Options options;
+  options.seed = 42;
+  options.placement =
+      static_cast<idealgas::ParticleInitializer::Placement>(state.range(1));
+  options.maxwell_boltzmann = state.range(2) != 0;
+  idealgas::ParticleInitializer initializer(options);
+  // 10% of the area covered, dilute enough for Poisson-disk placement.
+  size_t length = BoxLength(count, kRadius * kRadius, 10);
+  idealgas::Box box(0, 0, length, length);
+  std::vector<idealgas::ParticleInitializer::SpeciesAmount> species = {
+      {Particle(vec2(), vec2(1, 1), 1, kRadius, "cyan"), count}};
+  ThreadPool pool(std::thread::hardware_concurrency());
+  ParticleStore particles;
+  for (auto _ : state) {
+    initializer.Generate(box, species, particles, &pool);
+  }
+  state.SetItemsProcessed(state.iterations() * particles.Size());
+}
+BENCHMARK(BM_InitializeParticles)
+    ->ArgsProduct({{100000, 10000000}, {0, 1, 2}, {0, 1}})
+    ->Unit(benchmark::kMillisecond)
+    ->UseRealTime();
+
+// Fused pass computing every statistic, before a move, on all threads.
+template <typename Store>
+void BM_ReduceStatistics(benchmark::State &state) {
+  Store particles;
+  size_t box_length =
+      MakeParticles(particles, state.range(0), state.range(1), state.range(2));
+  idealgas::Box box(0, 0, box_length, box_length);
+  std::vector<idealgas::WallBounds> bounds = box.GetSpeciesBounds(particles);
+  ThreadPool pool(std::thread::hardware_concurrency());
+  for (auto _ : state) {
+    benchmark::DoNotOptimize(idealgas::StatisticsReduction::ReduceBeforeMove(
+        particles, box, bounds, 1, &pool));
+  }
+  state.SetItemsProcessed(state.iterations() * particles.Size());
+  state.counters["threads"] = static_cast<double>(pool.GetThreadCount());
+}
+BENCHMARK_TEMPLATE(BM_ReduceStatistics, ParticleStore)
+    ->Apply(CollisionArgs)
+    ->Unit(benchmark::kMicrosecond)
+    ->UseRealTime();
+BENCHMARK_TEMPLATE(BM_ReduceStatistics, DoubleParticleStore)
+    ->Apply(CollisionArgs)
+    ->Unit(benchmark::kMicrosecond)
+    ->UseRealTime();
+
+}  // namespace
+
+BENCHMARK_MAIN();
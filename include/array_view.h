@@ -0,0 +1,52 @@
+#pragma once
+
+#include <cstddef>
+
+namespace idealgas {
+
+/**
+ * A read-only view of a contiguous array owned by someone else. Views are
+ * cheap to copy and never allocate; one stays valid until its owner
+ * changes the size of the array or is destroyed.
+ */
+template <typename T>
+class ArrayView {
+ public:
+  ArrayView() : data_(nullptr), size_(0) { }
+
+  /**
+   * @param data first element of the array
+   * @param size number of elements
+   */
+  ArrayView(const T *data, size_t size) : data_(data), size_(size) { }
+
+  const T *begin() const {
+    return data_;
+  }
+
+  const T *end() const {
+    return data_ + size_;
+  }
+
+  const T *data() const {
+    return data_;
+  }
+
+  size_t size() const {
+    return size_;
+  }
+
+  bool empty() const {
+    return size_ == 0;
+  }
+
+  const T &operator[](size_t index) const {
+    return data_[index];
+  }
+
+ private:
+  const T *data_;
+  size_t size_;
+};
+
+}  // namespace idealgas
@@ -0,0 +1,124 @@
+#pragma once
+
+#include <cstddef>
+#include <glm/vec2.hpp>
+#include <vector>
+
+#include "particle_store.h"
+
+namespace idealgas {
+
+/**
+ * Range a particle's centre can move in before it touches a wall: the box
+ * shrunk by the particle's radius on every side.
+ */
+struct WallBounds {
+  double lower_x;
+  double upper_x;
+  double lower_y;
+  double upper_y;
+};
+
+/**
+ * What happens to a particle that reaches the edge of the box.
+ */
+enum class Boundary {
+  kReflecting,  // the edges are walls the particles bounce off
+  kPeriodic     // particles leaving one edge come back in at the opposite one
+};
+
+/**
+ * The rectangle particles move in, in simulation units. The x and y extents
+ * are independent and are not tied to window pixels; the renderer scales
+ * the box to fit the window.
+ *
+ * A periodic box is a torus: distances between particles are measured to
+ * the nearest periodic image, and positions are wrapped back into the box.
+ */
+class Box {
+ public:
+  /**
+   * @param min_x coordinate of the left wall
+   * @param min_y coordinate of the top wall
+   * @param max_x coordinate of the right wall
+   * @param max_y coordinate of the bottom wall
+   * @param boundary what happens at the edges
+   * @throws std::invalid_argument if a wall is not finite or the box is
+   * empty
+   */
+  Box(double min_x, double min_y, double max_x, double max_y,
+      Boundary boundary = Boundary::kReflecting);
+
+  /**
+   * The square box drawn inside a window with a margin on each side, as
+   * the container has always used.
+   * @param window_length length of the application window
+   * @param margin size of margin surrounding container
+   * @param boundary what happens at the edges
+   */
+  static Box FromWindow(size_t window_length, size_t margin,
+                        Boundary boundary = Boundary::kReflecting);
+
+  double GetMinX() const;
+  double GetMinY() const;
+  double GetMaxX() const;
+  double GetMaxY() const;
+  double GetWidth() const;
+  double GetHeight() const;
+  Boundary GetBoundary() const;
+
+  /**
+   * @return if the box is periodic
+   */
+  bool IsPeriodic() const;
+
+  /**
+   * Shortens a displacement between two particles to the one between
+   * nearest images. Displacements in a reflecting box are returned as is.
+   * @param displacement position of one particle minus the other
+   * @return displacement to the nearest image
+   */
+  glm::vec2 MinimumImage(const glm::vec2 &displacement) const;
+
+  /**
+   * Shortens a displacement along x to the one between nearest images.
+   * @param dx x component of a displacement
+   * @return x component of the displacement to the nearest image
+   */
+  double MinimumImageX(double dx) const;
+
+  /**
+   * Shortens a displacement along y to the one between nearest images.
+   * @param dy y component of a displacement
+   * @return y component of the displacement to the nearest image
+   */
+  double MinimumImageY(double dy) const;
+
+  /**
+   * @param radius radius of a particle
+   * @return range the particle's centre can move in
+   */
+  WallBounds GetBounds(double radius) const;
+
+  /**
+   * Computes the wall bounds of every species of a store, so loops over
+   * the particles look them up instead of recomputing them.
+   * @param particles store whose species to use
+   * @return bounds indexed by species id
+   */
+  template <typename T>
+  std::vector<WallBounds> GetSpeciesBounds(
+      const BasicParticleStore<T> &particles) const;
+
+  bool operator==(const Box &other) const;
+  bool operator!=(const Box &other) const;
+
+ private:
+  double min_x_;
+  double min_y_;
+  double max_x_;
+  double max_y_;
+  Boundary boundary_;
+};
+
+}  // namespace idealgas
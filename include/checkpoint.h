@@ -0,0 +1,151 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "particle_store.h"
+
+namespace idealgas {
+
+/**
+ * A saved simulation state, read through a memory mapping of the file.
+ * The particle arrays are read straight from the mapping, with no buffers
+ * in between, and Restore copies each one into a store in a single bulk
+ * copy.
+ *
+ * The file starts with a Header, followed by the species table and one
+ * array per particle field, each starting on a 64 byte boundary:
+ * x, y, vx, vy and inverse mass and radius as floats, then species ids as
+ * bytes. Values are in the byte order of the machine that wrote them, which
+ * is checked on load.
+ */
+class Checkpoint {
+ public:
+  static const uint32_t kVersion = 3;  // bumped when the layout changes
+
+  /**
+   * Size of the container the particles were simulated in. A checkpoint can
+   * only be restored into a container of the same size.
+   */
+  struct Geometry {
+    uint64_t window_length;
+    uint64_t window_width;
+    uint64_t margin;
+    double box_min_x;  // walls of the box the particles move in
+    double box_min_y;
+    double box_max_x;
+    double box_max_y;
+    uint64_t boundary;  // Boundary of the box, as its underlying value
+  };
+
+  /**
+   * Writes a checkpoint. The file is written under a temporary name and
+   * renamed into place, so an interrupted save keeps the previous file.
+   * @param path file to write
+   * @param particles particles to save
+   * @param frame frame counter to save
+   * @param geometry size of the container
+   * @throws std::runtime_error if the file cannot be written
+   */
+  static void Save(const std::string &path, const ParticleStore &particles,
+                   int64_t frame, const Geometry &geometry);
+
+  /**
+   * Maps a checkpoint file and checks its header.
+   * @param path file to read
+   * @throws std::runtime_error if the file cannot be read
+   * @throws std::invalid_argument if the file is not a valid checkpoint
+   */
+  explicit Checkpoint(const std::string &path);
+
+  ~Checkpoint();
+
+  Checkpoint(const Checkpoint &) = delete;
+  Checkpoint &operator=(const Checkpoint &) = delete;
+
+  /**
+   * Copies the saved particles into a store, replacing its contents.
+   * @param particles store to fill
+   */
+  void Restore(ParticleStore &particles) const;
+
+  /**
+   * @return number of saved particles
+   */
+  size_t GetParticleCount() const;
+
+  /**
+   * @return saved frame counter
+   */
+  int64_t GetFrame() const;
+
+  /**
+   * @return size of the container the particles were saved from
+   */
+  Geometry GetGeometry() const;
+
+  /**
+   * @return saved species table
+   */
+  std::vector<ParticleStore::Species> GetSpecies() const;
+
+  // Saved particle arrays, pointing into the mapped file.
+  const float *PositionX() const;
+  const float *PositionY() const;
+  const float *VelocityX() const;
+  const float *VelocityY() const;
+  const float *InverseMass() const;
+  const float *Radius() const;
+  const uint8_t *SpeciesId() const;
+
+ private:
+  enum Array {
+    kPositionX,
+    kPositionY,
+    kVelocityX,
+    kVelocityY,
+    kInverseMass,
+    kRadius,
+    kSpeciesId,
+    kArrayCount
+  };
+
+  struct Header {
+    char magic[8];
+    uint32_t version;
+    uint32_t byte_order;
+    uint32_t species_count;
+    uint32_t reserved;
+    uint64_t particle_count;
+    int64_t frame;
+    Geometry geometry;
+    uint64_t array_offsets[kArrayCount];
+  };
+
+  struct SpeciesRecord {
+    float red;
+    float green;
+    float blue;
+    int32_t mass;
+    int32_t radius;
+  };
+
+  /**
+   * Checks that the header describes arrays that fit in the file.
+   */
+  void Validate() const;
+
+  /**
+   * @return pointer to the start of an array in the mapped file
+   */
+  const unsigned char *ArrayData(Array array) const;
+
+  const Header &GetHeader() const;
+
+  const unsigned char *data_ = nullptr;  // start of the mapped file
+  size_t size_ = 0;                      // size of the mapped file in bytes
+  std::vector<unsigned char> buffer_;    // file contents without mmap
+};
+
+}  // namespace idealgas
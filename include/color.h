@@ -0,0 +1,29 @@
+#pragma once
+
+namespace idealgas {
+
+/**
+ * An RGB colour with components between 0 and 1. The simulation only uses
+ * colours to tell the renderer how to draw particles, so this keeps the core
+ * free of any graphics library.
+ */
+struct Color {
+  Color();
+  Color(float red, float green, float blue);
+
+  /**
+   * Looks up a colour by its SVG name, such as "orange" or "cyan".
+   * @param name SVG colour name
+   * @throws std::invalid_argument if the name is unknown
+   */
+  Color(const char *name);
+
+  bool operator==(const Color &other) const;
+  bool operator!=(const Color &other) const;
+
+  float r;
+  float g;
+  float b;
+};
+
+}  // namespace idealgas
@@ -0,0 +1,145 @@
+#pragma once
+
+#include <cstddef>
+#include <functional>
+
+#include "gas_statistics.h"
+
+namespace idealgas {
+
+/**
+ * A quantity the collisions should leave unchanged.
+ */
+enum class ConservedQuantity {
+  kKineticEnergy,  // sum of m v^2 / 2
+  kMomentum        // total momentum, a vector
+};
+
+/**
+ * A conserved quantity that drifted further than its tolerance.
+ */
+struct ConservationAlarm {
+  ConservedQuantity quantity = ConservedQuantity::kKineticEnergy;
+  int frame = 0;         // frame the drift was found at
+  double reference = 0;  // energy, or momentum scale, it drifted from
+  double drift = 0;      // change relative to the reference
+};
+
+/**
+ * Watches the kinetic energy and momentum of a gas for drift. Elastic
+ * collisions conserve both, but overlapping pairs, pairs colliding more
+ * than once in a frame and float rounding all let them wander; so can a
+ * larger time step or a faster, less exact path through the engine.
+ *
+ * The first check after construction or Rebase takes the reference, and
+ * every later check compares with it. Energy drift is relative to the
+ * reference energy. Momentum drift is the length of the change in the
+ * momentum vector relative to sqrt(2 M E), the momentum the gas would
+ * have if every particle moved the same way at the rms speed; total
+ * momentum itself is often close to zero.
+ *
+ * When a drift goes over its tolerance the callback is told once. It is
+ * told again only after the drift has come back within the tolerance or
+ * the monitor has been rebased.
+ */
+class ConservationMonitor {
+ public:
+  struct Options {
+    size_t sample_every = 1;         // frames between checks
+    double energy_tolerance = 1e-3;  // relative energy drift allowed
+    double momentum_tolerance = 1e-3;  // relative momentum drift allowed
+  };
+
+  using Callback = std::function<void(const ConservationAlarm &)>;
+
+  /**
+   * @param options how often to check and how much drift to allow
+   * @param callback called with each alarm, on the thread that checks, or
+   * an empty function to only keep the drifts
+   * @throws std::invalid_argument if the sampling interval is 0 or a
+   * tolerance is negative
+   */
+  ConservationMonitor(const Options &options, const Callback &callback);
+
+  /**
+   * @param frame frame number
+   * @return if the frame is one to check
+   */
+  bool ShouldSample(int frame) const;
+
+  /**
+   * Compares the statistics of a frame with the reference, taking them as
+   * the reference instead if there is none yet.
+   * @param statistics statistics of the frame, with the total mass
+   * @param frame frame number, for the alarm
+   * @param check_energy whether kinetic energy should be conserved, which
+   * it is not under an external field
+   * @param check_momentum whether momentum should be conserved, which it is
+   * not against walls or under an external field
+   */
+  void Check(const GasStatistics &statistics, int frame, bool check_energy,
+             bool check_momentum);
+
+  /**
+   * Takes the next checked frame as the new reference, after the gas has
+   * been replaced or changed on purpose in a way Rescale cannot follow.
+   */
+  void Rebase();
+
+  /**
+   * Follows a deliberate scaling of every velocity, so it does not count
+   * as drift.
+   * @param factor factor every velocity was multiplied by
+   */
+  void Rescale(double factor);
+
+  /**
+   * @return energy drift at the last check of energy
+   */
+  double GetEnergyDrift() const;
+
+  /**
+   * @return momentum drift at the last check of momentum
+   */
+  double GetMomentumDrift() const;
+
+  /**
+   * @return largest energy drift since the last rebase
+   */
+  double GetMaxEnergyDrift() const;
+
+  /**
+   * @return largest momentum drift since the last rebase
+   */
+  double GetMaxMomentumDrift() const;
+
+  /**
+   * @return number of alarms raised
+   */
+  size_t GetAlarmCount() const;
+
+ private:
+  /**
+   * Raises an alarm for a drift that went over its tolerance, once until it
+   * comes back within it.
+   */
+  void Compare(ConservedQuantity quantity, int frame, double reference,
+               double drift, double tolerance, bool &raised);
+
+  const Options kOptions_;
+  Callback callback_;
+  bool has_reference_ = false;
+  double reference_energy_ = 0;      // kinetic energy at the reference
+  double reference_momentum_x_ = 0;  // momentum at the reference
+  double reference_momentum_y_ = 0;
+  double momentum_scale_ = 0;        // sqrt(2 M E) at the reference
+  double energy_drift_ = 0;
+  double momentum_drift_ = 0;
+  double max_energy_drift_ = 0;
+  double max_momentum_drift_ = 0;
+  bool energy_raised_ = false;       // if the energy alarm is out
+  bool momentum_raised_ = false;     // if the momentum alarm is out
+  size_t alarm_count_ = 0;
+};
+
+}  // namespace idealgas
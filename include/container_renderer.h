@@ -0,0 +1,95 @@
+#pragma once
+
+#include <memory>
+#include <string>
+
+#include "cinder/gl/gl.h"
+#include "gas_container.h"
+#include "particle_batch_renderer.h"
+#include "simulation_thread.h"
+
+namespace idealgas {
+
+/**
+ * Draws a gas container and its speed histograms with Cinder. This is kept
+ * apart from GasContainer so the simulation can run without a GL context.
+ * Only the container's fixed layout is read directly; everything that
+ * changes comes from a snapshot, so the container may be advanced on
+ * another thread while drawing.
+ */
+class ContainerRenderer {
+ public:
+  /**
+   * @param container gas container to draw, which must outlive the renderer
+   */
+  explicit ContainerRenderer(const GasContainer &container);
+
+  /**
+   * Displays the container walls and the positions of the particles in a
+   * snapshot. The particles are drawn in one instanced call. The GL
+   * resources, including the axis labels, are created on the first call;
+   * later frames only draw them and allocate nothing.
+   * @param snapshot particles and histograms to draw
+   */
+  void Display(const SimulationSnapshot &snapshot) const;
+
+  /**
+   * Draws the outlines for the histograms and their axis labels
+   * @param rows number of histograms, one per species
+   */
+  void DrawHistogramBoxes(size_t rows) const;
+
+  /**
+   * Draws histogram bins
+   * @param top_left_corner of histogram
+   * @param bottom_right_corner of histogram
+   * @param color of particles and histogram bins
+   * @param speeds how many particles are in each bin
+   * @param max_height most particles in any bin
+   */
+  void DisplayHistogram(const glm::vec2 &top_left_corner,
+                        const glm::vec2 &bottom_right_corner,
+                        const ci::Color &color, ArrayView<uint32_t> speeds,
+                        size_t max_height) const;
+
+  /**
+   * @param color simulation colour
+   * @return the same colour for Cinder
+   */
+  static ci::Color ToCinderColor(const Color &color);
+
+ private:
+  /**
+   * Finds where a histogram goes in the column right of the container.
+   * @param row row of the histogram, from the top
+   * @param rows number of histograms
+   * @param top_left set to the top left corner of the histogram
+   * @param bottom_right set to the bottom right corner of the histogram
+   */
+  void GetHistogramBounds(size_t row, size_t rows, glm::vec2 &top_left,
+                          glm::vec2 &bottom_right) const;
+
+  /**
+   * Renders a line of white text once, to be tinted when drawn.
+   * @param text label to render
+   * @return texture holding the text
+   */
+  static ci::gl::Texture2dRef RenderLabel(const std::string &text);
+
+  /**
+   * Draws a label rendered by RenderLabel in the current colour.
+   * @param label texture of the label
+   * @param center where the middle of the label goes
+   */
+  static void DrawLabelCentered(const ci::gl::Texture2dRef &label,
+                                const glm::vec2 &center);
+
+  const GasContainer &container_;  // container being drawn
+
+  // Created on the first draw, once a GL context is current.
+  mutable std::unique_ptr<ParticleBatchRenderer> particle_renderer_;
+  mutable ci::gl::Texture2dRef speed_label_;         // histogram x axis
+  mutable ci::gl::Texture2dRef inverse_path_label_;  // histogram y axis
+};
+
+}  // namespace idealgas
@@ -0,0 +1,175 @@
+#pragma once
+
+#include <cstdint>
+#include <functional>
+#include <vector>
+
+#include "box.h"
+#include "particle_store.h"
+
+namespace idealgas {
+
+/**
+ * An event-driven hard-sphere engine. Instead of moving every particle by a
+ * fixed step and checking for overlaps afterwards, it predicts the exact
+ * time of every particle-particle and particle-wall collision, keeps them in
+ * a priority queue and jumps straight from one collision to the next. This
+ * stays correct at any speed and does no work between collisions.
+ *
+ * Particles are kept in a uniform grid, and a particle only predicts
+ * collisions with particles in neighbouring cells. Leaving a cell is an
+ * event of its own, at which point the particle looks at its new neighbours.
+ * Predictions are invalidated lazily: every particle counts its collisions,
+ * and an event is skipped if either particle has collided since it was made.
+ *
+ * In a periodic box there are no wall events. The grid wraps around, and a
+ * particle crossing an edge is moved to the opposite one. A periodic box
+ * must be more than two particle diameters across, so that colliding
+ * particles are nearest images of each other.
+ */
+class EventDrivenEngine {
+ public:
+  /**
+   * @param box walls to bounce off
+   */
+  explicit EventDrivenEngine(const Box &box);
+
+  /**
+   * Forgets all predictions. Must be called after particles are changed
+   * outside of the engine, so they are read again on the next Advance.
+   */
+  void Reset();
+
+  /**
+   * Moves the particles forward in time, resolving every collision at the
+   * moment it happens. Velocities are in distance per unit of time.
+   * @param particles particles to move
+   * @param duration amount of time to move forward by
+   */
+  void Advance(ParticleStore &particles, double duration);
+
+  /**
+   * @return number of particle-particle collisions resolved so far
+   */
+  size_t GetCollisionCount() const;
+
+  /**
+   * @return number of wall bounces so far
+   */
+  size_t GetWallHitCount() const;
+
+  /**
+   * @return momentum the walls have taken from the particles so far
+   */
+  double GetWallImpulse() const;
+
+  /**
+   * @return time the engine has moved forward by since the last Reset
+   */
+  double GetTime() const;
+
+ private:
+  enum class EventType : uint8_t { kParticle, kWallX, kWallY, kCellCrossing };
+
+  /**
+   * A predicted event. For particle events, other is the second particle;
+   * for cell crossings, it is the direction of the crossing.
+   */
+  struct Event {
+    double time;
+    uint32_t particle;
+    uint32_t other;
+    uint32_t particle_count;
+    uint32_t other_count;
+    EventType type;
+
+    bool operator>(const Event &event) const;
+  };
+
+  /**
+   * Copies the particles in and predicts all of their events.
+   */
+  void Initialize(const ParticleStore &particles);
+
+  /**
+   * Predicts every event for the particles at the current time.
+   */
+  void PredictAll();
+
+  /**
+   * Adds an event to the queue.
+   */
+  void PushEvent(const Event &event);
+
+  /**
+   * Predicts collisions of a particle with the walls.
+   */
+  void PredictWalls(size_t i);
+
+  /**
+   * Predicts collisions of a particle with the particles around it.
+   */
+  void PredictParticles(size_t i);
+
+  /**
+   * Predicts a collision between two particles, if they are closing in.
+   * @param i first particle
+   * @param j second particle
+   * @param dx x displacement of the second particle from the first
+   * @param dy y displacement of the second particle from the first
+   */
+  void PredictPair(size_t i, size_t j, double dx, double dy);
+
+  /**
+   * Predicts when a particle leaves its cell.
+   */
+  void PredictCellCrossing(size_t i);
+
+  /**
+   * Moves a particle along its path to the current time.
+   */
+  void MoveToNow(size_t i);
+
+  /**
+   * @return if neither particle of the event has collided since it was made
+   */
+  bool IsValid(const Event &event) const;
+
+  void InsertIntoCell(size_t i, size_t cell);
+  void RemoveFromCell(size_t i);
+
+  const Box kBox_;
+  double time_ = 0;
+  bool initialized_ = false;
+  size_t collision_count_ = 0;
+  size_t wall_hit_count_ = 0;
+  double wall_impulse_ = 0;  // momentum taken by the walls
+
+  // Particle state at each particle's own last update time.
+  std::vector<double> x_;
+  std::vector<double> y_;
+  std::vector<double> vx_;
+  std::vector<double> vy_;
+  std::vector<double> last_update_;
+  std::vector<double> inverse_mass_;
+  std::vector<double> radius_;
+  std::vector<uint8_t> species_;        // species id of each particle
+  std::vector<WallBounds> species_bounds_;  // wall bounds of each species
+  std::vector<uint32_t> counts_;  // collisions of each particle
+
+  // Grid as linked lists of particles per cell.
+  double cell_width_ = 1;
+  double cell_height_ = 1;
+  size_t columns_ = 1;
+  size_t rows_ = 1;
+  std::vector<uint32_t> cell_heads_;
+  std::vector<uint32_t> next_in_cell_;
+  std::vector<uint32_t> prev_in_cell_;
+  std::vector<uint32_t> cell_of_;
+
+  // Binary heap with the earliest event first, kept in a plain vector so
+  // its memory is reused when the queue is rebuilt.
+  std::vector<Event> events_;
+};
+
+}  // namespace idealgas
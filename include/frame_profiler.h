@@ -0,0 +1,286 @@
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <ostream>
+#include <vector>
+
+namespace idealgas {
+
+/**
+ * Parts of a frame that are timed separately.
+ */
+enum class FramePhase : uint8_t {
+  kGridRebuild,  // sorting particles into the spatial grid
+  kCollisions,   // resolving particle-particle collisions
+  kWalls,        // bouncing particles off the walls
+  kIntegration,  // moving particles; includes the walls in the fused kernel
+  kEventDriven,  // advancing the event-driven engine
+  kStatistics,   // reducing GasStatistics
+  kHistograms,   // updating the speed histograms
+  kRecording     // handing the frame to the trajectory recorder
+};
+
+const size_t kFramePhaseCount = 8;
+
+/**
+ * Events counted over a frame.
+ */
+enum class FrameCounter : uint8_t {
+  kPairsTested,         // particle pairs checked for a collision
+  kCollisionsResolved,  // particle pairs that collided
+  kWallHits             // velocity components reversed by a wall
+};
+
+const size_t kFrameCounterCount = 3;
+
+/**
+ * Timings and counts of one frame. Times are in nanoseconds since the
+ * profiler was created.
+ */
+struct FrameMetrics {
+  int64_t frame = 0;
+  uint64_t start_ns = 0;
+  uint64_t duration_ns = 0;
+  uint64_t phase_start_ns[kFramePhaseCount] = {};  // first start of a phase
+  uint64_t phase_ns[kFramePhaseCount] = {};        // total time in a phase
+  uint64_t counters[kFrameCounterCount] = {};
+};
+
+/**
+ * Collects the timings and counters of each frame and keeps those of the
+ * last frames in a ring. One thread advances the frames; any other thread
+ * can read the ring at the same time without locks, and never blocks the
+ * frame thread.
+ *
+ * Code on the hot path reaches the profiler through the macros below, which
+ * find the profiler of the frame being advanced on the current thread.
+ * Unless the build defines IDEALGAS_PROFILING, the macros expand to nothing
+ * and a frame costs no more than without a profiler.
+ */
+class FrameProfiler {
+ public:
+  /**
+   * @param capacity number of frames kept
+   * @throws std::invalid_argument if the capacity is 0
+   */
+  explicit FrameProfiler(size_t capacity = 256);
+
+  FrameProfiler(const FrameProfiler &) = delete;
+  FrameProfiler &operator=(const FrameProfiler &) = delete;
+
+  /**
+   * Starts collecting a frame. Only the frame thread may call this.
+   * @param frame frame counter of the frame
+   */
+  void BeginFrame(int64_t frame);
+
+  /**
+   * Finishes the frame and publishes it to the ring.
+   */
+  void EndFrame();
+
+  /**
+   * Adds time spent in a phase of the current frame.
+   * @param phase phase the time was spent in
+   * @param start_ns when the phase started, from Now
+   * @param end_ns when the phase ended, from Now
+   */
+  void AddPhaseTime(FramePhase phase, uint64_t start_ns, uint64_t end_ns);
+
+  /**
+   * Adds to a counter of the current frame. Safe to call from any thread.
+   * @param counter counter to add to
+   * @param amount amount to add
+   */
+  void AddCount(FrameCounter counter, uint64_t amount);
+
+  /**
+   * @return nanoseconds since the profiler was created
+   */
+  uint64_t Now() const;
+
+  /**
+   * Copies the frames in the ring. Safe to call from any thread while
+   * frames are being published; frames overwritten during the copy are
+   * left out.
+   * @return frames from oldest to newest
+   */
+  std::vector<FrameMetrics> GetRecentFrames() const;
+
+  /**
+   * @return number of frames published so far
+   */
+  uint64_t GetFrameCount() const;
+
+  /**
+   * Writes the frames in the ring in the Chrome trace event format, for
+   * chrome://tracing or Perfetto. Every frame and phase is a complete
+   * event, and the counters are counter events.
+   * @param output stream to write to
+   */
+  void WriteChromeTrace(std::ostream &output) const;
+
+  /**
+   * @param phase a phase
+   * @return name of the phase in traces
+   */
+  static const char *GetName(FramePhase phase);
+
+  /**
+   * @param counter a counter
+   * @return name of the counter in traces
+   */
+  static const char *GetName(FrameCounter counter);
+
+  /**
+   * @return profiler of the frame being advanced on this thread, or nullptr
+   */
+  static FrameProfiler *GetActive();
+
+  /**
+   * Makes a profiler the active one of this thread for a scope, such as a
+   * frame or a task run for one.
+   */
+  class Activation {
+   public:
+    explicit Activation(FrameProfiler *profiler);
+    ~Activation();
+
+    Activation(const Activation &) = delete;
+    Activation &operator=(const Activation &) = delete;
+
+   private:
+    FrameProfiler *previous_;
+  };
+
+ private:
+  /**
+   * A frame in the ring, guarded by a sequence number that is odd while
+   * the frame is being written.
+   */
+  struct Slot {
+    std::atomic<uint64_t> sequence;
+    FrameMetrics metrics;
+  };
+
+  const std::chrono::steady_clock::time_point kEpoch_;
+  std::unique_ptr<Slot[]> slots_;
+  const size_t kCapacity_;
+  std::atomic<uint64_t> published_;  // number of frames published
+
+  FrameMetrics current_;                             // owned by the writer
+  std::atomic<uint64_t> counts_[kFrameCounterCount];  // of the current frame
+};
+
+/**
+ * Advances a frame under a profiler for a scope. Does nothing without one.
+ */
+class ScopedFrame {
+ public:
+  ScopedFrame(FrameProfiler *profiler, int64_t frame);
+  ~ScopedFrame();
+
+  ScopedFrame(const ScopedFrame &) = delete;
+  ScopedFrame &operator=(const ScopedFrame &) = delete;
+
+ private:
+  FrameProfiler::Activation activation_;
+  FrameProfiler *profiler_;
+};
+
+/**
+ * Times a scope as a phase of the active profiler's frame. Does nothing
+ * when no profiler is active.
+ */
+class ScopedPhaseTimer {
+ public:
+  explicit ScopedPhaseTimer(FramePhase phase)
+      : profiler_(FrameProfiler::GetActive()), phase_(phase),
+        start_ns_(profiler_ != nullptr ? profiler_->Now() : 0) { }
+
+  ~ScopedPhaseTimer() {
+    if (profiler_ != nullptr) {
+      profiler_->AddPhaseTime(phase_, start_ns_, profiler_->Now());
+    }
+  }
+
+  ScopedPhaseTimer(const ScopedPhaseTimer &) = delete;
+  ScopedPhaseTimer &operator=(const ScopedPhaseTimer &) = delete;
+
+ private:
+  FrameProfiler *profiler_;
+  FramePhase phase_;
+  uint64_t start_ns_;
+};
+
+/**
+ * Adds to a counter of the active profiler's frame, if there is one.
+ */
+inline void CountFrameEvents(FrameCounter counter, uint64_t amount) {
+  FrameProfiler *profiler = FrameProfiler::GetActive();
+  if (profiler != nullptr) {
+    profiler->AddCount(counter, amount);
+  }
+}
+
+}  // namespace idealgas
+
+#define IDEALGAS_PROFILE_JOIN2(a, b) a##b
+#define IDEALGAS_PROFILE_JOIN(a, b) IDEALGAS_PROFILE_JOIN2(a, b)
+
+#if IDEALGAS_PROFILING
+// Advances a frame under a profiler until the end of the scope.
+#define IDEALGAS_PROFILE_FRAME(profiler, frame) \
+  ::idealgas::ScopedFrame IDEALGAS_PROFILE_JOIN(profile_frame_, __LINE__)( \
+      profiler, frame)
+// Times the rest of the scope as a FramePhase.
+#define IDEALGAS_PROFILE_PHASE(phase) \
+  ::idealgas::ScopedPhaseTimer IDEALGAS_PROFILE_JOIN(profile_phase_, \
+                                                     __LINE__)(phase)
+// Adds to a FrameCounter. The amount is not evaluated when disabled.
+#define IDEALGAS_PROFILE_COUNT(counter, amount) \
+  ::idealgas::CountFrameEvents(counter, amount)
+#else
+#define IDEALGAS_PROFILE_FRAME(profiler, frame) ((void)0)
+#define IDEALGAS_PROFILE_PHASE(phase) ((void)0)
+#define IDEALGAS_PROFILE_COUNT(counter, amount) ((void)0)
+#endif
+
+namespace idealgas {
+
+/**
+ * Adds up counts in a loop and adds them to the active profiler's frame
+ * once, when it goes out of scope. Loops that run on the thread pool count
+ * into one per task, so the profiler is looked up and its shared counters
+ * touched once per task rather than once per particle. Costs nothing when
+ * profiling is compiled out.
+ */
+class ScopedFrameCounts {
+ public:
+  ScopedFrameCounts() = default;
+
+  ~ScopedFrameCounts() {
+    for (size_t counter = 0; counter < kFrameCounterCount; ++counter) {
+      if (counts_[counter] != 0) {
+        IDEALGAS_PROFILE_COUNT(static_cast<FrameCounter>(counter),
+                               counts_[counter]);
+      }
+    }
+  }
+
+  ScopedFrameCounts(const ScopedFrameCounts &) = delete;
+  ScopedFrameCounts &operator=(const ScopedFrameCounts &) = delete;
+
+  void Add(FrameCounter counter, uint64_t amount) {
+    counts_[static_cast<size_t>(counter)] += amount;
+  }
+
+ private:
+  uint64_t counts_[kFrameCounterCount] = {};
+};
+
+}  // namespace idealgas
@@ -1,15 +1,49 @@
 #pragma once
 
-#include "cinder/gl/gl.h"
+#include <map>
+#include <memory>
+#include <string>
+
+#include "array_view.h"
+#include "box.h"
+#include "color.h"
+#include "conservation_monitor.h"
+#include "event_driven_engine.h"
+#include "frame_profiler.h"
 #include "gas_particle.h"
+#include "gas_statistics.h"
+#include "neighbor_list.h"
+#include "particle_initializer.h"
+#include "particle_store.h"
 #include "physics_engine.h"
+#include "spatial_grid.h"
+#include "speed_histogram.h"
+#include "thread_pool.h"
+#include "trajectory_recorder.h"
 
 namespace idealgas {
 
+/**
+ * How the container moves its particles from one frame to the next.
+ */
+enum class EngineMode {
+  kTimeStepped,  // move by a fixed step, then resolve overlapping particles
+  kEventDriven   // resolve every collision at the exact time it happens
+};
+
+/**
+ * How the time-stepped engine moves particles over one step.
+ */
+enum class IntegratorKind {
+  kEuler,           // explicit Euler, EulerIntegrator
+  kVelocityVerlet,  // velocity Verlet, VelocityVerletIntegrator
+  kLeapfrog         // drift-kick-drift leapfrog, LeapfrogIntegrator
+};
+
 /**
  * The container in which all of the gas particles_ are contained. This class
  * stores all of the particles_ and updates them on each frame of the
- * simulation.
+ * simulation. It has no graphics dependency; ContainerRenderer draws it.
  */
 class GasContainer {
  public:
@@ -17,12 +51,42 @@ class GasContainer {
    * The gas container used to hold the gas particles.
    */
   GasContainer(const size_t kWindowLength, const size_t kWindowWidth,
-               const size_t kMargin, const ci::Color &kBorderColor);
+               const size_t kMargin, const Color &kBorderColor);
+
+  /**
+   * A gas container holding the given amounts of each kind of particle.
+   * @param slow_amount number of slow (green) particles
+   * @param medium_amount number of medium (red) particles
+   * @param fast_amount number of fast (orange) particles
+   */
+  GasContainer(const size_t kWindowLength, const size_t kWindowWidth,
+               const size_t kMargin, const Color &kBorderColor,
+               size_t slow_amount, size_t medium_amount, size_t fast_amount);
+
+  /**
+   * A gas container whose particles move in a box of any size, which is
+   * scaled to fit the window when drawn.
+   * @param box walls the particles move between, in simulation units
+   * @param slow_amount number of slow (green) particles
+   * @param medium_amount number of medium (red) particles
+   * @param fast_amount number of fast (orange) particles
+   */
+  GasContainer(const size_t kWindowLength, const size_t kWindowWidth,
+               const size_t kMargin, const Color &kBorderColor,
+               const Box &box, size_t slow_amount, size_t medium_amount,
+               size_t fast_amount);
 
   /**
-   * Displays the container walls and the current positions of the particles_.
+   * A gas container holding any mixture of species. Each species gets the
+   * id of its position in the list, and its own histogram.
+   * @param box walls the particles move between, in simulation units
+   * @param species prototype particle and amount of each species
+   * @throws std::length_error if there are more than 256 species
    */
-  void Display() const;
+  GasContainer(const size_t kWindowLength, const size_t kWindowWidth,
+               const size_t kMargin, const Color &kBorderColor,
+               const Box &box,
+               const std::vector<ParticleInitializer::SpeciesAmount> &species);
 
   /**
    * Updates the positions and velocities of all particles_ (based on the rules
@@ -31,38 +95,50 @@ class GasContainer {
   void AdvanceOneFrame();
 
   /**
-   * Generates a given amount of particles of a given particle to a vector.
-   * @param particles vector of particles
+   * Generates a given amount of particles of a given particle to a store.
+   * At most as many particles as fit side by side in the box are made, so
+   * use InitializeParticles to be told when the amount does not fit.
+   * @param particles store of particles
    * @param particle to generate
    * @param particle_amount number of particles to generate
    */
-  void GenerateParticles(std::vector<idealgas::Particle> &particles,
+  void GenerateParticles(ParticleStore &particles,
                          Particle &particle, size_t particle_amount);
 
   /**
-   * Draws the outlines for the histograms
+   * Replaces the particles with ones generated from a seed. Unlike the
+   * constructors, this does not use rand(), so the same initializer gives
+   * the same particles on every platform and for any thread pool.
+   * @param initializer how to place the particles and give them velocities
+   * @param slow_amount number of slow (green) particles
+   * @param medium_amount number of medium (red) particles
+   * @param fast_amount number of fast (orange) particles
+   * @throws std::invalid_argument or std::runtime_error if the particles do
+   * not fit in the box, see ParticleInitializer::Generate
    */
-  void DrawHistogramBoxes() const;
+  void InitializeParticles(const ParticleInitializer &initializer,
+                           size_t slow_amount, size_t medium_amount,
+                           size_t fast_amount);
 
   /**
-   * Updates three maps of different particles
+   * Replaces the particles with a mixture generated from a seed.
+   * @param initializer how to place the particles and give them velocities
+   * @param species prototype particle and amount of each species
+   * @throws std::invalid_argument or std::runtime_error if the particles do
+   * not fit in the box, see ParticleInitializer::Generate
    */
-  void UpdateHistograms();
+  void InitializeParticles(
+      const ParticleInitializer &initializer,
+      const std::vector<ParticleInitializer::SpeciesAmount> &species);
 
   /**
-   * Draws histogram bins
-   * @param top_left_corner of histogram
-   * @param bottom_right_corner of histogram
-   * @param color of particles and histogram bins
-   * @param speeds map of how many particles are in each bin
+   * Updates the speed histograms, re-binning only the particles whose speed
+   * changed since the last update.
    */
-  void DisplayHistogram(const glm::vec2 &top_left_corner,
-                        const glm::vec2 &bottom_right_corner,
-                        const ci::Color &color,
-                        std::map<int, int> speeds) const;
+  void UpdateHistograms();
 
   /**
-   * sets all values of keys in histogram maps to 0
+   * Sets all histogram counts to 0 until the next update.
    */
   void ResetHistograms();
 
@@ -83,8 +159,206 @@ class GasContainer {
 
   /**
    * Getter method to retrieve map that stores histogram data.
+   * @param color colour of the particles, whose species are counted together
+   * @return number of particles in each bin
+   */
+  std::map<int, int> GetMap(const Color& color) const;
+
+  /**
+   * @param species species id
+   * @return number of particles of the species in each bin
+   */
+  std::map<int, int> GetSpeciesMap(uint8_t species) const;
+
+  /**
+   * Reads a histogram without copying it, for callers that run every frame.
+   * @param species species id
+   * @return number of particles of the species in each bin, or an empty
+   * view before the histograms are first updated; valid until the next
+   * update
+   */
+  ArrayView<uint32_t> GetSpeciesCounts(uint8_t species) const;
+
+  /**
+   * @return number of species, each with its own histogram
+   */
+  size_t GetSpeciesCount() const;
+
+  /**
+   * @return particles in the container
    */
-  std::map<int, int> GetMap(const ci::Color& color) const;
+  const ParticleStore &GetParticles() const;
+
+  /**
+   * @return length of the application window
+   */
+  size_t GetWindowLength() const;
+
+  /**
+   * @return width of the application window
+   */
+  size_t GetWindowWidth() const;
+
+  /**
+   * @return size of margin surrounding container
+   */
+  size_t GetMargin() const;
+
+  /**
+   * @return walls the particles move between
+   */
+  const Box &GetBox() const;
+
+  /**
+   * @return color of gas container border
+   */
+  const Color &GetBorderColor() const;
+
+  /**
+   * @return number of bins in each histogram
+   */
+  size_t GetNumBins() const;
+
+  /**
+   * @return most amount of particles in a histogram bin
+   */
+  size_t GetMaxHeight() const;
+
+  /**
+   * @return number of frames advanced so far
+   */
+  int GetFrameCount() const;
+
+  /**
+   * Resolves collisions on the threads of a pool. The results are the same
+   * for any number of threads, but differ slightly from the serial order.
+   * @param pool thread pool to use, or nullptr to resolve collisions serially
+   */
+  void SetThreadPool(ThreadPool *pool);
+
+  /**
+   * Finds colliding pairs of the time-stepped engine in a neighbour list
+   * that is kept from frame to frame, rebuilt only once some particle has
+   * moved more than half the skin. This suits dense gases with small time
+   * steps. Resolved serially, the results are the same as with the grid.
+   * @param skin extra distance kept in the list, or 0 to rebuild the grid
+   * every frame instead
+   * @throws std::invalid_argument if the skin is negative or not finite
+   */
+  void SetNeighborListSkin(double skin);
+
+  /**
+   * @return neighbour list in use, or nullptr if collisions use the grid
+   */
+  const NeighborList *GetNeighborList() const;
+
+  /**
+   * Times the phases of every frame and counts its collisions and wall
+   * hits into a profiler. Only builds with IDEALGAS_PROFILING defined have
+   * the timers; in other builds the profiler receives nothing.
+   * @param profiler profiler to use, or nullptr to stop profiling
+   */
+  void SetFrameProfiler(FrameProfiler *profiler);
+
+  /**
+   * Hands the particles to a recorder after every frame. The recorder
+   * writes them on its own thread.
+   * @param recorder recorder to use, or nullptr to stop recording
+   */
+  void SetTrajectoryRecorder(TrajectoryRecorder *recorder);
+
+  /**
+   * Checks the kinetic energy and momentum against a monitor after every
+   * frame it samples. Energy is checked unless an external field acts, and
+   * momentum only in a periodic box without one. The monitor is rebased
+   * when the particles are replaced or a field changes, and follows
+   * SlowDownParticles and SpeedUpParticles. Sampled frames reuse the
+   * statistics if they are enabled, and otherwise cost one pass over the
+   * particles.
+   * @param monitor monitor to use, or nullptr to stop checking
+   */
+  void SetConservationMonitor(ConservationMonitor *monitor);
+
+  /**
+   * Switches between the time-stepped and event-driven engines.
+   * @param mode engine to advance frames with
+   */
+  void SetEngineMode(EngineMode mode);
+
+  /**
+   * @return engine used to advance frames
+   */
+  EngineMode GetEngineMode() const;
+
+  /**
+   * Picks the integrator the time-stepped engine moves particles with.
+   * @param integrator integrator to use
+   */
+  void SetIntegrator(IntegratorKind integrator);
+
+  /**
+   * @return integrator the time-stepped engine moves particles with
+   */
+  IntegratorKind GetIntegrator() const;
+
+  /**
+   * Sets how much time each frame advances. Velocities are in distance per
+   * unit of time, so the default of 1 moves particles by their velocity.
+   * @param time_step time per frame
+   * @throws std::invalid_argument if the step is not a positive number
+   */
+  void SetTimeStep(float time_step);
+
+  /**
+   * @return time per frame
+   */
+  float GetTimeStep() const;
+
+  /**
+   * Sets a uniform acceleration, such as gravity, on every particle. Fields
+   * only act in the time-stepped engine; the event-driven engine moves
+   * particles in straight lines between collisions.
+   * @param acceleration acceleration, or zero for none
+   */
+  void SetGravity(const glm::vec2 &acceleration);
+
+  /**
+   * Sets an attraction towards a point on every particle, added to gravity.
+   * Like gravity it only acts in the time-stepped engine.
+   * @param field central field, with a strength of zero for none
+   */
+  void SetCentralField(const CentralField &field);
+
+  /**
+   * Turns on computing GasStatistics on every frame. They cost one extra
+   * pass over the particles, so they are off by default.
+   * @param enabled whether to compute statistics
+   */
+  void SetStatisticsEnabled(bool enabled);
+
+  /**
+   * Statistics of the last frame advanced with statistics enabled. In the
+   * time-stepped engine the velocities are those after collisions and
+   * before the move; in the event-driven engine they are those at the end
+   * of the frame. The pressure comes from the wall bounces of the frame.
+   * @return statistics of the last frame
+   */
+  const GasStatistics &GetStatistics() const;
+
+  /**
+   * Saves the particles and frame counter to a checkpoint file.
+   * @param path file to write
+   * @throws std::runtime_error if the file cannot be written
+   */
+  void SaveCheckpoint(const std::string &path) const;
+
+  /**
+   * Replaces the particles and frame counter with those of a checkpoint.
+   * @param path file saved by SaveCheckpoint
+   * @throws std::invalid_argument if the file is not a valid checkpoint or
+   * was saved from a container of another size
+   */
+  void LoadCheckpoint(const std::string &path);
 
   /**
    * Calculates the most amount of particles there are in a histogram bin
@@ -93,23 +367,67 @@ class GasContainer {
   void CalculateMaxHeight();
 
  private:
+  /**
+   * @return the slow, medium and fast particles with their amounts, in the
+   * order they are generated
+   */
+  std::vector<ParticleInitializer::SpeciesAmount> MakeSpecies(
+      size_t slow_amount, size_t medium_amount, size_t fast_amount) const;
+
+  /**
+   * Adds particles of a registered species at random places inside the
+   * walls for their radius, at most as many as fit side by side in the box.
+   * @param particles store of particles
+   * @param species id of the species in the store
+   * @param particle particle to copy the velocity of
+   * @param particle_amount number of particles to add
+   */
+  void AddRandomParticles(ParticleStore &particles, uint8_t species,
+                          const Particle &particle,
+                          size_t particle_amount) const;
+
+  /**
+   * Bounces the particles off the walls and steps them with the chosen
+   * integrator under a field.
+   * @param field external field
+   */
+  template <typename Field>
+  void Integrate(const Field &field);
+
+  /**
+   * @return if gravity or a central field acts on the particles
+   */
+  bool HasField() const;
+
+  /**
+   * Hands the monitor the energy and momentum of the frame just advanced.
+   */
+  void CheckConservation();
+
   int frames = 0;
   const size_t kWindowLength_;       // length of the application window
   const size_t kWindowWidth_;        // width of the application window
   const size_t kMargin_;             // size of margin surrounding container
-  const ci::Color kBorderColor_;     // color of gas container border
-  std::vector<idealgas::Particle> particles_;
-                                     // vector of particles in container
-  std::map<int, int> slow_speeds_;   // map of how many particles are in each bin for the slow particles
-  ci::Color slow_color_ = "green";
-
-  std::map<int, int> medium_speeds_; // medium particles
-  ci::Color medium_color_ = "red";
-
-  std::map<int, int> fast_speeds_;   // fast particles
-  ci::Color fast_color_ = "orange";
+  const Color kBorderColor_;         // color of gas container border
+  const Box kBox_;                   // walls the particles move between
+  std::vector<WallBounds> wall_bounds_;  // wall bounds of each species
+  ParticleStore particles_;          // particles in container
+  SpatialGrid grid_;                 // broad phase for particle collisions
+  std::unique_ptr<NeighborList> neighbor_list_;  // replaces grid_ if set
+  ThreadPool *pool_ = nullptr;       // threads for collisions, not owned
+  TrajectoryRecorder *recorder_ = nullptr;  // frame output, not owned
+  FrameProfiler *profiler_ = nullptr;  // frame timings, not owned
+  ConservationMonitor *monitor_ = nullptr;  // drift alarms, not owned
+  EngineMode engine_mode_ = EngineMode::kTimeStepped;
+  EventDrivenEngine event_engine_;   // engine for EngineMode::kEventDriven
+  IntegratorKind integrator_ = IntegratorKind::kEuler;
+  float time_step_ = 1;              // time advanced by each frame
+  SumField<UniformField, CentralField> field_;  // external acceleration
+  bool statistics_enabled_ = false;  // whether to compute statistics_
+  GasStatistics statistics_;         // statistics of the last frame
 
   const size_t num_bins_ = 12;       // number of bins in each histogram
+  SpeedHistogram histogram_;         // speed bins of each species
   size_t max_height_ = 0;            // most amount of particles in a histogram bin
 };
 
@@ -1,23 +1,27 @@
 #pragma once
 
-#include "cinder/gl/gl.h"
+#include <glm/vec2.hpp>
+
+#include "color.h"
 
 namespace idealgas {
 
 /**
- * A gas particle to put in the gas container.
+ * A gas particle to put in the gas container. The container keeps its
+ * particles in a ParticleStore; this class is the value type used to add
+ * particles to the store and to read a single one back out of it.
  */
 class Particle {
  public:
   Particle(const glm::vec2& position, const glm::vec2& velocity, int mass,
-           int radius, const ci::Color& color);
+           int radius, const Color& color);
 
   double GetSpeed() const;
-  glm::vec2 GetPosition() const;
-  glm::vec2 GetVelocity() const;
+  const glm::vec2 &GetPosition() const;
+  const glm::vec2 &GetVelocity() const;
   double GetMass() const;
   int GetRadius() const;
-  ci::Color GetColor() const;
+  const Color &GetColor() const;
 
   void SetPosition(const glm::vec2& position);
   void SetVelocity(const glm::vec2& velocity);
@@ -27,7 +31,7 @@ class Particle {
   glm::vec2 velocity_;
   double mass_;
   int radius_;
-  ci::Color color_;
+  Color color_;
 };
 
 }  // namespace idealgas
\ No newline at end of file
@@ -0,0 +1,77 @@
+#pragma once
+
+#include <cstddef>
+#include <vector>
+
+#include "box.h"
+#include "particle_store.h"
+#include "thread_pool.h"
+
+namespace idealgas {
+
+/**
+ * Aggregate state of the gas at one frame, in units where Boltzmann's
+ * constant is 1.
+ */
+struct GasStatistics {
+  size_t particle_count = 0;
+  double total_mass = 0;      // sum of the masses
+  double kinetic_energy = 0;  // sum of m v^2 / 2
+  double temperature = 0;     // kT, the kinetic energy per particle in 2D
+  double momentum_x = 0;      // x component of the total momentum
+  double momentum_y = 0;      // y component of the total momentum
+  double max_speed = 0;       // speed of the fastest particle
+  double wall_impulse = 0;    // momentum taken by the walls over the frame
+  double pressure = 0;        // wall impulse per unit of wall and of time
+};
+
+/**
+ * Computes every GasStatistics field in one pass over the particles, rather
+ * than one pass per quantity. The particles are split into fixed blocks
+ * that are reduced on a thread pool, and the partial sums are added in
+ * block order, so the result is the same for any number of threads.
+ */
+class StatisticsReduction {
+ public:
+  /**
+   * Summarizes the particles, with no wall impulse.
+   * @param particles particles to summarize
+   * @param pool threads to reduce on, or nullptr to use this thread
+   * @return statistics of the particles
+   */
+  template <typename T>
+  static GasStatistics Reduce(const BasicParticleStore<T> &particles,
+                              ThreadPool *pool = nullptr);
+
+  /**
+   * Summarizes the particles just before PhysicsEngine::MoveParticles or
+   * ReflectOffWalls, counting the impulse of every bounce those will make.
+   * A bounce reverses one velocity component, so the wall takes twice the
+   * particle's momentum along it. A periodic box has no walls.
+   * @param particles particles about to be moved
+   * @param box box the particles move in
+   * @param species_bounds wall bounds of each species, from
+   * Box::GetSpeciesBounds
+   * @param duration time the move covers, for the pressure
+   * @param pool threads to reduce on, or nullptr to use this thread
+   * @return statistics of the particles and the walls over the move
+   */
+  template <typename T>
+  static GasStatistics ReduceBeforeMove(
+      const BasicParticleStore<T> &particles, const Box &box,
+      const std::vector<WallBounds> &species_bounds, double duration,
+      ThreadPool *pool = nullptr);
+
+  /**
+   * Pressure of a 2D gas on the walls of a box: force per unit length of
+   * wall, which is impulse per unit length and time.
+   * @param wall_impulse momentum the walls took
+   * @param box box whose walls took it
+   * @param duration time over which they took it
+   * @return pressure, or 0 for a periodic box or no time
+   */
+  static double Pressure(double wall_impulse, const Box &box,
+                         double duration);
+};
+
+}  // namespace idealgas
@@ -0,0 +1,226 @@
+#pragma once
+
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+
+#include "particle_store.h"
+
+namespace idealgas {
+
+/**
+ * Integrators that move particles forward by a time step under an external
+ * field. Each one is a policy with a static Step template, so the field and
+ * the update rule are both inlined into one loop with no virtual calls.
+ *
+ * A field gives the acceleration at a position through
+ * `template <typename T> void Accelerate(T x, T y, T &ax, T &ay) const`, and
+ * has a `kIsZero` constant that is true only if it never accelerates
+ * anything. Fields depend on position alone, so each particle is stepped on
+ * its own. Every step runs in the scalar type of the store it is given.
+ */
+
+/**
+ * No external field; particles move in straight lines.
+ */
+struct NoField {
+  static const bool kIsZero = true;
+
+  template <typename T>
+  void Accelerate(T, T, T &ax, T &ay) const {
+    ax = 0;
+    ay = 0;
+  }
+};
+
+/**
+ * The same acceleration everywhere, such as gravity.
+ */
+struct UniformField {
+  static const bool kIsZero = false;
+
+  float x = 0;  // x component of the acceleration
+  float y = 0;  // y component of the acceleration
+
+  template <typename T>
+  void Accelerate(T, T, T &ax, T &ay) const {
+    ax = x;
+    ay = y;
+  }
+};
+
+/**
+ * Attraction towards a point with the potential -strength / r. The
+ * softening length keeps the acceleration finite at the centre.
+ */
+struct CentralField {
+  static const bool kIsZero = false;
+
+  float center_x = 0;   // x coordinate of the centre
+  float center_y = 0;   // y coordinate of the centre
+  float strength = 0;   // strength of the attraction, negative to repel
+  float softening = 1;  // distance below which the pull stops growing
+
+  template <typename T>
+  void Accelerate(T x, T y, T &ax, T &ay) const {
+    T dx = center_x - x;
+    T dy = center_y - y;
+    T squared = dx * dx + dy * dy + T(softening) * softening;
+    T scale = strength / (squared * std::sqrt(squared));
+    ax = scale * dx;
+    ay = scale * dy;
+  }
+};
+
+/**
+ * The sum of two fields.
+ */
+template <typename First, typename Second>
+struct SumField {
+  static const bool kIsZero = First::kIsZero && Second::kIsZero;
+
+  First first;
+  Second second;
+
+  template <typename T>
+  void Accelerate(T x, T y, T &ax, T &ay) const {
+    T first_ax;
+    T first_ay;
+    first.Accelerate(x, y, first_ax, first_ay);
+    second.Accelerate(x, y, ax, ay);
+    ax += first_ax;
+    ay += first_ay;
+  }
+};
+
+/**
+ * Marks every particle's speed as changed if the field can accelerate them.
+ */
+template <typename Field, typename T>
+void MarkAccelerated(BasicParticleStore<T> &particles) {
+  if (Field::kIsZero) {
+    return;
+  }
+  std::fill(particles.SpeedChanged(),
+            particles.SpeedChanged() + particles.Size(), 1);
+}
+
+/**
+ * Explicit Euler: moves by the old velocity, then updates the velocity with
+ * the acceleration at the old position. First order and not symplectic, so
+ * orbits in a field slowly gain energy. With no field it moves each particle
+ * by velocity * dt, exactly as the original frame update did for dt = 1.
+ */
+struct EulerIntegrator {
+  /**
+   * @param particles particles to move
+   * @param field external field
+   * @param dt time step
+   */
+  template <typename Field, typename T>
+  static void Step(BasicParticleStore<T> &particles, const Field &field,
+                   typename BasicParticleStore<T>::Scalar dt) {
+    T *x = particles.PositionX();
+    T *y = particles.PositionY();
+    T *vx = particles.VelocityX();
+    T *vy = particles.VelocityY();
+    const size_t count = particles.Size();
+    for (size_t i = 0; i < count; ++i) {
+      T ax;
+      T ay;
+      field.Accelerate(x[i], y[i], ax, ay);
+      x[i] += vx[i] * dt;
+      y[i] += vy[i] * dt;
+      if (!Field::kIsZero) {
+        vx[i] += ax * dt;
+        vy[i] += ay * dt;
+      }
+    }
+    MarkAccelerated<Field>(particles);
+  }
+};
+
+/**
+ * Velocity Verlet: moves with the old velocity and acceleration, then
+ * updates the velocity with the mean of the old and new accelerations.
+ * Second order and symplectic, at two field evaluations per step.
+ */
+struct VelocityVerletIntegrator {
+  /**
+   * @param particles particles to move
+   * @param field external field
+   * @param dt time step
+   */
+  template <typename Field, typename T>
+  static void Step(BasicParticleStore<T> &particles, const Field &field,
+                   typename BasicParticleStore<T>::Scalar dt) {
+    T *x = particles.PositionX();
+    T *y = particles.PositionY();
+    T *vx = particles.VelocityX();
+    T *vy = particles.VelocityY();
+    const T half_dt = T(0.5) * dt;
+    const size_t count = particles.Size();
+    for (size_t i = 0; i < count; ++i) {
+      if (Field::kIsZero) {
+        x[i] += vx[i] * dt;
+        y[i] += vy[i] * dt;
+        continue;
+      }
+      T ax;
+      T ay;
+      field.Accelerate(x[i], y[i], ax, ay);
+      x[i] += (vx[i] + ax * half_dt) * dt;
+      y[i] += (vy[i] + ay * half_dt) * dt;
+
+      T new_ax;
+      T new_ay;
+      field.Accelerate(x[i], y[i], new_ax, new_ay);
+      vx[i] += (ax + new_ax) * half_dt;
+      vy[i] += (ay + new_ay) * half_dt;
+    }
+    MarkAccelerated<Field>(particles);
+  }
+};
+
+/**
+ * Leapfrog in drift-kick-drift form: half a step of motion, a full velocity
+ * update with the acceleration at the midpoint, then the other half step.
+ * Second order and symplectic like velocity Verlet, with one field
+ * evaluation per step.
+ */
+struct LeapfrogIntegrator {
+  /**
+   * @param particles particles to move
+   * @param field external field
+   * @param dt time step
+   */
+  template <typename Field, typename T>
+  static void Step(BasicParticleStore<T> &particles, const Field &field,
+                   typename BasicParticleStore<T>::Scalar dt) {
+    T *x = particles.PositionX();
+    T *y = particles.PositionY();
+    T *vx = particles.VelocityX();
+    T *vy = particles.VelocityY();
+    const T half_dt = T(0.5) * dt;
+    const size_t count = particles.Size();
+    for (size_t i = 0; i < count; ++i) {
+      if (Field::kIsZero) {
+        x[i] += vx[i] * dt;
+        y[i] += vy[i] * dt;
+        continue;
+      }
+      T mid_x = x[i] + vx[i] * half_dt;
+      T mid_y = y[i] + vy[i] * half_dt;
+      T ax;
+      T ay;
+      field.Accelerate(mid_x, mid_y, ax, ay);
+      vx[i] += ax * dt;
+      vy[i] += ay * dt;
+      x[i] = mid_x + vx[i] * half_dt;
+      y[i] = mid_y + vy[i] * half_dt;
+    }
+    MarkAccelerated<Field>(particles);
+  }
+};
+
+}  // namespace idealgas
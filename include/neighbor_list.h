@@ -0,0 +1,158 @@
+#pragma once
+
+#include <cstdint>
+#include <vector>
+
+#include "box.h"
+#include "particle_store.h"
+#include "spatial_grid.h"
+#include "thread_pool.h"
+
+namespace idealgas {
+
+/**
+ * A Verlet neighbour list: for every particle, the particles with a larger
+ * index that were within touching distance plus a skin when the list was
+ * built. Until some particle has moved more than half the skin, no pair
+ * outside the list can have come into contact, so the list is reused from
+ * frame to frame instead of rebuilding a broad phase every frame.
+ *
+ * The pairs are stored in compressed sparse row form: the neighbours of
+ * particle i are entries [offsets[i], offsets[i + 1]) of one array, in
+ * ascending order. Resolving them in that order visits the touching pairs
+ * in the same order as PhysicsEngine's grid and brute-force overloads.
+ *
+ * For resolving on a thread pool, the list also remembers the particles in
+ * each tile of the grid it was built with, coloured in the same 2x2 pattern
+ * as the grid overload. Tiles of one colour never share a particle or a
+ * neighbour, however far the particles have moved since.
+ */
+class NeighborList {
+ public:
+  /**
+   * @param skin extra distance beyond touching kept in the list
+   * @throws std::invalid_argument if the skin is negative or not finite
+   */
+  explicit NeighborList(double skin);
+
+  /**
+   * Rebuilds the list if it is out of date.
+   * @param particles particles to list
+   * @param box box the particles move in
+   * @param pool threads to rebuild on, or nullptr to use this thread
+   * @return if the list was rebuilt
+   */
+  template <typename T>
+  bool Update(const BasicParticleStore<T> &particles, const Box &box,
+              ThreadPool *pool = nullptr);
+
+  /**
+   * Lists the neighbours of every particle and remembers their positions.
+   * @param particles particles to list
+   * @param box box the particles move in
+   * @param pool threads to rebuild on, or nullptr to use this thread
+   * @throws std::length_error if there are more than 2^32 - 1 particles
+   */
+  template <typename T>
+  void Rebuild(const BasicParticleStore<T> &particles, const Box &box,
+               ThreadPool *pool = nullptr);
+
+  /**
+   * @param particles particles the list was built with
+   * @param box box the particles move in
+   * @return if the list was never built, was invalidated, has a different
+   * number of particles or species, or a particle moved more than half
+   * the skin since it was built
+   */
+  template <typename T>
+  bool NeedsRebuild(const BasicParticleStore<T> &particles,
+                    const Box &box) const;
+
+  /**
+   * Forces a rebuild on the next Update, for when particles were replaced.
+   */
+  void Invalidate();
+
+  /**
+   * @return extra distance beyond touching kept in the list
+   */
+  double GetSkin() const;
+
+  /**
+   * @return offset of each particle's neighbours, one more than particles
+   */
+  const std::vector<uint32_t> &GetOffsets() const;
+
+  /**
+   * @return neighbours of all particles, one after the other
+   */
+  const std::vector<uint32_t> &GetNeighbors() const;
+
+  /**
+   * @return number of pairs in the list
+   */
+  size_t GetPairCount() const;
+
+  /**
+   * @return number of times the list was built
+   */
+  size_t GetRebuildCount() const;
+
+  /**
+   * @return box the list was built in if it was periodic, otherwise nullptr
+   */
+  const Box *GetPeriodicBox() const;
+
+  /**
+   * @return if the tiles can be resolved in parallel; a periodic grid whose
+   * tiles cannot be coloured across its edges is resolved serially
+   */
+  bool HasTiles() const;
+
+  /**
+   * @param colour one of the 4 tile colours
+   * @return number of tiles of the colour
+   */
+  size_t GetTileCount(size_t colour) const;
+
+  /**
+   * @param colour one of the 4 tile colours
+   * @param tile tile of that colour
+   * @param begin set to the first of the tile's particles in GetTileParticles
+   * @param end set to one past the last of them
+   */
+  void GetTileRange(size_t colour, size_t tile, size_t &begin,
+                    size_t &end) const;
+
+  /**
+   * @return particles of every tile, grouped by colour and then by tile, in
+   * ascending order within each tile
+   */
+  const std::vector<uint32_t> &GetTileParticles() const;
+
+ private:
+  /**
+   * Records the particles of each tile of the grid, by colour.
+   */
+  void BuildTiles();
+
+  const double kSkin_;
+  bool valid_ = false;
+  size_t species_count_ = 0;
+  size_t rebuild_count_ = 0;
+  bool periodic_ = false;
+  Box box_ = Box(0, 0, 1, 1);          // box of a periodic list
+  SpatialGrid grid_;                   // broad phase used to build the list
+  std::vector<double> reference_x_;    // positions the list was built at
+  std::vector<double> reference_y_;
+  std::vector<uint32_t> offsets_;      // start of each particle's neighbours
+  std::vector<uint32_t> neighbors_;    // neighbour indices
+  std::vector<std::vector<uint32_t>> block_neighbors_;  // rebuild buffers
+
+  bool has_tiles_ = false;
+  std::vector<uint32_t> tile_particles_;  // particles grouped by tile
+  std::vector<size_t> tile_starts_;       // start of each tile
+  size_t colour_tiles_[5] = {};           // first tile of each colour
+};
+
+}  // namespace idealgas
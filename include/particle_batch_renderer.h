@@ -0,0 +1,93 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+#include "particle_store.h"
+
+namespace idealgas {
+
+/**
+ * Draws every particle of a store as a filled circle in a single instanced
+ * draw call. The particle arrays are copied as they are into a vertex
+ * buffer and read as per-instance attributes: x, y and radius as floats,
+ * and the species id as a byte that picks the colour from a palette.
+ *
+ * With OpenGL 4.4 or ARB_buffer_storage, the buffer is mapped once and
+ * kept mapped. It is split into three regions used in turn, and a fence per
+ * region keeps the CPU from overwriting data the GPU has not drawn yet.
+ * Older contexts re-specify the buffer every frame instead.
+ *
+ * Uses plain OpenGL 3.3 core calls, so it needs a current context but no
+ * windowing library. Bindings it changes are restored after each draw.
+ */
+class ParticleBatchRenderer {
+ public:
+  /**
+   * Compiles the shaders and creates the buffers in the current context.
+   * @throws std::runtime_error if the shaders do not compile
+   */
+  ParticleBatchRenderer();
+
+  /**
+   * Deletes the GL objects. The context they were made in must be current.
+   */
+  ~ParticleBatchRenderer();
+
+  ParticleBatchRenderer(const ParticleBatchRenderer &) = delete;
+  ParticleBatchRenderer &operator=(const ParticleBatchRenderer &) = delete;
+
+  /**
+   * Draws the particles.
+   * @param particles particles to draw
+   * @param view_projection column-major 4x4 matrix from particle
+   * coordinates to clip space
+   */
+  void Draw(const ParticleStore &particles, const float *view_projection);
+
+  /**
+   * @return if the instance buffer is persistently mapped
+   */
+  bool IsPersistentlyMapped() const;
+
+  /**
+   * @return number of particles the instance buffer has room for
+   */
+  size_t GetCapacity() const;
+
+ private:
+  static const size_t kRegionCount = 3;  // frames the GPU may lag behind
+
+  /**
+   * Makes room for at least a number of particles in every region.
+   */
+  void Reserve(size_t count);
+
+  /**
+   * Copies the particle arrays into the region of the current frame.
+   * @return byte offset of the region in the buffer
+   */
+  size_t Upload(const ParticleStore &particles);
+
+  /**
+   * Deletes the instance buffer and its fences.
+   */
+  void ReleaseInstanceBuffer();
+
+  // GL object names, as GLuint.
+  unsigned int program_ = 0;
+  unsigned int vertex_array_ = 0;
+  unsigned int quad_buffer_ = 0;
+  unsigned int instance_buffer_ = 0;
+  int view_projection_location_ = -1;
+  int palette_location_ = -1;
+
+  bool buffer_storage_ = false;   // if persistent mapping is available
+  size_t capacity_ = 0;           // particles per region
+  size_t region_size_ = 0;        // bytes per region
+  size_t region_ = 0;             // region of the next frame
+  unsigned char *mapped_ = nullptr;      // start of the mapped buffer
+  void *fences_[kRegionCount] = {};      // GLsync of each region's last draw
+};
+
+}  // namespace idealgas
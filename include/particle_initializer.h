@@ -0,0 +1,109 @@
+#pragma once
+
+#include <cstdint>
+#include <vector>
+
+#include "box.h"
+#include "gas_particle.h"
+#include "particle_store.h"
+#include "philox.h"
+#include "thread_pool.h"
+
+namespace idealgas {
+
+/**
+ * Fills a box with particles from a seed. Every particle draws its numbers
+ * from its own Philox stream, so the particles are the same on every
+ * platform and for any number of threads.
+ */
+class ParticleInitializer {
+ public:
+  /**
+   * Where the particles start.
+   */
+  enum class Placement {
+    kUniform,     // anywhere in the box, overlaps allowed
+    kLattice,     // on a rectangular lattice covering the box
+    kPoissonDisk  // random, but no two particles overlap
+  };
+
+  /**
+   * A number of particles of one kind.
+   */
+  struct SpeciesAmount {
+    Particle prototype;  // particle to copy, with its starting velocity
+    size_t amount;       // number of copies
+  };
+
+  struct Options {
+    uint64_t seed = 0;                             // seed of every stream
+    Placement placement = Placement::kPoissonDisk;
+    bool maxwell_boltzmann = false;  // draw velocities instead of copying
+    double temperature = 4;          // kT, for Maxwell-Boltzmann velocities
+    size_t max_attempts = 100;       // tries per particle for Poisson disk
+  };
+
+  /**
+   * @param options how to place the particles and give them velocities
+   */
+  explicit ParticleInitializer(const Options &options);
+
+  /**
+   * Replaces the contents of a store with new particles. Each entry of the
+   * list is a species with the id of its position, and the particles are
+   * numbered by species; particle i uses the streams of item i.
+   *
+   * Maxwell-Boltzmann velocities have each component normally distributed
+   * with variance kT / mass, so every species has the same temperature.
+   * @param box box to place the particles in, inside its walls
+   * @param species kinds and numbers of particles
+   * @param particles store to fill
+   * @param pool threads to generate on, or nullptr to use this thread
+   * @throws std::invalid_argument if a lattice with room for every particle
+   * does not fit in the box
+   * @throws std::runtime_error if Poisson-disk placement runs out of
+   * attempts for a particle
+   */
+  void Generate(const Box &box, const std::vector<SpeciesAmount> &species,
+                ParticleStore &particles, ThreadPool *pool = nullptr) const;
+
+ private:
+  /**
+   * Places each particle uniformly inside the walls for its radius.
+   */
+  void PlaceUniformly(const Box &box, ParticleStore &particles,
+                      ThreadPool *pool) const;
+
+  /**
+   * Places the particles on the sites of a lattice, in an order that mixes
+   * the species.
+   */
+  void PlaceOnLattice(const Box &box, ParticleStore &particles,
+                      ThreadPool *pool) const;
+
+  /**
+   * Places the particles one species at a time, in rounds. In each round
+   * every particle of the species not yet placed tries its next candidate
+   * position, which is kept if it overlaps no particle placed before it;
+   * candidates are taken in cell order and, within a cell, in particle
+   * order.
+   */
+  void PlacePoissonDisk(const Box &box, ParticleStore &particles,
+                        ThreadPool *pool) const;
+
+  /**
+   * @return bounds a particle's centre is drawn from: inside the walls for
+   * its radius, or anywhere in a periodic box
+   */
+  static WallBounds PositionBounds(const Box &box, float radius);
+
+  /**
+   * Draws a candidate position from the bounds of PositionBounds.
+   */
+  static void DrawPosition(const WallBounds &bounds, bool periodic,
+                           PhiloxStream &stream, float &x, float &y);
+
+  const Options kOptions_;
+};
+
+}  // namespace idealgas
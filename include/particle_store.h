@@ -0,0 +1,171 @@
+#pragma once
+
+#include <cstdint>
+#include <vector>
+
+#include "color.h"
+#include "gas_particle.h"
+
+namespace idealgas {
+
+/**
+ * A kind of particle. Particles with the same colour, mass and radius
+ * belong to the same species.
+ */
+struct ParticleSpecies {
+  Color color;
+  int mass;
+  int radius;
+};
+
+/**
+ * Stores particles as a structure of arrays, so that loops which only need
+ * positions and velocities stream through dense arrays. Colour, mass and
+ * radius are shared per species and only looked up when needed.
+ *
+ * The arrays hold one scalar type throughout, so the loops over them never
+ * convert between precisions. ParticleStore uses float, which packs twice
+ * as many particles into each vector register; DoubleParticleStore uses
+ * double, which conserves energy better over long runs. Both are compiled
+ * into the library.
+ * @tparam T float or double
+ */
+template <typename T>
+class BasicParticleStore {
+ public:
+  typedef T Scalar;
+  typedef ParticleSpecies Species;
+
+  BasicParticleStore();
+
+  /**
+   * @return number of particles in the store
+   */
+  size_t Size() const;
+
+  /**
+   * Removes all particles and species.
+   */
+  void Clear();
+
+  /**
+   * Reserves room for a number of particles.
+   * @param capacity number of particles
+   */
+  void Reserve(size_t capacity);
+
+  /**
+   * Appends a particle, registering its species if it is new. This compares
+   * the particle against every registered species; loops adding many
+   * particles of one species should register it once and add by id.
+   * @param particle particle to copy into the store
+   */
+  void Add(const Particle &particle);
+
+  /**
+   * Appends a particle of a registered species.
+   * @param species species id, from AddSpecies
+   * @param x, y position
+   * @param vx, vy velocity
+   * @throws std::invalid_argument if the species is not registered
+   */
+  void Add(uint8_t species, T x, T y, T vx, T vy);
+
+  /**
+   * Registers a species, or finds the registered one with the same colour,
+   * mass and radius.
+   * @param species species to register
+   * @return id of the species
+   * @throws std::length_error if 256 species are already registered
+   */
+  uint8_t AddSpecies(const Species &species);
+
+  /**
+   * Replaces every particle and species with the given arrays, for loading
+   * saved state without going through Particle.
+   * @param species species table
+   * @param count number of particles
+   * @param x, y positions
+   * @param vx, vy velocities
+   * @param inverse_mass 1 / mass of each particle
+   * @param radius radius of each particle
+   * @param species_id species id of each particle
+   */
+  void Assign(const std::vector<Species> &species, size_t count,
+              const T *x, const T *y, const T *vx, const T *vy,
+              const T *inverse_mass, const T *radius,
+              const uint8_t *species_id);
+
+  /**
+   * Replaces every particle and species with the given number of particles
+   * of each species, numbered in species order. The particles start at the
+   * origin and at rest, for the caller to fill in.
+   * @param species species table
+   * @param counts number of particles of each species
+   * @throws std::invalid_argument if there is not one count per species
+   */
+  void Reset(const std::vector<Species> &species,
+             const std::vector<size_t> &counts);
+
+  /**
+   * @param index index of particle
+   * @return copy of the particle at the index
+   */
+  Particle Get(size_t index) const;
+
+  /**
+   * Writes the position and velocity of a particle back into the store.
+   * @param index index of particle
+   * @param particle particle holding the new state
+   */
+  void Set(size_t index, const Particle &particle);
+
+  /**
+   * @param id species id
+   * @return the species with the given id
+   */
+  const Species &GetSpecies(uint8_t id) const;
+
+  /**
+   * @return number of registered species
+   */
+  size_t SpeciesCount() const;
+
+  T *PositionX();
+  T *PositionY();
+  T *VelocityX();
+  T *VelocityY();
+  const T *PositionX() const;
+  const T *PositionY() const;
+  const T *VelocityX() const;
+  const T *VelocityY() const;
+  const T *InverseMass() const;
+  const T *Radius() const;
+  const uint8_t *SpeciesId() const;
+
+  /**
+   * Marks of particles whose speed may have changed, set by collisions and
+   * cleared by SpeedHistogram. Wall bounces keep the speed and set no mark.
+   */
+  uint8_t *SpeedChanged();
+  const uint8_t *SpeedChanged() const;
+
+ private:
+  std::vector<T> x_;             // x coordinates of positions
+  std::vector<T> y_;             // y coordinates of positions
+  std::vector<T> vx_;            // x components of velocities
+  std::vector<T> vy_;            // y components of velocities
+  std::vector<T> inverse_mass_;  // 1 / mass of each particle
+  std::vector<T> radius_;        // radius of each particle
+  std::vector<uint8_t> species_;     // species id of each particle
+  std::vector<uint8_t> speed_changed_;  // if each particle's speed changed
+  std::vector<Species> species_table_;
+};
+
+extern template class BasicParticleStore<float>;
+extern template class BasicParticleStore<double>;
+
+typedef BasicParticleStore<float> ParticleStore;
+typedef BasicParticleStore<double> DoubleParticleStore;
+
+}  // namespace idealgas
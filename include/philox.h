@@ -0,0 +1,120 @@
+#pragma once
+
+#include <cmath>
+#include <cstdint>
+
+namespace idealgas {
+
+/**
+ * The Philox4x32-10 counter-based random number generator of Salmon et al.,
+ * "Parallel random numbers: as easy as 1, 2, 3". Each call maps a 128 bit
+ * counter and a 64 bit key to 128 random bits, with no state carried from
+ * one call to the next. Giving every particle its own counter lets any
+ * thread generate any particle, and the result does not depend on which
+ * thread did it or in what order.
+ */
+class Philox {
+ public:
+  /**
+   * Four 32 bit words, used for both counters and results.
+   */
+  struct Block {
+    uint32_t word[4];
+  };
+
+  /**
+   * @param counter counter to encrypt
+   * @param key_low low 32 bits of the key
+   * @param key_high high 32 bits of the key
+   * @return 128 random bits for the counter
+   */
+  static Block Generate(Block counter, uint32_t key_low, uint32_t key_high) {
+    for (int round = 0; round < kRounds; ++round) {
+      if (round > 0) {
+        key_low += kWeyl0;
+        key_high += kWeyl1;
+      }
+      uint64_t product0 = static_cast<uint64_t>(kMultiplier0) *
+                          counter.word[0];
+      uint64_t product1 = static_cast<uint64_t>(kMultiplier1) *
+                          counter.word[2];
+      counter = {{static_cast<uint32_t>(product1 >> 32) ^ counter.word[1] ^
+                      key_low,
+                  static_cast<uint32_t>(product1),
+                  static_cast<uint32_t>(product0 >> 32) ^ counter.word[3] ^
+                      key_high,
+                  static_cast<uint32_t>(product0)}};
+    }
+    return counter;
+  }
+
+ private:
+  static const int kRounds = 10;
+  static const uint32_t kMultiplier0 = 0xD2511F53;
+  static const uint32_t kMultiplier1 = 0xCD9E8D57;
+  static const uint32_t kWeyl0 = 0x9E3779B9;  // golden ratio
+  static const uint32_t kWeyl1 = 0xBB67AE85;  // sqrt(3) - 1
+};
+
+/**
+ * A stream of random numbers for one item, such as one particle. Streams
+ * with the same seed, item and purpose give the same numbers on every
+ * platform; any other combination gives an independent stream.
+ */
+class PhiloxStream {
+ public:
+  /**
+   * @param seed seed of the whole run
+   * @param item index of the item the numbers are for
+   * @param purpose what the numbers are used for, so that one item can have
+   *                several independent streams
+   */
+  PhiloxStream(uint64_t seed, uint64_t item, uint32_t purpose)
+      : seed_(seed), counter_{{static_cast<uint32_t>(item),
+                               static_cast<uint32_t>(item >> 32), purpose,
+                               0}} { }
+
+  /**
+   * @return next 32 random bits
+   */
+  uint32_t Next() {
+    if (used_ == 4) {
+      block_ = Philox::Generate(counter_, static_cast<uint32_t>(seed_),
+                                static_cast<uint32_t>(seed_ >> 32));
+      ++counter_.word[3];
+      used_ = 0;
+    }
+    return block_.word[used_++];
+  }
+
+  /**
+   * @return uniform number in [0, 1)
+   */
+  float NextUniform() {
+    return static_cast<float>(Next() >> 8) * (1.0f / 16777216.0f);
+  }
+
+  /**
+   * Draws two independent numbers from the standard normal distribution
+   * with the Box-Muller transform.
+   * @param first set to a number with mean 0 and deviation 1
+   * @param second set to another such number
+   */
+  void NextNormalPair(double &first, double &second) {
+    // 1 - u lies in (0, 1], so the logarithm is finite.
+    double radius = std::sqrt(-2.0 * std::log(1.0 - NextUniform()));
+    double angle = kTwoPi * NextUniform();
+    first = radius * std::cos(angle);
+    second = radius * std::sin(angle);
+  }
+
+ private:
+  static constexpr double kTwoPi = 6.283185307179586;
+
+  uint64_t seed_;
+  Philox::Block counter_;
+  Philox::Block block_ = Philox::Block();
+  int used_ = 4;  // words of block_ already returned
+};
+
+}  // namespace idealgas
@@ -1,12 +1,25 @@
 #pragma once
 
-#include "cinder/gl/gl.h"
+#include <glm/vec2.hpp>
+#include <vector>
+
+#include "box.h"
+#include "frame_profiler.h"
 #include "gas_particle.h"
+#include "integrator.h"
+#include "neighbor_list.h"
+#include "particle_store.h"
+#include "spatial_grid.h"
+#include "thread_pool.h"
 
 namespace idealgas {
 
 /**
  * The engine which runs all the calculations for the particles in the gas container.
+ *
+ * The functions on a particle store are templates over its scalar type, and
+ * every calculation on a store runs in that type. They are compiled for
+ * ParticleStore and DoubleParticleStore.
  */
 class PhysicsEngine {
  public:
@@ -19,6 +32,13 @@ class PhysicsEngine {
                                     const size_t margin,
                                             Particle &particle);
 
+  /**
+   * Sets new velocity after hitting a wall of a box.
+   * @param box walls to bounce off
+   * @param particle particle to bounce
+   */
+  static void ParticleWallCollision(const Box &box, Particle &particle);
+
   /**
    * Detects if there is a collision between two particles.
    * @param p1 first particle
@@ -27,10 +47,184 @@ class PhysicsEngine {
    */
   static bool DetectCollision(const Particle &p1, const Particle &p2);
 
+  /**
+   * Detects if there is a collision between two particles in a box, using
+   * the nearest periodic image of the second particle in a periodic box.
+   * @param p1 first particle
+   * @param p2 second particle
+   * @param box box the particles move in
+   * @return if there is a collision
+   */
+  static bool DetectCollision(const Particle &p1, const Particle &p2,
+                              const Box &box);
+
   /**
    * Sets new velocities of particles that have collided.
    */
-  static void AdjustVelocitiesOnCollision(std::vector<idealgas::Particle> &particles);
+  template <typename T>
+  static void AdjustVelocitiesOnCollision(BasicParticleStore<T> &particles);
+
+  /**
+   * Sets new velocities of particles that have collided, only testing pairs
+   * that share or neighbor a grid cell. Pairs are resolved in the same order
+   * as the brute-force overload, so both produce identical results. A grid
+   * rebuilt over a periodic box also finds pairs across the edges, and
+   * measures them between nearest images.
+   * @param particles particles the grid was last rebuilt with
+   * @param grid broad phase grid
+   */
+  template <typename T>
+  static void AdjustVelocitiesOnCollision(BasicParticleStore<T> &particles,
+                                          const SpatialGrid &grid);
+
+  /**
+   * Sets new velocities of particles that have collided, spread over the
+   * threads of a pool. The grid is split into square tiles coloured in a
+   * 2x2 pattern, and all tiles of one colour are resolved in parallel before
+   * moving on to the next colour. Tiles of the same colour never touch the
+   * same particles, so the result is the same for any number of threads.
+   * A periodic grid whose tiles cannot be coloured that way across its
+   * edges is resolved serially instead.
+   * @param particles particles the grid was last rebuilt with
+   * @param grid broad phase grid
+   * @param pool thread pool to run the tiles on
+   */
+  template <typename T>
+  static void AdjustVelocitiesOnCollision(BasicParticleStore<T> &particles,
+                                          const SpatialGrid &grid,
+                                          ThreadPool &pool);
+
+  /**
+   * Sets new velocities of particles that have collided, only testing the
+   * pairs in a neighbour list. Pairs are resolved in the same order as the
+   * grid and brute-force overloads, so all of them produce identical
+   * results while the list is up to date.
+   * @param particles particles the list was last updated with
+   * @param list neighbour list
+   */
+  template <typename T>
+  static void AdjustVelocitiesOnCollision(BasicParticleStore<T> &particles,
+                                          const NeighborList &list);
+
+  /**
+   * Sets new velocities of particles that have collided, spread over the
+   * threads of a pool by the tiles the neighbour list was built with. Like
+   * the grid overload, a list without tiles is resolved serially.
+   * @param particles particles the list was last updated with
+   * @param list neighbour list
+   * @param pool thread pool to run the tiles on
+   */
+  template <typename T>
+  static void AdjustVelocitiesOnCollision(BasicParticleStore<T> &particles,
+                                          const NeighborList &list,
+                                          ThreadPool &pool);
+
+  /**
+   * Updates the velocities of two stored particles if they are colliding.
+   * This matches DetectCollision followed by GetVelocityAfterCollision for
+   * both particles, but reads the dense arrays directly.
+   * @param particles particle store
+   * @param i index of first particle
+   * @param j index of second particle
+   * @return if the particles collided
+   */
+  template <typename T>
+  static bool ResolveCollision(BasicParticleStore<T> &particles, size_t i,
+                               size_t j);
+
+  /**
+   * Updates the velocities of two stored particles if they are colliding,
+   * measuring between nearest images in a periodic box.
+   * @param particles particle store
+   * @param i index of first particle
+   * @param j index of second particle
+   * @param box box the particles move in
+   * @return if the particles collided
+   */
+  template <typename T>
+  static bool ResolveCollision(BasicParticleStore<T> &particles, size_t i,
+                               size_t j, const Box &box);
+
+  /**
+   * Bounces all particles off the container walls and then moves each one by
+   * its velocity, the same as ParticleWallCollision followed by a position
+   * update for every particle. Runs the widest batched kernel the processor
+   * supports. In a periodic box the particles are moved and wrapped back
+   * into the box instead.
+   * @param box walls to bounce off
+   * @param species_bounds wall bounds of each species, from
+   * Box::GetSpeciesBounds
+   * @param particles particle store
+   */
+  template <typename T>
+  static void MoveParticles(const Box &box,
+                            const std::vector<WallBounds> &species_bounds,
+                            BasicParticleStore<T> &particles);
+
+  /**
+   * MoveParticles with the wall bounds worked out on every call. Callers
+   * that move the same species frame after frame should keep the bounds
+   * and pass them in instead.
+   * @param box walls to bounce off
+   * @param particles particle store
+   */
+  template <typename T>
+  static void MoveParticles(const Box &box, BasicParticleStore<T> &particles) {
+    MoveParticles(box, box.GetSpeciesBounds(particles), particles);
+  }
+
+  /**
+   * Bounces all particles off the container walls and then steps them with
+   * an integrator under an external field. MoveParticles above is the fast
+   * path for EulerIntegrator with no field and a step of 1. In a periodic
+   * box the particles are stepped and then wrapped back into the box.
+   * @tparam Integrator integrator policy, such as VelocityVerletIntegrator
+   * @param box box the particles move in
+   * @param species_bounds wall bounds of each species, from
+   * Box::GetSpeciesBounds
+   * @param particles particle store
+   * @param field external field, such as NoField or UniformField
+   * @param dt time step
+   */
+  template <typename Integrator, typename Field, typename T>
+  static void MoveParticles(const Box &box,
+                            const std::vector<WallBounds> &species_bounds,
+                            BasicParticleStore<T> &particles,
+                            const Field &field,
+                            typename BasicParticleStore<T>::Scalar dt) {
+    if (box.IsPeriodic()) {
+      IDEALGAS_PROFILE_PHASE(FramePhase::kIntegration);
+      Integrator::Step(particles, field, dt);
+      WrapIntoBox(box, particles);
+      return;
+    }
+    {
+      IDEALGAS_PROFILE_PHASE(FramePhase::kWalls);
+      ReflectOffWalls(species_bounds, particles);
+    }
+    IDEALGAS_PROFILE_PHASE(FramePhase::kIntegration);
+    Integrator::Step(particles, field, dt);
+  }
+
+  /**
+   * Bounces all particles off the container walls without moving them, the
+   * same as ParticleWallCollision for every particle.
+   * @param species_bounds wall bounds of each species, from
+   * Box::GetSpeciesBounds
+   * @param particles particle store
+   */
+  template <typename T>
+  static void ReflectOffWalls(const std::vector<WallBounds> &species_bounds,
+                              BasicParticleStore<T> &particles);
+
+  /**
+   * Moves particles that have left a periodic box back in through the
+   * opposite edge.
+   * @param box periodic box
+   * @param particles particle store
+   */
+  template <typename T>
+  static void WrapIntoBox(const Box &box, BasicParticleStore<T> &particles);
 
   /**
    * Gets the new velocity after a collision.
@@ -39,6 +233,32 @@ class PhysicsEngine {
    * @return new velocity vec2 after collision
    */
   static glm::vec2 GetVelocityAfterCollision(const Particle &p1, const Particle &p2);
+
+  /**
+   * Gets the new velocity after a collision in a box, using the nearest
+   * periodic image of the second particle in a periodic box.
+   * @param p1 first particle
+   * @param p2 second particle
+   * @param box box the particles move in
+   * @return new velocity vec2 after collision
+   */
+  static glm::vec2 GetVelocityAfterCollision(const Particle &p1,
+                                             const Particle &p2,
+                                             const Box &box);
+
+ private:
+  /**
+   * Updates the velocities of two stored particles if they are colliding.
+   * @param particles particle store
+   * @param i index of first particle
+   * @param j index of second particle
+   * @param dx x coordinate of the first particle minus the second
+   * @param dy y coordinate of the first particle minus the second
+   * @return if the particles collided
+   */
+  template <typename T>
+  static bool ResolveCollision(BasicParticleStore<T> &particles, size_t i,
+                               size_t j, T dx, T dy);
 };
 
 }  // namespace idealgas
\ No newline at end of file
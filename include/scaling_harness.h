@@ -0,0 +1,143 @@
+#pragma once
+
+#include <cstdint>
+#include <istream>
+#include <ostream>
+#include <string>
+#include <vector>
+
+namespace idealgas {
+
+/**
+ * What the scaling harness runs. Every combination of a particle count and
+ * a thread count is one run.
+ */
+struct ScalingOptions {
+  std::vector<size_t> particle_counts = {1000, 10000, 100000, 1000000};
+  std::vector<size_t> thread_counts = {0, 1, 2, 4};  // 0 runs on this thread
+  size_t steps = 50;          // frames timed in each run
+  double area_fraction = 0.2; // share of the box covered by particles
+  int radius = 2;             // radius of every particle
+  int mass = 1;               // mass of every particle
+  double temperature = 0.5;   // kT of the Maxwell-Boltzmann velocities
+  double skin = 0;            // neighbour list skin, 0 to use the grid
+  uint64_t seed = 1;          // seed of the initializer
+};
+
+/**
+ * What one run of the scaling harness measured.
+ */
+struct ScalingResult {
+  size_t particles = 0;
+  size_t threads = 0;
+  size_t steps = 0;
+  bool succeeded = false;         // if the run finished
+  std::string error;              // why the run failed, if it did
+  double elapsed_ms = 0;          // wall-clock time of the timed frames
+  double particle_steps_per_second = 0;
+  uint64_t peak_rss_bytes = 0;    // peak resident memory, 0 if unknown
+  double energy_drift = 0;        // |E_end - E_start| / E_start
+};
+
+/**
+ * How far results may fall behind a baseline before they count as a
+ * regression.
+ */
+struct ScalingTolerance {
+  double throughput = 0.25;    // fraction of the baseline throughput lost
+  double peak_rss = 0.25;      // fraction of the baseline memory gained
+  double energy_drift = 1e-4;  // drift allowed above the baseline's
+};
+
+/**
+ * Runs the time-stepped engine on boxes of one species at a fixed density,
+ * from a few thousand particles up to millions, and measures how it
+ * scales with the particle count and the number of threads.
+ *
+ * Runs use a seeded ParticleInitializer, which throws when the particles
+ * do not fit rather than quietly making fewer, so every run advances
+ * exactly the particles asked for.
+ */
+class ScalingHarness {
+ public:
+  /**
+   * @param options particle counts, thread counts and the gas to run
+   * @throws std::invalid_argument if the options cannot describe a box
+   */
+  explicit ScalingHarness(const ScalingOptions &options);
+
+  /**
+   * Fills a box with particles, times the frames and measures the drift in
+   * kinetic energy over them. Failures are reported in the result rather
+   * than thrown, so one run that does not fit does not stop the rest.
+   * @param particles number of particles
+   * @param threads threads in the pool, or 0 to run on this thread
+   * @return what the run measured
+   */
+  ScalingResult Run(size_t particles, size_t threads) const;
+
+  /**
+   * Runs every combination of the options, one after another so the runs
+   * do not share the machine.
+   * @return results ordered by particle count, then thread count
+   */
+  std::vector<ScalingResult> Run() const;
+
+  /**
+   * @return length of the side of the square box that holds a number of
+   * particles at the configured area fraction
+   */
+  double GetBoxLength(size_t particles) const;
+
+  /**
+   * Writes results as a table of tab-separated values with a header row
+   * and one row per run. ReadResults reads the table back.
+   * @param output stream to write to
+   * @param results results to write
+   */
+  static void WriteResults(std::ostream &output,
+                           const std::vector<ScalingResult> &results);
+
+  /**
+   * Reads a table written by WriteResults.
+   * @param input stream to read from
+   * @param source name of the stream, for error messages
+   * @return results in the order of the rows
+   * @throws std::invalid_argument if a row is malformed
+   */
+  static std::vector<ScalingResult> ReadResults(std::istream &input,
+                                                const std::string &source);
+
+  /**
+   * Compares results with a baseline run with the same particle and thread
+   * counts. A run with no baseline row, and a baseline row with no run, are
+   * reported too, so the two cannot silently drift apart. Peak memory is
+   * only compared when both sides measured it.
+   * @param results results to check
+   * @param baseline results to check against
+   * @param tolerance how far results may fall behind
+   * @return a description of each regression, empty if there are none
+   */
+  static std::vector<std::string> FindRegressions(
+      const std::vector<ScalingResult> &results,
+      const std::vector<ScalingResult> &baseline,
+      const ScalingTolerance &tolerance);
+
+  /**
+   * @return the most memory the process has had resident, in bytes, since
+   * it started or since the last ResetPeakResidentBytes, or 0 if the
+   * platform does not say
+   */
+  static uint64_t GetPeakResidentBytes();
+
+  /**
+   * Starts a new peak of resident memory where the platform allows it, so
+   * each run measures its own peak. Elsewhere peaks only ever grow.
+   */
+  static void ResetPeakResidentBytes();
+
+ private:
+  ScalingOptions options_;
+};
+
+}  // namespace idealgas
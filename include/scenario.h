@@ -0,0 +1,92 @@
+#pragma once
+
+#include <istream>
+#include <string>
+#include <vector>
+
+#include "box.h"
+#include "gas_container.h"
+#include "particle_initializer.h"
+
+namespace idealgas {
+
+/**
+ * Everything needed to set up and run one simulation without a window.
+ */
+struct Scenario {
+  std::string name = "scenario";  // names the run and its output files
+  size_t window_length = 800;     // container size, kept in checkpoints
+  size_t window_width = 1280;
+  size_t margin = 80;
+  Box box = Box::FromWindow(800, 80);  // walls the particles move between
+  std::vector<ParticleInitializer::SpeciesAmount> species;
+  ParticleInitializer::Options initializer;  // seed, placement, velocities
+  EngineMode engine = EngineMode::kTimeStepped;
+  IntegratorKind integrator = IntegratorKind::kEuler;
+  float time_step = 1;              // time per frame
+  double skin = 0;                  // neighbour list skin, 0 for the grid
+  size_t steps = 0;                 // frames to advance
+  std::string checkpoint_path;      // checkpoint after the last frame, if set
+  std::string trajectory_path;      // trajectory of the run, if set
+  size_t record_every = 1;          // frames per recorded trajectory frame
+};
+
+/**
+ * Reads scenarios from a text file. Each line is blank, a comment starting
+ * with '#', a "key = value" setting, or a "[species]" header that starts
+ * the settings of a new species. Settings before the first header are
+ * those of the run:
+ *
+ *   name = dilute
+ *   box = 0 0 2000 1000       # min x, min y, max x, max y
+ *   boundary = reflecting     # or periodic
+ *   window = 800 1280 80      # length, width and margin of the container
+ *   engine = time-stepped     # or event-driven
+ *   integrator = euler        # or verlet, leapfrog
+ *   dt = 1
+ *   skin = 2                  # neighbour list skin, 0 rebuilds the grid
+ *   steps = 1000
+ *   seed = 1
+ *   init = poisson            # or uniform, lattice
+ *   temperature = 4           # draws Maxwell-Boltzmann velocities
+ *   checkpoint = {name}.ckpt  # {name} is replaced by the run's name
+ *   trajectory = {name}.traj
+ *   record_every = 10
+ *
+ *   [species]
+ *   color = red
+ *   mass = 10
+ *   radius = 12
+ *   velocity = 1 2
+ *   count = 200
+ *
+ * A "sweep key = a, b, c" line runs the scenario once for every value of
+ * the key. Species settings are swept as "species.<index>.<key>". Several
+ * sweeps give every combination of their values, and each run's name gets
+ * "_key=value" appended for every swept key.
+ */
+class ScenarioFile {
+ public:
+  /**
+   * Parses scenarios and expands their sweeps.
+   * @param input text to parse
+   * @param source name of the text, used in error messages
+   * @return one scenario per run, in sweep order with the last sweep
+   * changing fastest
+   * @throws std::invalid_argument if a line is malformed, a key is unknown
+   * or set twice, a value is out of range, or there are no species
+   */
+  static std::vector<Scenario> Parse(std::istream &input,
+                                     const std::string &source = "scenario");
+
+  /**
+   * Reads and parses a scenario file.
+   * @param path file to read
+   * @return one scenario per run
+   * @throws std::runtime_error if the file cannot be read
+   * @throws std::invalid_argument if it is not a valid scenario
+   */
+  static std::vector<Scenario> Load(const std::string &path);
+};
+
+}  // namespace idealgas
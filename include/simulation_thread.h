@@ -0,0 +1,139 @@
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include "gas_container.h"
+#include "triple_buffer.h"
+
+namespace idealgas {
+
+/**
+ * What the draw side needs from the container at one point in time.
+ */
+struct SimulationSnapshot {
+  /**
+   * Copies the container into the snapshot. Once the snapshot has held a
+   * container of the same size, this reuses its memory and does not
+   * allocate.
+   * @param container container to copy
+   */
+  void CopyFrom(const GasContainer &container);
+
+  ParticleStore particles;
+  std::vector<std::vector<uint32_t>> species_speeds;  // histogram by species
+  size_t max_height = 0;  // most particles in a histogram bin
+  int frame = 0;          // frame counter of the container
+};
+
+/**
+ * Advances a gas container on a thread of its own, so the simulation rate
+ * does not depend on how fast frames are drawn. After each group of
+ * substeps the thread publishes a snapshot, which the draw side reads
+ * without locking.
+ *
+ * While the thread runs it owns the container. Anything that changes the
+ * container must be posted as a command, which runs between steps.
+ */
+class SimulationThread {
+ public:
+  struct Options {
+    size_t substeps = 1;              // frames advanced per snapshot
+    double snapshot_rate = 60;        // snapshots per second at a fixed rate
+    bool as_fast_as_possible = false; // advance without waiting
+  };
+
+  /**
+   * @param container container to advance, which must outlive the thread
+   * @param options how fast to advance
+   */
+  SimulationThread(GasContainer &container, const Options &options);
+
+  /**
+   * Stops the thread.
+   */
+  ~SimulationThread();
+
+  SimulationThread(const SimulationThread &) = delete;
+  SimulationThread &operator=(const SimulationThread &) = delete;
+
+  /**
+   * Publishes a first snapshot and starts advancing the container.
+   */
+  void Start();
+
+  /**
+   * Stops advancing the container and waits for the thread to finish.
+   * Commands still queued are run before it returns.
+   */
+  void Stop();
+
+  /**
+   * Runs a command on the simulation thread before its next step, or right
+   * away if the thread is not running.
+   * @param command command to run with the container
+   */
+  void Post(std::function<void(GasContainer &)> command);
+
+  /**
+   * @param substeps frames advanced per snapshot
+   */
+  void SetSubsteps(size_t substeps);
+
+  /**
+   * @param as_fast_as_possible if the thread should advance without waiting
+   */
+  void SetAsFastAsPossible(bool as_fast_as_possible);
+
+  /**
+   * @return if the thread advances without waiting
+   */
+  bool IsAsFastAsPossible() const;
+
+  /**
+   * Returns the latest snapshot. Only one thread may read snapshots.
+   * @return snapshot that stays valid until the next call
+   */
+  const SimulationSnapshot &AcquireSnapshot();
+
+  /**
+   * @return number of frames advanced since Start
+   */
+  size_t GetStepCount() const;
+
+ private:
+  /**
+   * Advances the container until stopped.
+   */
+  void Run();
+
+  /**
+   * Runs and removes every queued command.
+   */
+  void RunCommands();
+
+  /**
+   * Copies the container into the write buffer and publishes it.
+   */
+  void PublishSnapshot();
+
+  GasContainer &container_;  // container being advanced, not owned
+  const double kSnapshotRate_;
+  std::atomic<size_t> substeps_;
+  std::atomic<bool> as_fast_as_possible_;
+  std::atomic<size_t> step_count_;
+
+  TripleBuffer<SimulationSnapshot> snapshots_;
+
+  std::mutex mutex_;  // guards commands_ and running_
+  std::condition_variable wake_;
+  std::vector<std::function<void(GasContainer &)>> commands_;
+  bool running_ = false;
+  std::thread thread_;
+};
+
+}  // namespace idealgas
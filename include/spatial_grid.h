@@ -0,0 +1,148 @@
+#pragma once
+
+#include <vector>
+
+#include "box.h"
+#include "particle_store.h"
+
+namespace idealgas {
+
+/**
+ * A uniform grid used as the broad phase for particle collisions. The cell
+ * size comes from the largest particle radius, so any two particles that can
+ * touch are always in the same or in adjacent cells.
+ *
+ * In a periodic box the grid covers the box exactly and wraps around: the
+ * cells past one edge are the cells at the opposite edge, which takes the
+ * place of a layer of ghost cells without copying any particles.
+ */
+class SpatialGrid {
+ public:
+  SpatialGrid();
+
+  /**
+   * Sorts the particles into cells. The cell storage is reused between
+   * frames, so after the first frame this only moves indices around.
+   * @param particles particles to bin
+   * @param margin extra width of the cells, so that particles up to this
+   * far apart from touching are still in the same or adjacent cells
+   */
+  template <typename T>
+  void Rebuild(const BasicParticleStore<T> &particles, double margin = 0);
+
+  /**
+   * Sorts the particles into cells of a grid over a box. For a reflecting
+   * box this is the same as Rebuild without one; for a periodic box the grid
+   * wraps around at the edges, and every particle must be inside the box.
+   * @param particles particles to bin
+   * @param box box the particles move in
+   * @param margin extra width of the cells, as for Rebuild without a box
+   */
+  template <typename T>
+  void Rebuild(const BasicParticleStore<T> &particles, const Box &box,
+               double margin = 0);
+
+  /**
+   * Finds the particles with a larger index than the given one that share a
+   * cell with it or sit in an adjacent cell, wrapping around the edges of a
+   * periodic grid.
+   * @param index index of the particle used in the last Rebuild
+   * @param neighbors filled with the neighbor indices in ascending order
+   */
+  void FindNeighbors(size_t index, std::vector<size_t> &neighbors) const;
+
+  /**
+   * Finds the particles in a square block of cells.
+   * @param first_column leftmost column of the block
+   * @param first_row top row of the block
+   * @param cells number of cells along each side of the block
+   * @param particles filled with the particle indices in ascending order
+   */
+  void FindParticlesInBlock(size_t first_column, size_t first_row,
+                            size_t cells, std::vector<size_t> &particles) const;
+
+  /**
+   * Tells if the grid's square tiles of cells can be given four colours so
+   * that tiles of one colour are at least a tile apart. Work that reads and
+   * writes at most one cell outside a tile can then run on all the tiles
+   * of a colour at once. This always holds for a reflecting grid; across
+   * the edges of a periodic grid the first and last tiles along each axis
+   * need different colours, and the last tile must be two cells wide.
+   * @return if the tiles can be coloured
+   */
+  bool CanColourTiles() const;
+
+  /**
+   * @param colour tile colour, from 0 to 3
+   * @return number of tiles of the colour
+   */
+  size_t GetTileCount(size_t colour) const;
+
+  /**
+   * Finds the particles in one tile.
+   * @param colour tile colour, from 0 to 3
+   * @param tile index of the tile among those of its colour
+   * @param particles filled with the particle indices in ascending order
+   */
+  void FindParticlesInTile(size_t colour, size_t tile,
+                           std::vector<size_t> &particles) const;
+
+  /**
+   * @return number of cell columns
+   */
+  size_t GetColumns() const;
+
+  /**
+   * @return number of cell rows
+   */
+  size_t GetRows() const;
+
+  /**
+   * @return shortest side length of a cell
+   */
+  float GetCellSize() const;
+
+  /**
+   * @return box of the last Rebuild if it was periodic, otherwise nullptr
+   */
+  const Box *GetPeriodicBox() const;
+
+  /**
+   * Lists a column or row and its neighbours, each once.
+   * @param coordinate column or row
+   * @param cell_count number of columns or rows
+   * @param periodic if the grid wraps around at the edges
+   * @param coordinates filled with the neighbouring columns or rows
+   * @return number of coordinates filled in
+   */
+  static size_t NeighborCoordinates(size_t coordinate, size_t cell_count,
+                                    bool periodic, size_t coordinates[3]);
+
+  /**
+   * @return column or row of a coordinate, clamped to the grid
+   */
+  static size_t CellCoordinate(double position, double min,
+                               double cell_size, size_t cell_count);
+
+ private:
+  /**
+   * Sorts the particles into the cells of the current layout.
+   */
+  template <typename T>
+  void SortIntoCells(const BasicParticleStore<T> &particles);
+
+  double cell_width_ = 1;
+  double cell_height_ = 1;
+  double min_x_ = 0;
+  double min_y_ = 0;
+  size_t columns_ = 0;
+  size_t rows_ = 0;
+  bool periodic_ = false;       // if the grid wraps around at the edges
+  Box box_ = Box(0, 0, 1, 1);   // box of a periodic grid
+  std::vector<size_t> cell_starts_;     // offset of each cell in cell_entries_
+  std::vector<size_t> cell_entries_;    // particle indices grouped by cell
+  std::vector<size_t> particle_cells_;  // cell of each particle
+  size_t max_cell_particles_ = 0;       // most particles in any one cell
+};
+
+}  // namespace idealgas
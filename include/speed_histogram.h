@@ -0,0 +1,112 @@
+#pragma once
+
+#include <cstdint>
+#include <vector>
+
+#include "array_view.h"
+#include "particle_store.h"
+
+namespace idealgas {
+
+/**
+ * Counts how many particles of each species fall into each speed bin. The
+ * bins split the speed range from 0 to the whole part of the fastest speed
+ * evenly; particles faster than that are not counted.
+ *
+ * The counts are kept up to date incrementally. Only particles marked in
+ * ParticleStore::SpeedChanged are re-binned, and every particle is re-binned
+ * only when the whole part of the fastest speed changes.
+ */
+class SpeedHistogram {
+ public:
+  /**
+   * @param num_bins number of bins per species
+   */
+  explicit SpeedHistogram(size_t num_bins);
+
+  /**
+   * Brings the counts up to date with the particles and clears their
+   * speed changed marks.
+   * @param particles particles to count
+   */
+  void Update(ParticleStore &particles);
+
+  /**
+   * Sets every count to 0. The next Update counts all particles again.
+   */
+  void Clear();
+
+  /**
+   * Makes the next Update count all particles again, for when speeds were
+   * changed without being marked.
+   */
+  void Invalidate();
+
+  /**
+   * @param speed speed of a particle
+   * @return bin the speed falls into, or the number of bins if it is faster
+   * than the last bin
+   */
+  size_t FindBin(double speed) const;
+
+  /**
+   * @param species species id
+   * @param bin bin index
+   * @return number of particles of the species in the bin
+   */
+  size_t GetCount(uint8_t species, size_t bin) const;
+
+  /**
+   * @param species species id
+   * @return count of each bin of the species, or an empty view if the
+   * species was not counted yet
+   */
+  ArrayView<uint32_t> GetCounts(uint8_t species) const;
+
+  /**
+   * @return number of bins per species
+   */
+  size_t GetNumBins() const;
+
+  /**
+   * @return whole part of the fastest speed when last updated
+   */
+  int GetMaxSpeed() const;
+
+ private:
+  /**
+   * Recounts every particle from scratch.
+   */
+  void Rebuild(ParticleStore &particles);
+
+  /**
+   * Re-bins every particle against the current max speed.
+   */
+  void RebinAll(const ParticleStore &particles);
+
+  /**
+   * Moves a particle from its old bin into the bin of its current speed.
+   */
+  void Rebin(const ParticleStore &particles, size_t i);
+
+  /**
+   * Finds the max speed and how many particles have it from scratch.
+   */
+  void FindMaxSpeed();
+
+  /**
+   * @return largest speed that falls into a bin
+   */
+  double UpperEdge(size_t bin) const;
+
+  const size_t num_bins_;
+  bool stale_ = true;               // if the next Update recounts everything
+  int max_speed_ = 0;               // whole part of the fastest speed
+  size_t max_speed_count_ = 0;      // particles whose speed has that whole part
+  std::vector<uint32_t> counts_;    // counts, indexed species * bins + bin
+  std::vector<int> whole_speeds_;   // whole part of each particle's speed
+  std::vector<uint32_t> bins_;      // bin of each particle
+  std::vector<uint32_t> changed_;   // particles changed since the last Update
+};
+
+}  // namespace idealgas
@@ -0,0 +1,72 @@
+#pragma once
+
+#include <ostream>
+#include <string>
+#include <vector>
+
+#include "gas_statistics.h"
+#include "scenario.h"
+#include "thread_pool.h"
+
+namespace idealgas {
+
+/**
+ * What one run of a scenario ended with.
+ */
+struct RunSummary {
+  std::string name;            // name of the scenario
+  bool succeeded = false;      // if the run finished
+  std::string error;           // why the run failed, if it did
+  size_t particle_count = 0;
+  size_t steps = 0;            // frames advanced
+  double elapsed_ms = 0;       // wall-clock time of the run
+  GasStatistics statistics;    // statistics of the last frame
+  double mean_temperature = 0; // temperature averaged over the frames
+  double mean_pressure = 0;    // pressure averaged over the frames
+};
+
+/**
+ * Runs many scenarios in one process. The scenarios are spread over a
+ * thread pool, and every container also resolves its collisions on the
+ * same pool, so small runs keep all threads busy and large runs are still
+ * split up. A run gives the same particles whether it is run alone or as
+ * part of a sweep.
+ */
+class SweepRunner {
+ public:
+  /**
+   * @param pool threads to run on, or nullptr to run one scenario at a time
+   * on this thread
+   */
+  explicit SweepRunner(ThreadPool *pool);
+
+  /**
+   * Sets up a container for a scenario, advances it and writes the
+   * scenario's outputs. Failures are reported in the summary rather than
+   * thrown, so one bad run does not stop a sweep.
+   * @param scenario scenario to run
+   * @return summary of the run
+   */
+  RunSummary Run(const Scenario &scenario) const;
+
+  /**
+   * Runs scenarios concurrently.
+   * @param scenarios scenarios to run
+   * @return summary of each run, in the order of the scenarios
+   */
+  std::vector<RunSummary> Run(const std::vector<Scenario> &scenarios) const;
+
+  /**
+   * Writes summaries as a table of tab-separated values with a header row
+   * and one row per run.
+   * @param output stream to write to
+   * @param summaries summaries to write
+   */
+  static void WriteSummaries(std::ostream &output,
+                             const std::vector<RunSummary> &summaries);
+
+ private:
+  ThreadPool *pool_;  // threads for runs and their collisions, not owned
+};
+
+}  // namespace idealgas
@@ -0,0 +1,124 @@
+#pragma once
+
+#include <algorithm>
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace idealgas {
+
+/**
+ * A thread pool for parallel loops. Each ParallelFor call is a batch whose
+ * indices the calling thread and every idle worker claim one at a time
+ * from a shared counter, so busy threads leave the rest of a loop to the
+ * others. Starting a loop takes no allocation. The thread that calls
+ * ParallelFor also claims indices until none are left, so loops can be
+ * nested inside tasks.
+ *
+ * The pool first gave each worker its own queue of tasks and let idle
+ * workers steal from the others. Queuing a loop's tasks then allocated on
+ * every call, which steady-state frames must not do. A shared counter per
+ * batch balances the load the same way, since a thread that finishes early
+ * simply claims the next index, so the queues were dropped.
+ */
+class ThreadPool {
+ public:
+  /**
+   * Starts the worker threads.
+   * @param thread_count number of worker threads, 0 runs everything on the
+   *                     calling thread
+   */
+  explicit ThreadPool(size_t thread_count);
+
+  /**
+   * Finishes running loops and joins the worker threads.
+   */
+  ~ThreadPool();
+
+  ThreadPool(const ThreadPool &) = delete;
+  ThreadPool &operator=(const ThreadPool &) = delete;
+
+  /**
+   * @return number of worker threads
+   */
+  size_t GetThreadCount() const;
+
+  /**
+   * Runs a task for every index in [0, count) and waits for all of them. The
+   * first exception thrown by a task is rethrown here.
+   * @param count number of indices
+   * @param task function taking an index, called in place rather than
+   * copied into a std::function
+   */
+  template <typename Task>
+  void ParallelFor(size_t count, const Task &task) {
+    RunLoop(count, &task, [](const void *function, size_t index) {
+      (*static_cast<const Task *>(function))(index);
+    });
+  }
+
+ private:
+  struct Batch;
+
+  /**
+   * Calls a task through a pointer to it.
+   */
+  typedef void (*TaskInvoker)(const void *task, size_t index);
+
+  /**
+   * ParallelFor for a task of any type.
+   */
+  void RunLoop(size_t count, const void *task, TaskInvoker invoke);
+
+  /**
+   * Claims and runs indices of a batch until none are left.
+   * @param batch batch to work on
+   */
+  static void RunBatch(Batch &batch);
+
+  /**
+   * @return the most recently started batch with indices left to claim, or
+   * nullptr; called with mutex_ held
+   */
+  Batch *FindBatch() const;
+
+  /**
+   * Works on batches until the pool is stopped.
+   */
+  void WorkerLoop();
+
+  std::vector<std::thread> threads_;
+  std::mutex mutex_;
+  std::condition_variable wake_;  // a batch started or the pool is stopping
+  std::condition_variable done_;  // a worker left a finished batch
+  Batch *batches_ = nullptr;      // running batches, newest first
+  bool stopping_ = false;
+};
+
+/**
+ * Runs a function on consecutive blocks of [0, count), one block per task
+ * on a pool, or all on the calling thread without one.
+ * @param count number of indices
+ * @param block_size indices in every block but the last
+ * @param pool threads to run on, or nullptr to use this thread
+ * @param function called with the begin and end of each block
+ */
+template <typename Function>
+void ForEachBlock(size_t count, size_t block_size, ThreadPool *pool,
+                  const Function &function) {
+  size_t blocks = (count + block_size - 1) / block_size;
+  auto run_block = [&](size_t block) {
+    size_t begin = block * block_size;
+    function(begin, std::min(begin + block_size, count));
+  };
+  if (pool != nullptr && blocks > 1) {
+    pool->ParallelFor(blocks, run_block);
+  } else {
+    for (size_t block = 0; block < blocks; ++block) {
+      run_block(block);
+    }
+  }
+}
+
+}  // namespace idealgas
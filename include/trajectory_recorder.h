@@ -0,0 +1,165 @@
+#pragma once
+
+#include <condition_variable>
+#include <cstdint>
+#include <fstream>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "particle_store.h"
+
+namespace idealgas {
+
+/**
+ * Positions and velocities of some particles at one frame.
+ */
+struct TrajectoryFrame {
+  int64_t frame = 0;
+  std::vector<uint32_t> indices;  // index of each particle in the store
+  std::vector<float> x;
+  std::vector<float> y;
+  std::vector<float> vx;
+  std::vector<float> vy;
+};
+
+/**
+ * Streams particle positions and velocities to a file on a thread of its
+ * own. Record only copies the particles into a free slot of a ring of
+ * snapshots; the writer thread compresses and writes them. When every slot
+ * is full the frame is dropped instead of waiting, so recording never
+ * stalls the simulation.
+ *
+ * The file is a header followed by self-contained chunks of up to
+ * frames_per_chunk frames. Within a chunk, each column (x, y, vx, vy) is
+ * stored particle by particle as differences of float bits from frame to
+ * frame, zigzag and varint encoded. Positions store the change in their
+ * difference, which barely moves while a particle flies straight, so most
+ * values take a byte or two. Decoding is exact.
+ */
+class TrajectoryRecorder {
+ public:
+  struct Options {
+    size_t decimation = 1;          // record every this many frames
+    std::vector<uint8_t> species;   // species to record, or empty for all
+    size_t frames_per_chunk = 64;   // frames compressed together
+    size_t buffer_frames = 8;       // snapshots waiting for the writer
+  };
+
+  /**
+   * Opens the file and starts the writer thread.
+   * @param path file to write
+   * @param options what to record
+   * @throws std::runtime_error if the file cannot be opened
+   */
+  TrajectoryRecorder(const std::string &path, const Options &options);
+
+  /**
+   * Writes what has been recorded and stops the writer thread.
+   */
+  ~TrajectoryRecorder();
+
+  TrajectoryRecorder(const TrajectoryRecorder &) = delete;
+  TrajectoryRecorder &operator=(const TrajectoryRecorder &) = delete;
+
+  /**
+   * Queues the particles for writing if the frame is one to record.
+   * @param particles particles to record
+   * @param frame frame counter of the particles
+   */
+  void Record(const ParticleStore &particles, int64_t frame);
+
+  /**
+   * Writes every queued frame and closes the file. Later calls to Record
+   * are ignored.
+   * @throws std::runtime_error if writing failed
+   */
+  void Close();
+
+  /**
+   * @return number of frames queued for writing
+   */
+  size_t GetRecordedFrameCount() const;
+
+  /**
+   * @return number of frames dropped because the writer fell behind
+   */
+  size_t GetDroppedFrameCount() const;
+
+ private:
+  /**
+   * Takes snapshots off the ring until closed.
+   */
+  void RunWriter();
+
+  /**
+   * Appends a snapshot to the chunk being built.
+   */
+  void AddToChunk(const TrajectoryFrame &snapshot);
+
+  /**
+   * Compresses and writes the chunk being built.
+   */
+  void WriteChunk();
+
+  const Options options_;
+  std::ofstream file_;
+  std::vector<bool> species_filter_;  // if each species id is recorded
+
+  // Ring of snapshots, filled by Record and emptied by the writer thread.
+  std::vector<TrajectoryFrame> slots_;
+  size_t write_slot_ = 0;
+  size_t read_slot_ = 0;
+  size_t filled_slots_ = 0;
+  bool closing_ = false;
+  bool closed_ = false;
+  size_t recorded_frames_ = 0;
+  size_t dropped_frames_ = 0;
+  mutable std::mutex mutex_;
+  std::condition_variable slot_filled_;
+
+  // Chunk being built by the writer thread, one value per particle and
+  // frame in each column.
+  std::vector<int64_t> chunk_frames_;
+  std::vector<uint32_t> chunk_indices_;
+  std::vector<float> chunk_columns_[4];
+  std::vector<uint8_t> encoded_;
+  bool write_failed_ = false;
+
+  std::thread writer_;
+};
+
+/**
+ * Reads a file written by TrajectoryRecorder one frame at a time.
+ */
+class TrajectoryReader {
+ public:
+  /**
+   * @param path file to read
+   * @throws std::runtime_error if the file cannot be opened
+   * @throws std::invalid_argument if the file is not a trajectory
+   */
+  explicit TrajectoryReader(const std::string &path);
+
+  /**
+   * Reads the next frame.
+   * @param frame frame to fill
+   * @return false at the end of the file
+   * @throws std::invalid_argument if a chunk is corrupt
+   */
+  bool Next(TrajectoryFrame &frame);
+
+ private:
+  /**
+   * Reads and decodes the next chunk.
+   * @return false at the end of the file
+   */
+  bool ReadChunk();
+
+  std::ifstream file_;
+  std::vector<TrajectoryFrame> chunk_;  // frames of the current chunk
+  size_t next_frame_ = 0;               // next frame of the chunk to return
+};
+
+}  // namespace idealgas
@@ -0,0 +1,68 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+
+namespace idealgas {
+
+/**
+ * Hands values from one writer thread to one reader thread without locks
+ * and without either side waiting. The writer fills its own buffer and
+ * publishes it; the reader picks up the most recently published buffer.
+ * The third buffer sits between them, so neither ever touches the buffer
+ * the other is using. Values the reader never picked up are overwritten.
+ */
+template <typename T>
+class TripleBuffer {
+ public:
+  TripleBuffer() : middle_(2) { }
+
+  /**
+   * @return buffer for the writer to fill, which the reader cannot see
+   */
+  T &GetWriteBuffer() {
+    return buffers_[write_];
+  }
+
+  /**
+   * Makes the write buffer the latest value and gives the writer a new one.
+   * The new buffer holds an old value, which the writer should overwrite.
+   */
+  void Publish() {
+    uint8_t previous = middle_.exchange(write_ | kFresh,
+                                        std::memory_order_acq_rel);
+    write_ = previous & kIndex;
+  }
+
+  /**
+   * Switches the reader to the latest published value, if there is one it
+   * has not seen.
+   * @return if the read buffer changed
+   */
+  bool Update() {
+    if ((middle_.load(std::memory_order_acquire) & kFresh) == 0) {
+      return false;
+    }
+    uint8_t previous = middle_.exchange(read_, std::memory_order_acq_rel);
+    read_ = previous & kIndex;
+    return true;
+  }
+
+  /**
+   * @return buffer for the reader, which stays the same until Update
+   */
+  const T &GetReadBuffer() const {
+    return buffers_[read_];
+  }
+
+ private:
+  static const uint8_t kIndex = 0x3;  // bits of the buffer index
+  static const uint8_t kFresh = 0x4;  // set while the reader has not seen it
+
+  T buffers_[3];
+  uint8_t write_ = 0;             // owned by the writer
+  uint8_t read_ = 1;              // owned by the reader
+  std::atomic<uint8_t> middle_;   // shared, with the fresh bit
+};
+
+}  // namespace idealgas
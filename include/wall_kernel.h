@@ -0,0 +1,78 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+#include "box.h"
+
+namespace idealgas {
+
+/**
+ * Batched wall reflection and position update over dense particle arrays.
+ * The instruction set is picked at runtime, and every batched version gives
+ * exactly the same results as PhysicsEngine::ParticleWallCollision followed
+ * by adding the velocity to the position.
+ */
+class WallKernel {
+ public:
+  /**
+   * Instruction sets the kernel can run with, from narrowest to widest.
+   */
+  enum class InstructionSet { kScalar, kSse2, kAvx2, kAvx512 };
+
+  /**
+   * @return widest instruction set supported by this processor
+   */
+  static InstructionSet Detect();
+
+  /**
+   * @param instruction_set instruction set to check
+   * @return if the kernel can run with the instruction set on this processor
+   */
+  static bool IsSupported(InstructionSet instruction_set);
+
+  /**
+   * @param instruction_set instruction set to name
+   * @return readable name of the instruction set
+   */
+  static const char *GetName(InstructionSet instruction_set);
+
+  /**
+   * Bounces particles off the walls and moves each one by its velocity. A
+   * particle bounces when its centre is within its radius of a wall. The
+   * batched versions work the bounds out from the radii in registers; the
+   * scalar loop, which also takes the tail, looks them up by species.
+   * @param instruction_set instruction set to run with, must be supported
+   * @param box walls to bounce off
+   * @param species_bounds wall bounds of each species, from
+   * Box::GetSpeciesBounds
+   * @param count number of particles
+   * @param x x coordinates of positions
+   * @param y y coordinates of positions
+   * @param vx x components of velocities
+   * @param vy y components of velocities
+   * @param radius radius of each particle, that of its species
+   * @param species species id of each particle
+   */
+  static void ReflectAndIntegrate(InstructionSet instruction_set,
+                                  const Box &box,
+                                  const WallBounds *species_bounds,
+                                  size_t count, float *x, float *y, float *vx,
+                                  float *vy, const float *radius,
+                                  const uint8_t *species);
+
+  /**
+   * Double precision version of ReflectAndIntegrate, with half as many
+   * particles per instruction. The batched versions compare in double like
+   * the scalar one, so they agree with it for any walls.
+   */
+  static void ReflectAndIntegrate(InstructionSet instruction_set,
+                                  const Box &box,
+                                  const WallBounds *species_bounds,
+                                  size_t count, double *x, double *y,
+                                  double *vx, double *vy,
+                                  const double *radius,
+                                  const uint8_t *species);
+};
+
+}  // namespace idealgas
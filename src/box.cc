@@ -0,0 +1,117 @@
+#include "box.h"
+
+#include <cmath>
+#include <stdexcept>
+
+namespace idealgas {
+
+Box::Box(double min_x, double min_y, double max_x, double max_y,
+         Boundary boundary)
+    : min_x_(min_x),
+      min_y_(min_y),
+      max_x_(max_x),
+      max_y_(max_y),
+      boundary_(boundary) {
+  if (!std::isfinite(min_x) || !std::isfinite(min_y) ||
+      !std::isfinite(max_x) || !std::isfinite(max_y)) {
+    throw std::invalid_argument("Box walls must be finite");
+  }
+  if (!(max_x > min_x) || !(max_y > min_y)) {
+    throw std::invalid_argument("Box must have a positive width and height");
+  }
+}
+
+Box Box::FromWindow(size_t window_length, size_t margin, Boundary boundary) {
+  return Box(static_cast<double>(margin), static_cast<double>(margin),
+             static_cast<double>(window_length - margin),
+             static_cast<double>(window_length - margin), boundary);
+}
+
+double Box::GetMinX() const {
+  return min_x_;
+}
+
+double Box::GetMinY() const {
+  return min_y_;
+}
+
+double Box::GetMaxX() const {
+  return max_x_;
+}
+
+double Box::GetMaxY() const {
+  return max_y_;
+}
+
+double Box::GetWidth() const {
+  return max_x_ - min_x_;
+}
+
+double Box::GetHeight() const {
+  return max_y_ - min_y_;
+}
+
+Boundary Box::GetBoundary() const {
+  return boundary_;
+}
+
+bool Box::IsPeriodic() const {
+  return boundary_ == Boundary::kPeriodic;
+}
+
+glm::vec2 Box::MinimumImage(const glm::vec2 &displacement) const {
+  if (boundary_ != Boundary::kPeriodic) {
+    return displacement;
+  }
+  return glm::vec2(MinimumImageX(displacement.x),
+                   MinimumImageY(displacement.y));
+}
+
+double Box::MinimumImageX(double dx) const {
+  if (boundary_ != Boundary::kPeriodic) {
+    return dx;
+  }
+  double width = GetWidth();
+  return dx - width * std::round(dx / width);
+}
+
+double Box::MinimumImageY(double dy) const {
+  if (boundary_ != Boundary::kPeriodic) {
+    return dy;
+  }
+  double height = GetHeight();
+  return dy - height * std::round(dy / height);
+}
+
+WallBounds Box::GetBounds(double radius) const {
+  return {min_x_ + radius, max_x_ - radius, min_y_ + radius, max_y_ - radius};
+}
+
+template <typename T>
+std::vector<WallBounds> Box::GetSpeciesBounds(
+    const BasicParticleStore<T> &particles) const {
+  std::vector<WallBounds> bounds;
+  bounds.reserve(particles.SpeciesCount());
+  for (size_t id = 0; id < particles.SpeciesCount(); ++id) {
+    bounds.push_back(
+        GetBounds(particles.GetSpecies(static_cast<uint8_t>(id)).radius));
+  }
+  return bounds;
+}
+
+template std::vector<WallBounds> Box::GetSpeciesBounds(
+    const ParticleStore &particles) const;
+template std::vector<WallBounds> Box::GetSpeciesBounds(
+    const DoubleParticleStore &particles) const;
+
+bool Box::operator==(const Box &other) const {
+  return min_x_ == other.min_x_ && min_y_ == other.min_y_ &&
+         max_x_ == other.max_x_ && max_y_ == other.max_y_ &&
+         boundary_ == other.boundary_;
+}
+
+bool Box::operator!=(const Box &other) const {
+  return !(*this == other);
+}
+
+}  // namespace idealgas
@@ -0,0 +1,270 @@
+#include "checkpoint.h"
+
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <stdexcept>
+
+#if defined(_WIN32)
+#include <iterator>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace idealgas {
+
+namespace {
+
+// Species ids are stored in a uint8_t.
+const uint32_t kMaxSpecies = 256;
+
+const char kMagic[8] = {'I', 'G', 'A', 'S', 'C', 'K', 'P', 'T'};
+
+// Reads back as a different value on a machine of the other byte order.
+const uint32_t kByteOrder = 0x01020304;
+
+// Arrays start on cache line boundaries so they can be streamed in place.
+const uint64_t kArrayAlignment = 64;
+
+uint64_t AlignUp(uint64_t offset) {
+  return (offset + kArrayAlignment - 1) / kArrayAlignment * kArrayAlignment;
+}
+
+void WriteBytes(std::ofstream &file, const void *data, uint64_t size,
+                uint64_t &offset) {
+  file.write(static_cast<const char *>(data), static_cast<std::streamsize>(size));
+  offset += size;
+}
+
+void PadTo(std::ofstream &file, uint64_t target, uint64_t &offset) {
+  static const char kZeros[kArrayAlignment] = {};
+  WriteBytes(file, kZeros, target - offset, offset);
+}
+
+}  // namespace
+
+// The layout is part of the file format.
+static_assert(sizeof(Checkpoint::Geometry) == 64, "Geometry layout changed");
+
+void Checkpoint::Save(const std::string &path, const ParticleStore &particles,
+                      int64_t frame, const Geometry &geometry) {
+  const size_t count = particles.Size();
+  const size_t species_count = particles.SpeciesCount();
+  const uint64_t element_sizes[kArrayCount] = {
+      sizeof(float), sizeof(float), sizeof(float), sizeof(float),
+      sizeof(float), sizeof(float), sizeof(uint8_t)};
+  const void *arrays[kArrayCount] = {
+      particles.PositionX(), particles.PositionY(), particles.VelocityX(),
+      particles.VelocityY(), particles.InverseMass(), particles.Radius(),
+      particles.SpeciesId()};
+
+  Header header;
+  std::memset(&header, 0, sizeof(header));
+  std::memcpy(header.magic, kMagic, sizeof(kMagic));
+  header.version = kVersion;
+  header.byte_order = kByteOrder;
+  header.species_count = static_cast<uint32_t>(species_count);
+  header.particle_count = count;
+  header.frame = frame;
+  header.geometry = geometry;
+  uint64_t end = sizeof(Header) + species_count * sizeof(SpeciesRecord);
+  for (size_t array = 0; array < kArrayCount; ++array) {
+    header.array_offsets[array] = AlignUp(end);
+    end = header.array_offsets[array] + count * element_sizes[array];
+  }
+
+  std::string temporary_path = path + ".tmp";
+  std::ofstream file(temporary_path, std::ios::binary | std::ios::trunc);
+  if (!file) {
+    throw std::runtime_error("Cannot open checkpoint for writing: " +
+                             temporary_path);
+  }
+
+  uint64_t offset = 0;
+  WriteBytes(file, &header, sizeof(header), offset);
+  for (size_t id = 0; id < species_count; ++id) {
+    const ParticleStore::Species &species =
+        particles.GetSpecies(static_cast<uint8_t>(id));
+    SpeciesRecord record = {species.color.r, species.color.g, species.color.b,
+                            species.mass, species.radius};
+    WriteBytes(file, &record, sizeof(record), offset);
+  }
+  for (size_t array = 0; array < kArrayCount; ++array) {
+    PadTo(file, header.array_offsets[array], offset);
+    WriteBytes(file, arrays[array], count * element_sizes[array], offset);
+  }
+
+  file.close();
+  if (!file) {
+    std::remove(temporary_path.c_str());
+    throw std::runtime_error("Cannot write checkpoint: " + temporary_path);
+  }
+#if defined(_WIN32)
+  // rename does not replace an existing file on Windows.
+  std::remove(path.c_str());
+#endif
+  if (std::rename(temporary_path.c_str(), path.c_str()) != 0) {
+    throw std::runtime_error("Cannot move checkpoint into place: " + path);
+  }
+}
+
+Checkpoint::Checkpoint(const std::string &path) {
+#if defined(_WIN32)
+  std::ifstream file(path, std::ios::binary);
+  if (!file) {
+    throw std::runtime_error("Cannot open checkpoint: " + path);
+  }
+  buffer_.assign(std::istreambuf_iterator<char>(file),
+                 std::istreambuf_iterator<char>());
+  data_ = buffer_.data();
+  size_ = buffer_.size();
+#else
+  int descriptor = open(path.c_str(), O_RDONLY);
+  if (descriptor < 0) {
+    throw std::runtime_error("Cannot open checkpoint: " + path);
+  }
+  struct stat status;
+  if (fstat(descriptor, &status) != 0) {
+    close(descriptor);
+    throw std::runtime_error("Cannot read checkpoint size: " + path);
+  }
+  size_ = static_cast<size_t>(status.st_size);
+  if (size_ > 0) {
+    void *mapping = mmap(nullptr, size_, PROT_READ, MAP_PRIVATE, descriptor, 0);
+    if (mapping == MAP_FAILED) {
+      close(descriptor);
+      throw std::runtime_error("Cannot map checkpoint: " + path);
+    }
+    data_ = static_cast<const unsigned char *>(mapping);
+  }
+  // The mapping stays valid after the descriptor is closed.
+  close(descriptor);
+#endif
+
+  try {
+    Validate();
+  } catch (...) {
+#if !defined(_WIN32)
+    if (data_ != nullptr) {
+      munmap(const_cast<unsigned char *>(data_), size_);
+    }
+#endif
+    throw;
+  }
+}
+
+Checkpoint::~Checkpoint() {
+#if !defined(_WIN32)
+  if (data_ != nullptr) {
+    munmap(const_cast<unsigned char *>(data_), size_);
+  }
+#endif
+}
+
+void Checkpoint::Restore(ParticleStore &particles) const {
+  particles.Assign(GetSpecies(), GetParticleCount(), PositionX(), PositionY(),
+                   VelocityX(), VelocityY(), InverseMass(), Radius(),
+                   SpeciesId());
+}
+
+size_t Checkpoint::GetParticleCount() const {
+  return static_cast<size_t>(GetHeader().particle_count);
+}
+
+int64_t Checkpoint::GetFrame() const {
+  return GetHeader().frame;
+}
+
+Checkpoint::Geometry Checkpoint::GetGeometry() const {
+  return GetHeader().geometry;
+}
+
+std::vector<ParticleStore::Species> Checkpoint::GetSpecies() const {
+  const unsigned char *records = data_ + sizeof(Header);
+  std::vector<ParticleStore::Species> species(GetHeader().species_count);
+  for (size_t id = 0; id < species.size(); ++id) {
+    SpeciesRecord record;
+    std::memcpy(&record, records + id * sizeof(record), sizeof(record));
+    species[id].color = Color(record.red, record.green, record.blue);
+    species[id].mass = record.mass;
+    species[id].radius = record.radius;
+  }
+  return species;
+}
+
+const float *Checkpoint::PositionX() const {
+  return reinterpret_cast<const float *>(ArrayData(kPositionX));
+}
+
+const float *Checkpoint::PositionY() const {
+  return reinterpret_cast<const float *>(ArrayData(kPositionY));
+}
+
+const float *Checkpoint::VelocityX() const {
+  return reinterpret_cast<const float *>(ArrayData(kVelocityX));
+}
+
+const float *Checkpoint::VelocityY() const {
+  return reinterpret_cast<const float *>(ArrayData(kVelocityY));
+}
+
+const float *Checkpoint::InverseMass() const {
+  return reinterpret_cast<const float *>(ArrayData(kInverseMass));
+}
+
+const float *Checkpoint::Radius() const {
+  return reinterpret_cast<const float *>(ArrayData(kRadius));
+}
+
+const uint8_t *Checkpoint::SpeciesId() const {
+  return ArrayData(kSpeciesId);
+}
+
+void Checkpoint::Validate() const {
+  static_assert(sizeof(Header) == 160, "Checkpoint header layout changed");
+  static_assert(sizeof(SpeciesRecord) == 20, "Species layout changed");
+  if (size_ < sizeof(Header)) {
+    throw std::invalid_argument("Checkpoint is too small for its header");
+  }
+  const Header &header = GetHeader();
+  if (std::memcmp(header.magic, kMagic, sizeof(kMagic)) != 0) {
+    throw std::invalid_argument("File is not a checkpoint");
+  }
+  if (header.byte_order != kByteOrder) {
+    throw std::invalid_argument("Checkpoint was written with another byte order");
+  }
+  if (header.version != kVersion) {
+    throw std::invalid_argument("Unsupported checkpoint version " +
+                                std::to_string(header.version));
+  }
+  if (header.species_count > kMaxSpecies) {
+    throw std::invalid_argument("Checkpoint has too many species");
+  }
+  if (header.species_count > (size_ - sizeof(Header)) / sizeof(SpeciesRecord)) {
+    throw std::invalid_argument("Checkpoint species table is truncated");
+  }
+
+  const uint64_t element_sizes[kArrayCount] = {
+      sizeof(float), sizeof(float), sizeof(float), sizeof(float),
+      sizeof(float), sizeof(float), sizeof(uint8_t)};
+  for (size_t array = 0; array < kArrayCount; ++array) {
+    uint64_t offset = header.array_offsets[array];
+    if (offset % kArrayAlignment != 0 || offset > size_ ||
+        header.particle_count > (size_ - offset) / element_sizes[array]) {
+      throw std::invalid_argument("Checkpoint particle arrays are truncated");
+    }
+  }
+}
+
+const unsigned char *Checkpoint::ArrayData(Array array) const {
+  return data_ + GetHeader().array_offsets[array];
+}
+
+const Checkpoint::Header &Checkpoint::GetHeader() const {
+  return *reinterpret_cast<const Header *>(data_);
+}
+
+}  // namespace idealgas
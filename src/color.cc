@@ -0,0 +1,61 @@
+#include "color.h"
+
+#include <cstring>
+#include <stdexcept>
+#include <string>
+
+namespace idealgas {
+
+namespace {
+
+struct NamedColor {
+  const char *name;
+  int red;
+  int green;
+  int blue;
+};
+
+// Common SVG colour names with their 0-255 components.
+const NamedColor kNamedColors[] = {
+    {"black", 0, 0, 0},         {"white", 255, 255, 255},
+    {"red", 255, 0, 0},         {"green", 0, 128, 0},
+    {"blue", 0, 0, 255},        {"yellow", 255, 255, 0},
+    {"cyan", 0, 255, 255},      {"magenta", 255, 0, 255},
+    {"orange", 255, 165, 0},    {"purple", 128, 0, 128},
+    {"gray", 128, 128, 128},    {"grey", 128, 128, 128},
+    {"pink", 255, 192, 203},    {"brown", 165, 42, 42},
+    {"lime", 0, 255, 0},        {"navy", 0, 0, 128},
+    {"teal", 0, 128, 128},      {"silver", 192, 192, 192},
+    {"maroon", 128, 0, 0},      {"olive", 128, 128, 0},
+    {"gold", 255, 215, 0},      {"violet", 238, 130, 238},
+    {"indigo", 75, 0, 130},     {"turquoise", 64, 224, 208},
+};
+
+}  // namespace
+
+Color::Color() : r(0), g(0), b(0) { }
+
+Color::Color(float red, float green, float blue)
+    : r(red), g(green), b(blue) { }
+
+Color::Color(const char *name) {
+  for (const auto &named_color : kNamedColors) {
+    if (std::strcmp(named_color.name, name) == 0) {
+      r = named_color.red / 255.0f;
+      g = named_color.green / 255.0f;
+      b = named_color.blue / 255.0f;
+      return;
+    }
+  }
+  throw std::invalid_argument("Unknown colour name: " + std::string(name));
+}
+
+bool Color::operator==(const Color &other) const {
+  return r == other.r && g == other.g && b == other.b;
+}
+
+bool Color::operator!=(const Color &other) const {
+  return !(*this == other);
+}
+
+}  // namespace idealgas
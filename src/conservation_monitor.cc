@@ -0,0 +1,128 @@
+#include "conservation_monitor.h"
+
+#include <algorithm>
+#include <cmath>
+#include <stdexcept>
+
+namespace idealgas {
+
+namespace {
+
+/**
+ * @return change relative to a reference, or the change itself if the
+ * reference is 0
+ */
+double RelativeTo(double change, double reference) {
+  return reference > 0 ? change / reference : change;
+}
+
+}  // namespace
+
+ConservationMonitor::ConservationMonitor(const Options &options,
+                                         const Callback &callback)
+    : kOptions_(options), callback_(callback) {
+  if (options.sample_every == 0) {
+    throw std::invalid_argument("Conservation checks need a sampling "
+                                "interval of at least 1");
+  }
+  if (!(options.energy_tolerance >= 0) ||
+      !(options.momentum_tolerance >= 0)) {
+    throw std::invalid_argument("Conservation tolerances must be at least 0");
+  }
+}
+
+bool ConservationMonitor::ShouldSample(int frame) const {
+  return frame % static_cast<int>(kOptions_.sample_every) == 0;
+}
+
+void ConservationMonitor::Check(const GasStatistics &statistics, int frame,
+                                bool check_energy, bool check_momentum) {
+  if (!has_reference_) {
+    reference_energy_ = statistics.kinetic_energy;
+    reference_momentum_x_ = statistics.momentum_x;
+    reference_momentum_y_ = statistics.momentum_y;
+    momentum_scale_ =
+        std::sqrt(2 * statistics.total_mass * statistics.kinetic_energy);
+    has_reference_ = true;
+    return;
+  }
+
+  if (check_energy) {
+    energy_drift_ = RelativeTo(
+        std::fabs(statistics.kinetic_energy - reference_energy_),
+        reference_energy_);
+    max_energy_drift_ = std::max(max_energy_drift_, energy_drift_);
+    Compare(ConservedQuantity::kKineticEnergy, frame, reference_energy_,
+            energy_drift_, kOptions_.energy_tolerance, energy_raised_);
+  }
+  if (check_momentum) {
+    double dx = statistics.momentum_x - reference_momentum_x_;
+    double dy = statistics.momentum_y - reference_momentum_y_;
+    momentum_drift_ =
+        RelativeTo(std::sqrt(dx * dx + dy * dy), momentum_scale_);
+    max_momentum_drift_ = std::max(max_momentum_drift_, momentum_drift_);
+    Compare(ConservedQuantity::kMomentum, frame, momentum_scale_,
+            momentum_drift_, kOptions_.momentum_tolerance, momentum_raised_);
+  }
+}
+
+void ConservationMonitor::Rebase() {
+  has_reference_ = false;
+  energy_drift_ = 0;
+  momentum_drift_ = 0;
+  max_energy_drift_ = 0;
+  max_momentum_drift_ = 0;
+  energy_raised_ = false;
+  momentum_raised_ = false;
+}
+
+void ConservationMonitor::Rescale(double factor) {
+  reference_energy_ *= factor * factor;
+  reference_momentum_x_ *= factor;
+  reference_momentum_y_ *= factor;
+  momentum_scale_ *= std::fabs(factor);
+}
+
+double ConservationMonitor::GetEnergyDrift() const {
+  return energy_drift_;
+}
+
+double ConservationMonitor::GetMomentumDrift() const {
+  return momentum_drift_;
+}
+
+double ConservationMonitor::GetMaxEnergyDrift() const {
+  return max_energy_drift_;
+}
+
+double ConservationMonitor::GetMaxMomentumDrift() const {
+  return max_momentum_drift_;
+}
+
+size_t ConservationMonitor::GetAlarmCount() const {
+  return alarm_count_;
+}
+
+void ConservationMonitor::Compare(ConservedQuantity quantity, int frame,
+                                  double reference, double drift,
+                                  double tolerance, bool &raised) {
+  if (!(drift > tolerance)) {
+    raised = false;
+    return;
+  }
+  if (raised) {
+    return;
+  }
+  raised = true;
+  ++alarm_count_;
+  if (callback_) {
+    ConservationAlarm alarm;
+    alarm.quantity = quantity;
+    alarm.frame = frame;
+    alarm.reference = reference;
+    alarm.drift = drift;
+    callback_(alarm);
+  }
+}
+
+}  // namespace idealgas
@@ -0,0 +1,151 @@
+#include "container_renderer.h"
+
+#include <algorithm>
+
+#include "cinder/Text.h"
+
+namespace idealgas {
+
+using glm::vec2;
+
+ContainerRenderer::ContainerRenderer(const GasContainer &container)
+    : container_(container) { }
+
+void ContainerRenderer::Display(const SimulationSnapshot &snapshot) const {
+  const ParticleStore &particles = snapshot.particles;
+  const size_t window_length = container_.GetWindowLength();
+  const size_t margin = container_.GetMargin();
+
+  // The box is scaled to fit the square left of the histograms and centred
+  // in it. The box of a window-sized container maps onto itself.
+  const Box &box = container_.GetBox();
+  const double area = static_cast<double>(window_length - 2 * margin);
+  const double scale =
+      std::min(area / box.GetWidth(), area / box.GetHeight());
+  const double offset_x =
+      margin + (area - box.GetWidth() * scale) / 2 - box.GetMinX() * scale;
+  const double offset_y =
+      margin + (area - box.GetHeight() * scale) / 2 - box.GetMinY() * scale;
+
+  if (!particle_renderer_) {
+    particle_renderer_.reset(new ParticleBatchRenderer());
+  }
+  // Appends the box transform to the current one; both are column-major.
+  const auto &view_projection = ci::gl::getModelViewProjection();
+  float box_projection[16];
+  for (int row = 0; row < 4; ++row) {
+    box_projection[row] = static_cast<float>(view_projection[0][row] * scale);
+    box_projection[4 + row] =
+        static_cast<float>(view_projection[1][row] * scale);
+    box_projection[8 + row] = view_projection[2][row];
+    box_projection[12 + row] = static_cast<float>(
+        view_projection[0][row] * offset_x +
+        view_projection[1][row] * offset_y + view_projection[3][row]);
+  }
+  particle_renderer_->Draw(particles, box_projection);
+
+  ci::gl::color(ToCinderColor(container_.GetBorderColor()));
+  ci::gl::drawStrokedRect(
+      ci::Rectf(vec2(box.GetMinX() * scale + offset_x,
+                     box.GetMinY() * scale + offset_y),
+                vec2(box.GetMaxX() * scale + offset_x,
+                     box.GetMaxY() * scale + offset_y)), 4);
+
+  // The species are stacked with the last one on top, which keeps the
+  // fast, medium, slow order of the default mixture.
+  const size_t rows = snapshot.species_speeds.size();
+  for (size_t row = 0; row < rows; ++row) {
+    const uint8_t species = static_cast<uint8_t>(rows - 1 - row);
+    vec2 top_left;
+    vec2 bottom_right;
+    GetHistogramBounds(row, rows, top_left, bottom_right);
+    const std::vector<uint32_t> &speeds = snapshot.species_speeds[species];
+    DisplayHistogram(top_left, bottom_right,
+                     ToCinderColor(particles.GetSpecies(species).color),
+                     ArrayView<uint32_t>(speeds.data(), speeds.size()),
+                     snapshot.max_height);
+  }
+
+  DrawHistogramBoxes(rows);
+}
+
+void ContainerRenderer::DrawHistogramBoxes(size_t rows) const {
+  const size_t window_length = container_.GetWindowLength();
+  const size_t window_width = container_.GetWindowWidth();
+  const size_t margin = container_.GetMargin();
+
+  if (!speed_label_) {
+    speed_label_ = RenderLabel("Speed");
+    inverse_path_label_ = RenderLabel("1 / λ");
+  }
+  ci::gl::color(ToCinderColor(container_.GetBorderColor()));
+  DrawLabelCentered(speed_label_,
+                    vec2((window_length + window_width - margin) / 2,
+                         margin / 4));
+  DrawLabelCentered(inverse_path_label_,
+                    vec2(window_width - margin * 0.67, window_length / 2));
+  for (size_t row = 0; row < rows; ++row) {
+    vec2 top_left;
+    vec2 bottom_right;
+    GetHistogramBounds(row, rows, top_left, bottom_right);
+    ci::gl::drawStrokedRect(ci::Rectf(top_left, bottom_right), 2);
+  }
+}
+
+void ContainerRenderer::GetHistogramBounds(size_t row, size_t rows,
+                                           vec2 &top_left,
+                                           vec2 &bottom_right) const {
+  const size_t window_length = container_.GetWindowLength();
+  const size_t window_width = container_.GetWindowWidth();
+  const size_t margin = container_.GetMargin();
+
+  // Rows are separated by half a margin, with half a margin above the first
+  // and below the last. With many species the gaps shrink so they never
+  // take more than half the column, which keeps every row visible.
+  const float length = static_cast<float>(window_length);
+  const float gap = std::min(margin / 2.0f, length / (2.0f * (rows + 1)));
+  const float height = (length - (rows + 1) * gap) / rows;
+  const float top = gap + row * (height + gap);
+  top_left = vec2(length, top);
+  bottom_right = vec2(window_width - margin, top + height);
+}
+
+void ContainerRenderer::DisplayHistogram(const glm::vec2 &top_left_corner,
+                                         const glm::vec2 &bottom_right_corner,
+                                         const ci::Color &color,
+                                         ArrayView<uint32_t> speeds,
+                                         size_t max_height) const {
+  const size_t num_bins = speeds.size();
+  if (num_bins == 0) {
+    return;
+  }
+
+  float bin_width = (bottom_right_corner.x - top_left_corner.x) / static_cast<float>(num_bins);
+  for (size_t bin = 0; bin < num_bins; ++bin) {
+    float bin_height_ratio =
+        max_height == 0 ? 0.0f
+                        : static_cast<float>(speeds[bin] / (max_height * 1.0));
+    ci::gl::color(color);
+    ci::gl::drawStrokedRect(
+        ci::Rectf(vec2(top_left_corner.x + bin*bin_width,
+                       bottom_right_corner.y - ((bottom_right_corner.y - top_left_corner.y) * bin_height_ratio * 0.95)),
+                  vec2(top_left_corner.x + (bin + 1.0) * bin_width, bottom_right_corner.y)), 2);
+  }
+}
+
+ci::gl::Texture2dRef ContainerRenderer::RenderLabel(const std::string &text) {
+  return ci::gl::Texture2d::create(ci::renderString(
+      text, ci::Font::getDefault(), ci::ColorA(1, 1, 1, 1)));
+}
+
+void ContainerRenderer::DrawLabelCentered(const ci::gl::Texture2dRef &label,
+                                          const vec2 &center) {
+  const vec2 size(label->getWidth(), label->getHeight());
+  ci::gl::draw(label, center - size / 2.0f);
+}
+
+ci::Color ContainerRenderer::ToCinderColor(const Color &color) {
+  return ci::Color(color.r, color.g, color.b);
+}
+
+}  // namespace idealgas
@@ -0,0 +1,417 @@
+#include "event_driven_engine.h"
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+#include "frame_profiler.h"
+#include "spatial_grid.h"
+
+namespace idealgas {
+
+namespace {
+
+const uint32_t kNone = std::numeric_limits<uint32_t>::max();
+
+// Cell crossing directions, stored in Event::other.
+const uint32_t kPositiveX = 0;
+const uint32_t kNegativeX = 1;
+const uint32_t kPositiveY = 2;
+const uint32_t kNegativeY = 3;
+
+// Upper bound on the number of cells per particle, for large boxes.
+const double kMaxCellsPerParticle = 4.0;
+
+// Stale events are dropped lazily, so the queue is rebuilt from scratch once
+// it grows past this many events per particle.
+const size_t kMaxEventsPerParticle = 32;
+
+}  // namespace
+
+bool EventDrivenEngine::Event::operator>(const Event &event) const {
+  if (time != event.time) {
+    return time > event.time;
+  }
+  if (particle != event.particle) {
+    return particle > event.particle;
+  }
+  return other > event.other;
+}
+
+EventDrivenEngine::EventDrivenEngine(const Box &box) : kBox_(box) { }
+
+void EventDrivenEngine::Reset() {
+  initialized_ = false;
+  time_ = 0;
+}
+
+void EventDrivenEngine::Advance(ParticleStore &particles, double duration) {
+  if (!initialized_ || particles.Size() != x_.size()) {
+    Initialize(particles);
+  }
+
+  double target = time_ + duration;
+  size_t max_events = kMaxEventsPerParticle * x_.size() + 1024;
+
+  while (!events_.empty() && events_.front().time <= target) {
+    std::pop_heap(events_.begin(), events_.end(), std::greater<Event>());
+    Event event = events_.back();
+    events_.pop_back();
+    if (!IsValid(event)) {
+      continue;
+    }
+
+    time_ = event.time;
+    size_t i = event.particle;
+    MoveToNow(i);
+
+    switch (event.type) {
+      case EventType::kParticle: {
+        size_t j = event.other;
+        MoveToNow(j);
+        double dx = kBox_.MinimumImageX(x_[i] - x_[j]);
+        double dy = kBox_.MinimumImageY(y_[i] - y_[j]);
+        double distance_squared = dx * dx + dy * dy;
+        if (distance_squared > 0) {
+          // Same elastic response as PhysicsEngine::GetVelocityAfterCollision.
+          double constant = ((vx_[i] - vx_[j]) * dx + (vy_[i] - vy_[j]) * dy) /
+                            distance_squared;
+          double total = inverse_mass_[i] + inverse_mass_[j];
+          double ratio_i = 2 * inverse_mass_[i] / total * constant;
+          double ratio_j = 2 * inverse_mass_[j] / total * constant;
+          vx_[i] -= ratio_i * dx;
+          vy_[i] -= ratio_i * dy;
+          vx_[j] += ratio_j * dx;
+          vy_[j] += ratio_j * dy;
+        }
+        ++counts_[i];
+        ++counts_[j];
+        ++collision_count_;
+        particles.SpeedChanged()[i] = 1;
+        particles.SpeedChanged()[j] = 1;
+
+        PredictWalls(i);
+        PredictParticles(i);
+        PredictCellCrossing(i);
+        PredictWalls(j);
+        PredictParticles(j);
+        PredictCellCrossing(j);
+        break;
+      }
+      case EventType::kWallX:
+      case EventType::kWallY:
+        if (event.type == EventType::kWallX) {
+          wall_impulse_ += 2 * std::fabs(vx_[i]) / inverse_mass_[i];
+          vx_[i] = -vx_[i];
+        } else {
+          wall_impulse_ += 2 * std::fabs(vy_[i]) / inverse_mass_[i];
+          vy_[i] = -vy_[i];
+        }
+        ++counts_[i];
+        ++wall_hit_count_;
+
+        PredictWalls(i);
+        PredictParticles(i);
+        PredictCellCrossing(i);
+        break;
+      case EventType::kCellCrossing: {
+        size_t column = cell_of_[i] % columns_;
+        size_t row = cell_of_[i] / columns_;
+        // In a periodic box a particle leaving the last cell comes back in
+        // at the first, shifted by the size of the box.
+        if (event.other == kPositiveX) {
+          if (++column == columns_) {
+            column = 0;
+            x_[i] -= kBox_.GetWidth();
+          }
+        } else if (event.other == kNegativeX) {
+          if (column == 0) {
+            column = columns_;
+            x_[i] += kBox_.GetWidth();
+          }
+          --column;
+        } else if (event.other == kPositiveY) {
+          if (++row == rows_) {
+            row = 0;
+            y_[i] -= kBox_.GetHeight();
+          }
+        } else {
+          if (row == 0) {
+            row = rows_;
+            y_[i] += kBox_.GetHeight();
+          }
+          --row;
+        }
+        RemoveFromCell(i);
+        InsertIntoCell(i, row * columns_ + column);
+
+        // The collision count stays the same, so the particle's earlier
+        // predictions stay valid and only new neighbours need checking.
+        PredictParticles(i);
+        PredictCellCrossing(i);
+        break;
+      }
+    }
+
+    if (events_.size() > max_events) {
+      for (size_t k = 0; k < x_.size(); ++k) {
+        MoveToNow(k);
+      }
+      PredictAll();
+    }
+  }
+
+  time_ = target;
+  float *x = particles.PositionX();
+  float *y = particles.PositionY();
+  float *vx = particles.VelocityX();
+  float *vy = particles.VelocityY();
+  for (size_t i = 0; i < x_.size(); ++i) {
+    MoveToNow(i);
+    x[i] = static_cast<float>(x_[i]);
+    y[i] = static_cast<float>(y_[i]);
+    vx[i] = static_cast<float>(vx_[i]);
+    vy[i] = static_cast<float>(vy_[i]);
+  }
+}
+
+size_t EventDrivenEngine::GetCollisionCount() const {
+  return collision_count_;
+}
+
+size_t EventDrivenEngine::GetWallHitCount() const {
+  return wall_hit_count_;
+}
+
+double EventDrivenEngine::GetWallImpulse() const {
+  return wall_impulse_;
+}
+
+double EventDrivenEngine::GetTime() const {
+  return time_;
+}
+
+void EventDrivenEngine::Initialize(const ParticleStore &particles) {
+  size_t count = particles.Size();
+  x_.assign(particles.PositionX(), particles.PositionX() + count);
+  y_.assign(particles.PositionY(), particles.PositionY() + count);
+  vx_.assign(particles.VelocityX(), particles.VelocityX() + count);
+  vy_.assign(particles.VelocityY(), particles.VelocityY() + count);
+  inverse_mass_.assign(particles.InverseMass(),
+                       particles.InverseMass() + count);
+  radius_.assign(particles.Radius(), particles.Radius() + count);
+  species_.assign(particles.SpeciesId(), particles.SpeciesId() + count);
+  species_bounds_ = kBox_.GetSpeciesBounds(particles);
+  last_update_.assign(count, time_);
+  counts_.assign(count, 0);
+
+  // Cells must be at least as wide as the largest touching distance.
+  double max_radius = 0;
+  for (double radius : radius_) {
+    max_radius = std::max(max_radius, radius);
+  }
+  double width = kBox_.GetWidth();
+  double height = kBox_.GetHeight();
+  double min_cell_size = std::max(2 * max_radius, 1.0);
+  double cells_per_unit = std::sqrt(kMaxCellsPerParticle * count /
+                                    (width * height));
+  double columns = std::min(std::floor(width / min_cell_size),
+                            std::floor(width * cells_per_unit));
+  double rows = std::min(std::floor(height / min_cell_size),
+                         std::floor(height * cells_per_unit));
+  columns_ = static_cast<size_t>(std::max(columns, 1.0));
+  rows_ = static_cast<size_t>(std::max(rows, 1.0));
+  cell_width_ = width / static_cast<double>(columns_);
+  cell_height_ = height / static_cast<double>(rows_);
+
+  cell_heads_.assign(columns_ * rows_, kNone);
+  next_in_cell_.assign(count, kNone);
+  prev_in_cell_.assign(count, kNone);
+  cell_of_.assign(count, 0);
+  for (size_t i = 0; i < count; ++i) {
+    InsertIntoCell(
+        i, SpatialGrid::CellCoordinate(y_[i], kBox_.GetMinY(), cell_height_,
+                                       rows_) * columns_ +
+               SpatialGrid::CellCoordinate(x_[i], kBox_.GetMinX(),
+                                           cell_width_, columns_));
+  }
+
+  PredictAll();
+  initialized_ = true;
+}
+
+void EventDrivenEngine::PredictAll() {
+  // Keeps the capacity, so rebuilding the queue does not allocate.
+  events_.clear();
+  for (size_t i = 0; i < x_.size(); ++i) {
+    PredictWalls(i);
+    PredictParticles(i);
+    PredictCellCrossing(i);
+  }
+}
+
+void EventDrivenEngine::PushEvent(const Event &event) {
+  events_.push_back(event);
+  std::push_heap(events_.begin(), events_.end(), std::greater<Event>());
+}
+
+void EventDrivenEngine::PredictWalls(size_t i) {
+  if (kBox_.IsPeriodic()) {
+    return;
+  }
+  const WallBounds &bounds = species_bounds_[species_[i]];
+
+  if (vx_[i] != 0) {
+    double bound = vx_[i] > 0 ? bounds.upper_x : bounds.lower_x;
+    double delay = std::max((bound - x_[i]) / vx_[i], 0.0);
+    PushEvent({time_ + delay, static_cast<uint32_t>(i), 0, counts_[i], 0,
+               EventType::kWallX});
+  }
+  if (vy_[i] != 0) {
+    double bound = vy_[i] > 0 ? bounds.upper_y : bounds.lower_y;
+    double delay = std::max((bound - y_[i]) / vy_[i], 0.0);
+    PushEvent({time_ + delay, static_cast<uint32_t>(i), 0, counts_[i], 0,
+               EventType::kWallY});
+  }
+}
+
+void EventDrivenEngine::PredictParticles(size_t i) {
+  size_t rows[3];
+  size_t columns[3];
+  const bool periodic = kBox_.IsPeriodic();
+  size_t row_count = SpatialGrid::NeighborCoordinates(cell_of_[i] / columns_,
+                                                      rows_, periodic, rows);
+  size_t column_count = SpatialGrid::NeighborCoordinates(
+      cell_of_[i] % columns_, columns_, periodic, columns);
+
+  // With fewer than four cells along an axis of a periodic box, a
+  // neighbour's nearest image need not be the one it will hit, so the
+  // images on either side are tried as well.
+  const int x_images = periodic && columns_ < 4 ? 1 : 0;
+  const int y_images = periodic && rows_ < 4 ? 1 : 0;
+
+  for (size_t r = 0; r < row_count; ++r) {
+    for (size_t c = 0; c < column_count; ++c) {
+      for (uint32_t j = cell_heads_[rows[r] * columns_ + columns[c]];
+           j != kNone; j = next_in_cell_[j]) {
+        if (j == i) {
+          continue;
+        }
+
+        double elapsed = time_ - last_update_[j];
+        double dx = kBox_.MinimumImageX(x_[j] + vx_[j] * elapsed - x_[i]);
+        double dy = kBox_.MinimumImageY(y_[j] + vy_[j] * elapsed - y_[i]);
+        for (int image_x = -x_images; image_x <= x_images; ++image_x) {
+          for (int image_y = -y_images; image_y <= y_images; ++image_y) {
+            PredictPair(i, j, dx + image_x * kBox_.GetWidth(),
+                        dy + image_y * kBox_.GetHeight());
+          }
+        }
+      }
+    }
+  }
+}
+
+void EventDrivenEngine::PredictPair(size_t i, size_t j, double dx,
+                                    double dy) {
+  IDEALGAS_PROFILE_COUNT(FrameCounter::kPairsTested, 1);
+  double dvx = vx_[j] - vx_[i];
+  double dvy = vy_[j] - vy_[i];
+  double dvdr = dx * dvx + dy * dvy;
+  if (dvdr >= 0) {
+    return;
+  }
+
+  double sigma = radius_[i] + radius_[j];
+  double dvdv = dvx * dvx + dvy * dvy;
+  double drdr = dx * dx + dy * dy;
+  double discriminant = dvdr * dvdr - dvdv * (drdr - sigma * sigma);
+  if (discriminant < 0) {
+    return;
+  }
+
+  // Overlapping particles that are still closing in collide at once.
+  double delay = 0;
+  if (drdr > sigma * sigma) {
+    delay = std::max(-(dvdr + std::sqrt(discriminant)) / dvdv, 0.0);
+  }
+  PushEvent({time_ + delay, static_cast<uint32_t>(i),
+             static_cast<uint32_t>(j), counts_[i], counts_[j],
+             EventType::kParticle});
+}
+
+void EventDrivenEngine::PredictCellCrossing(size_t i) {
+  size_t column = cell_of_[i] % columns_;
+  size_t row = cell_of_[i] / columns_;
+  double delay = std::numeric_limits<double>::infinity();
+  uint32_t direction = kNone;
+
+  // The edges of a periodic box are crossings into the cells opposite.
+  const bool periodic = kBox_.IsPeriodic();
+  const double min_x = kBox_.GetMinX();
+  if (vx_[i] > 0 && (periodic || column + 1 < columns_)) {
+    delay = (min_x + (column + 1) * cell_width_ - x_[i]) / vx_[i];
+    direction = kPositiveX;
+  } else if (vx_[i] < 0 && (periodic || column > 0)) {
+    delay = (min_x + column * cell_width_ - x_[i]) / vx_[i];
+    direction = kNegativeX;
+  }
+
+  const double min_y = kBox_.GetMinY();
+  double y_delay = std::numeric_limits<double>::infinity();
+  if (vy_[i] > 0 && (periodic || row + 1 < rows_)) {
+    y_delay = (min_y + (row + 1) * cell_height_ - y_[i]) / vy_[i];
+  } else if (vy_[i] < 0 && (periodic || row > 0)) {
+    y_delay = (min_y + row * cell_height_ - y_[i]) / vy_[i];
+  }
+  if (y_delay < delay) {
+    delay = y_delay;
+    direction = vy_[i] > 0 ? kPositiveY : kNegativeY;
+  }
+
+  if (direction != kNone) {
+    PushEvent({time_ + std::max(delay, 0.0), static_cast<uint32_t>(i),
+               direction, counts_[i], 0, EventType::kCellCrossing});
+  }
+}
+
+void EventDrivenEngine::MoveToNow(size_t i) {
+  double elapsed = time_ - last_update_[i];
+  x_[i] += vx_[i] * elapsed;
+  y_[i] += vy_[i] * elapsed;
+  last_update_[i] = time_;
+}
+
+bool EventDrivenEngine::IsValid(const Event &event) const {
+  if (counts_[event.particle] != event.particle_count) {
+    return false;
+  }
+  return event.type != EventType::kParticle ||
+         counts_[event.other] == event.other_count;
+}
+
+void EventDrivenEngine::InsertIntoCell(size_t i, size_t cell) {
+  uint32_t head = cell_heads_[cell];
+  next_in_cell_[i] = head;
+  prev_in_cell_[i] = kNone;
+  if (head != kNone) {
+    prev_in_cell_[head] = static_cast<uint32_t>(i);
+  }
+  cell_heads_[cell] = static_cast<uint32_t>(i);
+  cell_of_[i] = static_cast<uint32_t>(cell);
+}
+
+void EventDrivenEngine::RemoveFromCell(size_t i) {
+  uint32_t next = next_in_cell_[i];
+  uint32_t prev = prev_in_cell_[i];
+  if (prev != kNone) {
+    next_in_cell_[prev] = next;
+  } else {
+    cell_heads_[cell_of_[i]] = next;
+  }
+  if (next != kNone) {
+    prev_in_cell_[next] = prev;
+  }
+}
+
+}  // namespace idealgas
@@ -0,0 +1,202 @@
+#include "frame_profiler.h"
+
+#include <algorithm>
+#include <stdexcept>
+
+namespace idealgas {
+
+namespace {
+
+thread_local FrameProfiler *active_profiler = nullptr;
+
+/**
+ * Writes nanoseconds as the microseconds of the trace format.
+ */
+double Microseconds(uint64_t nanoseconds) {
+  return static_cast<double>(nanoseconds) / 1000;
+}
+
+}  // namespace
+
+FrameProfiler::FrameProfiler(size_t capacity)
+    : kEpoch_(std::chrono::steady_clock::now()),
+      slots_(new Slot[capacity == 0 ? 1 : capacity]),
+      kCapacity_(capacity),
+      published_(0) {
+  if (capacity == 0) {
+    throw std::invalid_argument("Profiler must keep at least one frame");
+  }
+  for (size_t i = 0; i < kCapacity_; ++i) {
+    slots_[i].sequence.store(0, std::memory_order_relaxed);
+  }
+  for (std::atomic<uint64_t> &count : counts_) {
+    count.store(0, std::memory_order_relaxed);
+  }
+}
+
+void FrameProfiler::BeginFrame(int64_t frame) {
+  current_ = FrameMetrics();
+  current_.frame = frame;
+  for (std::atomic<uint64_t> &count : counts_) {
+    count.store(0, std::memory_order_relaxed);
+  }
+  current_.start_ns = Now();
+}
+
+void FrameProfiler::EndFrame() {
+  current_.duration_ns = Now() - current_.start_ns;
+  for (size_t i = 0; i < kFrameCounterCount; ++i) {
+    current_.counters[i] = counts_[i].load(std::memory_order_relaxed);
+  }
+
+  // A seqlock: readers retry or drop a slot whose sequence changed while
+  // they copied it.
+  uint64_t index = published_.load(std::memory_order_relaxed);
+  Slot &slot = slots_[index % kCapacity_];
+  slot.sequence.store(2 * index + 1, std::memory_order_relaxed);
+  std::atomic_thread_fence(std::memory_order_release);
+  slot.metrics = current_;
+  slot.sequence.store(2 * index + 2, std::memory_order_release);
+  published_.store(index + 1, std::memory_order_release);
+}
+
+void FrameProfiler::AddPhaseTime(FramePhase phase, uint64_t start_ns,
+                                 uint64_t end_ns) {
+  size_t index = static_cast<size_t>(phase);
+  if (current_.phase_ns[index] == 0) {
+    current_.phase_start_ns[index] = start_ns;
+  }
+  current_.phase_ns[index] += end_ns - start_ns;
+}
+
+void FrameProfiler::AddCount(FrameCounter counter, uint64_t amount) {
+  counts_[static_cast<size_t>(counter)].fetch_add(amount,
+                                                  std::memory_order_relaxed);
+}
+
+uint64_t FrameProfiler::Now() const {
+  return static_cast<uint64_t>(
+      std::chrono::duration_cast<std::chrono::nanoseconds>(
+          std::chrono::steady_clock::now() - kEpoch_)
+          .count());
+}
+
+std::vector<FrameMetrics> FrameProfiler::GetRecentFrames() const {
+  uint64_t end = published_.load(std::memory_order_acquire);
+  uint64_t begin = end > kCapacity_ ? end - kCapacity_ : 0;
+  std::vector<FrameMetrics> frames;
+  frames.reserve(static_cast<size_t>(end - begin));
+  for (uint64_t index = begin; index < end; ++index) {
+    const Slot &slot = slots_[index % kCapacity_];
+    uint64_t before = slot.sequence.load(std::memory_order_acquire);
+    FrameMetrics metrics = slot.metrics;
+    std::atomic_thread_fence(std::memory_order_acquire);
+    uint64_t after = slot.sequence.load(std::memory_order_relaxed);
+    if (before == 2 * index + 2 && after == before) {
+      frames.push_back(metrics);
+    }
+  }
+  return frames;
+}
+
+uint64_t FrameProfiler::GetFrameCount() const {
+  return published_.load(std::memory_order_acquire);
+}
+
+void FrameProfiler::WriteChromeTrace(std::ostream &output) const {
+  output << "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[";
+  bool first = true;
+  auto begin_event = [&]() {
+    output << (first ? "\n" : ",\n");
+    first = false;
+  };
+  for (const FrameMetrics &metrics : GetRecentFrames()) {
+    begin_event();
+    output << "{\"name\":\"frame\",\"ph\":\"X\",\"pid\":1,\"tid\":1,"
+           << "\"ts\":" << Microseconds(metrics.start_ns)
+           << ",\"dur\":" << Microseconds(metrics.duration_ns)
+           << ",\"args\":{\"frame\":" << metrics.frame << "}}";
+    for (size_t i = 0; i < kFramePhaseCount; ++i) {
+      if (metrics.phase_ns[i] == 0) {
+        continue;
+      }
+      begin_event();
+      output << "{\"name\":\"" << GetName(static_cast<FramePhase>(i))
+             << "\",\"ph\":\"X\",\"pid\":1,\"tid\":1,"
+             << "\"ts\":" << Microseconds(metrics.phase_start_ns[i])
+             << ",\"dur\":" << Microseconds(metrics.phase_ns[i]) << "}";
+    }
+    begin_event();
+    output << "{\"name\":\"counters\",\"ph\":\"C\",\"pid\":1,"
+           << "\"ts\":" << Microseconds(metrics.start_ns) << ",\"args\":{";
+    for (size_t i = 0; i < kFrameCounterCount; ++i) {
+      output << (i == 0 ? "" : ",") << "\""
+             << GetName(static_cast<FrameCounter>(i))
+             << "\":" << metrics.counters[i];
+    }
+    output << "}}";
+  }
+  output << "\n]}\n";
+}
+
+const char *FrameProfiler::GetName(FramePhase phase) {
+  switch (phase) {
+    case FramePhase::kGridRebuild:
+      return "grid_rebuild";
+    case FramePhase::kCollisions:
+      return "collisions";
+    case FramePhase::kWalls:
+      return "walls";
+    case FramePhase::kIntegration:
+      return "integration";
+    case FramePhase::kEventDriven:
+      return "event_driven";
+    case FramePhase::kStatistics:
+      return "statistics";
+    case FramePhase::kHistograms:
+      return "histograms";
+    case FramePhase::kRecording:
+      return "recording";
+  }
+  return "unknown";
+}
+
+const char *FrameProfiler::GetName(FrameCounter counter) {
+  switch (counter) {
+    case FrameCounter::kPairsTested:
+      return "pairs_tested";
+    case FrameCounter::kCollisionsResolved:
+      return "collisions_resolved";
+    case FrameCounter::kWallHits:
+      return "wall_hits";
+  }
+  return "unknown";
+}
+
+FrameProfiler *FrameProfiler::GetActive() {
+  return active_profiler;
+}
+
+FrameProfiler::Activation::Activation(FrameProfiler *profiler)
+    : previous_(active_profiler) {
+  active_profiler = profiler;
+}
+
+FrameProfiler::Activation::~Activation() {
+  active_profiler = previous_;
+}
+
+ScopedFrame::ScopedFrame(FrameProfiler *profiler, int64_t frame)
+    : activation_(profiler), profiler_(profiler) {
+  if (profiler_ != nullptr) {
+    profiler_->BeginFrame(frame);
+  }
+}
+
+ScopedFrame::~ScopedFrame() {
+  if (profiler_ != nullptr) {
+    profiler_->EndFrame();
+  }
+}
+
+}  // namespace idealgas
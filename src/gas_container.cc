@@ -1,5 +1,12 @@
 #include "gas_container.h"
 
+#include <algorithm>
+#include <cmath>
+#include <glm/geometric.hpp>
+#include <stdexcept>
+
+#include "checkpoint.h"
+
 namespace idealgas {
 
 using std::vector;
@@ -7,188 +14,478 @@ using glm::vec2;
 
 GasContainer::GasContainer(const size_t kWindowLength,
                            const size_t kWindowWidth, const size_t kMargin,
-                           const ci::Color &kBorderColor)
+                           const Color &kBorderColor)
+    : GasContainer(kWindowLength, kWindowWidth, kMargin, kBorderColor, 33, 33,
+                   33) { }
+
+GasContainer::GasContainer(const size_t kWindowLength,
+                           const size_t kWindowWidth, const size_t kMargin,
+                           const Color &kBorderColor, size_t slow_amount,
+                           size_t medium_amount, size_t fast_amount)
+    : GasContainer(kWindowLength, kWindowWidth, kMargin, kBorderColor,
+                   Box::FromWindow(kWindowLength, kMargin), slow_amount,
+                   medium_amount, fast_amount) { }
+
+GasContainer::GasContainer(const size_t kWindowLength,
+                           const size_t kWindowWidth, const size_t kMargin,
+                           const Color &kBorderColor, const Box &box,
+                           size_t slow_amount, size_t medium_amount,
+                           size_t fast_amount)
+    : GasContainer(kWindowLength, kWindowWidth, kMargin, kBorderColor, box,
+                   MakeSpecies(slow_amount, medium_amount, fast_amount)) { }
+
+GasContainer::GasContainer(
+    const size_t kWindowLength, const size_t kWindowWidth,
+    const size_t kMargin, const Color &kBorderColor, const Box &box,
+    const vector<ParticleInitializer::SpeciesAmount> &species)
     : kWindowLength_(kWindowLength),
       kWindowWidth_(kWindowWidth),
       kMargin_(kMargin),
-      kBorderColor_(kBorderColor) {
-  Particle orange_particle(vec2(), vec2(4, 4), 6, 6, fast_color_);
-  Particle red_particle(vec2(), vec2(3, 2), 12, 12, medium_color_);
-  Particle green_particle(vec2(), vec2(2, 2), 18, 18, slow_color_);
-
-  GenerateParticles(particles_, green_particle, 33);
-  GenerateParticles(particles_, red_particle, 33);
-  GenerateParticles(particles_, orange_particle, 33);
-}
-
-void GasContainer::Display() const {
-  for (const auto &particle : particles_) {
-    ci::gl::color(particle.GetColor());
-    ci::gl::drawSolidCircle(particle.GetPosition(),
-                            static_cast<float>(particle.GetRadius()));
-  }
-  ci::gl::color(kBorderColor_);
-  ci::gl::drawStrokedRect(
-      ci::Rectf(vec2(kMargin_, kMargin_),
-                vec2(kWindowLength_ - kMargin_, kWindowLength_ - kMargin_)), 4);
-  DisplayHistogram(vec2(kWindowLength_, kMargin_/2),
-                   vec2(kWindowWidth_ - kMargin_, (kWindowLength_ - 2*kMargin_)/3 + kMargin_/2),
-                  ci::Color("orange"), fast_speeds_);
-  DisplayHistogram(vec2(kWindowLength_, (kWindowLength_ - 2*kMargin_)/3 + kMargin_),
-                   vec2(kWindowWidth_ - kMargin_, 2*(kWindowLength_ - 2*kMargin_)/3 + kMargin_),
-                  ci::Color("red"), medium_speeds_);
-  DisplayHistogram(vec2(kWindowLength_, 2*(kWindowLength_ - 2*kMargin_)/3 + 3*kMargin_/2),
-                   vec2(kWindowWidth_ - kMargin_, kWindowLength_ - kMargin_/2),
-                  ci::Color("green"), slow_speeds_);
-
-  GasContainer::DrawHistogramBoxes();
+      kBorderColor_(kBorderColor),
+      kBox_(box),
+      event_engine_(box),
+      histogram_(num_bins_) {
+  // Every entry is registered, even one with no particles or with the same
+  // prototype as another, so the ids are the positions in the list.
+  vector<ParticleStore::Species> species_table;
+  for (const ParticleInitializer::SpeciesAmount &kind : species) {
+    const Particle &prototype = kind.prototype;
+    species_table.push_back({prototype.GetColor(),
+                             static_cast<int>(prototype.GetMass()),
+                             prototype.GetRadius()});
+  }
+  particles_.Reset(species_table, vector<size_t>(species_table.size(), 0));
+  for (size_t id = 0; id < species.size(); ++id) {
+    AddRandomParticles(particles_, static_cast<uint8_t>(id),
+                       species[id].prototype, species[id].amount);
+  }
 }
 
 void GasContainer::AdvanceOneFrame() {
   ++frames;
-  PhysicsEngine::AdjustVelocitiesOnCollision(particles_);
+  IDEALGAS_PROFILE_FRAME(profiler_, frames);
+  if (engine_mode_ == EngineMode::kEventDriven) {
+    double wall_impulse = event_engine_.GetWallImpulse();
+#if IDEALGAS_PROFILING
+    size_t collision_count = event_engine_.GetCollisionCount();
+    size_t wall_hit_count = event_engine_.GetWallHitCount();
+#endif
+    {
+      IDEALGAS_PROFILE_PHASE(FramePhase::kEventDriven);
+      event_engine_.Advance(particles_, time_step_);
+    }
+    IDEALGAS_PROFILE_COUNT(FrameCounter::kCollisionsResolved,
+                           event_engine_.GetCollisionCount() -
+                               collision_count);
+    IDEALGAS_PROFILE_COUNT(FrameCounter::kWallHits,
+                           event_engine_.GetWallHitCount() - wall_hit_count);
+    if (statistics_enabled_) {
+      IDEALGAS_PROFILE_PHASE(FramePhase::kStatistics);
+      statistics_ = StatisticsReduction::Reduce(particles_, pool_);
+      statistics_.wall_impulse = event_engine_.GetWallImpulse() - wall_impulse;
+      statistics_.pressure = StatisticsReduction::Pressure(
+          statistics_.wall_impulse, kBox_, time_step_);
+    }
+  } else {
+    {
+      IDEALGAS_PROFILE_PHASE(FramePhase::kGridRebuild);
+      if (neighbor_list_) {
+        neighbor_list_->Update(particles_, kBox_, pool_);
+      } else {
+        grid_.Rebuild(particles_, kBox_);
+      }
+    }
+    {
+      IDEALGAS_PROFILE_PHASE(FramePhase::kCollisions);
+      if (neighbor_list_ && pool_ != nullptr) {
+        PhysicsEngine::AdjustVelocitiesOnCollision(particles_, *neighbor_list_,
+                                                   *pool_);
+      } else if (neighbor_list_) {
+        PhysicsEngine::AdjustVelocitiesOnCollision(particles_,
+                                                   *neighbor_list_);
+      } else if (pool_ != nullptr) {
+        PhysicsEngine::AdjustVelocitiesOnCollision(particles_, grid_, *pool_);
+      } else {
+        PhysicsEngine::AdjustVelocitiesOnCollision(particles_, grid_);
+      }
+    }
+    if (statistics_enabled_) {
+      IDEALGAS_PROFILE_PHASE(FramePhase::kStatistics);
+      // Before the move, while the particles that will bounce are still at
+      // or past their walls.
+      if (wall_bounds_.size() != particles_.SpeciesCount()) {
+        wall_bounds_ = kBox_.GetSpeciesBounds(particles_);
+      }
+      statistics_ = StatisticsReduction::ReduceBeforeMove(
+          particles_, kBox_, wall_bounds_, time_step_, pool_);
+    }
 
-  for (auto &particle : particles_) {
-    PhysicsEngine::ParticleWallCollision(kWindowLength_, kMargin_, particle);
-    particle.SetPosition(particle.GetPosition() += particle.GetVelocity());
+    if (HasField()) {
+      Integrate(field_);
+    } else if (integrator_ == IntegratorKind::kEuler && time_step_ == 1) {
+      // The batched kernel gives the same result as Euler with a unit step.
+      if (wall_bounds_.size() != particles_.SpeciesCount()) {
+        wall_bounds_ = kBox_.GetSpeciesBounds(particles_);
+      }
+      PhysicsEngine::MoveParticles(kBox_, wall_bounds_, particles_);
+    } else {
+      Integrate(NoField());
+    }
+  }
+  if (monitor_ != nullptr && monitor_->ShouldSample(frames)) {
+    IDEALGAS_PROFILE_PHASE(FramePhase::kStatistics);
+    CheckConservation();
+  }
+  if (recorder_ != nullptr) {
+    IDEALGAS_PROFILE_PHASE(FramePhase::kRecording);
+    recorder_->Record(particles_, frames);
   }
   // Update every two frames
   if (frames % 2 == 0) {
+    IDEALGAS_PROFILE_PHASE(FramePhase::kHistograms);
     UpdateHistograms();
   }
 }
 
-void GasContainer::GenerateParticles(vector<idealgas::Particle> &particles,
+void GasContainer::GenerateParticles(ParticleStore &particles,
                                      Particle &particle,
                                      size_t particle_amount) {
-  size_t max_particles =
-      pow((kWindowLength_ - 2 * kMargin_) / (2 * particle.GetRadius()), 2);
+  if (particle_amount == 0) {
+    return;
+  }
+  uint8_t species = particles.AddSpecies(
+      {particle.GetColor(), static_cast<int>(particle.GetMass()),
+       particle.GetRadius()});
+  AddRandomParticles(particles, species, particle, particle_amount);
+}
+
+void GasContainer::AddRandomParticles(ParticleStore &particles,
+                                      uint8_t species,
+                                      const Particle &particle,
+                                      size_t particle_amount) const {
+  const size_t diameter = 2 * particle.GetRadius();
+  size_t max_particles = (static_cast<size_t>(kBox_.GetWidth()) / diameter) *
+                         (static_cast<size_t>(kBox_.GetHeight()) / diameter);
   if (particle_amount > max_particles) {
     particle_amount = max_particles;
   }
 
-  size_t lower_bound = kMargin_ + particle.GetRadius();
-  size_t upper_bound = kWindowLength_ - 2 * (kMargin_ + particle.GetRadius());
+  WallBounds bounds = kBox_.GetBounds(particle.GetRadius());
+  size_t x_range = static_cast<size_t>(bounds.upper_x - bounds.lower_x);
+  size_t y_range = static_cast<size_t>(bounds.upper_y - bounds.lower_y);
 
+  const vec2 velocity = particle.GetVelocity();
+  particles.Reserve(particles.Size() + particle_amount);
   for (size_t i = 0; i < particle_amount; ++i) {
-    size_t rand_x_pos = (rand() % (upper_bound + 1)) + lower_bound;
-    size_t rand_y_pos = (rand() % (upper_bound + 1)) + lower_bound;
-
-    particle.SetPosition(vec2(rand_x_pos, rand_y_pos));
-    particles.push_back(particle);
+    size_t rand_x_offset = rand() % (x_range + 1);
+    size_t rand_y_offset = rand() % (y_range + 1);
+    particles.Add(species, bounds.lower_x + rand_x_offset,
+                  bounds.lower_y + rand_y_offset, velocity.x, velocity.y);
   }
 }
 
-void GasContainer::DrawHistogramBoxes() const {
-  ci::gl::drawStringCentered("Speed", vec2((kWindowLength_ + kWindowWidth_ - kMargin_)/2, kMargin_/4));
-  ci::gl::drawStringCentered("1 / λ", vec2(kWindowWidth_ - kMargin_*0.67, kWindowLength_/2));
-  ci::gl::color(kBorderColor_);
-  ci::gl::drawStrokedRect(
-      ci::Rectf(vec2(kWindowLength_, kMargin_/2),
-                vec2(kWindowWidth_ - kMargin_, (kWindowLength_ - 2*kMargin_)/3 + kMargin_/2)), 2);
-  ci::gl::drawStrokedRect(
-      ci::Rectf(vec2(kWindowLength_, (kWindowLength_ - 2*kMargin_)/3 + kMargin_),
-                vec2(kWindowWidth_ - kMargin_, 2*(kWindowLength_ - 2*kMargin_)/3 + kMargin_)), 2);
-  ci::gl::drawStrokedRect(
-      ci::Rectf(vec2(kWindowLength_, 2*(kWindowLength_ - 2*kMargin_)/3 + 3*kMargin_/2),
-                vec2(kWindowWidth_ - kMargin_, kWindowLength_ - kMargin_/2)), 2);
+void GasContainer::InitializeParticles(
+    const ParticleInitializer &initializer, size_t slow_amount,
+    size_t medium_amount, size_t fast_amount) {
+  InitializeParticles(initializer,
+                      MakeSpecies(slow_amount, medium_amount, fast_amount));
 }
 
-void GasContainer::UpdateHistograms() {
-  ResetHistograms();
-  int max_speed = MaxParticleSpeed();
-  for (auto & particle : particles_) {
-    for (size_t bin = 0; bin < num_bins_; ++bin) {
-      if (particle.GetSpeed() <= max_speed * (static_cast<double>((bin + 1.0) / num_bins_))) {
-        if (particle.GetColor() == fast_color_) {
-          fast_speeds_[bin] += 1;
-        } else if (particle.GetColor() == medium_color_) {
-          medium_speeds_[bin] += 1;
-        } else if (particle.GetColor() == slow_color_) {
-          slow_speeds_[bin] += 1;
-        }
-        break;
-      }
-    }
+void GasContainer::InitializeParticles(
+    const ParticleInitializer &initializer,
+    const vector<ParticleInitializer::SpeciesAmount> &species) {
+  initializer.Generate(kBox_, species, particles_, pool_);
+  wall_bounds_ = kBox_.GetSpeciesBounds(particles_);
+  event_engine_.Reset();
+  if (neighbor_list_) {
+    neighbor_list_->Invalidate();
   }
+  histogram_.Invalidate();
+  if (monitor_ != nullptr) {
+    monitor_->Rebase();
+  }
+}
 
+void GasContainer::UpdateHistograms() {
+  histogram_.Update(particles_);
   CalculateMaxHeight();
 }
 
-void GasContainer::DisplayHistogram(const glm::vec2 &top_left_corner,
-                                    const glm::vec2 &bottom_right_corner,
-                                    const ci::Color &color,
-                                    std::map<int, int> speeds) const {
+void GasContainer::ResetHistograms() {
+  histogram_.Clear();
+}
+
+int GasContainer::MaxParticleSpeed() const {
+  return static_cast<int>(
+      StatisticsReduction::Reduce(particles_, pool_).max_speed);
+}
+
+void GasContainer::SlowDownParticles() {
+  float *vx = particles_.VelocityX();
+  float *vy = particles_.VelocityY();
+  for (size_t i = 0; i < particles_.Size(); ++i) {
+    vx[i] *= 0.5f;
+    vy[i] *= 0.5f;
+  }
+  event_engine_.Reset();
+  histogram_.Invalidate();
+  if (monitor_ != nullptr) {
+    monitor_->Rescale(0.5);
+  }
+}
+
+void GasContainer::SpeedUpParticles() {
+  float *vx = particles_.VelocityX();
+  float *vy = particles_.VelocityY();
+  for (size_t i = 0; i < particles_.Size(); ++i) {
+    vx[i] *= 2.0f;
+    vy[i] *= 2.0f;
+  }
+  event_engine_.Reset();
+  histogram_.Invalidate();
+  if (monitor_ != nullptr) {
+    monitor_->Rescale(2);
+  }
+}
 
-  float bin_width = (bottom_right_corner.x - top_left_corner.x) / static_cast<float>(num_bins_);
+std::map<int, int> GasContainer::GetMap(const Color& color) const {
+  // Colours are only compared once per species, not per bin or particle.
+  std::map<int, int> speeds;
   for (size_t bin = 0; bin < num_bins_; ++bin) {
-    float bin_height_ratio = static_cast<float>(static_cast<float>(speeds[bin])/(max_height_ * 1.0));
-    ci::gl::color(color);
-    ci::gl::drawStrokedRect(
-        ci::Rectf(vec2(top_left_corner.x + bin*bin_width,
-                       bottom_right_corner.y - ((bottom_right_corner.y - top_left_corner.y) * bin_height_ratio * 0.95)),
-                  vec2(top_left_corner.x + (bin + 1.0) * bin_width, bottom_right_corner.y)), 2);
+    speeds[static_cast<int>(bin)] = 0;
+  }
+  for (size_t id = 0; id < particles_.SpeciesCount(); ++id) {
+    uint8_t species = static_cast<uint8_t>(id);
+    if (particles_.GetSpecies(species).color != color) {
+      continue;
+    }
+    for (size_t bin = 0; bin < num_bins_; ++bin) {
+      speeds[static_cast<int>(bin)] +=
+          static_cast<int>(histogram_.GetCount(species, bin));
+    }
   }
+  return speeds;
 }
 
-void GasContainer::ResetHistograms() {
+std::map<int, int> GasContainer::GetSpeciesMap(uint8_t species) const {
+  std::map<int, int> speeds;
   for (size_t bin = 0; bin < num_bins_; ++bin) {
-    slow_speeds_[bin] = 0;
-    medium_speeds_[bin] = 0;
-    fast_speeds_[bin] = 0;
+    speeds[static_cast<int>(bin)] =
+        static_cast<int>(histogram_.GetCount(species, bin));
   }
+  return speeds;
 }
 
-int GasContainer::MaxParticleSpeed() const {
-  double max_speed = 0;
-  for (auto & particle : particles_) {
-    double particle_speed = particle.GetSpeed();
-    if (particle_speed > max_speed) {
-      max_speed = particle_speed;
-    }
+ArrayView<uint32_t> GasContainer::GetSpeciesCounts(uint8_t species) const {
+  return histogram_.GetCounts(species);
+}
+
+size_t GasContainer::GetSpeciesCount() const {
+  return particles_.SpeciesCount();
+}
+
+void GasContainer::SetThreadPool(ThreadPool *pool) {
+  pool_ = pool;
+}
+
+void GasContainer::SetNeighborListSkin(double skin) {
+  if (skin == 0) {
+    neighbor_list_.reset();
+  } else {
+    neighbor_list_.reset(new NeighborList(skin));
   }
+}
 
-  return static_cast<int>(max_speed);
+const NeighborList *GasContainer::GetNeighborList() const {
+  return neighbor_list_.get();
 }
 
-void GasContainer::SlowDownParticles() {
-  for (auto & particle : particles_) {
-    particle.SetVelocity(particle.GetVelocity() * glm::vec2(0.5, 0.5));
+void GasContainer::SetFrameProfiler(FrameProfiler *profiler) {
+  profiler_ = profiler;
+}
+
+void GasContainer::SetTrajectoryRecorder(TrajectoryRecorder *recorder) {
+  recorder_ = recorder;
+}
+
+void GasContainer::SetConservationMonitor(ConservationMonitor *monitor) {
+  monitor_ = monitor;
+  if (monitor_ != nullptr) {
+    monitor_->Rebase();
   }
 }
 
-void GasContainer::SpeedUpParticles() {
-  for (auto & particle : particles_) {
-    particle.SetVelocity(particle.GetVelocity() * glm::vec2(2, 2));
+void GasContainer::SetEngineMode(EngineMode mode) {
+  engine_mode_ = mode;
+  event_engine_.Reset();
+}
+
+EngineMode GasContainer::GetEngineMode() const {
+  return engine_mode_;
+}
+
+void GasContainer::SetIntegrator(IntegratorKind integrator) {
+  integrator_ = integrator;
+}
+
+IntegratorKind GasContainer::GetIntegrator() const {
+  return integrator_;
+}
+
+void GasContainer::SetTimeStep(float time_step) {
+  if (!(time_step > 0) || std::isinf(time_step)) {
+    throw std::invalid_argument("Time step must be a positive number");
   }
+  time_step_ = time_step;
 }
 
-std::map<int, int> GasContainer::GetMap(const ci::Color& color) const {
-  if (color == fast_color_) {
-    return fast_speeds_;
-  } else if (color == medium_color_) {
-    return medium_speeds_;
-  } else {
-    return slow_speeds_;
+float GasContainer::GetTimeStep() const {
+  return time_step_;
+}
+
+void GasContainer::SetGravity(const vec2 &acceleration) {
+  field_.first.x = acceleration.x;
+  field_.first.y = acceleration.y;
+  if (monitor_ != nullptr) {
+    monitor_->Rebase();
   }
 }
-void GasContainer::CalculateMaxHeight() {
-  int max_height = 0;
-  for (auto const& speed : fast_speeds_) {
-    if (speed.second > max_height) {
-      max_height = speed.second;
-    }
+
+void GasContainer::SetCentralField(const CentralField &field) {
+  field_.second = field;
+  if (monitor_ != nullptr) {
+    monitor_->Rebase();
   }
+}
 
-  for (auto const& speed : medium_speeds_) {
-    if (speed.second > max_height) {
-      max_height = speed.second;
-    }
+void GasContainer::SetStatisticsEnabled(bool enabled) {
+  statistics_enabled_ = enabled;
+}
+
+const GasStatistics &GasContainer::GetStatistics() const {
+  return statistics_;
+}
+
+template <typename Field>
+void GasContainer::Integrate(const Field &field) {
+  if (wall_bounds_.size() != particles_.SpeciesCount()) {
+    wall_bounds_ = kBox_.GetSpeciesBounds(particles_);
+  }
+  switch (integrator_) {
+    case IntegratorKind::kEuler:
+      PhysicsEngine::MoveParticles<EulerIntegrator>(
+          kBox_, wall_bounds_, particles_, field, time_step_);
+      break;
+    case IntegratorKind::kVelocityVerlet:
+      PhysicsEngine::MoveParticles<VelocityVerletIntegrator>(
+          kBox_, wall_bounds_, particles_, field, time_step_);
+      break;
+    case IntegratorKind::kLeapfrog:
+      PhysicsEngine::MoveParticles<LeapfrogIntegrator>(
+          kBox_, wall_bounds_, particles_, field, time_step_);
+      break;
   }
+}
+
+bool GasContainer::HasField() const {
+  return field_.first.x != 0 || field_.first.y != 0 ||
+         field_.second.strength != 0;
+}
 
-  for (auto const& speed : slow_speeds_) {
-    if (speed.second > max_height) {
-      max_height = speed.second;
+void GasContainer::CheckConservation() {
+  // Without a field the move keeps every speed and only walls turn
+  // velocities, so statistics taken before the move still hold after it.
+  GasStatistics statistics = statistics_enabled_
+                                 ? statistics_
+                                 : StatisticsReduction::Reduce(particles_,
+                                                               pool_);
+  // Fields only act in the time-stepped engine.
+  bool field = HasField() && engine_mode_ == EngineMode::kTimeStepped;
+  monitor_->Check(statistics, frames, !field,
+                  !field && kBox_.IsPeriodic());
+}
+
+void GasContainer::SaveCheckpoint(const std::string &path) const {
+  Checkpoint::Save(path, particles_, frames,
+                   {kWindowLength_, kWindowWidth_, kMargin_, kBox_.GetMinX(),
+                    kBox_.GetMinY(), kBox_.GetMaxX(), kBox_.GetMaxY(),
+                    static_cast<uint64_t>(kBox_.GetBoundary())});
+}
+
+void GasContainer::LoadCheckpoint(const std::string &path) {
+  Checkpoint checkpoint(path);
+  Checkpoint::Geometry geometry = checkpoint.GetGeometry();
+  Box box(geometry.box_min_x, geometry.box_min_y, geometry.box_max_x,
+          geometry.box_max_y, static_cast<Boundary>(geometry.boundary));
+  if (geometry.window_length != kWindowLength_ ||
+      geometry.window_width != kWindowWidth_ || geometry.margin != kMargin_ ||
+      box != kBox_) {
+    throw std::invalid_argument("Checkpoint is from a container of another size");
+  }
+
+  checkpoint.Restore(particles_);
+  wall_bounds_ = kBox_.GetSpeciesBounds(particles_);
+  frames = static_cast<int>(checkpoint.GetFrame());
+  event_engine_.Reset();
+  if (neighbor_list_) {
+    neighbor_list_->Invalidate();
+  }
+  histogram_.Invalidate();
+  UpdateHistograms();
+  if (monitor_ != nullptr) {
+    monitor_->Rebase();
+  }
+}
+
+vector<ParticleInitializer::SpeciesAmount> GasContainer::MakeSpecies(
+    size_t slow_amount, size_t medium_amount, size_t fast_amount) const {
+  return {{Particle(vec2(), vec2(2, 2), 18, 18, "green"), slow_amount},
+          {Particle(vec2(), vec2(3, 2), 12, 12, "red"), medium_amount},
+          {Particle(vec2(), vec2(4, 4), 6, 6, "orange"), fast_amount}};
+}
+
+const ParticleStore &GasContainer::GetParticles() const {
+  return particles_;
+}
+
+size_t GasContainer::GetWindowLength() const {
+  return kWindowLength_;
+}
+
+size_t GasContainer::GetWindowWidth() const {
+  return kWindowWidth_;
+}
+
+size_t GasContainer::GetMargin() const {
+  return kMargin_;
+}
+
+const Box &GasContainer::GetBox() const {
+  return kBox_;
+}
+
+const Color &GasContainer::GetBorderColor() const {
+  return kBorderColor_;
+}
+
+size_t GasContainer::GetNumBins() const {
+  return num_bins_;
+}
+
+size_t GasContainer::GetMaxHeight() const {
+  return max_height_;
+}
+
+int GasContainer::GetFrameCount() const {
+  return frames;
+}
+
+void GasContainer::CalculateMaxHeight() {
+  size_t max_height = 0;
+  for (size_t id = 0; id < particles_.SpeciesCount(); ++id) {
+    for (size_t bin = 0; bin < num_bins_; ++bin) {
+      max_height = std::max(
+          max_height, histogram_.GetCount(static_cast<uint8_t>(id), bin));
     }
   }
 
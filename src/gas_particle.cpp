@@ -1,9 +1,11 @@
 #include "gas_particle.h"
 
+#include <glm/geometric.hpp>
+
 namespace idealgas {
 
 Particle::Particle(const glm::vec2& position, const glm::vec2& velocity,
-                   int mass, int radius, const ci::Color& color)
+                   int mass, int radius, const Color& color)
     : position_(position),
       velocity_(velocity),
       mass_(mass),
@@ -15,11 +17,11 @@ double Particle::GetSpeed() const {
   return glm::length(velocity_);
 }
 
-glm::vec2 Particle::GetPosition() const {
+const glm::vec2 &Particle::GetPosition() const {
   return position_;
 }
 
-glm::vec2 Particle::GetVelocity() const {
+const glm::vec2 &Particle::GetVelocity() const {
   return velocity_;
 }
 
@@ -31,7 +33,7 @@ int Particle::GetRadius() const {
   return radius_;
 }
 
-ci::Color Particle::GetColor() const {
+const Color &Particle::GetColor() const {
   return color_;
 }
 
@@ -4,27 +4,48 @@ namespace idealgas {
 
 
 IdealGasApp::IdealGasApp() : container_(kWindowLength, kWindowWidth,
-                 kMargin, kBorderColor) {
+                 kMargin, kBorderColor), renderer_(container_),
+                 simulation_(container_, SimulationThread::Options()) {
     ci::app::setWindowSize(kWindowWidth, kWindowLength);
+    simulation_.Start();
 }
 
 void IdealGasApp::draw() {
   ci::Color background_color("black");
   ci::gl::clear(background_color);
 
-  container_.Display();
+  renderer_.Display(simulation_.AcquireSnapshot());
 }
 
 void IdealGasApp::update() {
-  container_.AdvanceOneFrame();
+  // The simulation thread advances the container.
+}
+
+void IdealGasApp::cleanup() {
+  simulation_.Stop();
 }
 
 void IdealGasApp::keyDown(cinder::app::KeyEvent event) {
   if (event.getCode() == cinder::app::KeyEvent::KEY_UP) {
-    container_.SpeedUpParticles();
+    simulation_.Post([](GasContainer &container) {
+      container.SpeedUpParticles();
+    });
   }
   if (event.getCode() == cinder::app::KeyEvent::KEY_DOWN) {
-    container_.SlowDownParticles();
+    simulation_.Post([](GasContainer &container) {
+      container.SlowDownParticles();
+    });
+  }
+  if (event.getCode() == cinder::app::KeyEvent::KEY_e) {
+    simulation_.Post([](GasContainer &container) {
+      container.SetEngineMode(
+          container.GetEngineMode() == EngineMode::kEventDriven
+              ? EngineMode::kTimeStepped
+              : EngineMode::kEventDriven);
+    });
+  }
+  if (event.getCode() == cinder::app::KeyEvent::KEY_f) {
+    simulation_.SetAsFastAsPossible(!simulation_.IsAsFastAsPossible());
   }
 }
 
@@ -0,0 +1,175 @@
+#include "gas_statistics.h"
+
+#include <algorithm>
+#include <cmath>
+
+namespace idealgas {
+
+namespace {
+
+// Particles reduced by one task. Fixed, so the order partial sums are
+// added in does not depend on the thread count.
+const size_t kBlockSize = 16384;
+
+// Blocks whose partial sums are held at once by a pooled reduction, enough
+// to keep a pool busy with a million particles per pass.
+const size_t kBlocksPerPass = 64;
+
+/**
+ * Sums over one block of particles.
+ */
+struct PartialSums {
+  double mass = 0;
+  double twice_kinetic_energy = 0;
+  double momentum_x = 0;
+  double momentum_y = 0;
+  double max_squared_speed = 0;
+  double wall_impulse = 0;
+
+  /**
+   * Adds the sums of the next block.
+   */
+  void Add(const PartialSums &sums) {
+    mass += sums.mass;
+    twice_kinetic_energy += sums.twice_kinetic_energy;
+    momentum_x += sums.momentum_x;
+    momentum_y += sums.momentum_y;
+    max_squared_speed = std::max(max_squared_speed, sums.max_squared_speed);
+    wall_impulse += sums.wall_impulse;
+  }
+};
+
+/**
+ * Reduces the particles in [begin, end) in a single loop.
+ * @param walls wall bounds of each species, or nullptr to skip the walls
+ */
+template <typename T>
+PartialSums ReduceBlock(const BasicParticleStore<T> &particles,
+                        const double *mass, const WallBounds *walls,
+                        size_t begin, size_t end) {
+  const T *x = particles.PositionX();
+  const T *y = particles.PositionY();
+  const T *vx = particles.VelocityX();
+  const T *vy = particles.VelocityY();
+  const uint8_t *species = particles.SpeciesId();
+
+  PartialSums sums;
+  for (size_t i = begin; i < end; ++i) {
+    double m = mass[species[i]];
+    double velocity_x = vx[i];
+    double velocity_y = vy[i];
+    double squared_speed = velocity_x * velocity_x + velocity_y * velocity_y;
+    sums.mass += m;
+    sums.twice_kinetic_energy += m * squared_speed;
+    sums.momentum_x += m * velocity_x;
+    sums.momentum_y += m * velocity_y;
+    sums.max_squared_speed = std::max(sums.max_squared_speed, squared_speed);
+
+    if (walls != nullptr) {
+      // The same test as PhysicsEngine::ReflectOffWalls.
+      const WallBounds &wall = walls[species[i]];
+      bool hit_x = (x[i] <= wall.lower_x) | (x[i] >= wall.upper_x);
+      bool hit_y = (y[i] <= wall.lower_y) | (y[i] >= wall.upper_y);
+      sums.wall_impulse += hit_x ? 2 * m * std::fabs(velocity_x) : 0;
+      sums.wall_impulse += hit_y ? 2 * m * std::fabs(velocity_y) : 0;
+    }
+  }
+  return sums;
+}
+
+template <typename T>
+GasStatistics ReduceParticles(const BasicParticleStore<T> &particles,
+                              const WallBounds *walls, ThreadPool *pool) {
+  // Species ids are bytes, so this covers every species without allocating.
+  double masses[256];
+  for (size_t id = 0; id < particles.SpeciesCount(); ++id) {
+    masses[id] = particles.GetSpecies(static_cast<uint8_t>(id)).mass;
+  }
+
+  const size_t count = particles.Size();
+  size_t blocks = (count + kBlockSize - 1) / kBlockSize;
+  auto reduce_block = [&](size_t block) {
+    size_t begin = block * kBlockSize;
+    return ReduceBlock(particles, masses, walls, begin,
+                       std::min(begin + kBlockSize, count));
+  };
+
+  // Either way the block sums are added in block order, so the result does
+  // not depend on the pool.
+  PartialSums total;
+  if (pool != nullptr && blocks > 1) {
+    // The pool reduces up to kBlocksPerPass blocks at a time into this
+    // buffer, which lives on the stack so a frame never allocates for it.
+    PartialSums partial[kBlocksPerPass];
+    for (size_t first = 0; first < blocks; first += kBlocksPerPass) {
+      size_t pass_blocks = std::min(kBlocksPerPass, blocks - first);
+      pool->ParallelFor(pass_blocks, [&](size_t block) {
+        partial[block] = reduce_block(first + block);
+      });
+      for (size_t block = 0; block < pass_blocks; ++block) {
+        total.Add(partial[block]);
+      }
+    }
+  } else {
+    for (size_t block = 0; block < blocks; ++block) {
+      total.Add(reduce_block(block));
+    }
+  }
+
+  GasStatistics statistics;
+  statistics.particle_count = count;
+  statistics.total_mass = total.mass;
+  statistics.kinetic_energy = total.twice_kinetic_energy / 2;
+  // Two degrees of freedom per particle, each holding kT / 2.
+  statistics.temperature =
+      count == 0 ? 0 : statistics.kinetic_energy / static_cast<double>(count);
+  statistics.momentum_x = total.momentum_x;
+  statistics.momentum_y = total.momentum_y;
+  statistics.max_speed = std::sqrt(total.max_squared_speed);
+  statistics.wall_impulse = total.wall_impulse;
+  return statistics;
+}
+
+}  // namespace
+
+template <typename T>
+GasStatistics StatisticsReduction::Reduce(
+    const BasicParticleStore<T> &particles, ThreadPool *pool) {
+  return ReduceParticles(particles, nullptr, pool);
+}
+
+template <typename T>
+GasStatistics StatisticsReduction::ReduceBeforeMove(
+    const BasicParticleStore<T> &particles, const Box &box,
+    const std::vector<WallBounds> &species_bounds, double duration,
+    ThreadPool *pool) {
+  const WallBounds *walls =
+      box.IsPeriodic() ? nullptr : species_bounds.data();
+  GasStatistics statistics = ReduceParticles(particles, walls, pool);
+  statistics.pressure = Pressure(statistics.wall_impulse, box, duration);
+  return statistics;
+}
+
+double StatisticsReduction::Pressure(double wall_impulse, const Box &box,
+                                     double duration) {
+  if (box.IsPeriodic() || !(duration > 0)) {
+    return 0;
+  }
+  double perimeter = 2 * (box.GetWidth() + box.GetHeight());
+  return wall_impulse / (perimeter * duration);
+}
+
+template GasStatistics StatisticsReduction::Reduce(
+    const ParticleStore &particles, ThreadPool *pool);
+template GasStatistics StatisticsReduction::Reduce(
+    const DoubleParticleStore &particles, ThreadPool *pool);
+template GasStatistics StatisticsReduction::ReduceBeforeMove(
+    const ParticleStore &particles, const Box &box,
+    const std::vector<WallBounds> &species_bounds, double duration,
+    ThreadPool *pool);
+template GasStatistics StatisticsReduction::ReduceBeforeMove(
+    const DoubleParticleStore &particles, const Box &box,
+    const std::vector<WallBounds> &species_bounds, double duration,
+    ThreadPool *pool);
+
+}  // namespace idealgas
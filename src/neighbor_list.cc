@@ -0,0 +1,213 @@
+#include "neighbor_list.h"
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <stdexcept>
+
+namespace idealgas {
+
+namespace {
+
+// Particles listed by one task of a parallel rebuild.
+const size_t kBlockSize = 4096;
+
+}  // namespace
+
+NeighborList::NeighborList(double skin) : kSkin_(skin) {
+  if (!(skin >= 0) || !std::isfinite(skin)) {
+    throw std::invalid_argument("Neighbour list skin must be at least 0");
+  }
+}
+
+template <typename T>
+bool NeighborList::Update(const BasicParticleStore<T> &particles,
+                          const Box &box, ThreadPool *pool) {
+  if (!NeedsRebuild(particles, box)) {
+    return false;
+  }
+  Rebuild(particles, box, pool);
+  return true;
+}
+
+template <typename T>
+void NeighborList::Rebuild(const BasicParticleStore<T> &particles,
+                           const Box &box, ThreadPool *pool) {
+  const size_t count = particles.Size();
+  if (count >= std::numeric_limits<uint32_t>::max()) {
+    throw std::length_error("Too many particles for a neighbour list");
+  }
+  grid_.Rebuild(particles, box, kSkin_);
+  periodic_ = box.IsPeriodic();
+  box_ = box;
+
+  const T *x = particles.PositionX();
+  const T *y = particles.PositionY();
+  const T *radius = particles.Radius();
+  reference_x_.assign(x, x + count);
+  reference_y_.assign(y, y + count);
+
+  // Each block lists its particles' neighbours on its own, then the blocks
+  // are joined in order. The buffers are kept, so later rebuilds of a list
+  // of the same size do not allocate.
+  size_t blocks = (count + kBlockSize - 1) / kBlockSize;
+  std::vector<std::vector<uint32_t>> &block_neighbors = block_neighbors_;
+  if (block_neighbors.size() < blocks) {
+    block_neighbors.resize(blocks);
+  }
+  offsets_.assign(count + 1, 0);
+  ForEachBlock(count, kBlockSize, pool, [&](size_t begin, size_t end) {
+    std::vector<uint32_t> &listed = block_neighbors[begin / kBlockSize];
+    listed.clear();
+    thread_local std::vector<size_t> candidates;
+    for (size_t i = begin; i < end; ++i) {
+      grid_.FindNeighbors(i, candidates);
+      size_t before = listed.size();
+      for (size_t j : candidates) {
+        double dx = static_cast<double>(x[i]) - x[j];
+        double dy = static_cast<double>(y[i]) - y[j];
+        if (periodic_) {
+          dx = box_.MinimumImageX(dx);
+          dy = box_.MinimumImageY(dy);
+        }
+        double reach = static_cast<double>(radius[i]) + radius[j] + kSkin_;
+        if (dx * dx + dy * dy <= reach * reach) {
+          listed.push_back(static_cast<uint32_t>(j));
+        }
+      }
+      offsets_[i + 1] = static_cast<uint32_t>(listed.size() - before);
+    }
+  });
+
+  for (size_t i = 0; i < count; ++i) {
+    offsets_[i + 1] += offsets_[i];
+  }
+  neighbors_.resize(offsets_[count]);
+  ForEachBlock(count, kBlockSize, pool, [&](size_t begin, size_t) {
+    const std::vector<uint32_t> &listed = block_neighbors[begin / kBlockSize];
+    std::copy(listed.begin(), listed.end(),
+              neighbors_.begin() + offsets_[begin]);
+  });
+
+  BuildTiles();
+  species_count_ = particles.SpeciesCount();
+  valid_ = true;
+  ++rebuild_count_;
+}
+
+template <typename T>
+bool NeighborList::NeedsRebuild(const BasicParticleStore<T> &particles,
+                                const Box &box) const {
+  const size_t count = particles.Size();
+  if (!valid_ || count != reference_x_.size() ||
+      particles.SpeciesCount() != species_count_ ||
+      box.IsPeriodic() != periodic_ || (periodic_ && box != box_)) {
+    return true;
+  }
+
+  // Two particles each moving half the skin towards each other close at
+  // most the whole skin, so pairs outside the list still cannot touch.
+  const T *x = particles.PositionX();
+  const T *y = particles.PositionY();
+  const double *reference_x = reference_x_.data();
+  const double *reference_y = reference_y_.data();
+  double max_squared = 0;
+  if (periodic_) {
+    for (size_t i = 0; i < count; ++i) {
+      double dx = box_.MinimumImageX(x[i] - reference_x[i]);
+      double dy = box_.MinimumImageY(y[i] - reference_y[i]);
+      max_squared = std::max(max_squared, dx * dx + dy * dy);
+    }
+  } else {
+    for (size_t i = 0; i < count; ++i) {
+      double dx = x[i] - reference_x[i];
+      double dy = y[i] - reference_y[i];
+      max_squared = std::max(max_squared, dx * dx + dy * dy);
+    }
+  }
+  double half_skin = kSkin_ / 2;
+  return max_squared > half_skin * half_skin;
+}
+
+void NeighborList::Invalidate() {
+  valid_ = false;
+}
+
+double NeighborList::GetSkin() const {
+  return kSkin_;
+}
+
+const std::vector<uint32_t> &NeighborList::GetOffsets() const {
+  return offsets_;
+}
+
+const std::vector<uint32_t> &NeighborList::GetNeighbors() const {
+  return neighbors_;
+}
+
+size_t NeighborList::GetPairCount() const {
+  return neighbors_.size();
+}
+
+size_t NeighborList::GetRebuildCount() const {
+  return rebuild_count_;
+}
+
+const Box *NeighborList::GetPeriodicBox() const {
+  return periodic_ ? &box_ : nullptr;
+}
+
+bool NeighborList::HasTiles() const {
+  return has_tiles_;
+}
+
+size_t NeighborList::GetTileCount(size_t colour) const {
+  return colour_tiles_[colour + 1] - colour_tiles_[colour];
+}
+
+void NeighborList::GetTileRange(size_t colour, size_t tile, size_t &begin,
+                                size_t &end) const {
+  size_t index = colour_tiles_[colour] + tile;
+  begin = tile_starts_[index];
+  end = tile_starts_[index + 1];
+}
+
+const std::vector<uint32_t> &NeighborList::GetTileParticles() const {
+  return tile_particles_;
+}
+
+void NeighborList::BuildTiles() {
+  has_tiles_ = grid_.CanColourTiles();
+  tile_particles_.clear();
+  tile_starts_.assign(1, 0);
+  std::fill(colour_tiles_, colour_tiles_ + 5, 0);
+  if (!has_tiles_) {
+    return;
+  }
+
+  thread_local std::vector<size_t> in_tile;
+  for (size_t colour = 0; colour < 4; ++colour) {
+    for (size_t tile = 0; tile < grid_.GetTileCount(colour); ++tile) {
+      grid_.FindParticlesInTile(colour, tile, in_tile);
+      tile_particles_.insert(tile_particles_.end(), in_tile.begin(),
+                             in_tile.end());
+      tile_starts_.push_back(tile_particles_.size());
+    }
+    colour_tiles_[colour + 1] = tile_starts_.size() - 1;
+  }
+}
+
+template bool NeighborList::Update(const ParticleStore &particles,
+                                   const Box &box, ThreadPool *pool);
+template bool NeighborList::Update(const DoubleParticleStore &particles,
+                                   const Box &box, ThreadPool *pool);
+template void NeighborList::Rebuild(const ParticleStore &particles,
+                                    const Box &box, ThreadPool *pool);
+template void NeighborList::Rebuild(const DoubleParticleStore &particles,
+                                    const Box &box, ThreadPool *pool);
+template bool NeighborList::NeedsRebuild(const ParticleStore &particles,
+                                         const Box &box) const;
+template bool NeighborList::NeedsRebuild(
+    const DoubleParticleStore &particles, const Box &box) const;
+
+}  // namespace idealgas
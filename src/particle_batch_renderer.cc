@@ -0,0 +1,334 @@
+#include "particle_batch_renderer.h"
+
+#include <algorithm>
+#include <cstring>
+#include <stdexcept>
+#include <string>
+
+// Cinder declares the GL functions for the app. Without it, the system
+// headers are used and the functions are linked from libOpenGL.
+#if defined(IDEALGAS_SYSTEM_GL)
+#define GL_GLEXT_PROTOTYPES
+#include <GL/glcorearb.h>
+#else
+#include "cinder/gl/gl.h"
+#endif
+
+namespace idealgas {
+
+namespace {
+
+const size_t kMaxSpecies = 256;
+
+// Attribute locations shared by the shader and the vertex array.
+const GLuint kCornerAttribute = 0;
+const GLuint kPositionXAttribute = 1;
+const GLuint kPositionYAttribute = 2;
+const GLuint kRadiusAttribute = 3;
+const GLuint kSpeciesAttribute = 4;
+
+// Bytes per particle in a region: x, y and radius floats and a species byte.
+const size_t kBytesPerParticle = 3 * sizeof(float) + sizeof(uint8_t);
+
+// Regions start on boundaries every driver accepts for attribute offsets.
+const size_t kRegionAlignment = 256;
+
+const char *kVertexShader = R"(#version 330 core
+layout(location = 0) in vec2 corner;
+layout(location = 1) in float position_x;
+layout(location = 2) in float position_y;
+layout(location = 3) in float radius;
+layout(location = 4) in uint species;
+
+uniform mat4 view_projection;
+uniform vec3 palette[256];
+
+out vec2 offset;
+flat out vec3 color;
+
+void main() {
+  offset = corner;
+  color = palette[species];
+  vec2 position = vec2(position_x, position_y) + corner * radius;
+  gl_Position = view_projection * vec4(position, 0.0, 1.0);
+}
+)";
+
+// Each instance is a square around the particle; corners outside the
+// inscribed circle are discarded.
+const char *kFragmentShader = R"(#version 330 core
+in vec2 offset;
+flat in vec3 color;
+
+out vec4 fragment_color;
+
+void main() {
+  if (dot(offset, offset) > 1.0) {
+    discard;
+  }
+  fragment_color = vec4(color, 1.0);
+}
+)";
+
+GLuint CompileShader(GLenum type, const char *source) {
+  GLuint shader = glCreateShader(type);
+  glShaderSource(shader, 1, &source, nullptr);
+  glCompileShader(shader);
+
+  GLint compiled = GL_FALSE;
+  glGetShaderiv(shader, GL_COMPILE_STATUS, &compiled);
+  if (compiled != GL_TRUE) {
+    char log[1024] = {};
+    glGetShaderInfoLog(shader, sizeof(log), nullptr, log);
+    glDeleteShader(shader);
+    throw std::runtime_error(std::string("Cannot compile particle shader: ") +
+                             log);
+  }
+  return shader;
+}
+
+/**
+ * @return if the context can create persistently mapped buffers
+ */
+bool HasBufferStorage() {
+#if defined(GL_MAP_PERSISTENT_BIT)
+  GLint major = 0;
+  GLint minor = 0;
+  glGetIntegerv(GL_MAJOR_VERSION, &major);
+  glGetIntegerv(GL_MINOR_VERSION, &minor);
+  if (major > 4 || (major == 4 && minor >= 4)) {
+    return true;
+  }
+  GLint extension_count = 0;
+  glGetIntegerv(GL_NUM_EXTENSIONS, &extension_count);
+  for (GLint i = 0; i < extension_count; ++i) {
+    const char *name = reinterpret_cast<const char *>(
+        glGetStringi(GL_EXTENSIONS, static_cast<GLuint>(i)));
+    if (name != nullptr && std::strcmp(name, "GL_ARB_buffer_storage") == 0) {
+      return true;
+    }
+  }
+#endif
+  return false;
+}
+
+const void *BufferOffset(size_t offset) {
+  return reinterpret_cast<const void *>(offset);
+}
+
+}  // namespace
+
+ParticleBatchRenderer::ParticleBatchRenderer() {
+  GLuint vertex_shader = CompileShader(GL_VERTEX_SHADER, kVertexShader);
+  GLuint fragment_shader;
+  try {
+    fragment_shader = CompileShader(GL_FRAGMENT_SHADER, kFragmentShader);
+  } catch (...) {
+    glDeleteShader(vertex_shader);
+    throw;
+  }
+
+  program_ = glCreateProgram();
+  glAttachShader(program_, vertex_shader);
+  glAttachShader(program_, fragment_shader);
+  glLinkProgram(program_);
+  glDeleteShader(vertex_shader);
+  glDeleteShader(fragment_shader);
+
+  GLint linked = GL_FALSE;
+  glGetProgramiv(program_, GL_LINK_STATUS, &linked);
+  if (linked != GL_TRUE) {
+    char log[1024] = {};
+    glGetProgramInfoLog(program_, sizeof(log), nullptr, log);
+    glDeleteProgram(program_);
+    throw std::runtime_error(std::string("Cannot link particle shader: ") +
+                             log);
+  }
+  view_projection_location_ = glGetUniformLocation(program_, "view_projection");
+  palette_location_ = glGetUniformLocation(program_, "palette");
+  buffer_storage_ = HasBufferStorage();
+
+  GLint previous_vertex_array = 0;
+  GLint previous_buffer = 0;
+  glGetIntegerv(GL_VERTEX_ARRAY_BINDING, &previous_vertex_array);
+  glGetIntegerv(GL_ARRAY_BUFFER_BINDING, &previous_buffer);
+
+  const float kCorners[] = {-1, -1, 1, -1, -1, 1, 1, 1};
+  glGenVertexArrays(1, &vertex_array_);
+  glBindVertexArray(vertex_array_);
+  glGenBuffers(1, &quad_buffer_);
+  glBindBuffer(GL_ARRAY_BUFFER, quad_buffer_);
+  glBufferData(GL_ARRAY_BUFFER, sizeof(kCorners), kCorners, GL_STATIC_DRAW);
+  glEnableVertexAttribArray(kCornerAttribute);
+  glVertexAttribPointer(kCornerAttribute, 2, GL_FLOAT, GL_FALSE, 0,
+                        BufferOffset(0));
+
+  const GLuint kInstanceAttributes[] = {kPositionXAttribute, kPositionYAttribute,
+                                        kRadiusAttribute, kSpeciesAttribute};
+  for (GLuint attribute : kInstanceAttributes) {
+    glEnableVertexAttribArray(attribute);
+    glVertexAttribDivisor(attribute, 1);
+  }
+
+  glBindVertexArray(static_cast<GLuint>(previous_vertex_array));
+  glBindBuffer(GL_ARRAY_BUFFER, static_cast<GLuint>(previous_buffer));
+}
+
+ParticleBatchRenderer::~ParticleBatchRenderer() {
+  ReleaseInstanceBuffer();
+  glDeleteBuffers(1, &quad_buffer_);
+  glDeleteVertexArrays(1, &vertex_array_);
+  glDeleteProgram(program_);
+}
+
+void ParticleBatchRenderer::Draw(const ParticleStore &particles,
+                                 const float *view_projection) {
+  size_t count = particles.Size();
+  if (count == 0) {
+    return;
+  }
+
+  GLint previous_program = 0;
+  GLint previous_vertex_array = 0;
+  GLint previous_buffer = 0;
+  glGetIntegerv(GL_CURRENT_PROGRAM, &previous_program);
+  glGetIntegerv(GL_VERTEX_ARRAY_BINDING, &previous_vertex_array);
+  glGetIntegerv(GL_ARRAY_BUFFER_BINDING, &previous_buffer);
+
+  float palette[3 * kMaxSpecies];
+  size_t species_count = std::min(particles.SpeciesCount(), kMaxSpecies);
+  for (size_t id = 0; id < species_count; ++id) {
+    const Color &color = particles.GetSpecies(static_cast<uint8_t>(id)).color;
+    palette[3 * id] = color.r;
+    palette[3 * id + 1] = color.g;
+    palette[3 * id + 2] = color.b;
+  }
+  glUseProgram(program_);
+  glUniformMatrix4fv(view_projection_location_, 1, GL_FALSE, view_projection);
+  glUniform3fv(palette_location_, static_cast<GLsizei>(species_count),
+               palette);
+
+  glBindVertexArray(vertex_array_);
+  Reserve(count);
+  glBindBuffer(GL_ARRAY_BUFFER, instance_buffer_);
+  size_t offset = Upload(particles);
+  glVertexAttribPointer(kPositionXAttribute, 1, GL_FLOAT, GL_FALSE, 0,
+                        BufferOffset(offset));
+  glVertexAttribPointer(kPositionYAttribute, 1, GL_FLOAT, GL_FALSE, 0,
+                        BufferOffset(offset + capacity_ * sizeof(float)));
+  glVertexAttribPointer(kRadiusAttribute, 1, GL_FLOAT, GL_FALSE, 0,
+                        BufferOffset(offset + 2 * capacity_ * sizeof(float)));
+  glVertexAttribIPointer(kSpeciesAttribute, 1, GL_UNSIGNED_BYTE, 0,
+                         BufferOffset(offset + 3 * capacity_ * sizeof(float)));
+  glDrawArraysInstanced(GL_TRIANGLE_STRIP, 0, 4, static_cast<GLsizei>(count));
+
+  if (buffer_storage_) {
+    fences_[region_] = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+    region_ = (region_ + 1) % kRegionCount;
+  }
+
+  glUseProgram(static_cast<GLuint>(previous_program));
+  glBindVertexArray(static_cast<GLuint>(previous_vertex_array));
+  glBindBuffer(GL_ARRAY_BUFFER, static_cast<GLuint>(previous_buffer));
+}
+
+bool ParticleBatchRenderer::IsPersistentlyMapped() const {
+  return mapped_ != nullptr;
+}
+
+size_t ParticleBatchRenderer::GetCapacity() const {
+  return capacity_;
+}
+
+void ParticleBatchRenderer::Reserve(size_t count) {
+  if (count <= capacity_) {
+    return;
+  }
+  ReleaseInstanceBuffer();
+  capacity_ = std::max(count, std::max<size_t>(2 * capacity_, 1024));
+  region_size_ = (capacity_ * kBytesPerParticle + kRegionAlignment - 1) /
+                 kRegionAlignment * kRegionAlignment;
+  region_ = 0;
+
+  glGenBuffers(1, &instance_buffer_);
+  glBindBuffer(GL_ARRAY_BUFFER, instance_buffer_);
+#if defined(GL_MAP_PERSISTENT_BIT)
+  if (buffer_storage_) {
+    const GLbitfield kFlags =
+        GL_MAP_WRITE_BIT | GL_MAP_PERSISTENT_BIT | GL_MAP_COHERENT_BIT;
+    GLsizeiptr size = static_cast<GLsizeiptr>(kRegionCount * region_size_);
+    glBufferStorage(GL_ARRAY_BUFFER, size, nullptr, kFlags);
+    mapped_ = static_cast<unsigned char *>(
+        glMapBufferRange(GL_ARRAY_BUFFER, 0, size, kFlags));
+    if (mapped_ != nullptr) {
+      return;
+    }
+    // Mapping failed, so fall back to a buffer that can be re-specified.
+    buffer_storage_ = false;
+    glDeleteBuffers(1, &instance_buffer_);
+    glGenBuffers(1, &instance_buffer_);
+    glBindBuffer(GL_ARRAY_BUFFER, instance_buffer_);
+  }
+#endif
+  glBufferData(GL_ARRAY_BUFFER, static_cast<GLsizeiptr>(region_size_),
+               nullptr, GL_STREAM_DRAW);
+}
+
+size_t ParticleBatchRenderer::Upload(const ParticleStore &particles) {
+  size_t count = particles.Size();
+  const void *arrays[] = {particles.PositionX(), particles.PositionY(),
+                          particles.Radius(), particles.SpeciesId()};
+  const size_t sizes[] = {sizeof(float), sizeof(float), sizeof(float),
+                          sizeof(uint8_t)};
+
+  if (mapped_ == nullptr) {
+    // Orphaning the storage lets the driver hand out fresh memory instead
+    // of waiting for the previous draw.
+    glBufferData(GL_ARRAY_BUFFER, static_cast<GLsizeiptr>(region_size_),
+                 nullptr, GL_STREAM_DRAW);
+    size_t offset = 0;
+    for (size_t array = 0; array < 4; ++array) {
+      glBufferSubData(GL_ARRAY_BUFFER, static_cast<GLintptr>(offset),
+                      static_cast<GLsizeiptr>(count * sizes[array]),
+                      arrays[array]);
+      offset += capacity_ * sizes[array];
+    }
+    return 0;
+  }
+
+  GLsync fence = static_cast<GLsync>(fences_[region_]);
+  if (fence != nullptr) {
+    const GLuint64 kTimeout = 1000000000;  // nanoseconds
+    GLenum status;
+    do {
+      status = glClientWaitSync(fence, GL_SYNC_FLUSH_COMMANDS_BIT, kTimeout);
+    } while (status == GL_TIMEOUT_EXPIRED);
+    glDeleteSync(fence);
+    fences_[region_] = nullptr;
+  }
+
+  size_t region_offset = region_ * region_size_;
+  size_t offset = region_offset;
+  for (size_t array = 0; array < 4; ++array) {
+    std::memcpy(mapped_ + offset, arrays[array], count * sizes[array]);
+    offset += capacity_ * sizes[array];
+  }
+  return region_offset;
+}
+
+void ParticleBatchRenderer::ReleaseInstanceBuffer() {
+  for (size_t region = 0; region < kRegionCount; ++region) {
+    if (fences_[region] != nullptr) {
+      glDeleteSync(static_cast<GLsync>(fences_[region]));
+      fences_[region] = nullptr;
+    }
+  }
+  if (instance_buffer_ != 0) {
+    // Deleting a mapped buffer unmaps it.
+    glDeleteBuffers(1, &instance_buffer_);
+    instance_buffer_ = 0;
+  }
+  mapped_ = nullptr;
+}
+
+}  // namespace idealgas
@@ -0,0 +1,382 @@
+#include "particle_initializer.h"
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <stdexcept>
+#include <utility>
+#include <vector>
+
+#include "spatial_grid.h"
+
+namespace idealgas {
+
+namespace {
+
+// Purposes of the streams of one particle.
+const uint32_t kPositionStream = 0;
+const uint32_t kVelocityStream = 1;
+
+// Particles handed to a thread at a time.
+const size_t kBlockSize = 16384;
+
+// Upper bound on the number of Poisson-disk cells per particle.
+const double kMaxCellsPerParticle = 4.0;
+
+const uint32_t kNone = std::numeric_limits<uint32_t>::max();
+
+size_t GreatestCommonDivisor(size_t a, size_t b) {
+  while (b != 0) {
+    size_t remainder = a % b;
+    a = b;
+    b = remainder;
+  }
+  return a;
+}
+
+/**
+ * @return largest radius of the species in a store
+ */
+double MaxRadius(const ParticleStore &particles) {
+  int max_radius = 0;
+  for (size_t id = 0; id < particles.SpeciesCount(); ++id) {
+    max_radius = std::max(
+        max_radius, particles.GetSpecies(static_cast<uint8_t>(id)).radius);
+  }
+  return max_radius;
+}
+
+}  // namespace
+
+ParticleInitializer::ParticleInitializer(const Options &options)
+    : kOptions_(options) { }
+
+void ParticleInitializer::Generate(const Box &box,
+                                   const std::vector<SpeciesAmount> &species,
+                                   ParticleStore &particles,
+                                   ThreadPool *pool) const {
+  // Every entry is its own species, even one with no particles or with the
+  // same prototype as another, so the ids are the positions in the list.
+  std::vector<ParticleStore::Species> species_table;
+  std::vector<size_t> counts;
+  std::vector<glm::vec2> velocities;
+  for (const SpeciesAmount &kind : species) {
+    const Particle &prototype = kind.prototype;
+    species_table.push_back({prototype.GetColor(),
+                             static_cast<int>(prototype.GetMass()),
+                             prototype.GetRadius()});
+    counts.push_back(kind.amount);
+    velocities.push_back(prototype.GetVelocity());
+  }
+  particles.Reset(species_table, counts);
+
+  switch (kOptions_.placement) {
+    case Placement::kUniform:
+      PlaceUniformly(box, particles, pool);
+      break;
+    case Placement::kLattice:
+      PlaceOnLattice(box, particles, pool);
+      break;
+    case Placement::kPoissonDisk:
+      PlacePoissonDisk(box, particles, pool);
+      break;
+  }
+
+  float *vx = particles.VelocityX();
+  float *vy = particles.VelocityY();
+  const float *inverse_mass = particles.InverseMass();
+  const uint8_t *species_id = particles.SpeciesId();
+  const size_t count = particles.Size();
+  ForEachBlock(count, kBlockSize, pool, [&](size_t begin, size_t end) {
+    for (size_t i = begin; i < end; ++i) {
+      if (!kOptions_.maxwell_boltzmann) {
+        vx[i] = velocities[species_id[i]].x;
+        vy[i] = velocities[species_id[i]].y;
+        continue;
+      }
+      double deviation = std::sqrt(kOptions_.temperature * inverse_mass[i]);
+      PhiloxStream stream(kOptions_.seed, i, kVelocityStream);
+      double normal_x;
+      double normal_y;
+      stream.NextNormalPair(normal_x, normal_y);
+      vx[i] = static_cast<float>(deviation * normal_x);
+      vy[i] = static_cast<float>(deviation * normal_y);
+    }
+  });
+}
+
+void ParticleInitializer::PlaceUniformly(const Box &box,
+                                         ParticleStore &particles,
+                                         ThreadPool *pool) const {
+  float *x = particles.PositionX();
+  float *y = particles.PositionY();
+  const float *radius = particles.Radius();
+  const bool periodic = box.IsPeriodic();
+  const size_t count = particles.Size();
+  ForEachBlock(count, kBlockSize, pool, [&](size_t begin, size_t end) {
+    // Particles come grouped by species, so the bounds rarely change.
+    float bounds_radius = -1;
+    WallBounds bounds = WallBounds();
+    for (size_t i = begin; i < end; ++i) {
+      if (radius[i] != bounds_radius) {
+        bounds_radius = radius[i];
+        bounds = PositionBounds(box, bounds_radius);
+      }
+      PhiloxStream stream(kOptions_.seed, i, kPositionStream);
+      DrawPosition(bounds, periodic, stream, x[i], y[i]);
+    }
+  });
+}
+
+void ParticleInitializer::PlaceOnLattice(const Box &box,
+                                         ParticleStore &particles,
+                                         ThreadPool *pool) const {
+  float *x = particles.PositionX();
+  float *y = particles.PositionY();
+  size_t count = particles.Size();
+  if (count == 0) {
+    return;
+  }
+
+  // Cells about as square as the box allows, one site at the centre of each.
+  double width = box.GetWidth();
+  double height = box.GetHeight();
+  size_t columns = static_cast<size_t>(
+      std::max(std::ceil(std::sqrt(count * width / height)), 1.0));
+  size_t rows = (count + columns - 1) / columns;
+  double cell_width = width / static_cast<double>(columns);
+  double cell_height = height / static_cast<double>(rows);
+  if (std::min(cell_width, cell_height) < 2.0 * MaxRadius(particles)) {
+    throw std::invalid_argument("Too many particles for a lattice in the box");
+  }
+
+  // Particles come grouped by species, so stepping through the sites with a
+  // stride coprime to their number spreads each species over the box.
+  size_t sites = columns * rows;
+  size_t stride = static_cast<size_t>(0.6180339887 * sites) | 1;
+  while (GreatestCommonDivisor(stride, sites) != 1) {
+    stride += 2;
+  }
+
+  const size_t column_step = stride % columns;
+  const size_t row_step = stride / columns;
+  const double min_x = box.GetMinX();
+  const double min_y = box.GetMinY();
+  ForEachBlock(count, kBlockSize, pool, [&](size_t begin, size_t end) {
+    // Site i * stride mod sites, stepped along without dividing.
+    size_t site = static_cast<size_t>(
+        static_cast<uint64_t>(begin) * stride % sites);
+    size_t column = site % columns;
+    size_t row = site / columns;
+    for (size_t i = begin; i < end; ++i) {
+      x[i] = static_cast<float>(min_x + (column + 0.5) * cell_width);
+      y[i] = static_cast<float>(min_y + (row + 0.5) * cell_height);
+      column += column_step;
+      if (column >= columns) {
+        column -= columns;
+        ++row;
+      }
+      row += row_step;
+      if (row >= rows) {
+        row -= rows;
+      }
+    }
+  });
+}
+
+void ParticleInitializer::PlacePoissonDisk(const Box &box,
+                                           ParticleStore &particles,
+                                           ThreadPool *pool) const {
+  float *x = particles.PositionX();
+  float *y = particles.PositionY();
+  const float *radius = particles.Radius();
+  size_t count = particles.Size();
+  if (count == 0) {
+    return;
+  }
+
+  // First candidates are drawn in parallel; almost all are accepted in a
+  // dilute gas.
+  PlaceUniformly(box, particles, pool);
+
+  // Overlapping particles are at most a diameter apart, so each candidate
+  // is only checked against the cells around it.
+  double width = box.GetWidth();
+  double height = box.GetHeight();
+  double cell_size = std::max(2.0 * MaxRadius(particles), 1.0);
+  double columns = std::max(std::floor(width / cell_size), 1.0);
+  double rows = std::max(std::floor(height / cell_size), 1.0);
+  double max_cells = kMaxCellsPerParticle * count + 16;
+  if (columns * rows > max_cells) {
+    double scale = std::sqrt(columns * rows / max_cells);
+    columns = std::max(std::floor(columns / scale), 1.0);
+    rows = std::max(std::floor(rows / scale), 1.0);
+  }
+  const bool periodic = box.IsPeriodic();
+  size_t column_count = static_cast<size_t>(columns);
+  size_t row_count = static_cast<size_t>(rows);
+  if (periodic) {
+    // An odd count would put cells of one colour side by side across the
+    // edges. Fewer cells are only wider.
+    column_count -= column_count > 2 && column_count % 2 == 1 ? 1 : 0;
+    row_count -= row_count > 2 && row_count % 2 == 1 ? 1 : 0;
+  }
+  const double cell_width = width / column_count;
+  const double cell_height = height / row_count;
+
+  std::vector<uint32_t> cell_heads(column_count * row_count, kNone);
+  std::vector<uint32_t> next_in_cell(count, kNone);
+  auto overlaps = [&](size_t i, size_t row, size_t column) {
+    size_t near_rows[3];
+    size_t near_columns[3];
+    size_t near_row_count = SpatialGrid::NeighborCoordinates(
+        row, row_count, periodic, near_rows);
+    size_t near_column_count = SpatialGrid::NeighborCoordinates(
+        column, column_count, periodic, near_columns);
+    for (size_t r = 0; r < near_row_count; ++r) {
+      for (size_t c = 0; c < near_column_count; ++c) {
+        for (uint32_t j = cell_heads[near_rows[r] * column_count +
+                                     near_columns[c]];
+             j != kNone; j = next_in_cell[j]) {
+          double dx = box.MinimumImageX(x[i] - x[j]);
+          double dy = box.MinimumImageY(y[i] - y[j]);
+          double touching = radius[i] + radius[j];
+          if (dx * dx + dy * dy < touching * touching) {
+            return true;
+          }
+        }
+      }
+    }
+    return false;
+  };
+
+  // Every particle still to be placed tries one candidate per round, which
+  // it keeps in its own position. The candidates are accepted cell by cell
+  // in four passes, one per colour of a 2x2 tiling of the cells. A cell only
+  // adds particles to itself and only looks at the cells next to it, none
+  // of which has its colour, so the rows of one pass run in parallel and
+  // the result does not depend on the number of threads.
+  const uint8_t *species = particles.SpeciesId();
+  std::vector<uint32_t> pending;
+  std::vector<PhiloxStream> streams;
+  std::vector<std::pair<size_t, uint32_t>> by_cell;  // cell, pending slot
+  std::vector<char> accepted;
+  // The particles are numbered by species, and each species is placed
+  // before the next, so a later species of small particles does not break
+  // up the room an earlier one of large particles needs.
+  for (size_t first = 0; first < count;) {
+    size_t last = first + 1;
+    while (last < count && species[last] == species[first]) {
+      ++last;
+    }
+    pending.clear();
+    for (size_t i = first; i < last; ++i) {
+      pending.push_back(static_cast<uint32_t>(i));
+    }
+    streams.clear();
+    for (size_t attempt = 0;
+         attempt < kOptions_.max_attempts && !pending.empty(); ++attempt) {
+      if (attempt == 1) {
+        streams.assign(pending.size(),
+                       PhiloxStream(kOptions_.seed, 0, kPositionStream));
+      }
+      by_cell.resize(pending.size());
+      auto draw = [&](size_t begin, size_t end) {
+        for (size_t k = begin; k < end; ++k) {
+          size_t i = pending[k];
+          if (attempt > 0) {
+            WallBounds bounds = PositionBounds(box, radius[i]);
+            if (attempt == 1) {
+              // Replays the candidate PlaceUniformly drew to get past it.
+              streams[k] = PhiloxStream(kOptions_.seed, i, kPositionStream);
+              DrawPosition(bounds, periodic, streams[k], x[i], y[i]);
+            }
+            DrawPosition(bounds, periodic, streams[k], x[i], y[i]);
+          }
+          size_t column = SpatialGrid::CellCoordinate(
+              x[i], box.GetMinX(), cell_width, column_count);
+          size_t row = SpatialGrid::CellCoordinate(y[i], box.GetMinY(),
+                                                   cell_height, row_count);
+          by_cell[k] = std::make_pair(row * column_count + column,
+                                      static_cast<uint32_t>(k));
+        }
+      };
+      ForEachBlock(pending.size(), kBlockSize, pool, draw);
+      // Within a cell the candidates are taken in particle order.
+      std::sort(by_cell.begin(), by_cell.end());
+
+      accepted.assign(pending.size(), 0);
+      for (size_t colour = 0; colour < 4; ++colour) {
+        const size_t first_row = colour / 2;
+        const size_t first_column = colour % 2;
+        auto accept_row = [&](size_t task) {
+          size_t row = first_row + 2 * task;
+          auto entry = std::lower_bound(
+              by_cell.begin(), by_cell.end(),
+              std::make_pair(row * column_count, static_cast<uint32_t>(0)));
+          for (; entry != by_cell.end() &&
+                 entry->first < (row + 1) * column_count;
+               ++entry) {
+            size_t column = entry->first % column_count;
+            size_t i = pending[entry->second];
+            if (column % 2 != first_column || overlaps(i, row, column)) {
+              continue;
+            }
+            next_in_cell[i] = cell_heads[entry->first];
+            cell_heads[entry->first] = static_cast<uint32_t>(i);
+            accepted[entry->second] = 1;
+          }
+        };
+        size_t tasks = (row_count + 1 - first_row) / 2;
+        if (pool != nullptr) {
+          pool->ParallelFor(tasks, accept_row);
+        } else {
+          for (size_t task = 0; task < tasks; ++task) {
+            accept_row(task);
+          }
+        }
+      }
+
+      size_t kept = 0;
+      for (size_t k = 0; k < pending.size(); ++k) {
+        if (!accepted[k]) {
+          pending[kept] = pending[k];
+          if (!streams.empty()) {
+            streams[kept] = streams[k];
+          }
+          ++kept;
+        }
+      }
+      pending.resize(kept);
+      streams.erase(streams.begin() + std::min(kept, streams.size()),
+                    streams.end());
+    }
+    if (!pending.empty()) {
+      throw std::runtime_error(
+          "Could not place every particle without overlap");
+    }
+    first = last;
+  }
+}
+
+WallBounds ParticleInitializer::PositionBounds(const Box &box,
+                                               float radius) {
+  // A periodic box has no walls to keep clear of.
+  return box.GetBounds(box.IsPeriodic() ? 0 : radius);
+}
+
+void ParticleInitializer::DrawPosition(const WallBounds &bounds,
+                                       bool periodic, PhiloxStream &stream,
+                                       float &x, float &y) {
+  double width = bounds.upper_x - bounds.lower_x;
+  double height = bounds.upper_y - bounds.lower_y;
+  x = static_cast<float>(bounds.lower_x + stream.NextUniform() * width);
+  y = static_cast<float>(bounds.lower_y + stream.NextUniform() * height);
+  if (periodic) {
+    // Rounding to float may land exactly on the far edge.
+    x = x < bounds.upper_x ? x : static_cast<float>(bounds.lower_x);
+    y = y < bounds.upper_y ? y : static_cast<float>(bounds.lower_y);
+  }
+}
+
+}  // namespace idealgas
@@ -0,0 +1,251 @@
+#include "particle_store.h"
+
+#include <stdexcept>
+
+namespace idealgas {
+
+using glm::vec2;
+
+// Species ids are stored in a uint8_t.
+const size_t kMaxSpecies = 256;
+
+template <typename T>
+BasicParticleStore<T>::BasicParticleStore() { }
+
+template <typename T>
+size_t BasicParticleStore<T>::Size() const {
+  return x_.size();
+}
+
+template <typename T>
+void BasicParticleStore<T>::Clear() {
+  x_.clear();
+  y_.clear();
+  vx_.clear();
+  vy_.clear();
+  inverse_mass_.clear();
+  radius_.clear();
+  species_.clear();
+  speed_changed_.clear();
+  species_table_.clear();
+}
+
+template <typename T>
+void BasicParticleStore<T>::Reserve(size_t capacity) {
+  x_.reserve(capacity);
+  y_.reserve(capacity);
+  vx_.reserve(capacity);
+  vy_.reserve(capacity);
+  inverse_mass_.reserve(capacity);
+  radius_.reserve(capacity);
+  species_.reserve(capacity);
+  speed_changed_.reserve(capacity);
+}
+
+template <typename T>
+void BasicParticleStore<T>::Add(const Particle &particle) {
+  uint8_t species =
+      AddSpecies({particle.GetColor(), static_cast<int>(particle.GetMass()),
+                  particle.GetRadius()});
+  x_.push_back(particle.GetPosition().x);
+  y_.push_back(particle.GetPosition().y);
+  vx_.push_back(particle.GetVelocity().x);
+  vy_.push_back(particle.GetVelocity().y);
+  inverse_mass_.push_back(static_cast<T>(1.0 / particle.GetMass()));
+  radius_.push_back(static_cast<T>(particle.GetRadius()));
+  species_.push_back(species);
+  speed_changed_.push_back(1);
+}
+
+template <typename T>
+void BasicParticleStore<T>::Add(uint8_t species, T x, T y, T vx, T vy) {
+  if (species >= species_table_.size()) {
+    throw std::invalid_argument("Particle has an unknown species");
+  }
+  const Species &kind = species_table_[species];
+  x_.push_back(x);
+  y_.push_back(y);
+  vx_.push_back(vx);
+  vy_.push_back(vy);
+  inverse_mass_.push_back(static_cast<T>(1.0 / kind.mass));
+  radius_.push_back(static_cast<T>(kind.radius));
+  species_.push_back(species);
+  speed_changed_.push_back(1);
+}
+
+template <typename T>
+uint8_t BasicParticleStore<T>::AddSpecies(const Species &species) {
+  for (size_t id = 0; id < species_table_.size(); ++id) {
+    const Species &known = species_table_[id];
+    if (known.color == species.color && known.mass == species.mass &&
+        known.radius == species.radius) {
+      return static_cast<uint8_t>(id);
+    }
+  }
+
+  if (species_table_.size() == kMaxSpecies) {
+    throw std::length_error("Too many particle species");
+  }
+  species_table_.push_back(species);
+  return static_cast<uint8_t>(species_table_.size() - 1);
+}
+
+template <typename T>
+void BasicParticleStore<T>::Assign(const std::vector<Species> &species,
+                                   size_t count, const T *x, const T *y,
+                                   const T *vx, const T *vy,
+                                   const T *inverse_mass, const T *radius,
+                                   const uint8_t *species_id) {
+  if (species.size() > kMaxSpecies) {
+    throw std::length_error("Too many particle species");
+  }
+  for (size_t i = 0; i < count; ++i) {
+    if (species_id[i] >= species.size()) {
+      throw std::invalid_argument("Particle has an unknown species");
+    }
+  }
+
+  x_.assign(x, x + count);
+  y_.assign(y, y + count);
+  vx_.assign(vx, vx + count);
+  vy_.assign(vy, vy + count);
+  inverse_mass_.assign(inverse_mass, inverse_mass + count);
+  radius_.assign(radius, radius + count);
+  species_.assign(species_id, species_id + count);
+  speed_changed_.assign(count, 1);
+  species_table_ = species;
+}
+
+template <typename T>
+void BasicParticleStore<T>::Reset(const std::vector<Species> &species,
+                                  const std::vector<size_t> &counts) {
+  if (species.size() > kMaxSpecies) {
+    throw std::length_error("Too many particle species");
+  }
+  if (counts.size() != species.size()) {
+    throw std::invalid_argument("Need one particle count per species");
+  }
+  size_t count = 0;
+  for (size_t amount : counts) {
+    count += amount;
+  }
+
+  x_.assign(count, 0);
+  y_.assign(count, 0);
+  vx_.assign(count, 0);
+  vy_.assign(count, 0);
+  inverse_mass_.clear();
+  radius_.clear();
+  species_.clear();
+  inverse_mass_.reserve(count);
+  radius_.reserve(count);
+  species_.reserve(count);
+  for (size_t id = 0; id < species.size(); ++id) {
+    inverse_mass_.insert(inverse_mass_.end(), counts[id],
+                         static_cast<T>(1.0 / species[id].mass));
+    radius_.insert(radius_.end(), counts[id],
+                   static_cast<T>(species[id].radius));
+    species_.insert(species_.end(), counts[id], static_cast<uint8_t>(id));
+  }
+  speed_changed_.assign(count, 1);
+  species_table_ = species;
+}
+
+template <typename T>
+Particle BasicParticleStore<T>::Get(size_t index) const {
+  const Species &species = species_table_[species_[index]];
+  return Particle(vec2(static_cast<float>(x_[index]),
+                       static_cast<float>(y_[index])),
+                  vec2(static_cast<float>(vx_[index]),
+                       static_cast<float>(vy_[index])),
+                  species.mass, species.radius, species.color);
+}
+
+template <typename T>
+void BasicParticleStore<T>::Set(size_t index, const Particle &particle) {
+  x_[index] = particle.GetPosition().x;
+  y_[index] = particle.GetPosition().y;
+  vx_[index] = particle.GetVelocity().x;
+  vy_[index] = particle.GetVelocity().y;
+  speed_changed_[index] = 1;
+}
+
+template <typename T>
+const ParticleSpecies &BasicParticleStore<T>::GetSpecies(uint8_t id) const {
+  return species_table_[id];
+}
+
+template <typename T>
+size_t BasicParticleStore<T>::SpeciesCount() const {
+  return species_table_.size();
+}
+
+template <typename T>
+T *BasicParticleStore<T>::PositionX() {
+  return x_.data();
+}
+
+template <typename T>
+T *BasicParticleStore<T>::PositionY() {
+  return y_.data();
+}
+
+template <typename T>
+T *BasicParticleStore<T>::VelocityX() {
+  return vx_.data();
+}
+
+template <typename T>
+T *BasicParticleStore<T>::VelocityY() {
+  return vy_.data();
+}
+
+template <typename T>
+const T *BasicParticleStore<T>::PositionX() const {
+  return x_.data();
+}
+
+template <typename T>
+const T *BasicParticleStore<T>::PositionY() const {
+  return y_.data();
+}
+
+template <typename T>
+const T *BasicParticleStore<T>::VelocityX() const {
+  return vx_.data();
+}
+
+template <typename T>
+const T *BasicParticleStore<T>::VelocityY() const {
+  return vy_.data();
+}
+
+template <typename T>
+const T *BasicParticleStore<T>::InverseMass() const {
+  return inverse_mass_.data();
+}
+
+template <typename T>
+const T *BasicParticleStore<T>::Radius() const {
+  return radius_.data();
+}
+
+template <typename T>
+const uint8_t *BasicParticleStore<T>::SpeciesId() const {
+  return species_.data();
+}
+
+template <typename T>
+uint8_t *BasicParticleStore<T>::SpeedChanged() {
+  return speed_changed_.data();
+}
+
+template <typename T>
+const uint8_t *BasicParticleStore<T>::SpeedChanged() const {
+  return speed_changed_.data();
+}
+
+template class BasicParticleStore<float>;
+template class BasicParticleStore<double>;
+
+}  // namespace idealgas
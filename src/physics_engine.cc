@@ -1,26 +1,59 @@
 #include "physics_engine.h"
 
+#include <cmath>
+#include <glm/geometric.hpp>
+
+#include "wall_kernel.h"
+
 using glm::vec2;
 using std::vector;
 
 namespace idealgas {
 
+namespace {
+
+#if IDEALGAS_PROFILING
+/**
+ * Counts the velocity components the walls are about to reverse, in a pass
+ * of its own so the bounce loops stay the same as in other builds.
+ */
+template <typename T>
+void CountWallHits(const vector<WallBounds> &species_bounds,
+                   const BasicParticleStore<T> &particles) {
+  const T *x = particles.PositionX();
+  const T *y = particles.PositionY();
+  const uint8_t *species = particles.SpeciesId();
+  uint64_t hits = 0;
+  for (size_t i = 0; i < particles.Size(); ++i) {
+    const WallBounds &wall = species_bounds[species[i]];
+    hits += (x[i] <= wall.lower_x) | (x[i] >= wall.upper_x);
+    hits += (y[i] <= wall.lower_y) | (y[i] >= wall.upper_y);
+  }
+  IDEALGAS_PROFILE_COUNT(FrameCounter::kWallHits, hits);
+}
+#endif
+
+}  // namespace
+
 PhysicsEngine::PhysicsEngine() { }
 
 void PhysicsEngine::ParticleWallCollision(const size_t window_length,
                                           const size_t margin, Particle& particle) {
-  double lower_bound = margin + particle.GetRadius();
-  double upper_bound = window_length - margin - particle.GetRadius();
+  ParticleWallCollision(Box::FromWindow(window_length, margin), particle);
+}
+
+void PhysicsEngine::ParticleWallCollision(const Box &box, Particle &particle) {
+  WallBounds bounds = box.GetBounds(particle.GetRadius());
 
   double x_pos = particle.GetPosition().x;
   double y_pos = particle.GetPosition().y;
 
-  if (x_pos <= lower_bound || x_pos >= upper_bound) {
+  if (x_pos <= bounds.lower_x || x_pos >= bounds.upper_x) {
     particle.SetVelocity(
         vec2(-particle.GetVelocity().x, particle.GetVelocity().y));
   }
 
-  if (y_pos <= lower_bound || y_pos >= upper_bound) {
+  if (y_pos <= bounds.lower_y || y_pos >= bounds.upper_y) {
     particle.SetVelocity(
         vec2(particle.GetVelocity().x, -particle.GetVelocity().y));
   }
@@ -30,41 +63,364 @@ bool PhysicsEngine::DetectCollision(const Particle& p1, const Particle& p2) {
   vec2 velocity_diff = p1.GetVelocity() - p2.GetVelocity();
   vec2 position_diff = p1.GetPosition() - p2.GetPosition();
 
-  bool is_touching = glm::distance(p1.GetPosition(), p2.GetPosition()) <=
-                     p1.GetRadius() + p2.GetRadius();
+  // Squared lengths, so no square root is taken.
+  float contact = static_cast<float>(p1.GetRadius() + p2.GetRadius());
+  bool is_touching = glm::dot(position_diff, position_diff) <=
+                     contact * contact;
+  bool is_moving_closer = glm::dot(velocity_diff, position_diff) < 0;
+
+  return is_touching && is_moving_closer;
+}
+
+bool PhysicsEngine::DetectCollision(const Particle &p1, const Particle &p2,
+                                    const Box &box) {
+  vec2 velocity_diff = p1.GetVelocity() - p2.GetVelocity();
+  vec2 position_diff = box.MinimumImage(p1.GetPosition() - p2.GetPosition());
+
+  float contact = static_cast<float>(p1.GetRadius() + p2.GetRadius());
+  bool is_touching =
+      glm::dot(position_diff, position_diff) <= contact * contact;
   bool is_moving_closer = glm::dot(velocity_diff, position_diff) < 0;
 
   return is_touching && is_moving_closer;
 }
 
-void PhysicsEngine::AdjustVelocitiesOnCollision(vector<idealgas::Particle> &particles) {
-  for (size_t i = 0; i < particles.size(); ++i) {
-    for (size_t j = i + 1; j < particles.size(); ++j) {
-      if (DetectCollision(particles[i], particles[j])) {
-        vec2 velocity_1 =
-            GetVelocityAfterCollision(particles[i], particles[j]);
-        vec2 velocity_2 =
-            GetVelocityAfterCollision(particles[j], particles[i]);
+template <typename T>
+void PhysicsEngine::AdjustVelocitiesOnCollision(
+    BasicParticleStore<T> &particles) {
+  ScopedFrameCounts counts;
+  for (size_t i = 0; i < particles.Size(); ++i) {
+    counts.Add(FrameCounter::kPairsTested, particles.Size() - i - 1);
+    for (size_t j = i + 1; j < particles.Size(); ++j) {
+      if (ResolveCollision(particles, i, j)) {
+        counts.Add(FrameCounter::kCollisionsResolved, 1);
+      }
+    }
+  }
+}
+
+template <typename T>
+void PhysicsEngine::AdjustVelocitiesOnCollision(
+    BasicParticleStore<T> &particles, const SpatialGrid &grid) {
+  const Box *periodic_box = grid.GetPeriodicBox();
+  // Kept between calls so steady state frames do not allocate.
+  thread_local vector<size_t> neighbors;
+  ScopedFrameCounts counts;
+  for (size_t i = 0; i < particles.Size(); ++i) {
+    grid.FindNeighbors(i, neighbors);
+    counts.Add(FrameCounter::kPairsTested, neighbors.size());
+    for (size_t j : neighbors) {
+      bool collided = periodic_box != nullptr
+                          ? ResolveCollision(particles, i, j, *periodic_box)
+                          : ResolveCollision(particles, i, j);
+      if (collided) {
+        counts.Add(FrameCounter::kCollisionsResolved, 1);
+      }
+    }
+  }
+}
+
+template <typename T>
+void PhysicsEngine::AdjustVelocitiesOnCollision(
+    BasicParticleStore<T> &particles, const SpatialGrid &grid,
+    ThreadPool &pool) {
+  // A tile resolves the pairs whose lower index lies inside it, which reads
+  // and writes particles at most one cell outside the tile, so the tiles of
+  // one colour touch disjoint particles. Grids whose tiles cannot be
+  // coloured are resolved serially.
+  if (!grid.CanColourTiles()) {
+    AdjustVelocitiesOnCollision(particles, grid);
+    return;
+  }
+
+  const Box *periodic_box = grid.GetPeriodicBox();
+  for (size_t colour = 0; colour < 4; ++colour) {
+    if (grid.GetTileCount(colour) == 0) {
+      continue;
+    }
+    pool.ParallelFor(grid.GetTileCount(colour), [&](size_t tile) {
+      thread_local vector<size_t> tile_particles;
+      thread_local vector<size_t> neighbors;
+      ScopedFrameCounts counts;
+      grid.FindParticlesInTile(colour, tile, tile_particles);
+      for (size_t i : tile_particles) {
+        grid.FindNeighbors(i, neighbors);
+        counts.Add(FrameCounter::kPairsTested, neighbors.size());
+        for (size_t j : neighbors) {
+          bool collided =
+              periodic_box != nullptr
+                  ? ResolveCollision(particles, i, j, *periodic_box)
+                  : ResolveCollision(particles, i, j);
+          if (collided) {
+            counts.Add(FrameCounter::kCollisionsResolved, 1);
+          }
+        }
+      }
+    });
+  }
+}
 
-        particles[i].SetVelocity(velocity_1);
-        particles[j].SetVelocity(velocity_2);
+template <typename T>
+void PhysicsEngine::AdjustVelocitiesOnCollision(
+    BasicParticleStore<T> &particles, const NeighborList &list) {
+  const Box *periodic_box = list.GetPeriodicBox();
+  const uint32_t *offsets = list.GetOffsets().data();
+  const uint32_t *neighbors = list.GetNeighbors().data();
+  ScopedFrameCounts counts;
+  for (size_t i = 0; i < particles.Size(); ++i) {
+    counts.Add(FrameCounter::kPairsTested, offsets[i + 1] - offsets[i]);
+    for (uint32_t k = offsets[i]; k < offsets[i + 1]; ++k) {
+      bool collided =
+          periodic_box != nullptr
+              ? ResolveCollision(particles, i, neighbors[k], *periodic_box)
+              : ResolveCollision(particles, i, neighbors[k]);
+      if (collided) {
+        counts.Add(FrameCounter::kCollisionsResolved, 1);
       }
     }
   }
 }
 
+template <typename T>
+void PhysicsEngine::AdjustVelocitiesOnCollision(
+    BasicParticleStore<T> &particles, const NeighborList &list,
+    ThreadPool &pool) {
+  if (!list.HasTiles()) {
+    AdjustVelocitiesOnCollision(particles, list);
+    return;
+  }
+
+  // Tiles keep the particles they were built with, and a particle's
+  // neighbours were within a cell of it then, so tiles of one colour still
+  // touch disjoint particles however far they have moved since.
+  const Box *periodic_box = list.GetPeriodicBox();
+  const uint32_t *offsets = list.GetOffsets().data();
+  const uint32_t *neighbors = list.GetNeighbors().data();
+  const uint32_t *tile_particles = list.GetTileParticles().data();
+  for (size_t colour = 0; colour < 4; ++colour) {
+    if (list.GetTileCount(colour) == 0) {
+      continue;
+    }
+    pool.ParallelFor(list.GetTileCount(colour), [&](size_t tile) {
+      size_t begin;
+      size_t end;
+      list.GetTileRange(colour, tile, begin, end);
+      ScopedFrameCounts counts;
+      for (size_t t = begin; t < end; ++t) {
+        size_t i = tile_particles[t];
+        counts.Add(FrameCounter::kPairsTested, offsets[i + 1] - offsets[i]);
+        for (uint32_t k = offsets[i]; k < offsets[i + 1]; ++k) {
+          bool collided =
+              periodic_box != nullptr
+                  ? ResolveCollision(particles, i, neighbors[k],
+                                     *periodic_box)
+                  : ResolveCollision(particles, i, neighbors[k]);
+          if (collided) {
+            counts.Add(FrameCounter::kCollisionsResolved, 1);
+          }
+        }
+      }
+    });
+  }
+}
+
+template <typename T>
+bool PhysicsEngine::ResolveCollision(BasicParticleStore<T> &particles,
+                                     size_t i, size_t j) {
+  const T *x = particles.PositionX();
+  const T *y = particles.PositionY();
+  return ResolveCollision(particles, i, j, x[i] - x[j], y[i] - y[j]);
+}
+
+template <typename T>
+bool PhysicsEngine::ResolveCollision(BasicParticleStore<T> &particles,
+                                     size_t i, size_t j, const Box &box) {
+  const T *x = particles.PositionX();
+  const T *y = particles.PositionY();
+  return ResolveCollision(particles, i, j,
+                   static_cast<T>(box.MinimumImageX(x[i] - x[j])),
+                   static_cast<T>(box.MinimumImageY(y[i] - y[j])));
+}
+
+template <typename T>
+bool PhysicsEngine::ResolveCollision(BasicParticleStore<T> &particles,
+                                     size_t i, size_t j, T dx, T dy) {
+  T *vx = particles.VelocityX();
+  T *vy = particles.VelocityY();
+  const T *inverse_mass = particles.InverseMass();
+  const T *radius = particles.Radius();
+
+  // Compares squared lengths, so no square root is taken for the pairs
+  // that do not touch.
+  T dvx = vx[i] - vx[j];
+  T dvy = vy[i] - vy[j];
+  T approach = dvx * dx + dvy * dy;
+  T squared_distance = dx * dx + dy * dy;
+  T contact = radius[i] + radius[j];
+  if (!(squared_distance <= contact * contact && approach < 0)) {
+    return false;
+  }
+
+  // 2 * m2 / (m1 + m2) written with inverse masses, times the projection
+  // of the relative velocity on the line between the centres.
+  T impulse = 2 * approach /
+              ((inverse_mass[i] + inverse_mass[j]) * squared_distance);
+  T impulse_i = impulse * inverse_mass[i];
+  T impulse_j = impulse * inverse_mass[j];
+  vx[i] -= impulse_i * dx;
+  vy[i] -= impulse_i * dy;
+  vx[j] += impulse_j * dx;
+  vy[j] += impulse_j * dy;
+  particles.SpeedChanged()[i] = 1;
+  particles.SpeedChanged()[j] = 1;
+  return true;
+}
+
+template <typename T>
+void PhysicsEngine::MoveParticles(
+    const Box &box, const std::vector<WallBounds> &species_bounds,
+    BasicParticleStore<T> &particles) {
+  static const WallKernel::InstructionSet kInstructionSet =
+      WallKernel::Detect();
+#if IDEALGAS_PROFILING
+  if (!box.IsPeriodic() && FrameProfiler::GetActive() != nullptr) {
+    // The fused kernel does not count its bounces, so count them first.
+    CountWallHits(species_bounds, particles);
+  }
+#endif
+  IDEALGAS_PROFILE_PHASE(FramePhase::kIntegration);
+  if (box.IsPeriodic()) {
+    // The kernel would bounce particles near the edges, which a periodic
+    // box does not have.
+    EulerIntegrator::Step(particles, NoField(), 1);
+    WrapIntoBox(box, particles);
+    return;
+  }
+  WallKernel::ReflectAndIntegrate(
+      kInstructionSet, box, species_bounds.data(), particles.Size(),
+      particles.PositionX(), particles.PositionY(), particles.VelocityX(),
+      particles.VelocityY(), particles.Radius(), particles.SpeciesId());
+}
+
+template <typename T>
+void PhysicsEngine::ReflectOffWalls(
+    const std::vector<WallBounds> &species_bounds,
+    BasicParticleStore<T> &particles) {
+  const T *x = particles.PositionX();
+  const T *y = particles.PositionY();
+  T *vx = particles.VelocityX();
+  T *vy = particles.VelocityY();
+  const uint8_t *species = particles.SpeciesId();
+  const WallBounds *bounds = species_bounds.data();
+  const size_t count = particles.Size();
+#if IDEALGAS_PROFILING
+  CountWallHits(species_bounds, particles);
+#endif
+  for (size_t i = 0; i < count; ++i) {
+    const WallBounds &wall = bounds[species[i]];
+    // Selects rather than branches, so the loop vectorizes.
+    bool hit_x = (x[i] <= wall.lower_x) | (x[i] >= wall.upper_x);
+    bool hit_y = (y[i] <= wall.lower_y) | (y[i] >= wall.upper_y);
+    vx[i] = hit_x ? -vx[i] : vx[i];
+    vy[i] = hit_y ? -vy[i] : vy[i];
+  }
+}
+
+template <typename T>
+void PhysicsEngine::WrapIntoBox(const Box &box,
+                                BasicParticleStore<T> &particles) {
+  T *x = particles.PositionX();
+  T *y = particles.PositionY();
+  const T min_x = static_cast<T>(box.GetMinX());
+  const T min_y = static_cast<T>(box.GetMinY());
+  const T max_x = static_cast<T>(box.GetMaxX());
+  const T max_y = static_cast<T>(box.GetMaxY());
+  const T width = max_x - min_x;
+  const T height = max_y - min_y;
+  const size_t count = particles.Size();
+  for (size_t i = 0; i < count; ++i) {
+    // A particle moves less than a box length per step, so one shift is
+    // enough.
+    x[i] += x[i] < min_x ? width : 0;
+    x[i] -= x[i] >= max_x ? width : 0;
+    y[i] += y[i] < min_y ? height : 0;
+    y[i] -= y[i] >= max_y ? height : 0;
+  }
+}
+
 vec2 PhysicsEngine::GetVelocityAfterCollision(const Particle& p1,
                                               const Particle& p2) {
   vec2 velocity_diff = p1.GetVelocity() - p2.GetVelocity();
   vec2 position_diff = p1.GetPosition() - p2.GetPosition();
 
-  double mass_ratio = 2 * p2.GetMass() / (p1.GetMass() + p2.GetMass());
-  double constant = glm::dot(velocity_diff, position_diff) /
-                    pow(glm::length(position_diff), 2);
+  float mass_ratio =
+      static_cast<float>(2 * p2.GetMass() / (p1.GetMass() + p2.GetMass()));
+  float constant = glm::dot(velocity_diff, position_diff) /
+                   glm::dot(position_diff, position_diff);
+
+  return p1.GetVelocity() - mass_ratio * constant * position_diff;
+}
+
+vec2 PhysicsEngine::GetVelocityAfterCollision(const Particle &p1,
+                                              const Particle &p2,
+                                              const Box &box) {
+  vec2 velocity_diff = p1.GetVelocity() - p2.GetVelocity();
+  vec2 position_diff = box.MinimumImage(p1.GetPosition() - p2.GetPosition());
 
-  vec2 new_position = vec2(mass_ratio * constant * position_diff.x,
-                           mass_ratio * constant * position_diff.y);
+  float mass_ratio =
+      static_cast<float>(2 * p2.GetMass() / (p1.GetMass() + p2.GetMass()));
+  float constant = glm::dot(velocity_diff, position_diff) /
+                   glm::dot(position_diff, position_diff);
 
-  return p1.GetVelocity() - new_position;
+  return p1.GetVelocity() - mass_ratio * constant * position_diff;
 }
+
+template void PhysicsEngine::AdjustVelocitiesOnCollision(
+    ParticleStore &particles);
+template void PhysicsEngine::AdjustVelocitiesOnCollision(
+    DoubleParticleStore &particles);
+template void PhysicsEngine::AdjustVelocitiesOnCollision(
+    ParticleStore &particles, const SpatialGrid &grid);
+template void PhysicsEngine::AdjustVelocitiesOnCollision(
+    DoubleParticleStore &particles, const SpatialGrid &grid);
+template void PhysicsEngine::AdjustVelocitiesOnCollision(
+    ParticleStore &particles, const SpatialGrid &grid, ThreadPool &pool);
+template void PhysicsEngine::AdjustVelocitiesOnCollision(
+    DoubleParticleStore &particles, const SpatialGrid &grid,
+    ThreadPool &pool);
+template void PhysicsEngine::AdjustVelocitiesOnCollision(
+    ParticleStore &particles, const NeighborList &list);
+template void PhysicsEngine::AdjustVelocitiesOnCollision(
+    DoubleParticleStore &particles, const NeighborList &list);
+template void PhysicsEngine::AdjustVelocitiesOnCollision(
+    ParticleStore &particles, const NeighborList &list, ThreadPool &pool);
+template void PhysicsEngine::AdjustVelocitiesOnCollision(
+    DoubleParticleStore &particles, const NeighborList &list,
+    ThreadPool &pool);
+template bool PhysicsEngine::ResolveCollision(ParticleStore &particles,
+                                              size_t i, size_t j);
+template bool PhysicsEngine::ResolveCollision(DoubleParticleStore &particles,
+                                              size_t i, size_t j);
+template bool PhysicsEngine::ResolveCollision(ParticleStore &particles,
+                                              size_t i, size_t j,
+                                              const Box &box);
+template bool PhysicsEngine::ResolveCollision(DoubleParticleStore &particles,
+                                              size_t i, size_t j,
+                                              const Box &box);
+template void PhysicsEngine::MoveParticles(
+    const Box &box, const std::vector<WallBounds> &species_bounds,
+    ParticleStore &particles);
+template void PhysicsEngine::MoveParticles(
+    const Box &box, const std::vector<WallBounds> &species_bounds,
+    DoubleParticleStore &particles);
+template void PhysicsEngine::ReflectOffWalls(
+    const std::vector<WallBounds> &species_bounds, ParticleStore &particles);
+template void PhysicsEngine::ReflectOffWalls(
+    const std::vector<WallBounds> &species_bounds,
+    DoubleParticleStore &particles);
+template void PhysicsEngine::WrapIntoBox(const Box &box,
+                                         ParticleStore &particles);
+template void PhysicsEngine::WrapIntoBox(const Box &box,
+                                         DoubleParticleStore &particles);
+
 } // namespace idealgas
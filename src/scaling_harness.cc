@@ -0,0 +1,308 @@
+#include "scaling_harness.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <exception>
+#include <fstream>
+#include <limits>
+#include <memory>
+#include <sstream>
+#include <stdexcept>
+
+#if defined(__unix__) || defined(__APPLE__)
+#include <sys/resource.h>
+#endif
+
+#include "gas_container.h"
+#include "gas_statistics.h"
+#include "particle_initializer.h"
+#include "thread_pool.h"
+
+namespace idealgas {
+
+namespace {
+
+const double kPi = 3.14159265358979323846;
+
+std::invalid_argument Error(const std::string &source, size_t line,
+                            const std::string &message) {
+  return std::invalid_argument(source + ":" + std::to_string(line) + ": " +
+                               message);
+}
+
+/**
+ * @return a field of a row as a number, or throws if it is not one
+ */
+template <typename Number>
+Number ParseField(const std::string &field, const std::string &source,
+                  size_t line, const char *name) {
+  std::istringstream stream(field);
+  Number value;
+  if (!(stream >> value) || !stream.eof()) {
+    throw Error(source, line, std::string("Invalid ") + name + ": " + field);
+  }
+  return value;
+}
+
+std::string Describe(const ScalingResult &result) {
+  return "particles=" + std::to_string(result.particles) +
+         " threads=" + std::to_string(result.threads);
+}
+
+}  // namespace
+
+ScalingHarness::ScalingHarness(const ScalingOptions &options)
+    : options_(options) {
+  if (!(options.area_fraction > 0 && options.area_fraction < 1)) {
+    throw std::invalid_argument("Area fraction must be between 0 and 1");
+  }
+  if (options.radius <= 0 || options.mass <= 0) {
+    throw std::invalid_argument("Radius and mass must be positive");
+  }
+  if (!(options.temperature >= 0)) {
+    throw std::invalid_argument("Temperature must be at least 0");
+  }
+}
+
+ScalingResult ScalingHarness::Run(size_t particles, size_t threads) const {
+  ScalingResult result;
+  result.particles = particles;
+  result.threads = threads;
+  result.steps = options_.steps;
+  try {
+    // Nothing from the previous run counts towards this one's peak.
+    ResetPeakResidentBytes();
+    std::unique_ptr<ThreadPool> pool;
+    if (threads > 0) {
+      pool.reset(new ThreadPool(threads));
+    }
+
+    double length = GetBoxLength(particles);
+    GasContainer container(800, 1280, 80, "white",
+                           Box(0, 0, length, length), {});
+    container.SetThreadPool(pool.get());
+    container.SetNeighborListSkin(options_.skin);
+
+    ParticleInitializer::Options initializer;
+    initializer.seed = options_.seed;
+    initializer.placement = ParticleInitializer::Placement::kLattice;
+    initializer.maxwell_boltzmann = true;
+    initializer.temperature = options_.temperature;
+    Particle prototype(glm::vec2(0, 0), glm::vec2(0, 0), options_.mass,
+                       options_.radius, "white");
+    container.InitializeParticles(ParticleInitializer(initializer),
+                                  {{prototype, particles}});
+
+    double start_energy =
+        StatisticsReduction::Reduce(container.GetParticles(), pool.get())
+            .kinetic_energy;
+    auto start = std::chrono::steady_clock::now();
+    for (size_t step = 0; step < options_.steps; ++step) {
+      container.AdvanceOneFrame();
+    }
+    result.elapsed_ms = std::chrono::duration<double, std::milli>(
+                            std::chrono::steady_clock::now() - start)
+                            .count();
+    double end_energy =
+        StatisticsReduction::Reduce(container.GetParticles(), pool.get())
+            .kinetic_energy;
+
+    if (result.elapsed_ms > 0) {
+      result.particle_steps_per_second =
+          static_cast<double>(particles) * options_.steps * 1000 /
+          result.elapsed_ms;
+    }
+    result.energy_drift =
+        start_energy > 0 ? std::fabs(end_energy - start_energy) / start_energy
+                         : 0;
+    result.peak_rss_bytes = GetPeakResidentBytes();
+    result.succeeded = true;
+  } catch (const std::exception &error) {
+    result.error = error.what();
+  }
+  return result;
+}
+
+std::vector<ScalingResult> ScalingHarness::Run() const {
+  std::vector<ScalingResult> results;
+  for (size_t particles : options_.particle_counts) {
+    for (size_t threads : options_.thread_counts) {
+      results.push_back(Run(particles, threads));
+    }
+  }
+  return results;
+}
+
+double ScalingHarness::GetBoxLength(size_t particles) const {
+  double area = kPi * options_.radius * options_.radius *
+                static_cast<double>(particles) / options_.area_fraction;
+  // Never smaller than one particle, so an empty run still has a box.
+  return std::max(std::sqrt(area), 4.0 * options_.radius);
+}
+
+void ScalingHarness::WriteResults(std::ostream &output,
+                                  const std::vector<ScalingResult> &results) {
+  output << "particles\tthreads\tsteps\tstatus\telapsed_ms"
+            "\tparticle_steps_per_second\tpeak_rss_bytes\tenergy_drift"
+            "\terror\n";
+  for (const ScalingResult &result : results) {
+    output << result.particles << "\t" << result.threads << "\t"
+           << result.steps << "\t" << (result.succeeded ? "ok" : "failed")
+           << "\t" << result.elapsed_ms << "\t"
+           << result.particle_steps_per_second << "\t"
+           << result.peak_rss_bytes << "\t" << result.energy_drift << "\t"
+           << result.error << "\n";
+  }
+}
+
+std::vector<ScalingResult> ScalingHarness::ReadResults(
+    std::istream &input, const std::string &source) {
+  std::vector<ScalingResult> results;
+  std::string text;
+  size_t line = 0;
+  while (std::getline(input, text)) {
+    ++line;
+    if (text.empty() || text[0] == '#' ||
+        text.compare(0, 9, "particles") == 0) {
+      continue;
+    }
+
+    std::vector<std::string> fields;
+    std::istringstream row(text);
+    std::string field;
+    while (std::getline(row, field, '\t')) {
+      fields.push_back(field);
+    }
+    if (fields.size() < 8 || fields.size() > 9) {
+      throw Error(source, line, "Expected 9 tab-separated fields");
+    }
+    if (fields[3] != "ok" && fields[3] != "failed") {
+      throw Error(source, line, "Invalid status: " + fields[3]);
+    }
+
+    ScalingResult result;
+    result.particles = ParseField<size_t>(fields[0], source, line,
+                                          "particle count");
+    result.threads = ParseField<size_t>(fields[1], source, line,
+                                        "thread count");
+    result.steps = ParseField<size_t>(fields[2], source, line, "steps");
+    result.succeeded = fields[3] == "ok";
+    result.elapsed_ms = ParseField<double>(fields[4], source, line,
+                                           "elapsed time");
+    result.particle_steps_per_second = ParseField<double>(
+        fields[5], source, line, "throughput");
+    result.peak_rss_bytes = ParseField<uint64_t>(fields[6], source, line,
+                                                 "peak memory");
+    result.energy_drift = ParseField<double>(fields[7], source, line,
+                                             "energy drift");
+    if (fields.size() == 9) {
+      result.error = fields[8];
+    }
+    results.push_back(result);
+  }
+  return results;
+}
+
+std::vector<std::string> ScalingHarness::FindRegressions(
+    const std::vector<ScalingResult> &results,
+    const std::vector<ScalingResult> &baseline,
+    const ScalingTolerance &tolerance) {
+  std::vector<std::string> regressions;
+  for (const ScalingResult &result : results) {
+    const ScalingResult *expected = nullptr;
+    for (const ScalingResult &candidate : baseline) {
+      if (candidate.particles == result.particles &&
+          candidate.threads == result.threads) {
+        expected = &candidate;
+      }
+    }
+    if (expected == nullptr) {
+      regressions.push_back(Describe(result) + ": not in the baseline");
+      continue;
+    }
+
+    if (!result.succeeded) {
+      if (expected->succeeded) {
+        regressions.push_back(Describe(result) + ": failed: " + result.error);
+      }
+      continue;
+    }
+    if (result.particle_steps_per_second <
+        expected->particle_steps_per_second * (1 - tolerance.throughput)) {
+      std::ostringstream message;
+      message << Describe(result) << ": throughput "
+              << result.particle_steps_per_second
+              << " particle-steps/s is below baseline "
+              << expected->particle_steps_per_second;
+      regressions.push_back(message.str());
+    }
+    if (result.peak_rss_bytes > 0 && expected->peak_rss_bytes > 0 &&
+        static_cast<double>(result.peak_rss_bytes) >
+            static_cast<double>(expected->peak_rss_bytes) *
+                (1 + tolerance.peak_rss)) {
+      std::ostringstream message;
+      message << Describe(result) << ": peak memory " << result.peak_rss_bytes
+              << " bytes is above baseline " << expected->peak_rss_bytes;
+      regressions.push_back(message.str());
+    }
+    if (result.energy_drift >
+        expected->energy_drift + tolerance.energy_drift) {
+      std::ostringstream message;
+      message << Describe(result) << ": energy drift " << result.energy_drift
+              << " is above baseline " << expected->energy_drift;
+      regressions.push_back(message.str());
+    }
+  }
+
+  for (const ScalingResult &expected : baseline) {
+    bool measured = false;
+    for (const ScalingResult &result : results) {
+      measured = measured || (result.particles == expected.particles &&
+                              result.threads == expected.threads);
+    }
+    if (!measured) {
+      regressions.push_back(Describe(expected) +
+                            ": in the baseline but not run");
+    }
+  }
+  return regressions;
+}
+
+uint64_t ScalingHarness::GetPeakResidentBytes() {
+#if defined(__linux__)
+  // VmHWM follows ResetPeakResidentBytes, unlike getrusage.
+  std::ifstream status("/proc/self/status");
+  std::string key;
+  while (status >> key) {
+    if (key == "VmHWM:") {
+      uint64_t kilobytes = 0;
+      status >> kilobytes;
+      return kilobytes * 1024;
+    }
+    status.ignore(std::numeric_limits<std::streamsize>::max(), '\n');
+  }
+#endif
+#if defined(__unix__) || defined(__APPLE__)
+  rusage usage;
+  if (getrusage(RUSAGE_SELF, &usage) == 0) {
+#if defined(__APPLE__)
+    return static_cast<uint64_t>(usage.ru_maxrss);  // in bytes
+#else
+    return static_cast<uint64_t>(usage.ru_maxrss) * 1024;  // in kilobytes
+#endif
+  }
+#endif
+  return 0;
+}
+
+void ScalingHarness::ResetPeakResidentBytes() {
+#if defined(__linux__)
+  // Writing 5 resets VmHWM to the current resident size. Kernels before 4.0
+  // ignore it, and then peaks just keep growing.
+  std::ofstream clear_refs("/proc/self/clear_refs");
+  clear_refs << "5";
+#endif
+}
+
+}  // namespace idealgas
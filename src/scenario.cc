@@ -0,0 +1,414 @@
+#include "scenario.h"
+
+#include <cerrno>
+#include <cmath>
+#include <cstdlib>
+#include <fstream>
+#include <map>
+#include <stdexcept>
+
+namespace idealgas {
+
+namespace {
+
+/**
+ * The value of a setting and the line it was set on.
+ */
+struct Setting {
+  std::string value;
+  size_t line;
+};
+
+/**
+ * The settings of the run, or of one species.
+ */
+struct Section {
+  std::map<std::string, Setting> settings;
+  size_t line;
+};
+
+/**
+ * A key and the values a sweep runs it with.
+ */
+struct Sweep {
+  std::string key;
+  std::vector<std::string> values;
+  size_t line;
+};
+
+std::invalid_argument Error(const std::string &source, size_t line,
+                            const std::string &message) {
+  return std::invalid_argument(source + ":" + std::to_string(line) + ": " +
+                               message);
+}
+
+std::string Trim(const std::string &text) {
+  size_t begin = text.find_first_not_of(" \t\r");
+  if (begin == std::string::npos) {
+    return "";
+  }
+  size_t end = text.find_last_not_of(" \t\r");
+  return text.substr(begin, end - begin + 1);
+}
+
+/**
+ * Splits a value into the words separated by whitespace.
+ */
+std::vector<std::string> Words(const std::string &value) {
+  std::vector<std::string> words;
+  size_t begin = value.find_first_not_of(" \t");
+  while (begin != std::string::npos) {
+    size_t end = value.find_first_of(" \t", begin);
+    words.push_back(value.substr(begin, end - begin));
+    begin = value.find_first_not_of(" \t", end);
+  }
+  return words;
+}
+
+/**
+ * Reads the value of a setting as numbers.
+ */
+class Reader {
+ public:
+  Reader(const std::string &source, const std::string &key,
+         const Setting &setting)
+      : source_(source), key_(key), setting_(setting) { }
+
+  std::vector<double> Numbers(size_t count) const {
+    std::vector<std::string> words = Words(setting_.value);
+    if (words.size() != count) {
+      throw Fail("expects " + std::to_string(count) + " numbers");
+    }
+    std::vector<double> numbers;
+    for (const std::string &word : words) {
+      char *end = nullptr;
+      errno = 0;
+      double number = std::strtod(word.c_str(), &end);
+      if (*end != '\0' || errno == ERANGE || !std::isfinite(number)) {
+        throw Fail("is not a number: " + word);
+      }
+      numbers.push_back(number);
+    }
+    return numbers;
+  }
+
+  double Number() const {
+    return Numbers(1)[0];
+  }
+
+  double Positive() const {
+    double number = Number();
+    if (!(number > 0)) {
+      throw Fail("must be positive");
+    }
+    return number;
+  }
+
+  size_t Count() const {
+    const std::string &value = setting_.value;
+    char *end = nullptr;
+    errno = 0;
+    unsigned long long count = std::strtoull(value.c_str(), &end, 10);
+    if (value.empty() || value[0] == '-' || *end != '\0' || errno == ERANGE) {
+      throw Fail("is not a count: " + value);
+    }
+    return static_cast<size_t>(count);
+  }
+
+  int PositiveInt() const {
+    size_t count = Count();
+    if (count == 0 || count > 1000000) {
+      throw Fail("must be between 1 and 1000000");
+    }
+    return static_cast<int>(count);
+  }
+
+  std::invalid_argument Fail(const std::string &message) const {
+    return Error(source_, setting_.line, key_ + " " + message);
+  }
+
+ private:
+  const std::string &source_;
+  const std::string &key_;
+  const Setting &setting_;
+};
+
+void ReplaceName(std::string &path, const std::string &name) {
+  const std::string kPlaceholder = "{name}";
+  for (size_t at = path.find(kPlaceholder); at != std::string::npos;
+       at = path.find(kPlaceholder, at + name.size())) {
+    path.replace(at, kPlaceholder.size(), name);
+  }
+}
+
+Particle MakePrototype(const std::string &source, const Section &section,
+                       size_t &amount) {
+  std::string color_name = "white";
+  int mass = 1;
+  int radius = 4;
+  glm::vec2 velocity;
+  amount = 0;
+  bool has_count = false;
+  for (const auto &entry : section.settings) {
+    const std::string &key = entry.first;
+    Reader reader(source, key, entry.second);
+    if (key == "color") {
+      color_name = entry.second.value;
+    } else if (key == "mass") {
+      mass = reader.PositiveInt();
+    } else if (key == "radius") {
+      radius = reader.PositiveInt();
+    } else if (key == "velocity") {
+      std::vector<double> components = reader.Numbers(2);
+      velocity = glm::vec2(components[0], components[1]);
+    } else if (key == "count") {
+      amount = reader.Count();
+      has_count = true;
+    } else {
+      throw Error(source, entry.second.line, "Unknown species key: " + key);
+    }
+  }
+  if (!has_count) {
+    throw Error(source, section.line, "Species has no count");
+  }
+
+  Color color;
+  try {
+    color = Color(color_name.c_str());
+  } catch (const std::invalid_argument &error) {
+    throw Error(source, section.settings.at("color").line, error.what());
+  }
+  return Particle(glm::vec2(), velocity, mass, radius, color);
+}
+
+Scenario MakeScenario(const std::string &source,
+                      const std::vector<Section> &sections,
+                      const std::string &name_suffix) {
+  Scenario scenario;
+  const Section &run = sections[0];
+  bool periodic = false;
+  std::vector<double> walls;
+  size_t box_line = 0;
+  for (const auto &entry : run.settings) {
+    const std::string &key = entry.first;
+    const std::string &value = entry.second.value;
+    Reader reader(source, key, entry.second);
+    if (key == "name") {
+      scenario.name = value;
+    } else if (key == "box") {
+      walls = reader.Numbers(4);
+      box_line = entry.second.line;
+    } else if (key == "boundary") {
+      if (value != "reflecting" && value != "periodic") {
+        throw reader.Fail("must be reflecting or periodic");
+      }
+      periodic = value == "periodic";
+    } else if (key == "window") {
+      std::vector<double> window = reader.Numbers(3);
+      for (double size : window) {
+        if (size < 0 || size != static_cast<size_t>(size)) {
+          throw reader.Fail("must be whole sizes");
+        }
+      }
+      scenario.window_length = static_cast<size_t>(window[0]);
+      scenario.window_width = static_cast<size_t>(window[1]);
+      scenario.margin = static_cast<size_t>(window[2]);
+    } else if (key == "engine") {
+      if (value == "time-stepped") {
+        scenario.engine = EngineMode::kTimeStepped;
+      } else if (value == "event-driven") {
+        scenario.engine = EngineMode::kEventDriven;
+      } else {
+        throw reader.Fail("must be time-stepped or event-driven");
+      }
+    } else if (key == "integrator") {
+      if (value == "euler") {
+        scenario.integrator = IntegratorKind::kEuler;
+      } else if (value == "verlet") {
+        scenario.integrator = IntegratorKind::kVelocityVerlet;
+      } else if (value == "leapfrog") {
+        scenario.integrator = IntegratorKind::kLeapfrog;
+      } else {
+        throw reader.Fail("must be euler, verlet or leapfrog");
+      }
+    } else if (key == "dt") {
+      scenario.time_step = static_cast<float>(reader.Positive());
+    } else if (key == "skin") {
+      scenario.skin = reader.Number();
+      if (!(scenario.skin >= 0)) {
+        throw reader.Fail("must not be negative");
+      }
+    } else if (key == "steps") {
+      scenario.steps = reader.Count();
+    } else if (key == "seed") {
+      scenario.initializer.seed = reader.Count();
+    } else if (key == "init") {
+      typedef ParticleInitializer::Placement Placement;
+      if (value == "uniform") {
+        scenario.initializer.placement = Placement::kUniform;
+      } else if (value == "lattice") {
+        scenario.initializer.placement = Placement::kLattice;
+      } else if (value == "poisson") {
+        scenario.initializer.placement = Placement::kPoissonDisk;
+      } else {
+        throw reader.Fail("must be uniform, lattice or poisson");
+      }
+    } else if (key == "temperature") {
+      scenario.initializer.temperature = reader.Positive();
+      scenario.initializer.maxwell_boltzmann = true;
+    } else if (key == "checkpoint") {
+      scenario.checkpoint_path = value;
+    } else if (key == "trajectory") {
+      scenario.trajectory_path = value;
+    } else if (key == "record_every") {
+      scenario.record_every = reader.Count();
+      if (scenario.record_every == 0) {
+        throw reader.Fail("must be positive");
+      }
+    } else {
+      throw Error(source, entry.second.line, "Unknown key: " + key);
+    }
+  }
+
+  Boundary boundary = periodic ? Boundary::kPeriodic : Boundary::kReflecting;
+  try {
+    scenario.box =
+        walls.empty()
+            ? Box::FromWindow(scenario.window_length, scenario.margin,
+                              boundary)
+            : Box(walls[0], walls[1], walls[2], walls[3], boundary);
+  } catch (const std::invalid_argument &error) {
+    throw Error(source, box_line != 0 ? box_line : run.line, error.what());
+  }
+
+  if (sections.size() == 1) {
+    throw Error(source, run.line, "Scenario has no species");
+  }
+  for (size_t i = 1; i < sections.size(); ++i) {
+    size_t amount;
+    Particle prototype = MakePrototype(source, sections[i], amount);
+    scenario.species.push_back({prototype, amount});
+  }
+
+  scenario.name += name_suffix;
+  ReplaceName(scenario.checkpoint_path, scenario.name);
+  ReplaceName(scenario.trajectory_path, scenario.name);
+  return scenario;
+}
+
+/**
+ * Sets a swept key in a copy of the sections.
+ */
+void ApplySweep(const std::string &source, const Sweep &sweep,
+                const std::string &value, std::vector<Section> &sections) {
+  const std::string kSpeciesPrefix = "species.";
+  size_t section = 0;
+  std::string key = sweep.key;
+  if (key.compare(0, kSpeciesPrefix.size(), kSpeciesPrefix) == 0) {
+    size_t dot = key.find('.', kSpeciesPrefix.size());
+    std::string index =
+        key.substr(kSpeciesPrefix.size(), dot - kSpeciesPrefix.size());
+    char *end = nullptr;
+    unsigned long species = std::strtoul(index.c_str(), &end, 10);
+    if (dot == std::string::npos || index.empty() || *end != '\0' ||
+        species + 1 >= sections.size()) {
+      throw Error(source, sweep.line, "No such species setting: " + key);
+    }
+    section = species + 1;
+    key = key.substr(dot + 1);
+  }
+  sections[section].settings[key] = {value, sweep.line};
+}
+
+}  // namespace
+
+std::vector<Scenario> ScenarioFile::Parse(std::istream &input,
+                                          const std::string &source) {
+  std::vector<Section> sections(1);
+  sections[0].line = 1;
+  std::vector<Sweep> sweeps;
+
+  std::string text;
+  for (size_t line = 1; std::getline(input, text); ++line) {
+    text = Trim(text.substr(0, text.find('#')));
+    if (text.empty()) {
+      continue;
+    }
+    if (text == "[species]") {
+      sections.push_back(Section());
+      sections.back().line = line;
+      continue;
+    }
+    size_t equals = text.find('=');
+    if (equals == std::string::npos) {
+      throw Error(source, line, "Expected key = value: " + text);
+    }
+    std::string key = Trim(text.substr(0, equals));
+    std::string value = Trim(text.substr(equals + 1));
+    if (key.empty() || value.empty()) {
+      throw Error(source, line, "Expected key = value: " + text);
+    }
+
+    const std::string kSweepPrefix = "sweep ";
+    if (key.compare(0, kSweepPrefix.size(), kSweepPrefix) == 0) {
+      Sweep sweep = {Trim(key.substr(kSweepPrefix.size())), {}, line};
+      for (const Sweep &other : sweeps) {
+        if (other.key == sweep.key) {
+          throw Error(source, line, "Key swept twice: " + sweep.key);
+        }
+      }
+      size_t begin = 0;
+      while (begin <= value.size()) {
+        size_t comma = value.find(',', begin);
+        std::string item = Trim(value.substr(begin, comma - begin));
+        if (item.empty()) {
+          throw Error(source, line, "Empty value in sweep of " + sweep.key);
+        }
+        sweep.values.push_back(item);
+        begin = comma == std::string::npos ? value.size() + 1 : comma + 1;
+      }
+      sweeps.push_back(sweep);
+      continue;
+    }
+
+    auto &settings = sections.back().settings;
+    if (settings.count(key) != 0) {
+      throw Error(source, line, "Key set twice: " + key);
+    }
+    settings[key] = {value, line};
+  }
+
+  // Counts through every combination of sweep values, the last sweep
+  // changing fastest.
+  std::vector<Scenario> scenarios;
+  std::vector<size_t> choice(sweeps.size(), 0);
+  while (true) {
+    std::vector<Section> swept = sections;
+    std::string suffix;
+    for (size_t i = 0; i < sweeps.size(); ++i) {
+      const std::string &value = sweeps[i].values[choice[i]];
+      ApplySweep(source, sweeps[i], value, swept);
+      suffix += "_" + sweeps[i].key + "=" + value;
+    }
+    scenarios.push_back(MakeScenario(source, swept, suffix));
+
+    size_t i = sweeps.size();
+    while (i > 0 && ++choice[i - 1] == sweeps[i - 1].values.size()) {
+      choice[--i] = 0;
+    }
+    if (i == 0) {
+      break;
+    }
+  }
+  return scenarios;
+}
+
+std::vector<Scenario> ScenarioFile::Load(const std::string &path) {
+  std::ifstream input(path);
+  if (!input) {
+    throw std::runtime_error("Cannot open scenario: " + path);
+  }
+  return Parse(input, path);
+}
+
+}  // namespace idealgas
@@ -0,0 +1,164 @@
+#include "simulation_thread.h"
+
+#include <chrono>
+
+namespace idealgas {
+
+namespace {
+
+// Periods the thread may fall behind before it stops trying to catch up.
+const int kMaxLagPeriods = 5;
+
+}  // namespace
+
+void SimulationSnapshot::CopyFrom(const GasContainer &container) {
+  particles = container.GetParticles();
+  species_speeds.resize(container.GetSpeciesCount());
+  for (size_t id = 0; id < species_speeds.size(); ++id) {
+    ArrayView<uint32_t> counts =
+        container.GetSpeciesCounts(static_cast<uint8_t>(id));
+    if (counts.empty()) {
+      species_speeds[id].assign(container.GetNumBins(), 0);
+    } else {
+      species_speeds[id].assign(counts.begin(), counts.end());
+    }
+  }
+  max_height = container.GetMaxHeight();
+  frame = container.GetFrameCount();
+}
+
+SimulationThread::SimulationThread(GasContainer &container,
+                                   const Options &options)
+    : container_(container),
+      kSnapshotRate_(options.snapshot_rate > 0 ? options.snapshot_rate : 60),
+      substeps_(options.substeps > 0 ? options.substeps : 1),
+      as_fast_as_possible_(options.as_fast_as_possible),
+      step_count_(0) { }
+
+SimulationThread::~SimulationThread() {
+  Stop();
+}
+
+void SimulationThread::Start() {
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (running_) {
+      return;
+    }
+    running_ = true;
+  }
+  step_count_ = 0;
+  PublishSnapshot();
+  thread_ = std::thread(&SimulationThread::Run, this);
+}
+
+void SimulationThread::Stop() {
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (!running_) {
+      return;
+    }
+    running_ = false;
+  }
+  wake_.notify_all();
+  thread_.join();
+
+  // The container belongs to the caller again.
+  RunCommands();
+  PublishSnapshot();
+}
+
+void SimulationThread::Post(std::function<void(GasContainer &)> command) {
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (running_) {
+      commands_.push_back(std::move(command));
+      return;
+    }
+  }
+  command(container_);
+}
+
+void SimulationThread::SetSubsteps(size_t substeps) {
+  substeps_ = substeps > 0 ? substeps : 1;
+}
+
+void SimulationThread::SetAsFastAsPossible(bool as_fast_as_possible) {
+  as_fast_as_possible_ = as_fast_as_possible;
+  {
+    // Taking the lock orders the change before a waiting thread's check.
+    std::lock_guard<std::mutex> lock(mutex_);
+  }
+  wake_.notify_all();
+}
+
+bool SimulationThread::IsAsFastAsPossible() const {
+  return as_fast_as_possible_;
+}
+
+const SimulationSnapshot &SimulationThread::AcquireSnapshot() {
+  snapshots_.Update();
+  return snapshots_.GetReadBuffer();
+}
+
+size_t SimulationThread::GetStepCount() const {
+  return step_count_;
+}
+
+void SimulationThread::Run() {
+  typedef std::chrono::steady_clock Clock;
+  const Clock::duration kPeriod = std::chrono::duration_cast<Clock::duration>(
+      std::chrono::duration<double>(1.0 / kSnapshotRate_));
+  Clock::time_point next_snapshot = Clock::now();
+
+  while (true) {
+    RunCommands();
+    size_t substeps = substeps_;
+    for (size_t step = 0; step < substeps; ++step) {
+      container_.AdvanceOneFrame();
+      ++step_count_;
+    }
+    PublishSnapshot();
+
+    std::unique_lock<std::mutex> lock(mutex_);
+    if (!running_) {
+      break;
+    }
+    if (as_fast_as_possible_) {
+      next_snapshot = Clock::now();
+      continue;
+    }
+
+    // Fixed rate: wait for the next period, without trying to make up for
+    // a long stall all at once.
+    next_snapshot += kPeriod;
+    Clock::time_point now = Clock::now();
+    if (now - next_snapshot > kMaxLagPeriods * kPeriod) {
+      next_snapshot = now;
+    }
+    wake_.wait_until(lock, next_snapshot, [this] {
+      return !running_ || as_fast_as_possible_;
+    });
+    if (!running_) {
+      break;
+    }
+  }
+}
+
+void SimulationThread::RunCommands() {
+  std::vector<std::function<void(GasContainer &)>> commands;
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    commands.swap(commands_);
+  }
+  for (auto &command : commands) {
+    command(container_);
+  }
+}
+
+void SimulationThread::PublishSnapshot() {
+  snapshots_.GetWriteBuffer().CopyFrom(container_);
+  snapshots_.Publish();
+}
+
+}  // namespace idealgas
@@ -0,0 +1,293 @@
+#include "spatial_grid.h"
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+using std::vector;
+
+namespace idealgas {
+
+// Cells are made slightly wider than the largest touching distance so that
+// rounding in the cell lookup can never separate two touching particles.
+const float kCellSlack = 1.001f;
+
+// Upper bound on the number of cells per particle, which keeps sparse or very
+// large domains from allocating a mostly empty grid.
+const double kMaxCellsPerParticle = 4.0;
+
+// Cells along one side of a tile.
+const size_t kTileCells = 4;
+
+namespace {
+
+/**
+ * @param cells cells along one axis of a periodic grid
+ * @return if the tiles along the axis can alternate in colour all the way
+ * round, with the last tile at least two cells wide
+ */
+bool CanColourPeriodically(size_t cells) {
+  size_t tiles = (cells + kTileCells - 1) / kTileCells;
+  return tiles == 1 ||
+         (tiles % 2 == 0 && cells - (tiles - 1) * kTileCells >= 2);
+}
+
+}  // namespace
+
+SpatialGrid::SpatialGrid() { }
+
+template <typename T>
+void SpatialGrid::Rebuild(const BasicParticleStore<T> &particles,
+                          double margin) {
+  size_t particle_count = particles.Size();
+  const T *x = particles.PositionX();
+  const T *y = particles.PositionY();
+  const T *radius = particles.Radius();
+  T max_radius = 0;
+  T min_x = std::numeric_limits<T>::max();
+  T min_y = std::numeric_limits<T>::max();
+  T max_x = std::numeric_limits<T>::lowest();
+  T max_y = std::numeric_limits<T>::lowest();
+
+  for (size_t i = 0; i < particle_count; ++i) {
+    max_radius = std::max(max_radius, radius[i]);
+    min_x = std::min(min_x, x[i]);
+    min_y = std::min(min_y, y[i]);
+    max_x = std::max(max_x, x[i]);
+    max_y = std::max(max_y, y[i]);
+  }
+
+  double width = particle_count == 0 ? 0 : static_cast<double>(max_x) - min_x;
+  double height = particle_count == 0 ? 0 : static_cast<double>(max_y) - min_y;
+  if (!(width >= 0)) {
+    width = 0;
+  }
+  if (!(height >= 0)) {
+    height = 0;
+  }
+
+  double cell_size = std::max(2.0 * max_radius + margin, 1.0) * kCellSlack;
+  double columns = std::floor(width / cell_size) + 1;
+  double rows = std::floor(height / cell_size) + 1;
+  double max_cells = kMaxCellsPerParticle * particle_count + 16;
+  if (columns * rows > max_cells) {
+    cell_size *= std::sqrt(columns * rows / max_cells);
+    columns = std::floor(width / cell_size) + 1;
+    rows = std::floor(height / cell_size) + 1;
+  }
+
+  cell_width_ = cell_size;
+  cell_height_ = cell_size;
+  min_x_ = particle_count == 0 ? 0 : min_x;
+  min_y_ = particle_count == 0 ? 0 : min_y;
+  columns_ = static_cast<size_t>(columns);
+  rows_ = static_cast<size_t>(rows);
+  periodic_ = false;
+  SortIntoCells(particles);
+}
+
+template <typename T>
+void SpatialGrid::Rebuild(const BasicParticleStore<T> &particles,
+                          const Box &box, double margin) {
+  if (!box.IsPeriodic()) {
+    Rebuild(particles, margin);
+    return;
+  }
+
+  size_t particle_count = particles.Size();
+  const T *radius = particles.Radius();
+  T max_radius = 0;
+  for (size_t i = 0; i < particle_count; ++i) {
+    max_radius = std::max(max_radius, radius[i]);
+  }
+
+  // The grid covers the box exactly, so the cells past each edge are the
+  // ones at the opposite edge. Cells are stretched to fit a whole number of
+  // them across, which only makes them larger.
+  double cell_size = std::max(2.0 * max_radius + margin, 1.0) * kCellSlack;
+  double columns = std::max(std::floor(box.GetWidth() / cell_size), 1.0);
+  double rows = std::max(std::floor(box.GetHeight() / cell_size), 1.0);
+  double max_cells = kMaxCellsPerParticle * particle_count + 16;
+  if (columns * rows > max_cells) {
+    double scale = std::sqrt(columns * rows / max_cells);
+    columns = std::max(std::floor(columns / scale), 1.0);
+    rows = std::max(std::floor(rows / scale), 1.0);
+  }
+
+  columns_ = static_cast<size_t>(columns);
+  rows_ = static_cast<size_t>(rows);
+  cell_width_ = box.GetWidth() / columns;
+  cell_height_ = box.GetHeight() / rows;
+  min_x_ = box.GetMinX();
+  min_y_ = box.GetMinY();
+  periodic_ = true;
+  box_ = box;
+  SortIntoCells(particles);
+}
+
+template <typename T>
+void SpatialGrid::SortIntoCells(const BasicParticleStore<T> &particles) {
+  size_t particle_count = particles.Size();
+  const T *x = particles.PositionX();
+  const T *y = particles.PositionY();
+
+  // Counting sort of the particle indices by cell. Indices are visited in
+  // ascending order, so every cell lists its particles in ascending order.
+  size_t cell_count = columns_ * rows_;
+  cell_starts_.assign(cell_count + 1, 0);
+  cell_entries_.resize(particle_count);
+  particle_cells_.resize(particle_count);
+
+  for (size_t i = 0; i < particle_count; ++i) {
+    size_t cell = CellCoordinate(y[i], min_y_, cell_height_, rows_) * columns_ +
+                  CellCoordinate(x[i], min_x_, cell_width_, columns_);
+    particle_cells_[i] = cell;
+    ++cell_starts_[cell + 1];
+  }
+
+  max_cell_particles_ = 0;
+  for (size_t cell = 0; cell < cell_count; ++cell) {
+    max_cell_particles_ = std::max(max_cell_particles_, cell_starts_[cell + 1]);
+    cell_starts_[cell + 1] += cell_starts_[cell];
+  }
+
+  for (size_t i = 0; i < particle_count; ++i) {
+    cell_entries_[cell_starts_[particle_cells_[i]]++] = i;
+  }
+
+  // Filling advanced every start to the start of the next cell.
+  for (size_t cell = cell_count; cell > 0; --cell) {
+    cell_starts_[cell] = cell_starts_[cell - 1];
+  }
+  cell_starts_[0] = 0;
+}
+
+void SpatialGrid::FindNeighbors(size_t index,
+                                vector<size_t> &neighbors) const {
+  // Reserving the most any particle could have keeps the capacity of a
+  // reused vector independent of which particles it was used for.
+  neighbors.clear();
+  neighbors.reserve(std::min(9 * max_cell_particles_, cell_entries_.size()));
+  size_t cell = particle_cells_[index];
+  size_t column = cell % columns_;
+  size_t row = cell / columns_;
+
+  size_t neighbor_rows[3];
+  size_t neighbor_columns[3];
+  size_t row_count = NeighborCoordinates(row, rows_, periodic_, neighbor_rows);
+  size_t column_count =
+      NeighborCoordinates(column, columns_, periodic_, neighbor_columns);
+
+  for (size_t r = 0; r < row_count; ++r) {
+    for (size_t c = 0; c < column_count; ++c) {
+      size_t neighbor_cell = neighbor_rows[r] * columns_ + neighbor_columns[c];
+      for (size_t k = cell_starts_[neighbor_cell];
+           k < cell_starts_[neighbor_cell + 1]; ++k) {
+        if (cell_entries_[k] > index) {
+          neighbors.push_back(cell_entries_[k]);
+        }
+      }
+    }
+  }
+
+  std::sort(neighbors.begin(), neighbors.end());
+}
+
+void SpatialGrid::FindParticlesInBlock(size_t first_column, size_t first_row,
+                                       size_t cells,
+                                       vector<size_t> &particles) const {
+  particles.clear();
+  particles.reserve(
+      std::min(cells * cells * max_cell_particles_, cell_entries_.size()));
+  size_t last_row = std::min(first_row + cells, rows_);
+  size_t last_column = std::min(first_column + cells, columns_);
+
+  for (size_t r = first_row; r < last_row; ++r) {
+    for (size_t c = first_column; c < last_column; ++c) {
+      size_t cell = r * columns_ + c;
+      particles.insert(particles.end(),
+                       cell_entries_.begin() + cell_starts_[cell],
+                       cell_entries_.begin() + cell_starts_[cell + 1]);
+    }
+  }
+
+  std::sort(particles.begin(), particles.end());
+}
+
+bool SpatialGrid::CanColourTiles() const {
+  return !periodic_ ||
+         (CanColourPeriodically(columns_) && CanColourPeriodically(rows_));
+}
+
+size_t SpatialGrid::GetTileCount(size_t colour) const {
+  size_t tile_columns = (columns_ + kTileCells - 1) / kTileCells;
+  size_t tile_rows = (rows_ + kTileCells - 1) / kTileCells;
+  return ((tile_columns + 1 - colour % 2) / 2) *
+         ((tile_rows + 1 - colour / 2) / 2);
+}
+
+void SpatialGrid::FindParticlesInTile(size_t colour, size_t tile,
+                                      vector<size_t> &particles) const {
+  size_t tile_columns = (columns_ + kTileCells - 1) / kTileCells;
+  size_t colour_columns = (tile_columns + 1 - colour % 2) / 2;
+  size_t tile_column = 2 * (tile % colour_columns) + colour % 2;
+  size_t tile_row = 2 * (tile / colour_columns) + colour / 2;
+  FindParticlesInBlock(tile_column * kTileCells, tile_row * kTileCells,
+                       kTileCells, particles);
+}
+
+size_t SpatialGrid::GetColumns() const {
+  return columns_;
+}
+
+size_t SpatialGrid::GetRows() const {
+  return rows_;
+}
+
+float SpatialGrid::GetCellSize() const {
+  return static_cast<float>(std::min(cell_width_, cell_height_));
+}
+
+const Box *SpatialGrid::GetPeriodicBox() const {
+  return periodic_ ? &box_ : nullptr;
+}
+
+size_t SpatialGrid::NeighborCoordinates(size_t coordinate, size_t cell_count,
+                                        bool periodic, size_t coordinates[3]) {
+  size_t count = 0;
+  if (coordinate > 0) {
+    coordinates[count++] = coordinate - 1;
+  } else if (periodic && cell_count > 2) {
+    coordinates[count++] = cell_count - 1;
+  }
+  coordinates[count++] = coordinate;
+  if (coordinate + 1 < cell_count) {
+    coordinates[count++] = coordinate + 1;
+  } else if (periodic && cell_count > 2) {
+    coordinates[count++] = 0;
+  }
+  return count;
+}
+
+size_t SpatialGrid::CellCoordinate(double position, double min,
+                                   double cell_size, size_t cell_count) {
+  double offset = (position - min) / cell_size;
+  if (!(offset > 0)) {
+    return 0;
+  }
+  if (offset >= static_cast<double>(cell_count)) {
+    return cell_count - 1;
+  }
+  return std::min(static_cast<size_t>(offset), cell_count - 1);
+}
+
+template void SpatialGrid::Rebuild(const ParticleStore &particles,
+                                   double margin);
+template void SpatialGrid::Rebuild(const DoubleParticleStore &particles,
+                                   double margin);
+template void SpatialGrid::Rebuild(const ParticleStore &particles,
+                                   const Box &box, double margin);
+template void SpatialGrid::Rebuild(const DoubleParticleStore &particles,
+                                   const Box &box, double margin);
+
+}  // namespace idealgas
@@ -0,0 +1,172 @@
+#include "speed_histogram.h"
+
+#include <algorithm>
+#include <cmath>
+#include <glm/geometric.hpp>
+
+namespace idealgas {
+
+using glm::vec2;
+
+namespace {
+
+double SpeedOf(const ParticleStore &particles, size_t i) {
+  return glm::length(vec2(particles.VelocityX()[i], particles.VelocityY()[i]));
+}
+
+}  // namespace
+
+SpeedHistogram::SpeedHistogram(size_t num_bins) : num_bins_(num_bins) { }
+
+void SpeedHistogram::Update(ParticleStore &particles) {
+  if (stale_ || particles.Size() != bins_.size() ||
+      particles.SpeciesCount() * num_bins_ != counts_.size()) {
+    Rebuild(particles);
+    return;
+  }
+
+  uint8_t *speed_changed = particles.SpeedChanged();
+  int old_max_speed = max_speed_;
+  changed_.clear();
+  for (size_t i = 0; i < particles.Size(); ++i) {
+    if (!speed_changed[i]) {
+      continue;
+    }
+    speed_changed[i] = 0;
+    changed_.push_back(static_cast<uint32_t>(i));
+
+    int whole_speed = static_cast<int>(SpeedOf(particles, i));
+    if (whole_speeds_[i] == max_speed_) {
+      --max_speed_count_;
+    }
+    if (whole_speed > max_speed_) {
+      max_speed_ = whole_speed;
+      max_speed_count_ = 1;
+    } else if (whole_speed == max_speed_) {
+      ++max_speed_count_;
+    }
+    whole_speeds_[i] = whole_speed;
+  }
+
+  if (max_speed_count_ == 0) {
+    FindMaxSpeed();
+  }
+
+  // Bin edges scale with the max speed, so a new max moves every particle.
+  if (max_speed_ != old_max_speed) {
+    RebinAll(particles);
+  } else {
+    for (uint32_t i : changed_) {
+      Rebin(particles, i);
+    }
+  }
+}
+
+void SpeedHistogram::Clear() {
+  std::fill(counts_.begin(), counts_.end(), 0);
+  stale_ = true;
+}
+
+void SpeedHistogram::Invalidate() {
+  stale_ = true;
+}
+
+size_t SpeedHistogram::FindBin(double speed) const {
+  // A speed falls into the first bin whose upper edge is at least the speed.
+  // Guess the bin directly, then step over any rounding at the edges.
+  size_t bin = 0;
+  if (max_speed_ > 0 && speed > 0) {
+    double guess = std::ceil(speed * num_bins_ / max_speed_) - 1;
+    bin = static_cast<size_t>(
+        std::min(std::max(guess, 0.0), static_cast<double>(num_bins_)));
+  }
+  while (bin > 0 && speed <= UpperEdge(bin - 1)) {
+    --bin;
+  }
+  while (bin < num_bins_ && !(speed <= UpperEdge(bin))) {
+    ++bin;
+  }
+  return bin;
+}
+
+size_t SpeedHistogram::GetCount(uint8_t species, size_t bin) const {
+  size_t index = species * num_bins_ + bin;
+  return index < counts_.size() ? counts_[index] : 0;
+}
+
+ArrayView<uint32_t> SpeedHistogram::GetCounts(uint8_t species) const {
+  size_t begin = species * num_bins_;
+  if (begin + num_bins_ > counts_.size()) {
+    return ArrayView<uint32_t>();
+  }
+  return ArrayView<uint32_t>(counts_.data() + begin, num_bins_);
+}
+
+size_t SpeedHistogram::GetNumBins() const {
+  return num_bins_;
+}
+
+int SpeedHistogram::GetMaxSpeed() const {
+  return max_speed_;
+}
+
+void SpeedHistogram::Rebuild(ParticleStore &particles) {
+  size_t count = particles.Size();
+  whole_speeds_.resize(count);
+  for (size_t i = 0; i < count; ++i) {
+    whole_speeds_[i] = static_cast<int>(SpeedOf(particles, i));
+  }
+  FindMaxSpeed();
+  RebinAll(particles);
+
+  // The marks are only needed between full recounts.
+  uint8_t *speed_changed = particles.SpeedChanged();
+  std::fill(speed_changed, speed_changed + count, 0);
+  // Room for every particle to change, so updates never allocate.
+  changed_.reserve(count);
+  stale_ = false;
+}
+
+void SpeedHistogram::RebinAll(const ParticleStore &particles) {
+  counts_.assign(particles.SpeciesCount() * num_bins_, 0);
+  bins_.resize(particles.Size());
+  const uint8_t *species = particles.SpeciesId();
+  for (size_t i = 0; i < particles.Size(); ++i) {
+    size_t bin = FindBin(SpeedOf(particles, i));
+    bins_[i] = static_cast<uint32_t>(bin);
+    if (bin < num_bins_) {
+      ++counts_[species[i] * num_bins_ + bin];
+    }
+  }
+}
+
+void SpeedHistogram::Rebin(const ParticleStore &particles, size_t i) {
+  size_t offset = particles.SpeciesId()[i] * num_bins_;
+  size_t bin = FindBin(SpeedOf(particles, i));
+  if (bins_[i] < num_bins_) {
+    --counts_[offset + bins_[i]];
+  }
+  if (bin < num_bins_) {
+    ++counts_[offset + bin];
+  }
+  bins_[i] = static_cast<uint32_t>(bin);
+}
+
+void SpeedHistogram::FindMaxSpeed() {
+  max_speed_ = 0;
+  max_speed_count_ = 0;
+  for (int whole_speed : whole_speeds_) {
+    if (whole_speed > max_speed_) {
+      max_speed_ = whole_speed;
+      max_speed_count_ = 1;
+    } else if (whole_speed == max_speed_) {
+      ++max_speed_count_;
+    }
+  }
+}
+
+double SpeedHistogram::UpperEdge(size_t bin) const {
+  return max_speed_ * (static_cast<double>((bin + 1.0) / num_bins_));
+}
+
+}  // namespace idealgas
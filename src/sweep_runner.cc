@@ -0,0 +1,102 @@
+#include "sweep_runner.h"
+
+#include <chrono>
+#include <exception>
+#include <memory>
+
+#include "trajectory_recorder.h"
+
+namespace idealgas {
+
+SweepRunner::SweepRunner(ThreadPool *pool) : pool_(pool) { }
+
+RunSummary SweepRunner::Run(const Scenario &scenario) const {
+  RunSummary summary;
+  summary.name = scenario.name;
+  auto start = std::chrono::steady_clock::now();
+  try {
+    GasContainer container(scenario.window_length, scenario.window_width,
+                           scenario.margin, "white", scenario.box, {});
+    container.SetThreadPool(pool_);
+    container.InitializeParticles(ParticleInitializer(scenario.initializer),
+                                  scenario.species);
+    container.SetEngineMode(scenario.engine);
+    container.SetIntegrator(scenario.integrator);
+    container.SetTimeStep(scenario.time_step);
+    container.SetNeighborListSkin(scenario.skin);
+    container.SetStatisticsEnabled(true);
+
+    std::unique_ptr<TrajectoryRecorder> recorder;
+    if (!scenario.trajectory_path.empty()) {
+      TrajectoryRecorder::Options options;
+      options.decimation = scenario.record_every;
+      recorder.reset(new TrajectoryRecorder(scenario.trajectory_path,
+                                            options));
+      container.SetTrajectoryRecorder(recorder.get());
+    }
+
+    for (size_t step = 0; step < scenario.steps; ++step) {
+      container.AdvanceOneFrame();
+      summary.mean_temperature += container.GetStatistics().temperature;
+      summary.mean_pressure += container.GetStatistics().pressure;
+    }
+    if (scenario.steps > 0) {
+      summary.mean_temperature /= static_cast<double>(scenario.steps);
+      summary.mean_pressure /= static_cast<double>(scenario.steps);
+      summary.statistics = container.GetStatistics();
+    } else {
+      summary.statistics = StatisticsReduction::Reduce(
+          container.GetParticles(), pool_);
+    }
+    summary.particle_count = container.GetParticles().Size();
+    summary.steps = scenario.steps;
+
+    if (recorder) {
+      container.SetTrajectoryRecorder(nullptr);
+      recorder->Close();
+    }
+    if (!scenario.checkpoint_path.empty()) {
+      container.SaveCheckpoint(scenario.checkpoint_path);
+    }
+    summary.succeeded = true;
+  } catch (const std::exception &error) {
+    summary.error = error.what();
+  }
+  summary.elapsed_ms = std::chrono::duration<double, std::milli>(
+                           std::chrono::steady_clock::now() - start)
+                           .count();
+  return summary;
+}
+
+std::vector<RunSummary> SweepRunner::Run(
+    const std::vector<Scenario> &scenarios) const {
+  std::vector<RunSummary> summaries(scenarios.size());
+  auto run = [&](size_t i) { summaries[i] = Run(scenarios[i]); };
+  if (pool_ != nullptr) {
+    pool_->ParallelFor(scenarios.size(), run);
+  } else {
+    for (size_t i = 0; i < scenarios.size(); ++i) {
+      run(i);
+    }
+  }
+  return summaries;
+}
+
+void SweepRunner::WriteSummaries(std::ostream &output,
+                                 const std::vector<RunSummary> &summaries) {
+  output << "name\tstatus\tparticles\tsteps\telapsed_ms\tkinetic_energy"
+            "\ttemperature\tmean_temperature\tmean_pressure\tmomentum_x"
+            "\tmomentum_y\tmax_speed\terror\n";
+  for (const RunSummary &summary : summaries) {
+    const GasStatistics &statistics = summary.statistics;
+    output << summary.name << "\t" << (summary.succeeded ? "ok" : "failed")
+           << "\t" << summary.particle_count << "\t" << summary.steps << "\t"
+           << summary.elapsed_ms << "\t" << statistics.kinetic_energy << "\t"
+           << statistics.temperature << "\t" << summary.mean_temperature
+           << "\t" << summary.mean_pressure << "\t" << statistics.momentum_x
+           << "\t" << statistics.momentum_y << "\t" << statistics.max_speed
+           << "\t" << summary.error << "\n";
+  }
+}
+
+}  // namespace idealgas
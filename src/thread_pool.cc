@@ -0,0 +1,145 @@
+#include "thread_pool.h"
+
+#include <atomic>
+#include <exception>
+
+#include "frame_profiler.h"
+
+namespace idealgas {
+
+/**
+ * The indices of one ParallelFor call, which lives on the caller's stack.
+ */
+struct ThreadPool::Batch {
+  Batch(const void *function, TaskInvoker invoker, size_t index_count)
+      : task(function), invoke(invoker), count(index_count), next_index(0),
+        remaining(index_count) { }
+
+  const void *task;
+  const TaskInvoker invoke;
+  const size_t count;
+  std::atomic<size_t> next_index;  // next index to claim
+  std::atomic<size_t> remaining;   // indices not finished yet
+  size_t helpers = 0;              // workers inside RunBatch, under mutex_
+  Batch *next = nullptr;           // next older batch, under mutex_
+#if IDEALGAS_PROFILING
+  // Tasks count into the frame of the thread that started the loop, on
+  // whichever thread they run.
+  FrameProfiler *profiler = FrameProfiler::GetActive();
+#endif
+  std::mutex error_mutex;
+  std::exception_ptr error;
+};
+
+ThreadPool::ThreadPool(size_t thread_count) {
+  for (size_t i = 0; i < thread_count; ++i) {
+    threads_.emplace_back(&ThreadPool::WorkerLoop, this);
+  }
+}
+
+ThreadPool::~ThreadPool() {
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    stopping_ = true;
+  }
+  wake_.notify_all();
+  for (auto &thread : threads_) {
+    thread.join();
+  }
+}
+
+size_t ThreadPool::GetThreadCount() const {
+  return threads_.size();
+}
+
+void ThreadPool::RunLoop(size_t count, const void *task,
+                         TaskInvoker invoke) {
+  if (threads_.empty() || count <= 1) {
+    for (size_t i = 0; i < count; ++i) {
+      invoke(task, i);
+    }
+    return;
+  }
+
+  Batch batch(task, invoke, count);
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    batch.next = batches_;
+    batches_ = &batch;
+  }
+  wake_.notify_all();
+
+  // Help out instead of blocking, which also keeps nested loops from
+  // waiting on indices that no thread is free to run.
+  RunBatch(batch);
+
+  std::unique_lock<std::mutex> lock(mutex_);
+  Batch **link = &batches_;
+  while (*link != &batch) {
+    link = &(*link)->next;
+  }
+  *link = batch.next;
+  // Once unlinked no worker can join, but the batch lives on this stack,
+  // so the workers still inside it must leave before it goes away.
+  done_.wait(lock, [&batch] {
+    return batch.remaining == 0 && batch.helpers == 0;
+  });
+  lock.unlock();
+
+  if (batch.error) {
+    std::rethrow_exception(batch.error);
+  }
+}
+
+void ThreadPool::RunBatch(Batch &batch) {
+#if IDEALGAS_PROFILING
+  FrameProfiler::Activation activation(batch.profiler);
+#endif
+  size_t finished = 0;
+  for (size_t i = batch.next_index++; i < batch.count;
+       i = batch.next_index++) {
+    try {
+      batch.invoke(batch.task, i);
+    } catch (...) {
+      std::lock_guard<std::mutex> lock(batch.error_mutex);
+      if (!batch.error) {
+        batch.error = std::current_exception();
+      }
+    }
+    ++finished;
+  }
+  batch.remaining -= finished;
+}
+
+ThreadPool::Batch *ThreadPool::FindBatch() const {
+  for (Batch *batch = batches_; batch != nullptr; batch = batch->next) {
+    if (batch->next_index < batch->count) {
+      return batch;
+    }
+  }
+  return nullptr;
+}
+
+void ThreadPool::WorkerLoop() {
+  std::unique_lock<std::mutex> lock(mutex_);
+  while (true) {
+    Batch *batch = FindBatch();
+    if (batch == nullptr) {
+      if (stopping_) {
+        return;
+      }
+      wake_.wait(lock);
+      continue;
+    }
+
+    ++batch->helpers;
+    lock.unlock();
+    RunBatch(*batch);
+    lock.lock();
+    if (--batch->helpers == 0 && batch->remaining == 0) {
+      done_.notify_all();
+    }
+  }
+}
+
+}  // namespace idealgas
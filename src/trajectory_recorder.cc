@@ -0,0 +1,390 @@
+#include "trajectory_recorder.h"
+
+#include <cstring>
+#include <stdexcept>
+
+namespace idealgas {
+
+namespace {
+
+const char kMagic[8] = {'I', 'G', 'A', 'S', 'T', 'R', 'A', 'J'};
+const char kChunkTag[4] = {'C', 'H', 'N', 'K'};
+const uint32_t kVersion = 1;
+
+// Reads back as a different value on a machine of the other byte order.
+const uint32_t kByteOrder = 0x01020304;
+
+const size_t kColumnCount = 4;
+
+// Columns in the order they are stored in a chunk.
+std::vector<float> TrajectoryFrame::*const kColumns[kColumnCount] = {
+    &TrajectoryFrame::x, &TrajectoryFrame::y, &TrajectoryFrame::vx,
+    &TrajectoryFrame::vy};
+
+// Positions move steadily and are stored as deltas of deltas. Velocities
+// only change in steps and are stored as plain deltas.
+const bool kSecondOrder[kColumnCount] = {true, true, false, false};
+
+struct FileHeader {
+  char magic[8];
+  uint32_t version;
+  uint32_t byte_order;
+};
+
+struct ChunkHeader {
+  char tag[4];
+  uint32_t frame_count;
+  uint32_t particle_count;
+  uint32_t reserved;
+  uint64_t payload_size;
+};
+
+uint32_t FloatBits(float value) {
+  uint32_t bits;
+  std::memcpy(&bits, &value, sizeof(bits));
+  return bits;
+}
+
+float BitsToFloat(uint32_t bits) {
+  float value;
+  std::memcpy(&value, &bits, sizeof(value));
+  return value;
+}
+
+void AppendBytes(std::vector<uint8_t> &buffer, const void *data, size_t size) {
+  const uint8_t *bytes = static_cast<const uint8_t *>(data);
+  buffer.insert(buffer.end(), bytes, bytes + size);
+}
+
+/**
+ * Appends the difference of two values. Zigzag encoding makes small
+ * negative differences small, and the varint stores 7 bits per byte.
+ */
+void AppendDelta(std::vector<uint8_t> &buffer, uint32_t value,
+                 uint32_t previous) {
+  int32_t delta = static_cast<int32_t>(value - previous);
+  uint32_t zigzag = (static_cast<uint32_t>(delta) << 1) ^
+                    static_cast<uint32_t>(delta >> 31);
+  while (zigzag >= 0x80) {
+    buffer.push_back(static_cast<uint8_t>(zigzag | 0x80));
+    zigzag >>= 7;
+  }
+  buffer.push_back(static_cast<uint8_t>(zigzag));
+}
+
+/**
+ * Reads a difference written by AppendDelta and returns the new value.
+ */
+uint32_t ReadDelta(const uint8_t *&data, const uint8_t *end,
+                   uint32_t previous) {
+  uint32_t zigzag = 0;
+  for (int shift = 0;; shift += 7) {
+    if (data == end || shift > 28) {
+      throw std::invalid_argument("Trajectory chunk is corrupt");
+    }
+    uint8_t byte = *data++;
+    zigzag |= static_cast<uint32_t>(byte & 0x7f) << shift;
+    if ((byte & 0x80) == 0) {
+      break;
+    }
+  }
+  uint32_t delta = (zigzag >> 1) ^ (0u - (zigzag & 1));
+  return previous + delta;
+}
+
+}  // namespace
+
+TrajectoryRecorder::TrajectoryRecorder(const std::string &path,
+                                       const Options &options)
+    : options_(options),
+      file_(path, std::ios::binary | std::ios::trunc),
+      species_filter_(256, options.species.empty()),
+      slots_(options.buffer_frames > 0 ? options.buffer_frames : 1) {
+  if (!file_) {
+    throw std::runtime_error("Cannot open trajectory for writing: " + path);
+  }
+  for (uint8_t species : options_.species) {
+    species_filter_[species] = true;
+  }
+
+  FileHeader header;
+  std::memcpy(header.magic, kMagic, sizeof(kMagic));
+  header.version = kVersion;
+  header.byte_order = kByteOrder;
+  file_.write(reinterpret_cast<const char *>(&header), sizeof(header));
+
+  writer_ = std::thread(&TrajectoryRecorder::RunWriter, this);
+}
+
+TrajectoryRecorder::~TrajectoryRecorder() {
+  try {
+    Close();
+  } catch (const std::exception &) {
+    // Destructors must not throw; call Close to see write errors.
+  }
+}
+
+void TrajectoryRecorder::Record(const ParticleStore &particles,
+                                int64_t frame) {
+  if (options_.decimation > 1 &&
+      frame % static_cast<int64_t>(options_.decimation) != 0) {
+    return;
+  }
+
+  TrajectoryFrame *slot;
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (closing_) {
+      return;
+    }
+    if (filled_slots_ == slots_.size()) {
+      ++dropped_frames_;
+      return;
+    }
+    slot = &slots_[write_slot_];
+  }
+
+  // The writer only reads a slot once it is published below. Clearing keeps
+  // each slot's capacity, so after the first lap nothing is allocated.
+  slot->frame = frame;
+  slot->indices.clear();
+  slot->x.clear();
+  slot->y.clear();
+  slot->vx.clear();
+  slot->vy.clear();
+  const uint8_t *species = particles.SpeciesId();
+  for (size_t i = 0; i < particles.Size(); ++i) {
+    if (species_filter_[species[i]]) {
+      slot->indices.push_back(static_cast<uint32_t>(i));
+      slot->x.push_back(particles.PositionX()[i]);
+      slot->y.push_back(particles.PositionY()[i]);
+      slot->vx.push_back(particles.VelocityX()[i]);
+      slot->vy.push_back(particles.VelocityY()[i]);
+    }
+  }
+
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    write_slot_ = (write_slot_ + 1) % slots_.size();
+    ++filled_slots_;
+    ++recorded_frames_;
+  }
+  slot_filled_.notify_one();
+}
+
+void TrajectoryRecorder::Close() {
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (closed_) {
+      return;
+    }
+    closing_ = true;
+    closed_ = true;
+  }
+  slot_filled_.notify_all();
+  if (writer_.joinable()) {
+    writer_.join();
+  }
+
+  file_.close();
+  if (write_failed_ || !file_) {
+    throw std::runtime_error("Cannot write trajectory");
+  }
+}
+
+size_t TrajectoryRecorder::GetRecordedFrameCount() const {
+  std::lock_guard<std::mutex> lock(mutex_);
+  return recorded_frames_;
+}
+
+size_t TrajectoryRecorder::GetDroppedFrameCount() const {
+  std::lock_guard<std::mutex> lock(mutex_);
+  return dropped_frames_;
+}
+
+void TrajectoryRecorder::RunWriter() {
+  while (true) {
+    TrajectoryFrame *slot;
+    {
+      std::unique_lock<std::mutex> lock(mutex_);
+      slot_filled_.wait(lock, [this] { return filled_slots_ > 0 || closing_; });
+      if (filled_slots_ == 0) {
+        break;
+      }
+      slot = &slots_[read_slot_];
+    }
+
+    AddToChunk(*slot);
+
+    {
+      std::lock_guard<std::mutex> lock(mutex_);
+      read_slot_ = (read_slot_ + 1) % slots_.size();
+      --filled_slots_;
+    }
+  }
+
+  if (!chunk_frames_.empty()) {
+    WriteChunk();
+  }
+  file_.flush();
+  if (!file_) {
+    write_failed_ = true;
+  }
+}
+
+void TrajectoryRecorder::AddToChunk(const TrajectoryFrame &snapshot) {
+  // A chunk stores its particle indices once, so a new set starts a new one.
+  if (!chunk_frames_.empty() && snapshot.indices != chunk_indices_) {
+    WriteChunk();
+  }
+  if (chunk_frames_.empty()) {
+    chunk_indices_ = snapshot.indices;
+  }
+
+  chunk_frames_.push_back(snapshot.frame);
+  for (size_t column = 0; column < kColumnCount; ++column) {
+    const std::vector<float> &values = snapshot.*kColumns[column];
+    chunk_columns_[column].insert(chunk_columns_[column].end(),
+                                  values.begin(), values.end());
+  }
+
+  if (chunk_frames_.size() >= options_.frames_per_chunk) {
+    WriteChunk();
+  }
+}
+
+void TrajectoryRecorder::WriteChunk() {
+  size_t frame_count = chunk_frames_.size();
+  size_t particle_count = chunk_indices_.size();
+
+  encoded_.clear();
+  AppendBytes(encoded_, chunk_frames_.data(), frame_count * sizeof(int64_t));
+  AppendBytes(encoded_, chunk_indices_.data(),
+              particle_count * sizeof(uint32_t));
+  for (size_t column = 0; column < kColumnCount; ++column) {
+    const std::vector<float> &values = chunk_columns_[column];
+    for (size_t particle = 0; particle < particle_count; ++particle) {
+      uint32_t previous = 0;
+      uint32_t previous_delta = 0;
+      for (size_t frame = 0; frame < frame_count; ++frame) {
+        uint32_t bits = FloatBits(values[frame * particle_count + particle]);
+        if (kSecondOrder[column]) {
+          // The first frame is stored whole, so its delta is not reused.
+          uint32_t delta = bits - previous;
+          AppendDelta(encoded_, delta, previous_delta);
+          previous_delta = frame == 0 ? 0 : delta;
+        } else {
+          AppendDelta(encoded_, bits, previous);
+        }
+        previous = bits;
+      }
+    }
+  }
+
+  ChunkHeader header;
+  std::memcpy(header.tag, kChunkTag, sizeof(kChunkTag));
+  header.frame_count = static_cast<uint32_t>(frame_count);
+  header.particle_count = static_cast<uint32_t>(particle_count);
+  header.reserved = 0;
+  header.payload_size = encoded_.size();
+  file_.write(reinterpret_cast<const char *>(&header), sizeof(header));
+  file_.write(reinterpret_cast<const char *>(encoded_.data()),
+              static_cast<std::streamsize>(encoded_.size()));
+  if (!file_) {
+    write_failed_ = true;
+  }
+
+  chunk_frames_.clear();
+  for (size_t column = 0; column < kColumnCount; ++column) {
+    chunk_columns_[column].clear();
+  }
+}
+
+TrajectoryReader::TrajectoryReader(const std::string &path)
+    : file_(path, std::ios::binary) {
+  if (!file_) {
+    throw std::runtime_error("Cannot open trajectory: " + path);
+  }
+  FileHeader header;
+  if (!file_.read(reinterpret_cast<char *>(&header), sizeof(header)) ||
+      std::memcmp(header.magic, kMagic, sizeof(kMagic)) != 0 ||
+      header.byte_order != kByteOrder) {
+    throw std::invalid_argument("File is not a trajectory");
+  }
+  if (header.version != kVersion) {
+    throw std::invalid_argument("Unsupported trajectory version " +
+                                std::to_string(header.version));
+  }
+}
+
+bool TrajectoryReader::Next(TrajectoryFrame &frame) {
+  while (next_frame_ == chunk_.size()) {
+    if (!ReadChunk()) {
+      return false;
+    }
+  }
+  frame = chunk_[next_frame_++];
+  return true;
+}
+
+bool TrajectoryReader::ReadChunk() {
+  ChunkHeader header;
+  if (!file_.read(reinterpret_cast<char *>(&header), sizeof(header))) {
+    if (file_.gcount() == 0) {
+      return false;
+    }
+    throw std::invalid_argument("Trajectory chunk header is truncated");
+  }
+  size_t frame_count = header.frame_count;
+  size_t particle_count = header.particle_count;
+  if (std::memcmp(header.tag, kChunkTag, sizeof(kChunkTag)) != 0 ||
+      header.payload_size < frame_count * sizeof(int64_t) +
+                                particle_count * sizeof(uint32_t)) {
+    throw std::invalid_argument("Trajectory chunk is corrupt");
+  }
+
+  std::vector<uint8_t> payload(static_cast<size_t>(header.payload_size));
+  if (!file_.read(reinterpret_cast<char *>(payload.data()),
+                  static_cast<std::streamsize>(payload.size()))) {
+    throw std::invalid_argument("Trajectory chunk is truncated");
+  }
+
+  const uint8_t *data = payload.data();
+  const uint8_t *end = data + payload.size();
+  chunk_.assign(frame_count, TrajectoryFrame());
+  std::vector<uint32_t> indices(particle_count);
+  for (size_t frame = 0; frame < frame_count; ++frame) {
+    std::memcpy(&chunk_[frame].frame, data, sizeof(int64_t));
+    data += sizeof(int64_t);
+  }
+  std::memcpy(indices.data(), data, particle_count * sizeof(uint32_t));
+  data += particle_count * sizeof(uint32_t);
+
+  for (TrajectoryFrame &frame : chunk_) {
+    frame.indices = indices;
+    for (size_t column = 0; column < kColumnCount; ++column) {
+      (frame.*kColumns[column]).resize(particle_count);
+    }
+  }
+  for (size_t column = 0; column < kColumnCount; ++column) {
+    for (size_t particle = 0; particle < particle_count; ++particle) {
+      uint32_t bits = 0;
+      uint32_t previous_delta = 0;
+      for (size_t frame = 0; frame < frame_count; ++frame) {
+        if (kSecondOrder[column]) {
+          uint32_t delta = ReadDelta(data, end, previous_delta);
+          bits += delta;
+          previous_delta = frame == 0 ? 0 : delta;
+        } else {
+          bits = ReadDelta(data, end, bits);
+        }
+        (chunk_[frame].*kColumns[column])[particle] = BitsToFloat(bits);
+      }
+    }
+  }
+
+  next_frame_ = 0;
+  return true;
+}
+
+}  // namespace idealgas
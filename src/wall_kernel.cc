@@ -0,0 +1,422 @@
+#include "wall_kernel.h"
+
+#include <cmath>
+
+#if defined(__x86_64__) || defined(_M_X64) || defined(__i386__) || \
+    defined(_M_IX86)
+#define IDEALGAS_X86 1
+#include <immintrin.h>
+#if defined(_MSC_VER)
+#include <intrin.h>
+#endif
+#endif
+
+// GCC and Clang only emit wider instructions inside functions marked with
+// the matching target, which lets one file hold every version of the kernel.
+#if defined(__GNUC__) || defined(__clang__)
+#define IDEALGAS_TARGET(isa) __attribute__((target(isa)))
+#else
+#define IDEALGAS_TARGET(isa)
+#endif
+
+namespace idealgas {
+
+namespace {
+
+// The batched kernels compare in float. Walls that are whole numbers below
+// this size, combined with the whole-number radii particles are created
+// with, give bounds that float represents exactly, so the comparisons agree
+// with the double comparisons of the scalar kernel.
+const double kMaxExactWall = 1 << 23;
+
+bool IsExactInFloat(double wall) {
+  return wall == std::floor(wall) && std::fabs(wall) < kMaxExactWall;
+}
+
+template <typename T>
+void ReflectAndIntegrateScalar(const WallBounds *species_bounds,
+                               size_t begin, size_t count, T *x, T *y, T *vx,
+                               T *vy, const uint8_t *species) {
+  for (size_t i = begin; i < count; ++i) {
+    const WallBounds &bounds = species_bounds[species[i]];
+
+    if (x[i] <= bounds.lower_x || x[i] >= bounds.upper_x) {
+      vx[i] = -vx[i];
+    }
+    if (y[i] <= bounds.lower_y || y[i] >= bounds.upper_y) {
+      vy[i] = -vy[i];
+    }
+
+    x[i] += vx[i];
+    y[i] += vy[i];
+  }
+}
+
+#ifdef IDEALGAS_X86
+
+IDEALGAS_TARGET("sse2")
+size_t ReflectAndIntegrateSse2(float lower_x, float upper_x, float lower_y,
+                               float upper_y, size_t count, float *x, float *y, float *vx,
+                               float *vy, const float *radius) {
+  const __m128 left = _mm_set1_ps(lower_x);
+  const __m128 right = _mm_set1_ps(upper_x);
+  const __m128 top = _mm_set1_ps(lower_y);
+  const __m128 bottom = _mm_set1_ps(upper_y);
+  const __m128 sign = _mm_set1_ps(-0.0f);
+
+  size_t i = 0;
+  for (; i + 4 <= count; i += 4) {
+    __m128 r = _mm_loadu_ps(radius + i);
+    __m128 lower_x_bound = _mm_add_ps(left, r);
+    __m128 upper_x_bound = _mm_sub_ps(right, r);
+    __m128 lower_y_bound = _mm_add_ps(top, r);
+    __m128 upper_y_bound = _mm_sub_ps(bottom, r);
+    __m128 px = _mm_loadu_ps(x + i);
+    __m128 py = _mm_loadu_ps(y + i);
+    __m128 pvx = _mm_loadu_ps(vx + i);
+    __m128 pvy = _mm_loadu_ps(vy + i);
+
+    __m128 hit_x = _mm_or_ps(_mm_cmple_ps(px, lower_x_bound),
+                             _mm_cmpge_ps(px, upper_x_bound));
+    __m128 hit_y = _mm_or_ps(_mm_cmple_ps(py, lower_y_bound),
+                             _mm_cmpge_ps(py, upper_y_bound));
+    pvx = _mm_xor_ps(pvx, _mm_and_ps(hit_x, sign));
+    pvy = _mm_xor_ps(pvy, _mm_and_ps(hit_y, sign));
+
+    _mm_storeu_ps(vx + i, pvx);
+    _mm_storeu_ps(vy + i, pvy);
+    _mm_storeu_ps(x + i, _mm_add_ps(px, pvx));
+    _mm_storeu_ps(y + i, _mm_add_ps(py, pvy));
+  }
+  return i;
+}
+
+IDEALGAS_TARGET("avx2")
+size_t ReflectAndIntegrateAvx2(float lower_x, float upper_x, float lower_y,
+                               float upper_y, size_t count, float *x, float *y, float *vx,
+                               float *vy, const float *radius) {
+  const __m256 left = _mm256_set1_ps(lower_x);
+  const __m256 right = _mm256_set1_ps(upper_x);
+  const __m256 top = _mm256_set1_ps(lower_y);
+  const __m256 bottom = _mm256_set1_ps(upper_y);
+  const __m256 sign = _mm256_set1_ps(-0.0f);
+
+  size_t i = 0;
+  for (; i + 8 <= count; i += 8) {
+    __m256 r = _mm256_loadu_ps(radius + i);
+    __m256 lower_x_bound = _mm256_add_ps(left, r);
+    __m256 upper_x_bound = _mm256_sub_ps(right, r);
+    __m256 lower_y_bound = _mm256_add_ps(top, r);
+    __m256 upper_y_bound = _mm256_sub_ps(bottom, r);
+    __m256 px = _mm256_loadu_ps(x + i);
+    __m256 py = _mm256_loadu_ps(y + i);
+    __m256 pvx = _mm256_loadu_ps(vx + i);
+    __m256 pvy = _mm256_loadu_ps(vy + i);
+
+    __m256 hit_x = _mm256_or_ps(_mm256_cmp_ps(px, lower_x_bound, _CMP_LE_OQ),
+                                _mm256_cmp_ps(px, upper_x_bound, _CMP_GE_OQ));
+    __m256 hit_y = _mm256_or_ps(_mm256_cmp_ps(py, lower_y_bound, _CMP_LE_OQ),
+                                _mm256_cmp_ps(py, upper_y_bound, _CMP_GE_OQ));
+    pvx = _mm256_xor_ps(pvx, _mm256_and_ps(hit_x, sign));
+    pvy = _mm256_xor_ps(pvy, _mm256_and_ps(hit_y, sign));
+
+    _mm256_storeu_ps(vx + i, pvx);
+    _mm256_storeu_ps(vy + i, pvy);
+    _mm256_storeu_ps(x + i, _mm256_add_ps(px, pvx));
+    _mm256_storeu_ps(y + i, _mm256_add_ps(py, pvy));
+  }
+  return i;
+}
+
+IDEALGAS_TARGET("avx512f")
+size_t ReflectAndIntegrateAvx512(float lower_x, float upper_x, float lower_y,
+                                 float upper_y, size_t count, float *x, float *y, float *vx,
+                                 float *vy, const float *radius) {
+  const __m512 left = _mm512_set1_ps(lower_x);
+  const __m512 right = _mm512_set1_ps(upper_x);
+  const __m512 top = _mm512_set1_ps(lower_y);
+  const __m512 bottom = _mm512_set1_ps(upper_y);
+  const __m512i sign = _mm512_set1_epi32(static_cast<int>(0x80000000u));
+
+  size_t i = 0;
+  for (; i + 16 <= count; i += 16) {
+    __m512 r = _mm512_loadu_ps(radius + i);
+    __m512 lower_x_bound = _mm512_add_ps(left, r);
+    __m512 upper_x_bound = _mm512_sub_ps(right, r);
+    __m512 lower_y_bound = _mm512_add_ps(top, r);
+    __m512 upper_y_bound = _mm512_sub_ps(bottom, r);
+    __m512 px = _mm512_loadu_ps(x + i);
+    __m512 py = _mm512_loadu_ps(y + i);
+    __m512i pvx = _mm512_castps_si512(_mm512_loadu_ps(vx + i));
+    __m512i pvy = _mm512_castps_si512(_mm512_loadu_ps(vy + i));
+
+    __mmask16 hit_x = _mm512_cmp_ps_mask(px, lower_x_bound, _CMP_LE_OQ) |
+                      _mm512_cmp_ps_mask(px, upper_x_bound, _CMP_GE_OQ);
+    __mmask16 hit_y = _mm512_cmp_ps_mask(py, lower_y_bound, _CMP_LE_OQ) |
+                      _mm512_cmp_ps_mask(py, upper_y_bound, _CMP_GE_OQ);
+    __m512 new_vx = _mm512_castsi512_ps(_mm512_mask_xor_epi32(pvx, hit_x, pvx, sign));
+    __m512 new_vy = _mm512_castsi512_ps(_mm512_mask_xor_epi32(pvy, hit_y, pvy, sign));
+
+    _mm512_storeu_ps(vx + i, new_vx);
+    _mm512_storeu_ps(vy + i, new_vy);
+    _mm512_storeu_ps(x + i, _mm512_add_ps(px, new_vx));
+    _mm512_storeu_ps(y + i, _mm512_add_ps(py, new_vy));
+  }
+  return i;
+}
+
+IDEALGAS_TARGET("sse2")
+size_t ReflectAndIntegrateSse2(double lower_x, double upper_x, double lower_y,
+                               double upper_y, size_t count, double *x,
+                               double *y, double *vx, double *vy,
+                               const double *radius) {
+  const __m128d left = _mm_set1_pd(lower_x);
+  const __m128d right = _mm_set1_pd(upper_x);
+  const __m128d top = _mm_set1_pd(lower_y);
+  const __m128d bottom = _mm_set1_pd(upper_y);
+  const __m128d sign = _mm_set1_pd(-0.0);
+
+  size_t i = 0;
+  for (; i + 2 <= count; i += 2) {
+    __m128d r = _mm_loadu_pd(radius + i);
+    __m128d px = _mm_loadu_pd(x + i);
+    __m128d py = _mm_loadu_pd(y + i);
+    __m128d pvx = _mm_loadu_pd(vx + i);
+    __m128d pvy = _mm_loadu_pd(vy + i);
+
+    __m128d hit_x = _mm_or_pd(_mm_cmple_pd(px, _mm_add_pd(left, r)),
+                              _mm_cmpge_pd(px, _mm_sub_pd(right, r)));
+    __m128d hit_y = _mm_or_pd(_mm_cmple_pd(py, _mm_add_pd(top, r)),
+                              _mm_cmpge_pd(py, _mm_sub_pd(bottom, r)));
+    pvx = _mm_xor_pd(pvx, _mm_and_pd(hit_x, sign));
+    pvy = _mm_xor_pd(pvy, _mm_and_pd(hit_y, sign));
+
+    _mm_storeu_pd(vx + i, pvx);
+    _mm_storeu_pd(vy + i, pvy);
+    _mm_storeu_pd(x + i, _mm_add_pd(px, pvx));
+    _mm_storeu_pd(y + i, _mm_add_pd(py, pvy));
+  }
+  return i;
+}
+
+IDEALGAS_TARGET("avx2")
+size_t ReflectAndIntegrateAvx2(double lower_x, double upper_x, double lower_y,
+                               double upper_y, size_t count, double *x,
+                               double *y, double *vx, double *vy,
+                               const double *radius) {
+  const __m256d left = _mm256_set1_pd(lower_x);
+  const __m256d right = _mm256_set1_pd(upper_x);
+  const __m256d top = _mm256_set1_pd(lower_y);
+  const __m256d bottom = _mm256_set1_pd(upper_y);
+  const __m256d sign = _mm256_set1_pd(-0.0);
+
+  size_t i = 0;
+  for (; i + 4 <= count; i += 4) {
+    __m256d r = _mm256_loadu_pd(radius + i);
+    __m256d px = _mm256_loadu_pd(x + i);
+    __m256d py = _mm256_loadu_pd(y + i);
+    __m256d pvx = _mm256_loadu_pd(vx + i);
+    __m256d pvy = _mm256_loadu_pd(vy + i);
+
+    __m256d hit_x = _mm256_or_pd(
+        _mm256_cmp_pd(px, _mm256_add_pd(left, r), _CMP_LE_OQ),
+        _mm256_cmp_pd(px, _mm256_sub_pd(right, r), _CMP_GE_OQ));
+    __m256d hit_y = _mm256_or_pd(
+        _mm256_cmp_pd(py, _mm256_add_pd(top, r), _CMP_LE_OQ),
+        _mm256_cmp_pd(py, _mm256_sub_pd(bottom, r), _CMP_GE_OQ));
+    pvx = _mm256_xor_pd(pvx, _mm256_and_pd(hit_x, sign));
+    pvy = _mm256_xor_pd(pvy, _mm256_and_pd(hit_y, sign));
+
+    _mm256_storeu_pd(vx + i, pvx);
+    _mm256_storeu_pd(vy + i, pvy);
+    _mm256_storeu_pd(x + i, _mm256_add_pd(px, pvx));
+    _mm256_storeu_pd(y + i, _mm256_add_pd(py, pvy));
+  }
+  return i;
+}
+
+IDEALGAS_TARGET("avx512f")
+size_t ReflectAndIntegrateAvx512(double lower_x, double upper_x,
+                                 double lower_y, double upper_y, size_t count,
+                                 double *x, double *y, double *vx, double *vy,
+                                 const double *radius) {
+  const __m512d left = _mm512_set1_pd(lower_x);
+  const __m512d right = _mm512_set1_pd(upper_x);
+  const __m512d top = _mm512_set1_pd(lower_y);
+  const __m512d bottom = _mm512_set1_pd(upper_y);
+  const __m512i sign =
+      _mm512_set1_epi64(static_cast<long long>(0x8000000000000000ull));
+
+  size_t i = 0;
+  for (; i + 8 <= count; i += 8) {
+    __m512d r = _mm512_loadu_pd(radius + i);
+    __m512d px = _mm512_loadu_pd(x + i);
+    __m512d py = _mm512_loadu_pd(y + i);
+    __m512i pvx = _mm512_castpd_si512(_mm512_loadu_pd(vx + i));
+    __m512i pvy = _mm512_castpd_si512(_mm512_loadu_pd(vy + i));
+
+    __mmask8 hit_x =
+        _mm512_cmp_pd_mask(px, _mm512_add_pd(left, r), _CMP_LE_OQ) |
+        _mm512_cmp_pd_mask(px, _mm512_sub_pd(right, r), _CMP_GE_OQ);
+    __mmask8 hit_y =
+        _mm512_cmp_pd_mask(py, _mm512_add_pd(top, r), _CMP_LE_OQ) |
+        _mm512_cmp_pd_mask(py, _mm512_sub_pd(bottom, r), _CMP_GE_OQ);
+    __m512d new_vx =
+        _mm512_castsi512_pd(_mm512_mask_xor_epi64(pvx, hit_x, pvx, sign));
+    __m512d new_vy =
+        _mm512_castsi512_pd(_mm512_mask_xor_epi64(pvy, hit_y, pvy, sign));
+
+    _mm512_storeu_pd(vx + i, new_vx);
+    _mm512_storeu_pd(vy + i, new_vy);
+    _mm512_storeu_pd(x + i, _mm512_add_pd(px, new_vx));
+    _mm512_storeu_pd(y + i, _mm512_add_pd(py, new_vy));
+  }
+  return i;
+}
+
+#if defined(_MSC_VER)
+bool CpuHasFeature(int leaf, int subleaf, int reg, int bit) {
+  int info[4];
+  __cpuidex(info, leaf, subleaf);
+  return (info[reg] >> bit) & 1;
+}
+
+bool OsSavesState(unsigned long long mask) {
+  return CpuHasFeature(1, 0, 2, 27) && (_xgetbv(0) & mask) == mask;
+}
+#endif
+
+#endif  // IDEALGAS_X86
+
+}  // namespace
+
+WallKernel::InstructionSet WallKernel::Detect() {
+  if (IsSupported(InstructionSet::kAvx512)) {
+    return InstructionSet::kAvx512;
+  }
+  if (IsSupported(InstructionSet::kAvx2)) {
+    return InstructionSet::kAvx2;
+  }
+  if (IsSupported(InstructionSet::kSse2)) {
+    return InstructionSet::kSse2;
+  }
+  return InstructionSet::kScalar;
+}
+
+bool WallKernel::IsSupported(InstructionSet instruction_set) {
+  if (instruction_set == InstructionSet::kScalar) {
+    return true;
+  }
+#if defined(IDEALGAS_X86) && (defined(__GNUC__) || defined(__clang__))
+  switch (instruction_set) {
+    case InstructionSet::kSse2:
+      return __builtin_cpu_supports("sse2");
+    case InstructionSet::kAvx2:
+      return __builtin_cpu_supports("avx2");
+    case InstructionSet::kAvx512:
+      return __builtin_cpu_supports("avx512f");
+    default:
+      return false;
+  }
+#elif defined(IDEALGAS_X86) && defined(_MSC_VER)
+  switch (instruction_set) {
+    case InstructionSet::kSse2:
+      return CpuHasFeature(1, 0, 3, 26);
+    case InstructionSet::kAvx2:
+      return CpuHasFeature(7, 0, 1, 5) && OsSavesState(0x6);
+    case InstructionSet::kAvx512:
+      return CpuHasFeature(7, 0, 1, 16) && OsSavesState(0xe6);
+    default:
+      return false;
+  }
+#else
+  return false;
+#endif
+}
+
+const char *WallKernel::GetName(InstructionSet instruction_set) {
+  switch (instruction_set) {
+    case InstructionSet::kSse2:
+      return "sse2";
+    case InstructionSet::kAvx2:
+      return "avx2";
+    case InstructionSet::kAvx512:
+      return "avx512";
+    default:
+      return "scalar";
+  }
+}
+
+void WallKernel::ReflectAndIntegrate(InstructionSet instruction_set,
+                                     const Box &box,
+                                     const WallBounds *species_bounds,
+                                     size_t count, float *x, float *y, float *vx,
+                                     float *vy, const float *radius,
+                                     const uint8_t *species) {
+  size_t done = 0;
+#ifdef IDEALGAS_X86
+  if (IsExactInFloat(box.GetMinX()) && IsExactInFloat(box.GetMaxX()) &&
+      IsExactInFloat(box.GetMinY()) && IsExactInFloat(box.GetMaxY())) {
+    float lower_x = static_cast<float>(box.GetMinX());
+    float upper_x = static_cast<float>(box.GetMaxX());
+    float lower_y = static_cast<float>(box.GetMinY());
+    float upper_y = static_cast<float>(box.GetMaxY());
+    switch (instruction_set) {
+      case InstructionSet::kSse2:
+        done = ReflectAndIntegrateSse2(lower_x, upper_x, lower_y, upper_y,
+                                       count, x, y, vx, vy, radius);
+        break;
+      case InstructionSet::kAvx2:
+        done = ReflectAndIntegrateAvx2(lower_x, upper_x, lower_y, upper_y,
+                                       count, x, y, vx, vy, radius);
+        break;
+      case InstructionSet::kAvx512:
+        done = ReflectAndIntegrateAvx512(lower_x, upper_x, lower_y, upper_y,
+                                         count, x, y, vx, vy, radius);
+        break;
+      default:
+        break;
+    }
+  }
+#else
+  (void)instruction_set;
+#endif
+  ReflectAndIntegrateScalar(species_bounds, done, count, x, y, vx, vy,
+                            species);
+}
+
+void WallKernel::ReflectAndIntegrate(InstructionSet instruction_set,
+                                     const Box &box,
+                                     const WallBounds *species_bounds,
+                                     size_t count, double *x, double *y, double *vx,
+                                     double *vy, const double *radius,
+                                     const uint8_t *species) {
+  size_t done = 0;
+#ifdef IDEALGAS_X86
+  switch (instruction_set) {
+    case InstructionSet::kSse2:
+      done = ReflectAndIntegrateSse2(box.GetMinX(), box.GetMaxX(),
+                                     box.GetMinY(), box.GetMaxY(), count, x,
+                                     y, vx, vy, radius);
+      break;
+    case InstructionSet::kAvx2:
+      done = ReflectAndIntegrateAvx2(box.GetMinX(), box.GetMaxX(),
+                                     box.GetMinY(), box.GetMaxY(), count, x,
+                                     y, vx, vy, radius);
+      break;
+    case InstructionSet::kAvx512:
+      done = ReflectAndIntegrateAvx512(box.GetMinX(), box.GetMaxX(),
+                                       box.GetMinY(), box.GetMaxY(), count,
+                                       x, y, vx, vy, radius);
+      break;
+    default:
+      break;
+  }
+#else
+  (void)instruction_set;
+#endif
+  ReflectAndIntegrateScalar(species_bounds, done, count, x, y, vx, vy,
+                            species);
+}
+
+}  // namespace idealgas
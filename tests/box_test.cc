@@ -0,0 +1,206 @@
+#include <catch2/catch.hpp>
+
+#include <algorithm>
+#include <limits>
+#include <stdexcept>
+
+#include "box.h"
+#include "gas_container.h"
+
+using idealgas::Boundary;
+using idealgas::Box;
+using idealgas::EngineMode;
+using idealgas::GasContainer;
+using idealgas::IntegratorKind;
+using idealgas::Particle;
+using idealgas::ParticleStore;
+using idealgas::PhysicsEngine;
+using idealgas::WallBounds;
+using glm::vec2;
+
+namespace {
+
+/**
+ * Requires every particle to be inside the box, allowing for the overshoot
+ * of a time step past the point where it bounces.
+ */
+void RequireInside(const GasContainer &container, float slack) {
+  const Box &box = container.GetBox();
+  const ParticleStore &particles = container.GetParticles();
+  for (size_t i = 0; i < particles.Size(); ++i) {
+    REQUIRE(particles.PositionX()[i] >= box.GetMinX() - slack);
+    REQUIRE(particles.PositionX()[i] <= box.GetMaxX() + slack);
+    REQUIRE(particles.PositionY()[i] >= box.GetMinY() - slack);
+    REQUIRE(particles.PositionY()[i] <= box.GetMaxY() + slack);
+  }
+}
+
+}  // namespace
+
+TEST_CASE("Box extents") {
+  SECTION("Walls are independent in x and y") {
+    Box box(-50, 10, 950, 60);
+    REQUIRE(box.GetWidth() == 1000);
+    REQUIRE(box.GetHeight() == 50);
+  }
+
+  SECTION("Window boxes are squares inside the margin") {
+    REQUIRE(Box::FromWindow(800, 80) == Box(80, 80, 720, 720));
+  }
+
+  SECTION("Empty and infinite boxes are rejected") {
+    REQUIRE_THROWS_AS(Box(0, 0, 0, 10), std::invalid_argument);
+    REQUIRE_THROWS_AS(Box(0, 10, 10, 5), std::invalid_argument);
+    REQUIRE_THROWS_AS(Box(0, 0, std::numeric_limits<double>::infinity(), 10), std::invalid_argument);
+  }
+}
+
+TEST_CASE("Periodic minimum image") {
+  Box box(0, 0, 100, 40, Boundary::kPeriodic);
+
+  SECTION("Short displacements are kept") {
+    REQUIRE(box.MinimumImage(vec2(30, -15)) == vec2(30, -15));
+  }
+
+  SECTION("Long displacements go the short way round") {
+    REQUIRE(box.MinimumImageX(90) == Approx(-10));
+    REQUIRE(box.MinimumImageX(-70) == Approx(30));
+    REQUIRE(box.MinimumImageY(35) == Approx(-5));
+  }
+
+  SECTION("Reflecting boxes keep every displacement") {
+    REQUIRE(Box(0, 0, 100, 40).MinimumImage(vec2(90, 35)) == vec2(90, 35));
+  }
+
+  SECTION("The boundary is part of the box") {
+    REQUIRE(box != Box(0, 0, 100, 40));
+    REQUIRE(box.IsPeriodic());
+  }
+}
+
+TEST_CASE("Species wall bounds") {
+  ParticleStore particles;
+  particles.Add(Particle(vec2(), vec2(), 1, 2, "orange"));
+  particles.Add(Particle(vec2(), vec2(), 1, 5, "red"));
+  particles.Add(Particle(vec2(), vec2(), 1, 2, "orange"));
+
+  std::vector<WallBounds> bounds =
+      Box(0, 100, 300, 200).GetSpeciesBounds(particles);
+  REQUIRE(bounds.size() == 2);
+  REQUIRE(bounds[0].lower_x == 2);
+  REQUIRE(bounds[0].upper_x == 298);
+  REQUIRE(bounds[1].lower_y == 105);
+  REQUIRE(bounds[1].upper_y == 195);
+}
+
+TEST_CASE("Particles stay inside a long channel") {
+  srand(3);
+  Box channel(0, 0, 4000, 120);
+  GasContainer container(800, 1280, 80, "white", channel, 20, 20, 20);
+  REQUIRE(container.GetParticles().Size() == 60);
+  RequireInside(container, 0);
+
+  SECTION("Time-stepped") {
+    for (int frame = 0; frame < 500; ++frame) {
+      container.AdvanceOneFrame();
+    }
+    RequireInside(container, 8);
+  }
+
+  SECTION("Time-stepped with an integrator") {
+    container.SetIntegrator(IntegratorKind::kLeapfrog);
+    container.SetTimeStep(0.5f);
+    for (int frame = 0; frame < 500; ++frame) {
+      container.AdvanceOneFrame();
+    }
+    RequireInside(container, 8);
+  }
+
+  SECTION("Event-driven") {
+    container.SetEngineMode(EngineMode::kEventDriven);
+    for (int frame = 0; frame < 500; ++frame) {
+      container.AdvanceOneFrame();
+    }
+    RequireInside(container, 0);
+  }
+}
+
+TEST_CASE("Particles stay inside a periodic box") {
+  srand(7);
+  Box box(0, 0, 1200, 800, Boundary::kPeriodic);
+  GasContainer container(800, 1280, 80, "white", box, 40, 40, 40);
+  double energy = 0;
+  for (size_t i = 0; i < container.GetParticles().Size(); ++i) {
+    Particle particle = container.GetParticles().Get(i);
+    energy += particle.GetMass() * particle.GetSpeed() * particle.GetSpeed();
+  }
+
+  SECTION("Time-stepped") {
+    for (int frame = 0; frame < 500; ++frame) {
+      container.AdvanceOneFrame();
+    }
+    RequireInside(container, 0);
+  }
+
+  SECTION("Time-stepped with an integrator") {
+    container.SetIntegrator(IntegratorKind::kVelocityVerlet);
+    container.SetTimeStep(0.5f);
+    for (int frame = 0; frame < 500; ++frame) {
+      container.AdvanceOneFrame();
+    }
+    RequireInside(container, 0);
+  }
+
+  SECTION("Event-driven, without losing energy") {
+    container.SetEngineMode(EngineMode::kEventDriven);
+    for (int frame = 0; frame < 500; ++frame) {
+      container.AdvanceOneFrame();
+    }
+    RequireInside(container, 1e-3f);
+
+    double final_energy = 0;
+    for (size_t i = 0; i < container.GetParticles().Size(); ++i) {
+      Particle particle = container.GetParticles().Get(i);
+      final_energy +=
+          particle.GetMass() * particle.GetSpeed() * particle.GetSpeed();
+    }
+    REQUIRE(final_energy == Approx(energy).epsilon(1e-4));
+  }
+
+  SECTION("Particles leaving an edge come back at the opposite one") {
+    // Both touch an edge within their radius, where walls would bounce them.
+    ParticleStore particles;
+    particles.Add(Particle(vec2(1195, 400), vec2(10, 0), 1, 10, "red"));
+    particles.Add(Particle(vec2(600, 3), vec2(0, -5), 1, 10, "red"));
+    PhysicsEngine::MoveParticles(box, particles);
+
+    REQUIRE(particles.PositionX()[0] == Approx(5));
+    REQUIRE(particles.PositionY()[0] == Approx(400));
+    REQUIRE(particles.VelocityX()[0] == 10);
+    REQUIRE(particles.VelocityY()[0] == 0);
+    REQUIRE(particles.PositionX()[1] == Approx(600));
+    REQUIRE(particles.PositionY()[1] == Approx(798));
+    REQUIRE(particles.VelocityX()[1] == 0);
+    REQUIRE(particles.VelocityY()[1] == -5);
+  }
+}
+
+TEST_CASE("Particles spread over a huge domain") {
+  srand(5);
+  Box domain(0, 0, 1e6, 1e6);
+  GasContainer container(800, 1280, 80, "white", domain, 300, 300, 300);
+  const ParticleStore &particles = container.GetParticles();
+  REQUIRE(particles.Size() == 900);
+
+  float max_x = *std::max_element(particles.PositionX(),
+                                  particles.PositionX() + particles.Size());
+  float max_y = *std::max_element(particles.PositionY(),
+                                  particles.PositionY() + particles.Size());
+  REQUIRE(max_x > 5e5);
+  REQUIRE(max_y > 5e5);
+
+  for (int frame = 0; frame < 10; ++frame) {
+    container.AdvanceOneFrame();
+  }
+  RequireInside(container, 8);
+}
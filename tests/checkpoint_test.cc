@@ -0,0 +1,99 @@
+#include <catch2/catch.hpp>
+
+#include <cstdio>
+#include <fstream>
+#include <stdexcept>
+
+#include "checkpoint.h"
+#include "gas_container.h"
+
+using idealgas::Checkpoint;
+using idealgas::GasContainer;
+using idealgas::ParticleStore;
+
+namespace {
+
+const char *kPath = "checkpoint_test.ckpt";
+
+void RequireSameParticles(const ParticleStore &first,
+                          const ParticleStore &second) {
+  REQUIRE(first.Size() == second.Size());
+  REQUIRE(first.SpeciesCount() == second.SpeciesCount());
+  for (size_t i = 0; i < first.Size(); ++i) {
+    REQUIRE(first.PositionX()[i] == second.PositionX()[i]);
+    REQUIRE(first.PositionY()[i] == second.PositionY()[i]);
+    REQUIRE(first.VelocityX()[i] == second.VelocityX()[i]);
+    REQUIRE(first.VelocityY()[i] == second.VelocityY()[i]);
+    REQUIRE(first.InverseMass()[i] == second.InverseMass()[i]);
+    REQUIRE(first.Radius()[i] == second.Radius()[i]);
+    REQUIRE(first.SpeciesId()[i] == second.SpeciesId()[i]);
+  }
+}
+
+}  // namespace
+
+TEST_CASE("Checkpoint round trip") {
+  srand(5);
+  GasContainer original(600, 960, 60, "white", 40, 40, 40);
+  for (size_t frame = 0; frame < 25; ++frame) {
+    original.AdvanceOneFrame();
+  }
+  original.SaveCheckpoint(kPath);
+
+  SECTION("Header and arrays are read in place") {
+    Checkpoint checkpoint(kPath);
+    REQUIRE(checkpoint.GetParticleCount() == 120);
+    REQUIRE(checkpoint.GetFrame() == 25);
+    REQUIRE(checkpoint.GetGeometry().window_length == 600);
+    REQUIRE(checkpoint.GetSpecies().size() == 3);
+    REQUIRE(checkpoint.GetSpecies()[0].color == idealgas::Color("green"));
+    REQUIRE(checkpoint.PositionX()[7] ==
+            original.GetParticles().PositionX()[7]);
+  }
+
+  SECTION("A restored container continues identically") {
+    GasContainer restored(600, 960, 60, "white", 0, 0, 0);
+    restored.LoadCheckpoint(kPath);
+    REQUIRE(restored.GetFrameCount() == 25);
+    RequireSameParticles(original.GetParticles(), restored.GetParticles());
+
+    for (size_t frame = 0; frame < 25; ++frame) {
+      original.AdvanceOneFrame();
+      restored.AdvanceOneFrame();
+    }
+    RequireSameParticles(original.GetParticles(), restored.GetParticles());
+    REQUIRE(original.GetMap("red") == restored.GetMap("red"));
+  }
+
+  SECTION("A container of another size is rejected") {
+    GasContainer other(800, 1280, 80, "white", 0, 0, 0);
+    REQUIRE_THROWS_AS(other.LoadCheckpoint(kPath), std::invalid_argument);
+  }
+
+  std::remove(kPath);
+}
+
+TEST_CASE("Invalid checkpoints are rejected") {
+  SECTION("Missing file") {
+    REQUIRE_THROWS_AS(Checkpoint("missing.ckpt"), std::runtime_error);
+  }
+
+  SECTION("Wrong magic") {
+    std::ofstream(kPath, std::ios::binary) << std::string(200, 'x');
+    REQUIRE_THROWS_AS(Checkpoint(kPath), std::invalid_argument);
+  }
+
+  SECTION("Truncated arrays") {
+    GasContainer container(600, 960, 60, "white", 10, 10, 10);
+    container.SaveCheckpoint(kPath);
+    std::ifstream file(kPath, std::ios::binary);
+    std::string contents((std::istreambuf_iterator<char>(file)),
+                         std::istreambuf_iterator<char>());
+    file.close();
+    std::ofstream(kPath, std::ios::binary)
+        << contents.substr(0, contents.size() - 10);
+    REQUIRE_THROWS_AS(Checkpoint(kPath), std::invalid_argument);
+  }
+
+  std::remove(kPath);
+}
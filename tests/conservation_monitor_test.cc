@@ -0,0 +1,217 @@
+#include <catch2/catch.hpp>
+
+#include <stdexcept>
+#include <vector>
+
+#include "conservation_monitor.h"
+#include "gas_container.h"
+#include "particle_initializer.h"
+
+using idealgas::Boundary;
+using idealgas::Box;
+using idealgas::ConservationAlarm;
+using idealgas::ConservationMonitor;
+using idealgas::ConservedQuantity;
+using idealgas::EngineMode;
+using idealgas::GasContainer;
+using idealgas::GasStatistics;
+using idealgas::ParticleInitializer;
+using glm::vec2;
+
+namespace {
+
+GasStatistics Statistics(double energy, double momentum_x,
+                         double momentum_y) {
+  GasStatistics statistics;
+  statistics.total_mass = 2;
+  statistics.kinetic_energy = energy;
+  statistics.momentum_x = momentum_x;
+  statistics.momentum_y = momentum_y;
+  return statistics;
+}
+
+/**
+ * A container of 200 particles at kT = 2, with a monitor that keeps every
+ * alarm.
+ */
+struct MonitoredGas {
+  explicit MonitoredGas(Boundary boundary, double tolerance = 1e-3)
+      : container(800, 1280, 80, "white",
+                  Box::FromWindow(800, 80, boundary), 0, 0, 0),
+        monitor(Options(tolerance), [this](const ConservationAlarm &alarm) {
+          alarms.push_back(alarm);
+        }) {
+    ParticleInitializer::Options options;
+    options.seed = 3;
+    options.maxwell_boltzmann = true;
+    options.temperature = 2;
+    container.InitializeParticles(ParticleInitializer(options), 60, 70, 70);
+    container.SetConservationMonitor(&monitor);
+  }
+
+  static ConservationMonitor::Options Options(double tolerance) {
+    ConservationMonitor::Options options;
+    options.energy_tolerance = tolerance;
+    options.momentum_tolerance = tolerance;
+    return options;
+  }
+
+  void Advance(size_t frames) {
+    for (size_t frame = 0; frame < frames; ++frame) {
+      container.AdvanceOneFrame();
+    }
+  }
+
+  GasContainer container;
+  std::vector<ConservationAlarm> alarms;
+  ConservationMonitor monitor;
+};
+
+}  // namespace
+
+TEST_CASE("Conservation monitors measure drift from the first check") {
+  std::vector<ConservationAlarm> alarms;
+  ConservationMonitor::Options options;
+  options.energy_tolerance = 0.1;
+  options.momentum_tolerance = 0.1;
+  ConservationMonitor monitor(options, [&](const ConservationAlarm &alarm) {
+    alarms.push_back(alarm);
+  });
+
+  // The momentum scale is sqrt(2 M E) = sqrt(2 * 2 * 100) = 20.
+  monitor.Check(Statistics(100, 3, 4), 1, true, true);
+  monitor.Check(Statistics(105, 3, 5), 2, true, true);
+  REQUIRE(monitor.GetEnergyDrift() == Approx(0.05));
+  REQUIRE(monitor.GetMomentumDrift() == Approx(0.05));
+  REQUIRE(alarms.empty());
+
+  SECTION("Drifts over the tolerance raise one alarm each") {
+    monitor.Check(Statistics(80, 3, 10), 3, true, true);
+    monitor.Check(Statistics(80, 3, 10), 4, true, true);
+    REQUIRE(alarms.size() == 2);
+    REQUIRE(alarms[0].quantity == ConservedQuantity::kKineticEnergy);
+    REQUIRE(alarms[0].frame == 3);
+    REQUIRE(alarms[0].reference == Approx(100));
+    REQUIRE(alarms[0].drift == Approx(0.2));
+    REQUIRE(alarms[1].quantity == ConservedQuantity::kMomentum);
+    REQUIRE(alarms[1].drift == Approx(0.3));
+    REQUIRE(monitor.GetAlarmCount() == 2);
+
+    SECTION("Alarms are raised again after the drift recovers") {
+      monitor.Check(Statistics(100, 3, 4), 5, true, true);
+      monitor.Check(Statistics(80, 3, 4), 6, true, true);
+      REQUIRE(alarms.size() == 3);
+      REQUIRE(alarms[2].frame == 6);
+      REQUIRE(monitor.GetMaxEnergyDrift() == Approx(0.2));
+    }
+
+    SECTION("Rebasing takes a new reference") {
+      monitor.Rebase();
+      monitor.Check(Statistics(80, 3, 10), 5, true, true);
+      monitor.Check(Statistics(81, 3, 10), 6, true, true);
+      REQUIRE(alarms.size() == 2);
+      REQUIRE(monitor.GetEnergyDrift() == Approx(1.0 / 80));
+      REQUIRE(monitor.GetMaxMomentumDrift() == 0);
+    }
+  }
+
+  SECTION("Quantities that are not conserved are not checked") {
+    monitor.Check(Statistics(200, 30, 40), 3, false, false);
+    REQUIRE(alarms.empty());
+    monitor.Check(Statistics(200, 3, 4), 4, false, true);
+    REQUIRE(monitor.GetMomentumDrift() == 0);
+    REQUIRE(alarms.empty());
+  }
+
+  SECTION("Rescaling velocities follows the reference") {
+    monitor.Rescale(2);
+    monitor.Check(Statistics(400, 6, 8), 3, true, true);
+    REQUIRE(monitor.GetEnergyDrift() == Approx(0));
+    REQUIRE(monitor.GetMomentumDrift() == Approx(0));
+    REQUIRE(alarms.empty());
+  }
+}
+
+TEST_CASE("Conservation monitors sample frames") {
+  ConservationMonitor::Options options;
+  options.sample_every = 4;
+  ConservationMonitor monitor(options, ConservationMonitor::Callback());
+  REQUIRE(monitor.ShouldSample(8));
+  REQUIRE_FALSE(monitor.ShouldSample(9));
+
+  SECTION("Options are checked") {
+    options.sample_every = 0;
+    REQUIRE_THROWS_AS(
+        ConservationMonitor(options, ConservationMonitor::Callback()),
+        std::invalid_argument);
+    options.sample_every = 1;
+    options.energy_tolerance = -1;
+    REQUIRE_THROWS_AS(
+        ConservationMonitor(options, ConservationMonitor::Callback()),
+        std::invalid_argument);
+  }
+}
+
+TEST_CASE("Containers conserve energy and momentum within the tolerance") {
+  MonitoredGas gas(Boundary::kPeriodic);
+  gas.Advance(300);
+
+  REQUIRE(gas.alarms.empty());
+  REQUIRE(gas.monitor.GetMaxEnergyDrift() < 1e-3);
+  REQUIRE(gas.monitor.GetMaxMomentumDrift() < 1e-3);
+
+  SECTION("Statistics are reused when they are enabled") {
+    gas.container.SetStatisticsEnabled(true);
+    gas.Advance(20);
+    REQUIRE(gas.alarms.empty());
+  }
+
+  SECTION("Changing speeds on purpose is not drift") {
+    gas.container.SpeedUpParticles();
+    gas.Advance(20);
+    gas.container.SlowDownParticles();
+    gas.container.SlowDownParticles();
+    gas.Advance(20);
+    REQUIRE(gas.alarms.empty());
+  }
+
+  SECTION("The event-driven engine is watched too") {
+    gas.container.SetEngineMode(EngineMode::kEventDriven);
+    gas.Advance(100);
+    REQUIRE(gas.alarms.empty());
+    REQUIRE(gas.monitor.GetMaxEnergyDrift() < 1e-3);
+  }
+}
+
+TEST_CASE("Containers only check what should be conserved") {
+  SECTION("Walls take momentum") {
+    MonitoredGas gas(Boundary::kReflecting, 0);
+    gas.Advance(50);
+    REQUIRE(gas.monitor.GetMaxMomentumDrift() == 0);
+    for (const ConservationAlarm &alarm : gas.alarms) {
+      REQUIRE(alarm.quantity == ConservedQuantity::kKineticEnergy);
+    }
+  }
+
+  SECTION("Fields change the kinetic energy") {
+    MonitoredGas gas(Boundary::kReflecting);
+    gas.container.SetGravity(vec2(0, 0.5f));
+    gas.Advance(100);
+    REQUIRE(gas.alarms.empty());
+
+    SECTION("Turning a field off takes a new reference") {
+      gas.container.SetGravity(vec2(0, 0));
+      gas.Advance(100);
+      REQUIRE(gas.alarms.empty());
+    }
+  }
+}
+
+TEST_CASE("Conservation monitors raise alarms from a container") {
+  // With no tolerance, float rounding alone sets off the energy alarm.
+  MonitoredGas gas(Boundary::kPeriodic, 0);
+  gas.Advance(100);
+  REQUIRE_FALSE(gas.alarms.empty());
+  REQUIRE(gas.alarms[0].frame >= 2);
+  REQUIRE(gas.alarms[0].drift > 0);
+}
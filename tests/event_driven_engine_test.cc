@@ -0,0 +1,126 @@
+#include <catch2/catch.hpp>
+
+#include "event_driven_engine.h"
+
+using idealgas::Boundary;
+using idealgas::Box;
+using idealgas::EventDrivenEngine;
+using idealgas::Particle;
+using idealgas::ParticleStore;
+using glm::vec2;
+
+namespace {
+
+double KineticEnergy(const ParticleStore &particles) {
+  double energy = 0;
+  for (size_t i = 0; i < particles.Size(); ++i) {
+    Particle particle = particles.Get(i);
+    energy += 0.5 * particle.GetMass() * particle.GetSpeed() * particle.GetSpeed();
+  }
+  return energy;
+}
+
+}  // namespace
+
+TEST_CASE("Event-driven particle collisions") {
+  EventDrivenEngine engine(Box(0, 0, 200, 200));
+  ParticleStore particles;
+
+  SECTION("Equal masses swap velocities at the moment they touch") {
+    particles.Add(Particle(vec2(90, 100), vec2(1, 0), 1, 2, "cyan"));
+    particles.Add(Particle(vec2(110, 100), vec2(-1, 0), 1, 2, "cyan"));
+
+    // They touch after 8 units of time, then move apart for 2 more.
+    engine.Advance(particles, 10);
+
+    REQUIRE(engine.GetCollisionCount() == 1);
+    REQUIRE(particles.Get(0).GetVelocity() == vec2(-1, 0));
+    REQUIRE(particles.Get(1).GetVelocity() == vec2(1, 0));
+    REQUIRE(particles.Get(0).GetPosition().x == Approx(96));
+    REQUIRE(particles.Get(1).GetPosition().x == Approx(104));
+  }
+
+  SECTION("Fast particles do not pass through each other") {
+    particles.Add(Particle(vec2(50, 100), vec2(100, 0), 1, 1, "cyan"));
+    particles.Add(Particle(vec2(150, 100), vec2(-100, 0), 1, 1, "cyan"));
+
+    engine.Advance(particles, 0.75);
+
+    REQUIRE(engine.GetCollisionCount() == 1);
+    REQUIRE(particles.Get(0).GetPosition().x < particles.Get(1).GetPosition().x);
+  }
+}
+
+TEST_CASE("Event-driven wall collisions") {
+  EventDrivenEngine engine(Box(0, 0, 200, 200));
+  ParticleStore particles;
+
+  SECTION("Fast particles stay inside the walls") {
+    particles.Add(Particle(vec2(100, 100), vec2(1000, 370), 1, 5, "cyan"));
+    for (size_t frame = 0; frame < 100; ++frame) {
+      engine.Advance(particles, 1);
+      REQUIRE(particles.Get(0).GetPosition().x >= Approx(5));
+      REQUIRE(particles.Get(0).GetPosition().x <= Approx(195));
+      REQUIRE(particles.Get(0).GetPosition().y >= Approx(5));
+      REQUIRE(particles.Get(0).GetPosition().y <= Approx(195));
+    }
+    REQUIRE(engine.GetWallHitCount() > 100);
+  }
+
+  SECTION("A particle bounces at its radius from the wall") {
+    particles.Add(Particle(vec2(190, 100), vec2(2, 0), 1, 5, "cyan"));
+
+    // Reaches x = 195 after 2.5 units of time, then moves back for 5 more.
+    engine.Advance(particles, 7.5);
+
+    REQUIRE(engine.GetWallHitCount() == 1);
+    REQUIRE(particles.Get(0).GetVelocity() == vec2(-2, 0));
+    REQUIRE(particles.Get(0).GetPosition().x == Approx(185));
+  }
+}
+
+TEST_CASE("Event-driven periodic box") {
+  EventDrivenEngine engine(Box(0, 0, 200, 200, Boundary::kPeriodic));
+  ParticleStore particles;
+
+  SECTION("Particles leaving an edge come back at the opposite one") {
+    particles.Add(Particle(vec2(190, 100), vec2(4, 0), 1, 2, "cyan"));
+    engine.Advance(particles, 5);
+    REQUIRE(engine.GetWallHitCount() == 0);
+    REQUIRE(particles.Get(0).GetPosition().x == Approx(10));
+    REQUIRE(particles.Get(0).GetVelocity() == vec2(4, 0));
+  }
+
+  SECTION("Particles collide across an edge") {
+    particles.Add(Particle(vec2(5, 100), vec2(-1, 0), 1, 2, "cyan"));
+    particles.Add(Particle(vec2(195, 100), vec2(1, 0), 1, 2, "cyan"));
+    engine.Advance(particles, 10);
+    REQUIRE(engine.GetCollisionCount() == 1);
+    REQUIRE(particles.Get(0).GetVelocity() == vec2(1, 0));
+    REQUIRE(particles.Get(0).GetPosition().x == Approx(9));
+  }
+}
+
+TEST_CASE("Event-driven engine conserves energy") {
+  srand(5);
+  ParticleStore particles;
+  for (size_t i = 0; i < 300; ++i) {
+    int mass = 1 + rand() % 5;
+    particles.Add(Particle(vec2(10 + rand() % 380, 10 + rand() % 380),
+                           vec2(rand() % 21 - 10, rand() % 21 - 10), mass, 3,
+                           "cyan"));
+  }
+  double energy = KineticEnergy(particles);
+
+  EventDrivenEngine engine(Box(0, 0, 400, 400));
+  for (size_t frame = 0; frame < 50; ++frame) {
+    engine.Advance(particles, 1);
+  }
+
+  REQUIRE(engine.GetCollisionCount() > 0);
+  REQUIRE(KineticEnergy(particles) == Approx(energy).epsilon(1e-4));
+  for (size_t i = 0; i < particles.Size(); ++i) {
+    REQUIRE(particles.Get(i).GetPosition().x >= Approx(3).margin(1e-3));
+    REQUIRE(particles.Get(i).GetPosition().x <= Approx(397).margin(1e-3));
+  }
+}
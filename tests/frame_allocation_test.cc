@@ -0,0 +1,189 @@
+#include <catch2/catch.hpp>
+
+#include <cstdlib>
+#include <new>
+
+#include "gas_container.h"
+#include "particle_initializer.h"
+#include "simulation_thread.h"
+#include "thread_pool.h"
+
+using idealgas::ArrayView;
+using idealgas::Box;
+using idealgas::EngineMode;
+using idealgas::GasContainer;
+using idealgas::ParticleInitializer;
+using idealgas::SimulationSnapshot;
+using idealgas::ThreadPool;
+
+namespace {
+
+// Heap allocations made by this thread while counting is on. Other threads,
+// such as Catch's or a pool's, are never counted.
+thread_local bool counting_allocations = false;
+thread_local size_t allocation_count = 0;
+
+/**
+ * Counts the heap allocations of this thread while it is in scope.
+ */
+class AllocationCounter {
+ public:
+  AllocationCounter() {
+    allocation_count = 0;
+    counting_allocations = true;
+  }
+
+  ~AllocationCounter() {
+    counting_allocations = false;
+  }
+
+  size_t GetCount() const {
+    return allocation_count;
+  }
+};
+
+}  // namespace
+
+// Replaces the global allocation functions of the test executable; the
+// array and nothrow forms call these.
+void *operator new(size_t size) {
+  if (counting_allocations) {
+    ++allocation_count;
+  }
+  void *memory = std::malloc(size == 0 ? 1 : size);
+  if (memory == nullptr) {
+    throw std::bad_alloc();
+  }
+  return memory;
+}
+
+void operator delete(void *memory) noexcept {
+  std::free(memory);
+}
+
+TEST_CASE("Allocation counter sees allocations") {
+  AllocationCounter counter;
+  std::vector<int> *numbers = new std::vector<int>(10);
+  delete numbers;
+  REQUIRE(counter.GetCount() == 2);
+}
+
+TEST_CASE("Steady state frames do not allocate") {
+  ThreadPool pool(2);
+  GasContainer container(800, 1280, 80, "white", Box(0, 0, 640, 640), 60, 60,
+                         60);
+  ParticleInitializer::Options options;
+  options.seed = 5;
+  container.InitializeParticles(ParticleInitializer(options), 60, 60, 60);
+
+  SECTION("Time-stepped frames with statistics") {
+    container.SetStatisticsEnabled(true);
+  }
+
+  SECTION("Time-stepped frames with a neighbour list") {
+    container.SetNeighborListSkin(4);
+  }
+
+  SECTION("Event-driven frames") {
+    container.SetEngineMode(EngineMode::kEventDriven);
+  }
+
+  SECTION("Time-stepped frames on a thread pool") {
+    container.SetThreadPool(&pool);
+    container.SetStatisticsEnabled(true);
+  }
+
+  SECTION("Time-stepped frames with a neighbour list on a thread pool") {
+    container.SetThreadPool(&pool);
+    container.SetNeighborListSkin(4);
+  }
+
+  // Buffers grow to the most any frame has needed and are then reused. The
+  // particles come from a seed, so the same frames set those marks on every
+  // run; past these, none of them moved for thousands of frames.
+  for (int frame = 0; frame < 1200; ++frame) {
+    container.AdvanceOneFrame();
+  }
+  AllocationCounter counter;
+  for (int frame = 0; frame < 500; ++frame) {
+    container.AdvanceOneFrame();
+  }
+  REQUIRE(counter.GetCount() == 0);
+}
+
+TEST_CASE("Steady state frames of a pooled gas with statistics do not "
+          "allocate") {
+  // More particles than one statistics block, so the pool reduces them.
+  ThreadPool pool(2);
+  GasContainer container(800, 1280, 80, "white", Box(0, 0, 6400, 6400), 6000,
+                         6000, 6000);
+  ParticleInitializer::Options options;
+  options.seed = 5;
+  container.InitializeParticles(ParticleInitializer(options), 6000, 6000,
+                                6000);
+  container.SetThreadPool(&pool);
+  container.SetStatisticsEnabled(true);
+  REQUIRE(container.GetParticles().Size() > 16384);
+
+  for (int frame = 0; frame < 100; ++frame) {
+    container.AdvanceOneFrame();
+  }
+  AllocationCounter counter;
+  for (int frame = 0; frame < 20; ++frame) {
+    container.AdvanceOneFrame();
+  }
+  REQUIRE(counter.GetCount() == 0);
+  REQUIRE(container.GetStatistics().particle_count > 16384);
+}
+
+TEST_CASE("Parallel loops do not allocate") {
+  ThreadPool pool(3);
+  std::vector<size_t> squares(100);
+  auto square = [&squares](size_t i) {
+    squares[i] = i * i;
+  };
+  pool.ParallelFor(squares.size(), square);
+
+  AllocationCounter counter;
+  for (int loop = 0; loop < 100; ++loop) {
+    pool.ParallelFor(squares.size(), square);
+  }
+  REQUIRE(counter.GetCount() == 0);
+  REQUIRE(squares[99] == 99 * 99);
+}
+
+TEST_CASE("Histogram views do not allocate") {
+  GasContainer container(800, 1280, 80, "white", 30, 30, 30);
+  container.AdvanceOneFrame();
+  container.AdvanceOneFrame();
+
+  AllocationCounter counter;
+  size_t total = 0;
+  for (size_t id = 0; id < container.GetSpeciesCount(); ++id) {
+    ArrayView<uint32_t> counts =
+        container.GetSpeciesCounts(static_cast<uint8_t>(id));
+    REQUIRE(counts.size() == container.GetNumBins());
+    for (uint32_t count : counts) {
+      total += count;
+    }
+  }
+  REQUIRE(counter.GetCount() == 0);
+  REQUIRE(total <= 90);
+  REQUIRE(total > 0);
+}
+
+TEST_CASE("Refilling a snapshot does not allocate") {
+  GasContainer container(800, 1280, 80, "white", 30, 30, 30);
+  SimulationSnapshot snapshot;
+  container.AdvanceOneFrame();
+  container.AdvanceOneFrame();
+  snapshot.CopyFrom(container);
+
+  container.AdvanceOneFrame();
+  container.AdvanceOneFrame();
+  AllocationCounter counter;
+  snapshot.CopyFrom(container);
+  REQUIRE(counter.GetCount() == 0);
+  REQUIRE(snapshot.species_speeds.size() == 3);
+  REQUIRE(snapshot.frame == 4);
+}
@@ -0,0 +1,168 @@
+#include <catch2/catch.hpp>
+
+#include <atomic>
+#include <sstream>
+#include <stdexcept>
+#include <thread>
+#include <vector>
+
+#include "frame_profiler.h"
+#include "gas_container.h"
+#include "thread_pool.h"
+
+using idealgas::Box;
+using idealgas::FrameCounter;
+using idealgas::FrameMetrics;
+using idealgas::FramePhase;
+using idealgas::FrameProfiler;
+using idealgas::GasContainer;
+using idealgas::ScopedFrame;
+using idealgas::ScopedPhaseTimer;
+using idealgas::ThreadPool;
+
+namespace {
+
+size_t Index(FramePhase phase) {
+  return static_cast<size_t>(phase);
+}
+
+size_t Index(FrameCounter counter) {
+  return static_cast<size_t>(counter);
+}
+
+}  // namespace
+
+TEST_CASE("Frame profiler ring") {
+  FrameProfiler profiler(4);
+  for (int64_t frame = 1; frame <= 6; ++frame) {
+    profiler.BeginFrame(frame);
+    profiler.AddPhaseTime(FramePhase::kCollisions, 100, 150);
+    profiler.AddPhaseTime(FramePhase::kCollisions, 200, 230);
+    profiler.AddCount(FrameCounter::kWallHits, static_cast<uint64_t>(frame));
+    profiler.EndFrame();
+  }
+
+  SECTION("Only the last frames are kept, oldest first") {
+    std::vector<FrameMetrics> frames = profiler.GetRecentFrames();
+    REQUIRE(profiler.GetFrameCount() == 6);
+    REQUIRE(frames.size() == 4);
+    REQUIRE(frames.front().frame == 3);
+    REQUIRE(frames.back().frame == 6);
+    REQUIRE(frames.back().counters[Index(FrameCounter::kWallHits)] == 6);
+  }
+
+  SECTION("Time in a phase adds up over the frame") {
+    const FrameMetrics &metrics = profiler.GetRecentFrames().back();
+    REQUIRE(metrics.phase_ns[Index(FramePhase::kCollisions)] == 80);
+    REQUIRE(metrics.phase_start_ns[Index(FramePhase::kCollisions)] == 100);
+    REQUIRE(metrics.phase_ns[Index(FramePhase::kWalls)] == 0);
+  }
+
+  SECTION("Traces have an event per frame, phase and counter set") {
+    std::ostringstream trace;
+    profiler.WriteChromeTrace(trace);
+    std::string json = trace.str();
+    REQUIRE(json.find("\"traceEvents\"") != std::string::npos);
+    size_t frames = 0;
+    size_t collisions = 0;
+    for (size_t at = json.find("\"name\":\"frame\""); at != std::string::npos;
+         at = json.find("\"name\":\"frame\"", at + 1)) {
+      ++frames;
+    }
+    for (size_t at = json.find("\"name\":\"collisions\"");
+         at != std::string::npos;
+         at = json.find("\"name\":\"collisions\"", at + 1)) {
+      ++collisions;
+    }
+    REQUIRE(frames == 4);
+    REQUIRE(collisions == 4);
+    REQUIRE(json.find("\"wall_hits\":6") != std::string::npos);
+  }
+
+  SECTION("A profiler keeps at least one frame") {
+    REQUIRE_THROWS_AS(FrameProfiler(0), std::invalid_argument);
+  }
+}
+
+TEST_CASE("Scoped timers use the active profiler") {
+  FrameProfiler profiler;
+  REQUIRE(FrameProfiler::GetActive() == nullptr);
+  {
+    ScopedFrame frame(&profiler, 9);
+    REQUIRE(FrameProfiler::GetActive() == &profiler);
+    ScopedPhaseTimer timer(FramePhase::kHistograms);
+    idealgas::CountFrameEvents(FrameCounter::kPairsTested, 3);
+  }
+  REQUIRE(FrameProfiler::GetActive() == nullptr);
+  // Counts without an active profiler go nowhere.
+  idealgas::CountFrameEvents(FrameCounter::kPairsTested, 5);
+
+  std::vector<FrameMetrics> frames = profiler.GetRecentFrames();
+  REQUIRE(frames.size() == 1);
+  REQUIRE(frames[0].frame == 9);
+  REQUIRE(frames[0].counters[Index(FrameCounter::kPairsTested)] == 3);
+  REQUIRE(frames[0].phase_ns[Index(FramePhase::kHistograms)] <=
+          frames[0].duration_ns);
+}
+
+TEST_CASE("Readers never see a partly written frame") {
+  FrameProfiler profiler(8);
+  std::atomic<bool> done(false);
+  std::thread writer([&] {
+    for (int64_t frame = 0; frame < 20000; ++frame) {
+      profiler.BeginFrame(frame);
+      profiler.AddCount(FrameCounter::kPairsTested,
+                        static_cast<uint64_t>(2 * frame));
+      profiler.AddCount(FrameCounter::kWallHits,
+                        static_cast<uint64_t>(3 * frame));
+      profiler.EndFrame();
+    }
+    done = true;
+  });
+
+  bool consistent = true;
+  while (!done) {
+    int64_t previous = -1;
+    for (const FrameMetrics &metrics : profiler.GetRecentFrames()) {
+      uint64_t frame = static_cast<uint64_t>(metrics.frame);
+      consistent &= metrics.frame > previous;
+      consistent &=
+          metrics.counters[Index(FrameCounter::kPairsTested)] == 2 * frame;
+      consistent &=
+          metrics.counters[Index(FrameCounter::kWallHits)] == 3 * frame;
+      previous = metrics.frame;
+    }
+  }
+  writer.join();
+  REQUIRE(consistent);
+  REQUIRE(profiler.GetRecentFrames().size() == 8);
+}
+
+TEST_CASE("Container frames are profiled") {
+  GasContainer container(1000, 1000, 200, "white", Box(0, 0, 600, 600), 30,
+                         30, 30);
+  FrameProfiler profiler;
+  ThreadPool pool(2);
+  container.SetThreadPool(&pool);
+  container.SetFrameProfiler(&profiler);
+  for (int frame = 0; frame < 10; ++frame) {
+    container.AdvanceOneFrame();
+  }
+
+#if IDEALGAS_PROFILING
+  std::vector<FrameMetrics> frames = profiler.GetRecentFrames();
+  REQUIRE(frames.size() == 10);
+  REQUIRE(frames.back().frame == 10);
+  uint64_t pairs = 0;
+  for (const FrameMetrics &metrics : frames) {
+    pairs += metrics.counters[Index(FrameCounter::kPairsTested)];
+    REQUIRE(metrics.phase_ns[Index(FramePhase::kCollisions)] > 0);
+    REQUIRE(metrics.phase_ns[Index(FramePhase::kIntegration)] > 0);
+  }
+  REQUIRE(pairs > 0);
+  REQUIRE(frames[1].phase_ns[Index(FramePhase::kHistograms)] > 0);
+#else
+  // The timers are compiled out.
+  REQUIRE(profiler.GetFrameCount() == 0);
+#endif
+}
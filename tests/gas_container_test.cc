@@ -43,4 +43,115 @@ TEST_CASE("Map size update") {
     }
   }
 }
-}
\ No newline at end of file
+
+TEST_CASE("Time step and external fields") {
+  GasContainer container(1000, 1000, 200, "white", 0, 0, 4);
+
+  SECTION("Time step must be positive") {
+    REQUIRE_THROWS_AS(container.SetTimeStep(0), std::invalid_argument);
+    REQUIRE_THROWS_AS(container.SetTimeStep(-1), std::invalid_argument);
+    REQUIRE(container.GetTimeStep() == 1);
+  }
+
+  SECTION("Gravity pulls every particle the same way") {
+    container.SetIntegrator(IntegratorKind::kVelocityVerlet);
+    container.SetTimeStep(0.5f);
+    container.SetGravity(glm::vec2(0, 0.25f));
+    const ParticleStore &particles = container.GetParticles();
+    std::vector<float> vy(particles.VelocityY(),
+                          particles.VelocityY() + particles.Size());
+
+    container.AdvanceOneFrame();
+    size_t pulled = 0;
+    for (size_t i = 0; i < particles.Size(); ++i) {
+      // A particle that bounced off a wall had its velocity flipped first.
+      if (particles.VelocityY()[i] == Approx(vy[i] + 0.125f) ||
+          particles.VelocityY()[i] == Approx(-vy[i] + 0.125f)) {
+        ++pulled;
+      }
+    }
+    REQUIRE(pulled == particles.Size());
+  }
+}
+
+TEST_CASE("Mixtures of many species") {
+  const char *kColors[] = {"cyan", "magenta", "gold", "navy"};
+  std::vector<ParticleInitializer::SpeciesAmount> species;
+  for (int id = 0; id < 16; ++id) {
+    species.push_back({Particle(glm::vec2(), glm::vec2(1 + id % 5, 1), 1 + id,
+                                2 + id % 4, kColors[id % 4]),
+                       static_cast<size_t>(3 + id)});
+  }
+  GasContainer container(1000, 1000, 200, "white", Box(0, 0, 2000, 2000),
+                         species);
+  container.UpdateHistograms();
+
+  SECTION("Each species gets the id of its place in the list") {
+    REQUIRE(container.GetSpeciesCount() == 16);
+    const ParticleStore &particles = container.GetParticles();
+    REQUIRE(particles.GetSpecies(9).mass == 10);
+    REQUIRE(particles.GetSpecies(9).color == Color("magenta"));
+  }
+
+  SECTION("Each species has its own histogram") {
+    for (int id = 0; id < 16; ++id) {
+      int counted = 0;
+      uint8_t species = static_cast<uint8_t>(id);
+      for (const auto &bin : container.GetSpeciesMap(species)) {
+        counted += bin.second;
+      }
+      // Particles exactly at the top speed fall past the last bin.
+      REQUIRE(counted <= 3 + id);
+    }
+    int slowest = 0;
+    for (const auto &bin : container.GetSpeciesMap(0)) {
+      slowest += bin.second;
+    }
+    REQUIRE(slowest == 3);
+  }
+
+  SECTION("Colour maps add up the species of that colour") {
+    std::map<int, int> gold = container.GetMap("gold");
+    for (const auto &bin : gold) {
+      int expected = 0;
+      for (int id = 2; id < 16; id += 4) {
+        expected +=
+            container.GetSpeciesMap(static_cast<uint8_t>(id))[bin.first];
+      }
+      REQUIRE(bin.second == expected);
+    }
+  }
+}
+
+TEST_CASE("Species keep their place with empty and repeated entries") {
+  Particle prototype(glm::vec2(), glm::vec2(1, 1), 2, 3, "cyan");
+  std::vector<ParticleInitializer::SpeciesAmount> species = {
+      {prototype, 5},
+      {Particle(glm::vec2(), glm::vec2(2, 0), 1, 2, "gold"), 0},
+      {prototype, 4}};
+
+  auto require_ids = [](const ParticleStore &particles) {
+    REQUIRE(particles.SpeciesCount() == 3);
+    REQUIRE(particles.Size() == 9);
+    REQUIRE(particles.GetSpecies(1).color == Color("gold"));
+    for (size_t i = 0; i < particles.Size(); ++i) {
+      REQUIRE(particles.SpeciesId()[i] == (i < 5 ? 0 : 2));
+    }
+  };
+
+  GasContainer container(1000, 1000, 200, "white", Box(0, 0, 2000, 2000),
+                         species);
+  container.UpdateHistograms();
+  require_ids(container.GetParticles());
+  for (const auto &bin : container.GetSpeciesMap(1)) {
+    REQUIRE(bin.second == 0);
+  }
+
+  SECTION("Seeded particles number their species the same way") {
+    ParticleInitializer::Options options;
+    options.seed = 5;
+    container.InitializeParticles(ParticleInitializer(options), species);
+    require_ids(container.GetParticles());
+  }
+}
+}
@@ -0,0 +1,143 @@
+#include <catch2/catch.hpp>
+
+#include <vector>
+
+#include "gas_container.h"
+#include "gas_statistics.h"
+#include "particle_initializer.h"
+#include "thread_pool.h"
+
+using idealgas::Boundary;
+using idealgas::Box;
+using idealgas::DoubleParticleStore;
+using idealgas::EngineMode;
+using idealgas::GasContainer;
+using idealgas::GasStatistics;
+using idealgas::Particle;
+using idealgas::ParticleInitializer;
+using idealgas::ParticleStore;
+using idealgas::StatisticsReduction;
+using idealgas::ThreadPool;
+using idealgas::WallBounds;
+using glm::vec2;
+
+TEST_CASE("Statistics of a few particles") {
+  ParticleStore particles;
+  particles.Add(Particle(vec2(10, 20), vec2(3, 4), 2, 1, "red"));
+  particles.Add(Particle(vec2(30, 40), vec2(-1, 0), 6, 2, "cyan"));
+
+  GasStatistics statistics = StatisticsReduction::Reduce(particles);
+
+  REQUIRE(statistics.particle_count == 2);
+  REQUIRE(statistics.total_mass == 8);
+  REQUIRE(statistics.kinetic_energy == Approx(0.5 * 2 * 25 + 0.5 * 6 * 1));
+  REQUIRE(statistics.temperature == Approx(14.0));
+  REQUIRE(statistics.momentum_x == Approx(2 * 3 - 6 * 1));
+  REQUIRE(statistics.momentum_y == Approx(2 * 4));
+  REQUIRE(statistics.max_speed == Approx(5));
+  REQUIRE(statistics.wall_impulse == 0);
+  REQUIRE(statistics.pressure == 0);
+
+  SECTION("An empty store has zero statistics") {
+    GasStatistics empty = StatisticsReduction::Reduce(ParticleStore());
+    REQUIRE(empty.particle_count == 0);
+    REQUIRE(empty.temperature == 0);
+    REQUIRE(empty.max_speed == 0);
+  }
+
+  SECTION("Double precision stores give the same statistics") {
+    DoubleParticleStore doubles;
+    doubles.Add(Particle(vec2(10, 20), vec2(3, 4), 2, 1, "red"));
+    doubles.Add(Particle(vec2(30, 40), vec2(-1, 0), 6, 2, "cyan"));
+    GasStatistics double_statistics = StatisticsReduction::Reduce(doubles);
+    REQUIRE(double_statistics.kinetic_energy == statistics.kinetic_energy);
+    REQUIRE(double_statistics.momentum_x == statistics.momentum_x);
+  }
+}
+
+TEST_CASE("Statistics are the same for any number of threads") {
+  ParticleInitializer::Options options;
+  options.seed = 11;
+  options.placement = ParticleInitializer::Placement::kUniform;
+  options.maxwell_boltzmann = true;
+  Box box(0, 0, 1000, 1000);
+  ParticleStore particles;
+  ParticleInitializer(options).Generate(
+      box, {{Particle(vec2(), vec2(), 4, 1, "red"), 30000},
+            {Particle(vec2(), vec2(), 1, 1, "cyan"), 20000}},
+      particles);
+  std::vector<WallBounds> bounds = box.GetSpeciesBounds(particles);
+
+  GasStatistics serial =
+      StatisticsReduction::ReduceBeforeMove(particles, box, bounds, 1);
+  for (size_t thread_count : {0, 1, 3, 4}) {
+    ThreadPool pool(thread_count);
+    GasStatistics parallel = StatisticsReduction::ReduceBeforeMove(
+        particles, box, bounds, 1, &pool);
+    REQUIRE(parallel.kinetic_energy == serial.kinetic_energy);
+    REQUIRE(parallel.momentum_x == serial.momentum_x);
+    REQUIRE(parallel.momentum_y == serial.momentum_y);
+    REQUIRE(parallel.max_speed == serial.max_speed);
+    REQUIRE(parallel.wall_impulse == serial.wall_impulse);
+  }
+
+  // Maxwell-Boltzmann velocities are drawn at the requested temperature.
+  REQUIRE(serial.temperature == Approx(options.temperature).epsilon(0.02));
+}
+
+TEST_CASE("Wall impulse and pressure") {
+  Box box(0, 0, 100, 50);
+  ParticleStore particles;
+  // At the right wall, bouncing in x; in the corner, bouncing in both.
+  particles.Add(Particle(vec2(98, 25), vec2(3, 1), 2, 2, "red"));
+  particles.Add(Particle(vec2(2, 2), vec2(-1, -2), 2, 2, "red"));
+  // Inside the walls, so no bounce.
+  particles.Add(Particle(vec2(50, 25), vec2(7, 7), 2, 2, "red"));
+  std::vector<WallBounds> bounds = box.GetSpeciesBounds(particles);
+
+  GasStatistics statistics =
+      StatisticsReduction::ReduceBeforeMove(particles, box, bounds, 2);
+
+  double impulse = 2 * 2 * 3 + 2 * 2 * 1 + 2 * 2 * 2;
+  REQUIRE(statistics.wall_impulse == Approx(impulse));
+  REQUIRE(statistics.pressure == Approx(impulse / (300.0 * 2)));
+
+  SECTION("A periodic box has no walls") {
+    Box periodic(0, 0, 100, 50, Boundary::kPeriodic);
+    GasStatistics wrapped = StatisticsReduction::ReduceBeforeMove(
+        particles, periodic, periodic.GetSpeciesBounds(particles), 2);
+    REQUIRE(wrapped.wall_impulse == 0);
+    REQUIRE(wrapped.pressure == 0);
+  }
+}
+
+TEST_CASE("Container statistics follow the ideal gas law") {
+  const size_t kAmount = 400;
+  GasContainer container(1000, 1000, 200, "white", Box(0, 0, 1000, 1000),
+                         {{Particle(vec2(), vec2(), 1, 1, "red"), kAmount}});
+  ParticleInitializer::Options options;
+  options.seed = 5;
+  options.maxwell_boltzmann = true;
+  container.InitializeParticles(
+      ParticleInitializer(options),
+      {{Particle(vec2(), vec2(), 1, 1, "red"), kAmount}});
+  container.SetStatisticsEnabled(true);
+
+  for (EngineMode mode : {EngineMode::kTimeStepped, EngineMode::kEventDriven}) {
+    container.SetEngineMode(mode);
+    double pressure = 0;
+    const int kFrames = 400;
+    for (int frame = 0; frame < kFrames; ++frame) {
+      container.AdvanceOneFrame();
+      pressure += container.GetStatistics().pressure / kFrames;
+    }
+
+    // In 2D, P A = N k T.
+    const GasStatistics &statistics = container.GetStatistics();
+    REQUIRE(statistics.particle_count == kAmount);
+    REQUIRE(statistics.max_speed == Approx(container.MaxParticleSpeed())
+                                        .margin(1));
+    REQUIRE(pressure * 1000 * 1000 ==
+            Approx(kAmount * statistics.temperature).epsilon(0.1));
+  }
+}
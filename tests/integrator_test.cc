@@ -0,0 +1,204 @@
+#include <catch2/catch.hpp>
+
+#include <cmath>
+#include <random>
+#include <vector>
+
+#include "integrator.h"
+#include "physics_engine.h"
+
+using idealgas::Box;
+using idealgas::BasicParticleStore;
+using idealgas::CentralField;
+using idealgas::DoubleParticleStore;
+using idealgas::EulerIntegrator;
+using idealgas::LeapfrogIntegrator;
+using idealgas::NoField;
+using idealgas::Particle;
+using idealgas::ParticleStore;
+using idealgas::PhysicsEngine;
+using idealgas::UniformField;
+using idealgas::VelocityVerletIntegrator;
+using idealgas::WallBounds;
+using glm::vec2;
+
+namespace {
+
+const size_t kWindowLength = 400;
+const size_t kMargin = 40;
+
+/**
+ * Fills a store with particles spread over the container, some of them
+ * touching the walls.
+ */
+void MakeParticles(ParticleStore &particles) {
+  std::mt19937 random(7);
+  std::uniform_real_distribution<float> position(kMargin,
+                                                 kWindowLength - kMargin);
+  std::uniform_real_distribution<float> velocity(-5, 5);
+  for (size_t i = 0; i < 200; ++i) {
+    particles.Add(Particle(vec2(position(random), position(random)),
+                           vec2(velocity(random), velocity(random)), 1,
+                           static_cast<float>(1 + i % 8), "orange"));
+  }
+}
+
+/**
+ * Energy per unit mass of a particle in a central field.
+ */
+template <typename T>
+double OrbitEnergy(const BasicParticleStore<T> &particles,
+                   const CentralField &field) {
+  double dx = particles.PositionX()[0] - field.center_x;
+  double dy = particles.PositionY()[0] - field.center_y;
+  double vx = particles.VelocityX()[0];
+  double vy = particles.VelocityY()[0];
+  double distance = std::sqrt(dx * dx + dy * dy +
+                              field.softening * field.softening);
+  return 0.5 * (vx * vx + vy * vy) - field.strength / distance;
+}
+
+/**
+ * Runs a circular orbit for a number of steps in a store of the given
+ * scalar type.
+ * @return largest relative change in energy along the way
+ */
+template <typename Integrator, typename Store = ParticleStore>
+double OrbitEnergyDrift(float dt, size_t steps) {
+  CentralField field;
+  field.strength = 1000;
+  field.softening = 0;
+  const float kOrbitRadius = 10;
+
+  Store particles;
+  float speed = std::sqrt(field.strength / kOrbitRadius);
+  particles.Add(Particle(vec2(kOrbitRadius, 0), vec2(0, speed), 1, 1, "red"));
+
+  double initial = OrbitEnergy(particles, field);
+  double drift = 0;
+  for (size_t step = 0; step < steps; ++step) {
+    Integrator::Step(particles, field, dt);
+    drift = std::max(drift, std::fabs(OrbitEnergy(particles, field) / initial -
+                                      1));
+  }
+  return drift;
+}
+
+/**
+ * Requires two stores to hold exactly the same positions and velocities.
+ */
+void RequireSame(const ParticleStore &expected, const ParticleStore &actual) {
+  REQUIRE(expected.Size() == actual.Size());
+  for (size_t i = 0; i < expected.Size(); ++i) {
+    REQUIRE(expected.PositionX()[i] == actual.PositionX()[i]);
+    REQUIRE(expected.PositionY()[i] == actual.PositionY()[i]);
+    REQUIRE(expected.VelocityX()[i] == actual.VelocityX()[i]);
+    REQUIRE(expected.VelocityY()[i] == actual.VelocityY()[i]);
+  }
+}
+
+}  // namespace
+
+TEST_CASE("Integrators without a field match the wall kernel") {
+  ParticleStore expected;
+  MakeParticles(expected);
+  ParticleStore euler = expected;
+  ParticleStore verlet = expected;
+  ParticleStore leapfrog = expected;
+  Box box = Box::FromWindow(kWindowLength, kMargin);
+  std::vector<WallBounds> bounds = box.GetSpeciesBounds(expected);
+
+  for (int frame = 0; frame < 50; ++frame) {
+    PhysicsEngine::MoveParticles(box, expected);
+    PhysicsEngine::MoveParticles<EulerIntegrator>(box, bounds, euler,
+                                                  NoField(), 1);
+    PhysicsEngine::MoveParticles<VelocityVerletIntegrator>(box, bounds, verlet,
+                                                           NoField(), 1);
+    PhysicsEngine::MoveParticles<LeapfrogIntegrator>(box, bounds, leapfrog,
+                                                     NoField(), 1);
+  }
+
+  RequireSame(expected, euler);
+  RequireSame(expected, verlet);
+  RequireSame(expected, leapfrog);
+}
+
+TEST_CASE("Integrators under uniform gravity") {
+  UniformField gravity;
+  gravity.y = 2;
+  const float kDt = 0.5f;
+  const int kSteps = 8;
+  const float kTime = kDt * kSteps;
+
+  ParticleStore verlet;
+  verlet.Add(Particle(vec2(0, 0), vec2(3, -4), 1, 1, "red"));
+  ParticleStore leapfrog = verlet;
+  ParticleStore euler = verlet;
+  for (int step = 0; step < kSteps; ++step) {
+    VelocityVerletIntegrator::Step(verlet, gravity, kDt);
+    LeapfrogIntegrator::Step(leapfrog, gravity, kDt);
+    EulerIntegrator::Step(euler, gravity, kDt);
+  }
+
+  SECTION("Second order integrators follow the exact parabola") {
+    float expected_y = -4 * kTime + 0.5f * gravity.y * kTime * kTime;
+    for (const ParticleStore *particles : {&verlet, &leapfrog}) {
+      REQUIRE(particles->PositionX()[0] == Approx(3 * kTime));
+      REQUIRE(particles->PositionY()[0] == Approx(expected_y));
+      REQUIRE(particles->VelocityY()[0] == Approx(-4 + gravity.y * kTime));
+    }
+  }
+
+  SECTION("Euler lags by half a step of acceleration") {
+    float expected_y = -4 * kTime + 0.5f * gravity.y * kTime * kTime -
+                       0.5f * gravity.y * kTime * kDt;
+    REQUIRE(euler.PositionY()[0] == Approx(expected_y));
+    REQUIRE(euler.VelocityY()[0] == Approx(-4 + gravity.y * kTime));
+  }
+
+  SECTION("Accelerated particles are marked for the histograms") {
+    REQUIRE(verlet.SpeedChanged()[0] == 1);
+  }
+}
+
+TEST_CASE("Symplectic integrators keep orbits bounded") {
+  // About 16 orbits at 200 steps per orbit.
+  const float kDt = 0.01f;
+  const size_t kSteps = 3200;
+
+  double euler_drift = OrbitEnergyDrift<EulerIntegrator>(kDt, kSteps);
+  double verlet_drift = OrbitEnergyDrift<VelocityVerletIntegrator>(kDt, kSteps);
+  double leapfrog_drift = OrbitEnergyDrift<LeapfrogIntegrator>(kDt, kSteps);
+
+  REQUIRE(verlet_drift < 1e-3);
+  REQUIRE(leapfrog_drift < 1e-3);
+  REQUIRE(euler_drift > 100 * verlet_drift);
+}
+
+TEST_CASE("Central field points at its centre") {
+  CentralField field;
+  field.center_x = 5;
+  field.center_y = 5;
+  field.strength = 8;
+  field.softening = 0;
+  float ax;
+  float ay;
+  field.Accelerate(7.0f, 5.0f, ax, ay);
+  REQUIRE(ax == Approx(-2));
+  REQUIRE(ay == Approx(0));
+}
+
+TEST_CASE("Double precision orbits drift less than float ones") {
+  // About 16 orbits at 2000 steps per orbit, where rounding in float
+  // outweighs the error of the integrator.
+  const float kDt = 0.001f;
+  const size_t kSteps = 32000;
+
+  double float_drift = OrbitEnergyDrift<VelocityVerletIntegrator>(kDt, kSteps);
+  double double_drift =
+      OrbitEnergyDrift<VelocityVerletIntegrator, DoubleParticleStore>(kDt,
+                                                                      kSteps);
+  INFO(float_drift << " " << double_drift);
+  REQUIRE(double_drift < 1e-6);
+  REQUIRE(double_drift * 10 < float_drift);
+}
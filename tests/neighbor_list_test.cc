@@ -0,0 +1,200 @@
+#include <catch2/catch.hpp>
+
+#include <stdexcept>
+#include <vector>
+
+#include "gas_container.h"
+#include "neighbor_list.h"
+#include "physics_engine.h"
+#include "random_particles.h"
+#include "spatial_grid.h"
+#include "thread_pool.h"
+
+using idealgas::Boundary;
+using idealgas::Box;
+using idealgas::DoubleParticleStore;
+using idealgas::GasContainer;
+using idealgas::MakeRandomParticles;
+using idealgas::NeighborList;
+using idealgas::Particle;
+using idealgas::ParticleInitializer;
+using idealgas::ParticleStore;
+using idealgas::PhysicsEngine;
+using idealgas::SpatialGrid;
+using idealgas::ThreadPool;
+using glm::vec2;
+
+namespace {
+
+// Slow enough that the list lasts a few frames between rebuilds.
+const float kSpeedScale = 1 / 8.0f;
+
+}  // namespace
+
+TEST_CASE("Neighbour list pairs") {
+  ParticleStore particles;
+  particles.Add(Particle(vec2(10, 10), vec2(0, 0), 1, 2, "cyan"));
+  particles.Add(Particle(vec2(14, 10), vec2(0, 0), 1, 2, "cyan"));
+  particles.Add(Particle(vec2(100, 100), vec2(0, 0), 1, 2, "cyan"));
+  particles.Add(Particle(vec2(10, 16), vec2(0, 0), 1, 2, "cyan"));
+  Box box(0, 0, 200, 200);
+
+  SECTION("Pairs within touching distance plus the skin are listed") {
+    NeighborList list(1);
+    list.Rebuild(particles, box);
+    REQUIRE(list.GetOffsets() == std::vector<uint32_t>{0, 1, 1, 1, 1});
+    REQUIRE(list.GetNeighbors() == std::vector<uint32_t>{1});
+  }
+
+  SECTION("A larger skin lists more pairs") {
+    NeighborList list(3);
+    list.Rebuild(particles, box);
+    REQUIRE(list.GetOffsets() == std::vector<uint32_t>{0, 2, 2, 2, 2});
+    REQUIRE(list.GetNeighbors() == std::vector<uint32_t>{1, 3});
+    REQUIRE(list.GetPairCount() == 2);
+  }
+
+  SECTION("The skin cannot be negative") {
+    REQUIRE_THROWS_AS(NeighborList(-1), std::invalid_argument);
+  }
+}
+
+TEST_CASE("Neighbour list rebuilds") {
+  ParticleStore particles = MakeRandomParticles(50, 5, kSpeedScale);
+  Box box(0, 0, 200, 200);
+  NeighborList list(2);
+
+  SECTION("The first update builds the list") {
+    REQUIRE(list.Update(particles, box));
+    REQUIRE_FALSE(list.Update(particles, box));
+    REQUIRE(list.GetRebuildCount() == 1);
+  }
+
+  SECTION("Moving less than half the skin keeps the list") {
+    list.Update(particles, box);
+    particles.PositionX()[7] += 0.9f;
+    REQUIRE_FALSE(list.NeedsRebuild(particles, box));
+    particles.PositionX()[7] += 0.2f;
+    REQUIRE(list.NeedsRebuild(particles, box));
+  }
+
+  SECTION("Adding a particle or invalidating rebuilds") {
+    list.Update(particles, box);
+    list.Invalidate();
+    REQUIRE(list.NeedsRebuild(particles, box));
+    list.Update(particles, box);
+    particles.Add(Particle(vec2(50, 50), vec2(0, 0), 1, 2, "cyan"));
+    REQUIRE(list.NeedsRebuild(particles, box));
+  }
+}
+
+TEST_CASE("Neighbour list collisions match the grid") {
+  double skin = GENERATE(0.0, 1.5, 4.0);
+
+  SECTION("Dense random particles over many frames") {
+    Box box(0, 0, 200, 200);
+    ParticleStore with_grid = MakeRandomParticles(400, 7, kSpeedScale);
+    ParticleStore with_list = with_grid;
+    SpatialGrid grid;
+    NeighborList list(skin);
+
+    for (size_t frame = 0; frame < 100; ++frame) {
+      grid.Rebuild(with_grid, box);
+      PhysicsEngine::AdjustVelocitiesOnCollision(with_grid, grid);
+      PhysicsEngine::MoveParticles(box, with_grid);
+      list.Update(with_list, box);
+      PhysicsEngine::AdjustVelocitiesOnCollision(with_list, list);
+      PhysicsEngine::MoveParticles(box, with_list);
+    }
+
+    for (size_t i = 0; i < with_grid.Size(); ++i) {
+      REQUIRE(with_grid.Get(i).GetPosition() == with_list.Get(i).GetPosition());
+      REQUIRE(with_grid.Get(i).GetVelocity() == with_list.Get(i).GetVelocity());
+    }
+    // Particles move about a unit per frame, so a skin of 4 lasts a while.
+    if (skin == 4) {
+      REQUIRE(list.GetRebuildCount() < 50);
+    }
+  }
+
+  SECTION("Periodic double precision stores") {
+    Box box(0, 0, 200, 200, Boundary::kPeriodic);
+    DoubleParticleStore with_grid =
+        MakeRandomParticles<DoubleParticleStore>(400, 8, kSpeedScale);
+    DoubleParticleStore with_list = with_grid;
+    SpatialGrid grid;
+    NeighborList list(skin);
+
+    for (size_t frame = 0; frame < 100; ++frame) {
+      grid.Rebuild(with_grid, box);
+      PhysicsEngine::AdjustVelocitiesOnCollision(with_grid, grid);
+      PhysicsEngine::MoveParticles(box, with_grid);
+      list.Update(with_list, box);
+      PhysicsEngine::AdjustVelocitiesOnCollision(with_list, list);
+      PhysicsEngine::MoveParticles(box, with_list);
+    }
+
+    for (size_t i = 0; i < with_grid.Size(); ++i) {
+      REQUIRE(with_grid.PositionX()[i] == with_list.PositionX()[i]);
+      REQUIRE(with_grid.PositionY()[i] == with_list.PositionY()[i]);
+      REQUIRE(with_grid.VelocityX()[i] == with_list.VelocityX()[i]);
+      REQUIRE(with_grid.VelocityY()[i] == with_list.VelocityY()[i]);
+    }
+  }
+}
+
+TEST_CASE("Parallel neighbour list collisions do not depend on the thread "
+          "count") {
+  // 200 across makes 4 tiles, which colour all the way round; 245 makes 5,
+  // which are resolved serially.
+  double length = GENERATE(200.0, 245.0);
+  Box box(0, 0, length, length, Boundary::kPeriodic);
+  ParticleStore serial = MakeRandomParticles(2000, 4, kSpeedScale);
+  ParticleStore start = serial;
+  NeighborList list(1.5);
+  ThreadPool no_threads(0);
+  for (size_t frame = 0; frame < 40; ++frame) {
+    list.Update(serial, box, &no_threads);
+    PhysicsEngine::AdjustVelocitiesOnCollision(serial, list, no_threads);
+    PhysicsEngine::MoveParticles(box, serial);
+  }
+
+  size_t thread_count = GENERATE(1, 3);
+  ThreadPool pool(thread_count);
+  ParticleStore parallel = start;
+  list.Invalidate();
+  for (size_t frame = 0; frame < 40; ++frame) {
+    list.Update(parallel, box, &pool);
+    PhysicsEngine::AdjustVelocitiesOnCollision(parallel, list, pool);
+    PhysicsEngine::MoveParticles(box, parallel);
+  }
+
+  for (size_t i = 0; i < serial.Size(); ++i) {
+    REQUIRE(serial.Get(i).GetPosition() == parallel.Get(i).GetPosition());
+    REQUIRE(serial.Get(i).GetVelocity() == parallel.Get(i).GetVelocity());
+  }
+}
+
+TEST_CASE("Containers can use a neighbour list") {
+  GasContainer with_grid(1000, 1000, 200, "white", Box(0, 0, 600, 600), 40,
+                         40, 40);
+  GasContainer with_list(1000, 1000, 200, "white", Box(0, 0, 600, 600), 40,
+                         40, 40);
+  ParticleInitializer::Options options;
+  options.seed = 3;
+  with_grid.InitializeParticles(ParticleInitializer(options), 40, 40, 40);
+  with_list.InitializeParticles(ParticleInitializer(options), 40, 40, 40);
+  with_list.SetNeighborListSkin(3);
+  REQUIRE(with_grid.GetNeighborList() == nullptr);
+  for (int frame = 0; frame < 30; ++frame) {
+    with_grid.AdvanceOneFrame();
+    with_list.AdvanceOneFrame();
+  }
+
+  REQUIRE(with_list.GetNeighborList()->GetRebuildCount() > 0);
+  for (size_t i = 0; i < with_grid.GetParticles().Size(); ++i) {
+    REQUIRE(with_grid.GetParticles().Get(i).GetPosition() ==
+            with_list.GetParticles().Get(i).GetPosition());
+  }
+  REQUIRE_THROWS_AS(with_list.SetNeighborListSkin(-2), std::invalid_argument);
+}
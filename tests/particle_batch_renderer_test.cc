@@ -0,0 +1,184 @@
+#include <catch2/catch.hpp>
+
+#define GL_GLEXT_PROTOTYPES
+#include <EGL/egl.h>
+#include <EGL/eglext.h>
+#include <GL/glcorearb.h>
+
+#include <vector>
+
+#include "particle_batch_renderer.h"
+
+using idealgas::Particle;
+using idealgas::ParticleBatchRenderer;
+using idealgas::ParticleStore;
+using glm::vec2;
+
+namespace {
+
+const int kSize = 64;
+
+/**
+ * A GL context without a window, drawing into a framebuffer of kSize by
+ * kSize pixels.
+ */
+class OffscreenContext {
+ public:
+  OffscreenContext() {
+    auto get_platform_display =
+        reinterpret_cast<PFNEGLGETPLATFORMDISPLAYEXTPROC>(
+            eglGetProcAddress("eglGetPlatformDisplayEXT"));
+    if (get_platform_display == nullptr) {
+      return;
+    }
+    display_ = get_platform_display(EGL_PLATFORM_SURFACELESS_MESA,
+                                    EGL_DEFAULT_DISPLAY, nullptr);
+    if (display_ == EGL_NO_DISPLAY ||
+        !eglInitialize(display_, nullptr, nullptr) ||
+        !eglBindAPI(EGL_OPENGL_API)) {
+      return;
+    }
+
+    const EGLint kAttributes[] = {
+        EGL_CONTEXT_MAJOR_VERSION, 3, EGL_CONTEXT_MINOR_VERSION, 3,
+        EGL_CONTEXT_OPENGL_PROFILE_MASK, EGL_CONTEXT_OPENGL_CORE_PROFILE_BIT,
+        EGL_NONE};
+    context_ = eglCreateContext(display_, EGL_NO_CONFIG_KHR, EGL_NO_CONTEXT,
+                                kAttributes);
+    if (context_ == EGL_NO_CONTEXT ||
+        !eglMakeCurrent(display_, EGL_NO_SURFACE, EGL_NO_SURFACE, context_)) {
+      return;
+    }
+
+    glGenRenderbuffers(1, &color_buffer_);
+    glBindRenderbuffer(GL_RENDERBUFFER, color_buffer_);
+    glRenderbufferStorage(GL_RENDERBUFFER, GL_RGBA8, kSize, kSize);
+    glGenFramebuffers(1, &framebuffer_);
+    glBindFramebuffer(GL_FRAMEBUFFER, framebuffer_);
+    glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0,
+                              GL_RENDERBUFFER, color_buffer_);
+    glViewport(0, 0, kSize, kSize);
+    valid_ = glCheckFramebufferStatus(GL_FRAMEBUFFER) ==
+             GL_FRAMEBUFFER_COMPLETE;
+  }
+
+  ~OffscreenContext() {
+    if (context_ != EGL_NO_CONTEXT) {
+      glDeleteFramebuffers(1, &framebuffer_);
+      glDeleteRenderbuffers(1, &color_buffer_);
+      eglMakeCurrent(display_, EGL_NO_SURFACE, EGL_NO_SURFACE, EGL_NO_CONTEXT);
+      eglDestroyContext(display_, context_);
+    }
+    if (display_ != EGL_NO_DISPLAY) {
+      eglTerminate(display_);
+    }
+  }
+
+  bool IsValid() const {
+    return valid_;
+  }
+
+  void Clear() {
+    glClearColor(0, 0, 0, 1);
+    glClear(GL_COLOR_BUFFER_BIT);
+  }
+
+  /**
+   * @return red, green and blue of a pixel, counted from the bottom left
+   */
+  std::vector<int> ReadPixel(int x, int y) {
+    unsigned char pixel[4] = {};
+    glReadPixels(x, y, 1, 1, GL_RGBA, GL_UNSIGNED_BYTE, pixel);
+    return {pixel[0], pixel[1], pixel[2]};
+  }
+
+ private:
+  EGLDisplay display_ = EGL_NO_DISPLAY;
+  EGLContext context_ = EGL_NO_CONTEXT;
+  GLuint framebuffer_ = 0;
+  GLuint color_buffer_ = 0;
+  bool valid_ = false;
+};
+
+// Maps particle coordinates 0 to kSize onto the framebuffer.
+const float kViewProjection[16] = {2.0f / kSize, 0, 0, 0,
+                                   0, 2.0f / kSize, 0, 0,
+                                   0, 0, -1, 0,
+                                   -1, -1, 0, 1};
+
+const std::vector<int> kBlack = {0, 0, 0};
+const std::vector<int> kRed = {255, 0, 0};
+const std::vector<int> kOrange = {255, 165, 0};
+
+}  // namespace
+
+TEST_CASE("Particle batch renderer") {
+  OffscreenContext context;
+  if (!context.IsValid()) {
+    WARN("No offscreen OpenGL 3.3 context, skipping");
+    return;
+  }
+  ParticleBatchRenderer renderer;
+  ParticleStore particles;
+  particles.Add(Particle(vec2(16, 16), vec2(), 6, 6, "orange"));
+  particles.Add(Particle(vec2(44, 40), vec2(), 12, 8, "red"));
+
+  SECTION("Particles are filled circles in their species colour") {
+    context.Clear();
+    renderer.Draw(particles, kViewProjection);
+    REQUIRE(context.ReadPixel(16, 16) == kOrange);
+    REQUIRE(context.ReadPixel(20, 16) == kOrange);
+    REQUIRE(context.ReadPixel(44, 40) == kRed);
+    REQUIRE(context.ReadPixel(32, 32) == kBlack);
+    // Inside the bounding square but outside the circle.
+    REQUIRE(context.ReadPixel(21, 21) == kBlack);
+  }
+
+  SECTION("Each frame draws the latest positions") {
+    for (int frame = 0; frame < 10; ++frame) {
+      particles.PositionX()[0] = 10.0f + 4 * frame;
+      context.Clear();
+      renderer.Draw(particles, kViewProjection);
+    }
+    REQUIRE(context.ReadPixel(46, 16) == kOrange);
+    REQUIRE(context.ReadPixel(16, 16) == kBlack);
+  }
+
+  SECTION("The buffer grows to fit more particles") {
+    for (int i = 0; i < 5000; ++i) {
+      particles.Add(Particle(vec2(8, 56), vec2(), 12, 8, "red"));
+    }
+    context.Clear();
+    renderer.Draw(particles, kViewProjection);
+    REQUIRE(renderer.GetCapacity() >= particles.Size());
+    REQUIRE(context.ReadPixel(8, 56) == kRed);
+    REQUIRE(context.ReadPixel(16, 16) == kOrange);
+  }
+
+  SECTION("Persistent mapping is used when the context supports it") {
+    renderer.Draw(particles, kViewProjection);
+    GLint major = 0;
+    GLint minor = 0;
+    glGetIntegerv(GL_MAJOR_VERSION, &major);
+    glGetIntegerv(GL_MINOR_VERSION, &minor);
+    if (major > 4 || (major == 4 && minor >= 4)) {
+      REQUIRE(renderer.IsPersistentlyMapped());
+    }
+  }
+
+  SECTION("Bindings are restored after drawing") {
+    GLuint vertex_array = 0;
+    glGenVertexArrays(1, &vertex_array);
+    glBindVertexArray(vertex_array);
+    renderer.Draw(particles, kViewProjection);
+
+    GLint bound_vertex_array = 0;
+    GLint bound_program = -1;
+    glGetIntegerv(GL_VERTEX_ARRAY_BINDING, &bound_vertex_array);
+    glGetIntegerv(GL_CURRENT_PROGRAM, &bound_program);
+    REQUIRE(bound_vertex_array == static_cast<GLint>(vertex_array));
+    REQUIRE(bound_program == 0);
+    glBindVertexArray(0);
+    glDeleteVertexArrays(1, &vertex_array);
+  }
+}
@@ -0,0 +1,211 @@
+#include <catch2/catch.hpp>
+
+#include <stdexcept>
+#include <vector>
+
+#include "gas_container.h"
+#include "particle_initializer.h"
+#include "thread_pool.h"
+
+using idealgas::Boundary;
+using idealgas::Box;
+using idealgas::GasContainer;
+using idealgas::Particle;
+using idealgas::ParticleInitializer;
+using idealgas::ParticleStore;
+using idealgas::ThreadPool;
+using glm::vec2;
+
+namespace {
+
+typedef ParticleInitializer::Placement Placement;
+
+std::vector<ParticleInitializer::SpeciesAmount> Species(size_t large,
+                                                        size_t small) {
+  return {{Particle(vec2(), vec2(1, 2), 16, 4, "red"), large},
+          {Particle(vec2(), vec2(3, 0), 1, 1, "cyan"), small}};
+}
+
+ParticleStore Generate(const ParticleInitializer::Options &options,
+                       const Box &box, size_t large, size_t small,
+                       ThreadPool *pool = nullptr) {
+  ParticleStore particles;
+  ParticleInitializer(options).Generate(box, Species(large, small),
+                                        particles, pool);
+  return particles;
+}
+
+bool Same(const ParticleStore &a, const ParticleStore &b) {
+  if (a.Size() != b.Size()) {
+    return false;
+  }
+  for (size_t i = 0; i < a.Size(); ++i) {
+    if (a.PositionX()[i] != b.PositionX()[i] ||
+        a.PositionY()[i] != b.PositionY()[i] ||
+        a.VelocityX()[i] != b.VelocityX()[i] ||
+        a.VelocityY()[i] != b.VelocityY()[i]) {
+      return false;
+    }
+  }
+  return true;
+}
+
+/**
+ * @return number of pairs of particles that overlap
+ */
+size_t CountOverlaps(const ParticleStore &particles, const Box &box) {
+  size_t overlaps = 0;
+  for (size_t i = 0; i < particles.Size(); ++i) {
+    for (size_t j = i + 1; j < particles.Size(); ++j) {
+      vec2 diff = box.MinimumImage(
+          vec2(particles.PositionX()[i] - particles.PositionX()[j],
+               particles.PositionY()[i] - particles.PositionY()[j]));
+      float touching = particles.Radius()[i] + particles.Radius()[j];
+      if (diff.x * diff.x + diff.y * diff.y < touching * touching) {
+        ++overlaps;
+      }
+    }
+  }
+  return overlaps;
+}
+
+/**
+ * Requires every particle to be inside the walls for its radius.
+ */
+void RequireInside(const ParticleStore &particles, const Box &box) {
+  for (size_t i = 0; i < particles.Size(); ++i) {
+    float radius = particles.Radius()[i];
+    REQUIRE(particles.PositionX()[i] >= box.GetMinX() + radius);
+    REQUIRE(particles.PositionX()[i] <= box.GetMaxX() - radius);
+    REQUIRE(particles.PositionY()[i] >= box.GetMinY() + radius);
+    REQUIRE(particles.PositionY()[i] <= box.GetMaxY() - radius);
+  }
+}
+
+}  // namespace
+
+TEST_CASE("Initialization is reproducible") {
+  Box box(0, 0, 400, 300);
+  ParticleInitializer::Options options;
+  options.seed = 11;
+  options.maxwell_boltzmann = true;
+  options.placement = GENERATE(Placement::kUniform, Placement::kLattice,
+                               Placement::kPoissonDisk);
+  ParticleStore serial = Generate(options, box, 200, 300);
+  REQUIRE(serial.Size() == 500);
+
+  SECTION("The same seed gives the same particles on any number of threads") {
+    ThreadPool pool(3);
+    REQUIRE(Same(serial, Generate(options, box, 200, 300)));
+    REQUIRE(Same(serial, Generate(options, box, 200, 300, &pool)));
+  }
+
+  SECTION("Another seed gives other particles") {
+    options.seed = 12;
+    REQUIRE_FALSE(Same(serial, Generate(options, box, 200, 300)));
+  }
+}
+
+TEST_CASE("Particle placement") {
+  Box box(-100, 50, 300, 350);
+  ParticleInitializer::Options options;
+  options.seed = 3;
+
+  SECTION("Species and velocities come from the prototypes") {
+    ParticleStore particles = Generate(options, box, 2, 3);
+    REQUIRE(particles.SpeciesCount() == 2);
+    REQUIRE(particles.Get(0).GetMass() == 16);
+    REQUIRE(particles.Get(0).GetVelocity() == vec2(1, 2));
+    REQUIRE(particles.Get(4).GetRadius() == 1);
+    REQUIRE(particles.Get(4).GetVelocity() == vec2(3, 0));
+  }
+
+  SECTION("Lattice sites do not overlap and mix the species") {
+    options.placement = Placement::kLattice;
+    ParticleStore particles = Generate(options, box, 500, 500);
+    RequireInside(particles, box);
+    REQUIRE(CountOverlaps(particles, box) == 0);
+
+    float left_large = 0;
+    for (size_t i = 0; i < 500; ++i) {
+      left_large += particles.PositionX()[i] < 100 ? 1 : 0;
+    }
+    REQUIRE(left_large / 500 == Approx(0.5).margin(0.1));
+  }
+
+  SECTION("A lattice that does not fit is rejected") {
+    options.placement = Placement::kLattice;
+    REQUIRE_THROWS_AS(Generate(options, box, 2000, 0), std::invalid_argument);
+  }
+
+  SECTION("Poisson-disk particles do not overlap") {
+    options.placement = Placement::kPoissonDisk;
+    ParticleStore particles = Generate(options, box, 800, 1000);
+    RequireInside(particles, box);
+    REQUIRE(CountOverlaps(particles, box) == 0);
+
+    // Dense enough that many candidates are turned down in parallel.
+    ThreadPool pool(3);
+    REQUIRE(Same(particles, Generate(options, box, 800, 1000, &pool)));
+  }
+
+  SECTION("Poisson-disk particles do not overlap across periodic edges") {
+    options.placement = Placement::kPoissonDisk;
+    Box periodic(0, 0, 200, 200, Boundary::kPeriodic);
+    ParticleStore particles = Generate(options, periodic, 250, 0);
+    REQUIRE(CountOverlaps(particles, periodic) == 0);
+    ThreadPool pool(2);
+    REQUIRE(Same(particles, Generate(options, periodic, 250, 0, &pool)));
+    for (size_t i = 0; i < particles.Size(); ++i) {
+      REQUIRE(particles.PositionX()[i] >= 0);
+      REQUIRE(particles.PositionX()[i] < 200);
+    }
+  }
+
+  SECTION("Poisson disk gives up on a box too full") {
+    options.placement = Placement::kPoissonDisk;
+    REQUIRE_THROWS_AS(Generate(options, box, 3000, 0), std::runtime_error);
+  }
+}
+
+TEST_CASE("Maxwell-Boltzmann velocities") {
+  Box box(0, 0, 1000, 1000);
+  ParticleInitializer::Options options;
+  options.seed = 5;
+  options.placement = Placement::kUniform;
+  options.maxwell_boltzmann = true;
+  options.temperature = 2.5;
+  ParticleStore particles = Generate(options, box, 20000, 20000);
+
+  // Equipartition: every species has a mean kinetic energy of kT / 2 per
+  // component, whatever its mass.
+  double energy[2] = {0, 0};
+  double momentum_x = 0;
+  for (size_t i = 0; i < particles.Size(); ++i) {
+    Particle particle = particles.Get(i);
+    double speed = particle.GetSpeed();
+    energy[particles.SpeciesId()[i]] +=
+        0.5 * particle.GetMass() * speed * speed;
+    momentum_x += particle.GetMass() * particle.GetVelocity().x;
+  }
+  REQUIRE(energy[0] / 20000 == Approx(2.5).epsilon(0.03));
+  REQUIRE(energy[1] / 20000 == Approx(2.5).epsilon(0.03));
+  REQUIRE(momentum_x / 40000 == Approx(0).margin(0.05));
+}
+
+TEST_CASE("Containers can be initialized from a seed") {
+  GasContainer container(800, 1280, 80, "white", 10, 10, 10);
+  ParticleInitializer::Options options;
+  options.seed = 9;
+  container.InitializeParticles(ParticleInitializer(options), 20, 30, 40);
+
+  const ParticleStore &particles = container.GetParticles();
+  REQUIRE(particles.Size() == 90);
+  REQUIRE(CountOverlaps(particles, container.GetBox()) == 0);
+  RequireInside(particles, container.GetBox());
+  REQUIRE(particles.Get(0).GetColor() == idealgas::Color("green"));
+  REQUIRE(particles.Get(89).GetColor() == idealgas::Color("orange"));
+  for (int frame = 0; frame < 20; ++frame) {
+    container.AdvanceOneFrame();
+  }
+}
@@ -0,0 +1,143 @@
+#include <catch2/catch.hpp>
+
+#include <stdexcept>
+#include <vector>
+
+#include "particle_store.h"
+#include "physics_engine.h"
+
+using idealgas::DoubleParticleStore;
+using idealgas::Particle;
+using idealgas::ParticleStore;
+using idealgas::PhysicsEngine;
+using glm::vec2;
+
+TEST_CASE("Particle store round trip") {
+  ParticleStore store;
+  store.Add(Particle(vec2(10, 20), vec2(1, -2), 6, 3, "orange"));
+  store.Add(Particle(vec2(30, 40), vec2(-3, 4), 12, 5, "red"));
+  store.Add(Particle(vec2(50, 60), vec2(5, 6), 6, 3, "orange"));
+
+  SECTION("Particles keep their state") {
+    Particle particle = store.Get(1);
+    REQUIRE(store.Size() == 3);
+    REQUIRE(particle.GetPosition() == vec2(30, 40));
+    REQUIRE(particle.GetVelocity() == vec2(-3, 4));
+    REQUIRE(particle.GetMass() == 12);
+    REQUIRE(particle.GetRadius() == 5);
+    REQUIRE(particle.GetColor() == idealgas::Color("red"));
+  }
+
+  SECTION("Particles of the same kind share a species") {
+    REQUIRE(store.SpeciesCount() == 2);
+    REQUIRE(store.SpeciesId()[0] == store.SpeciesId()[2]);
+    REQUIRE(store.SpeciesId()[0] != store.SpeciesId()[1]);
+  }
+
+  SECTION("Dense arrays hold positions, velocities and inverse masses") {
+    REQUIRE(store.PositionX()[2] == 50);
+    REQUIRE(store.VelocityY()[1] == 4);
+    REQUIRE(store.InverseMass()[1] == Approx(1.0 / 12));
+    REQUIRE(store.Radius()[0] == 3);
+  }
+
+  SECTION("Set writes position and velocity back") {
+    Particle particle = store.Get(0);
+    particle.SetPosition(vec2(11, 21));
+    particle.SetVelocity(vec2(0, 0));
+    store.Set(0, particle);
+    REQUIRE(store.PositionX()[0] == 11);
+    REQUIRE(store.PositionY()[0] == 21);
+    REQUIRE(store.VelocityX()[0] == 0);
+  }
+
+  SECTION("Reset makes particles of each species at rest") {
+    std::vector<ParticleStore::Species> species = {{"cyan", 2, 4},
+                                                   {"red", 8, 1}};
+    store.Reset(species, {1, 2});
+    REQUIRE(store.Size() == 3);
+    REQUIRE(store.SpeciesCount() == 2);
+    REQUIRE(store.SpeciesId()[2] == 1);
+    REQUIRE(store.InverseMass()[1] == Approx(1.0 / 8));
+    REQUIRE(store.Radius()[0] == 4);
+    REQUIRE(store.Get(2).GetColor() == idealgas::Color("red"));
+    REQUIRE(store.PositionX()[0] == 0);
+    REQUIRE(store.VelocityY()[2] == 0);
+    REQUIRE_THROWS_AS(store.Reset(species, {1}), std::invalid_argument);
+  }
+}
+
+TEST_CASE("Stored collisions use both velocities from before the collision") {
+  Particle heavy_particle(vec2(100, 100), vec2(1, 0), 5, 5, "cyan");
+  Particle light_particle(vec2(102, 100), vec2(-1, 0), 1, 1, "cyan");
+  ParticleStore store;
+  store.Add(heavy_particle);
+  store.Add(light_particle);
+
+  PhysicsEngine::ResolveCollision(store, 0, 1);
+
+  REQUIRE(store.VelocityX()[0] == Approx(0.33333f));
+  REQUIRE(store.VelocityY()[0] == 0.0f);
+  REQUIRE(store.VelocityX()[1] == Approx(2.33333f));
+  REQUIRE(store.VelocityY()[1] == 0.0f);
+}
+
+TEST_CASE("Stored wall bounces match particle wall bounces") {
+  Particle particle(vec2(199, 100), vec2(1, 0), 1, 1, "cyan");
+  ParticleStore store;
+  store.Add(particle);
+
+  PhysicsEngine::ParticleWallCollision(200, 0, particle);
+  particle.SetPosition(particle.GetPosition() + particle.GetVelocity());
+  PhysicsEngine::MoveParticles(idealgas::Box(0, 0, 200, 200), store);
+
+  REQUIRE(store.Get(0).GetPosition() == particle.GetPosition());
+  REQUIRE(store.Get(0).GetVelocity() == particle.GetVelocity());
+}
+
+TEST_CASE("Adding particles by species id") {
+  ParticleStore store;
+  uint8_t cyan = store.AddSpecies({"cyan", 2, 4});
+  uint8_t red = store.AddSpecies({"red", 8, 1});
+  store.Add(red, 1, 2, 3, 4);
+  store.Add(cyan, 5, 6, 7, 8);
+
+  SECTION("Species get consecutive ids") {
+    REQUIRE(cyan == 0);
+    REQUIRE(red == 1);
+    REQUIRE(store.AddSpecies({"cyan", 2, 4}) == cyan);
+    REQUIRE(store.SpeciesCount() == 2);
+  }
+
+  SECTION("Particles take the mass and radius of their species") {
+    REQUIRE(store.Size() == 2);
+    REQUIRE(store.SpeciesId()[0] == red);
+    REQUIRE(store.InverseMass()[0] == Approx(1.0 / 8));
+    REQUIRE(store.Radius()[1] == 4);
+    REQUIRE(store.Get(1).GetPosition() == vec2(5, 6));
+    REQUIRE(store.Get(1).GetVelocity() == vec2(7, 8));
+  }
+
+  SECTION("Unknown species are rejected") {
+    REQUIRE_THROWS_AS(store.Add(2, 0, 0, 0, 0), std::invalid_argument);
+  }
+}
+
+TEST_CASE("Double precision particle store") {
+  DoubleParticleStore store;
+  store.Add(Particle(vec2(10, 20), vec2(1, -2), 3, 3, "orange"));
+  store.Add(Particle(vec2(16, 20), vec2(-1, 0), 3, 3, "orange"));
+
+  SECTION("Inverse masses are exact in double") {
+    REQUIRE(store.InverseMass()[0] == 1.0 / 3);
+  }
+
+  SECTION("Collisions are resolved in double") {
+    PhysicsEngine::ResolveCollision(store, 0, 1);
+    REQUIRE(store.VelocityX()[0] == -1);
+    REQUIRE(store.VelocityY()[0] == -2);
+    REQUIRE(store.VelocityX()[1] == 1);
+    REQUIRE(store.VelocityY()[1] == 0);
+    REQUIRE(store.Get(0).GetVelocity() == vec2(-1, -2));
+  }
+}
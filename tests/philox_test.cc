@@ -0,0 +1,88 @@
+#include <catch2/catch.hpp>
+
+#include "philox.h"
+
+using idealgas::Philox;
+using idealgas::PhiloxStream;
+
+namespace {
+
+bool Equal(const Philox::Block &a, const Philox::Block &b) {
+  for (int i = 0; i < 4; ++i) {
+    if (a.word[i] != b.word[i]) {
+      return false;
+    }
+  }
+  return true;
+}
+
+}  // namespace
+
+TEST_CASE("Philox matches the published known answers") {
+  SECTION("Zero counter and key") {
+    Philox::Block result = Philox::Generate({{0, 0, 0, 0}}, 0, 0);
+    REQUIRE(Equal(result, {{0x6627e8d5, 0xe169c58d, 0xbc57ac4c, 0x9b00dbd8}}));
+  }
+
+  SECTION("All bits set") {
+    Philox::Block result = Philox::Generate(
+        {{0xffffffff, 0xffffffff, 0xffffffff, 0xffffffff}}, 0xffffffff,
+        0xffffffff);
+    REQUIRE(Equal(result, {{0x408f276d, 0x41c83b0e, 0xa20bc7c6, 0x6d5451fd}}));
+  }
+
+  SECTION("Digits of pi") {
+    Philox::Block result = Philox::Generate(
+        {{0x243f6a88, 0x85a308d3, 0x13198a2e, 0x03707344}}, 0xa4093822,
+        0x299f31d0);
+    REQUIRE(Equal(result, {{0xd16cfe09, 0x94fdcceb, 0x5001e420, 0x24126ea1}}));
+  }
+}
+
+TEST_CASE("Philox streams") {
+  SECTION("The same stream gives the same numbers") {
+    PhiloxStream first(7, 1000, 0);
+    PhiloxStream second(7, 1000, 0);
+    for (int i = 0; i < 10; ++i) {
+      REQUIRE(first.Next() == second.Next());
+    }
+  }
+
+  SECTION("Items, purposes and seeds give different numbers") {
+    uint32_t base = PhiloxStream(7, 1000, 0).Next();
+    REQUIRE(PhiloxStream(7, 1001, 0).Next() != base);
+    REQUIRE(PhiloxStream(7, 1000, 1).Next() != base);
+    REQUIRE(PhiloxStream(8, 1000, 0).Next() != base);
+    REQUIRE(PhiloxStream(7, 1000 + (uint64_t(1) << 32), 0).Next() != base);
+  }
+
+  SECTION("Uniform numbers lie in [0, 1) with the right mean") {
+    PhiloxStream stream(1, 0, 0);
+    double sum = 0;
+    for (int i = 0; i < 100000; ++i) {
+      float value = stream.NextUniform();
+      REQUIRE(value >= 0);
+      REQUIRE(value < 1);
+      sum += value;
+    }
+    REQUIRE(sum / 100000 == Approx(0.5).margin(0.01));
+  }
+
+  SECTION("Normal pairs have mean 0, variance 1 and no correlation") {
+    PhiloxStream stream(2, 0, 0);
+    double sum = 0;
+    double sum_of_squares = 0;
+    double sum_of_products = 0;
+    for (int i = 0; i < 50000; ++i) {
+      double first;
+      double second;
+      stream.NextNormalPair(first, second);
+      sum += first + second;
+      sum_of_squares += first * first + second * second;
+      sum_of_products += first * second;
+    }
+    REQUIRE(sum / 100000 == Approx(0).margin(0.02));
+    REQUIRE(sum_of_squares / 100000 == Approx(1).margin(0.02));
+    REQUIRE(sum_of_products / 50000 == Approx(0).margin(0.02));
+  }
+}
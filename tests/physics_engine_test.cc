@@ -1,4 +1,5 @@
 #include <catch2/catch.hpp>
+#include <iostream>
 
 #include "physics_engine.h"
 
@@ -261,7 +262,7 @@ TEST_CASE("Container wall boundaries") {
 
   SECTION("Particle does not collide with left wall") {
     Particle particle(vec2(1.1,100), vec2(0, 0), 1, 1, "cyan");
-    std::cout << particle.GetPosition() << std::endl;
+    std::cout << particle.GetPosition().x << ", " << particle.GetPosition().y << std::endl;
     size_t lower_bound = kMargin + particle.GetRadius();
     size_t upper_bound = kWindowSize - kMargin - particle.GetRadius();
     double x_pos = particle.GetPosition().x;
@@ -0,0 +1,33 @@
+#pragma once
+
+#include <cstdlib>
+
+#include "gas_particle.h"
+#include "particle_store.h"
+
+namespace idealgas {
+
+/**
+ * Makes particles of radius and mass 1 to 6 at random places in the square
+ * from 20 to 180, for tests of the collision broad phase.
+ * @param amount number of particles
+ * @param seed seed for rand()
+ * @param speed_scale factor on velocity components of -3 to 3
+ * @return the particles
+ */
+template <typename Store = ParticleStore>
+Store MakeRandomParticles(size_t amount, unsigned int seed,
+                          float speed_scale = 1) {
+  srand(seed);
+  Store particles;
+  for (size_t i = 0; i < amount; ++i) {
+    int radius = 1 + rand() % 6;
+    glm::vec2 position(20 + rand() % 160, 20 + rand() % 160);
+    glm::vec2 velocity(((rand() % 7) - 3) * speed_scale,
+                       ((rand() % 7) - 3) * speed_scale);
+    particles.Add(Particle(position, velocity, radius, radius, "cyan"));
+  }
+  return particles;
+}
+
+}  // namespace idealgas
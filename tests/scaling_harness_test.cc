@@ -0,0 +1,163 @@
+#include <catch2/catch.hpp>
+
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include "scaling_harness.h"
+
+using idealgas::ScalingHarness;
+using idealgas::ScalingOptions;
+using idealgas::ScalingResult;
+using idealgas::ScalingTolerance;
+
+namespace {
+
+ScalingResult Result(size_t particles, size_t threads, double throughput,
+                     uint64_t peak_rss, double drift) {
+  ScalingResult result;
+  result.particles = particles;
+  result.threads = threads;
+  result.steps = 10;
+  result.succeeded = true;
+  result.elapsed_ms = 5;
+  result.particle_steps_per_second = throughput;
+  result.peak_rss_bytes = peak_rss;
+  result.energy_drift = drift;
+  return result;
+}
+
+}  // namespace
+
+TEST_CASE("Scaling runs advance every particle asked for") {
+  ScalingOptions options;
+  options.particle_counts = {500, 5000};
+  options.thread_counts = {0, 2};
+  options.steps = 10;
+  std::vector<ScalingResult> results = ScalingHarness(options).Run();
+
+  REQUIRE(results.size() == 4);
+  for (size_t i = 0; i < results.size(); ++i) {
+    REQUIRE(results[i].succeeded);
+    REQUIRE(results[i].particles == options.particle_counts[i / 2]);
+    REQUIRE(results[i].threads == options.thread_counts[i % 2]);
+    REQUIRE(results[i].steps == 10);
+    REQUIRE(results[i].particle_steps_per_second > 0);
+    REQUIRE(results[i].energy_drift < 1e-3);
+  }
+#if defined(__linux__) || defined(__APPLE__)
+  REQUIRE(results[0].peak_rss_bytes > 0);
+#endif
+}
+
+TEST_CASE("Scaling boxes keep the same density") {
+  ScalingOptions options;
+  options.radius = 2;
+  options.area_fraction = 0.25;
+  ScalingHarness harness(options);
+
+  double length = harness.GetBoxLength(1000000);
+  REQUIRE(length * length * 0.25 ==
+          Approx(3.14159265358979 * 4 * 1000000));
+  REQUIRE(harness.GetBoxLength(4000000) == Approx(2 * length));
+
+  SECTION("Impossible densities are rejected") {
+    options.area_fraction = 1.5;
+    REQUIRE_THROWS_AS(ScalingHarness(options), std::invalid_argument);
+  }
+}
+
+TEST_CASE("Scaling runs report particles that do not fit") {
+  ScalingOptions options;
+  options.area_fraction = 0.9;
+  ScalingResult result = ScalingHarness(options).Run(1000, 0);
+
+  REQUIRE_FALSE(result.succeeded);
+  REQUIRE_FALSE(result.error.empty());
+}
+
+TEST_CASE("Scaling results round trip through a table") {
+  std::vector<ScalingResult> results = {Result(1000, 0, 2.5e6, 1 << 20, 0),
+                                        Result(1000, 4, 7.5e6, 3 << 20,
+                                               1.5e-7)};
+  results.push_back(ScalingResult());
+  results.back().particles = 10;
+  results.back().error = "Particles do not fit";
+
+  std::stringstream table;
+  ScalingHarness::WriteResults(table, results);
+  std::vector<ScalingResult> read = ScalingHarness::ReadResults(table, "t");
+
+  REQUIRE(read.size() == 3);
+  REQUIRE(read[1].particles == 1000);
+  REQUIRE(read[1].threads == 4);
+  REQUIRE(read[1].succeeded);
+  REQUIRE(read[1].particle_steps_per_second == Approx(7.5e6));
+  REQUIRE(read[1].peak_rss_bytes == 3 << 20);
+  REQUIRE(read[1].energy_drift == Approx(1.5e-7));
+  REQUIRE_FALSE(read[2].succeeded);
+  REQUIRE(read[2].error == "Particles do not fit");
+
+  SECTION("Malformed rows are rejected with their line") {
+    std::istringstream malformed("1000\t0\t10\tok\tfast\t1\t1\t0\t\n");
+    REQUIRE_THROWS_WITH(ScalingHarness::ReadResults(malformed, "baseline"),
+                        Catch::Contains("baseline:1"));
+  }
+}
+
+TEST_CASE("Scaling regressions are found against a baseline") {
+  std::vector<ScalingResult> baseline = {Result(1000, 0, 1e6, 100, 1e-6),
+                                         Result(1000, 4, 3e6, 200, 1e-6)};
+  ScalingTolerance tolerance;
+
+  SECTION("Results within the tolerance pass") {
+    std::vector<ScalingResult> results = {Result(1000, 0, 0.8e6, 120, 2e-6),
+                                          Result(1000, 4, 4e6, 150, 0)};
+    REQUIRE(ScalingHarness::FindRegressions(results, baseline, tolerance)
+                .empty());
+  }
+
+  SECTION("Runs and baseline rows without a match are reported") {
+    std::vector<ScalingResult> results = {Result(1000, 0, 1e6, 100, 1e-6),
+                                          Result(5000, 2, 1e6, 100, 1e-6)};
+    std::vector<std::string> regressions =
+        ScalingHarness::FindRegressions(results, baseline, tolerance);
+    REQUIRE(regressions.size() == 2);
+    REQUIRE_THAT(regressions[0], Catch::Contains("particles=5000 threads=2") &&
+                                     Catch::Contains("not in the baseline"));
+    REQUIRE_THAT(regressions[1], Catch::Contains("particles=1000 threads=4") &&
+                                     Catch::Contains("not run"));
+  }
+
+  SECTION("Slower, larger and drifting runs are regressions") {
+    std::vector<ScalingResult> results = {Result(1000, 0, 0.7e6, 100, 1e-6),
+                                          Result(1000, 4, 3e6, 300, 1e-3)};
+    std::vector<std::string> regressions =
+        ScalingHarness::FindRegressions(results, baseline, tolerance);
+    REQUIRE(regressions.size() == 3);
+    REQUIRE_THAT(regressions[0], Catch::Contains("threads=0") &&
+                                     Catch::Contains("throughput"));
+    REQUIRE_THAT(regressions[1], Catch::Contains("peak memory"));
+    REQUIRE_THAT(regressions[2], Catch::Contains("energy drift"));
+  }
+
+  SECTION("A failed run is a regression") {
+    std::vector<ScalingResult> results = {ScalingResult(),
+                                          Result(1000, 4, 3e6, 200, 1e-6)};
+    results[0].particles = 1000;
+    results[0].error = "out of memory";
+    std::vector<std::string> regressions =
+        ScalingHarness::FindRegressions(results, baseline, tolerance);
+    REQUIRE(regressions.size() == 1);
+    REQUIRE_THAT(regressions[0], Catch::Contains("out of memory"));
+  }
+
+  SECTION("Unmeasured memory is not compared") {
+    std::vector<ScalingResult> results = {Result(1000, 0, 1e6, 1000, 1e-6),
+                                          Result(1000, 4, 3e6, 200, 1e-6)};
+    baseline[0].peak_rss_bytes = 0;
+    REQUIRE(ScalingHarness::FindRegressions(results, baseline, tolerance)
+                .empty());
+  }
+}
@@ -0,0 +1,164 @@
+#include <catch2/catch.hpp>
+
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include "scenario.h"
+
+using idealgas::Boundary;
+using idealgas::Box;
+using idealgas::Color;
+using idealgas::EngineMode;
+using idealgas::IntegratorKind;
+using idealgas::ParticleInitializer;
+using idealgas::Scenario;
+using idealgas::ScenarioFile;
+using glm::vec2;
+
+namespace {
+
+std::vector<Scenario> Parse(const std::string &text) {
+  std::istringstream input(text);
+  return ScenarioFile::Parse(input, "test");
+}
+
+const char *kSpecies = "[species]\ncount = 10\n";
+
+}  // namespace
+
+TEST_CASE("Parsing a scenario") {
+  std::vector<Scenario> scenarios = Parse(
+      "# A dilute gas\n"
+      "name = dilute\n"
+      "box = 0 0 2000 1000\n"
+      "boundary = periodic\n"
+      "engine = event-driven\n"
+      "integrator = leapfrog\n"
+      "dt = 0.5\n"
+      "skin = 1.5\n"
+      "steps = 300\n"
+      "seed = 7\n"
+      "init = lattice\n"
+      "temperature = 2.5\n"
+      "checkpoint = out/{name}.ckpt   # after the last frame\n"
+      "\n"
+      "[species]\n"
+      "color = red\n"
+      "mass = 10\n"
+      "radius = 12\n"
+      "velocity = 1 -2\n"
+      "count = 200\n"
+      "[species]\n"
+      "count = 5\n");
+
+  REQUIRE(scenarios.size() == 1);
+  const Scenario &scenario = scenarios[0];
+  REQUIRE(scenario.name == "dilute");
+  REQUIRE(scenario.box == Box(0, 0, 2000, 1000, Boundary::kPeriodic));
+  REQUIRE(scenario.engine == EngineMode::kEventDriven);
+  REQUIRE(scenario.integrator == IntegratorKind::kLeapfrog);
+  REQUIRE(scenario.time_step == 0.5f);
+  REQUIRE(scenario.skin == 1.5);
+  REQUIRE(scenario.steps == 300);
+  REQUIRE(scenario.initializer.seed == 7);
+  REQUIRE(scenario.initializer.placement ==
+          ParticleInitializer::Placement::kLattice);
+  REQUIRE(scenario.initializer.maxwell_boltzmann);
+  REQUIRE(scenario.initializer.temperature == 2.5);
+  REQUIRE(scenario.checkpoint_path == "out/dilute.ckpt");
+  REQUIRE(scenario.trajectory_path.empty());
+
+  REQUIRE(scenario.species.size() == 2);
+  REQUIRE(scenario.species[0].amount == 200);
+  REQUIRE(scenario.species[0].prototype.GetColor() == Color("red"));
+  REQUIRE(scenario.species[0].prototype.GetMass() == 10);
+  REQUIRE(scenario.species[0].prototype.GetRadius() == 12);
+  REQUIRE(scenario.species[0].prototype.GetVelocity() == vec2(1, -2));
+  REQUIRE(scenario.species[1].amount == 5);
+
+  SECTION("Unset keys keep the container's defaults") {
+    Scenario defaults = Parse(kSpecies)[0];
+    REQUIRE(defaults.box == Box::FromWindow(800, 80));
+    REQUIRE(defaults.engine == EngineMode::kTimeStepped);
+    REQUIRE(defaults.time_step == 1);
+    REQUIRE_FALSE(defaults.initializer.maxwell_boltzmann);
+  }
+
+  SECTION("The window sets the default box") {
+    Scenario windowed = Parse(std::string("window = 500 900 50\n") +
+                              kSpecies)[0];
+    REQUIRE(windowed.window_width == 900);
+    REQUIRE(windowed.box == Box::FromWindow(500, 50));
+  }
+}
+
+TEST_CASE("Sweeping scenario keys") {
+  std::vector<Scenario> scenarios = Parse(
+      "name = scan\n"
+      "trajectory = {name}.traj\n"
+      "sweep seed = 1, 2, 3\n"
+      "sweep species.1.count = 10, 20\n"
+      "[species]\n"
+      "count = 4\n"
+      "[species]\n"
+      "count = 0\n");
+
+  REQUIRE(scenarios.size() == 6);
+  // The last sweep changes fastest.
+  REQUIRE(scenarios[0].name == "scan_seed=1_species.1.count=10");
+  REQUIRE(scenarios[1].name == "scan_seed=1_species.1.count=20");
+  REQUIRE(scenarios[5].name == "scan_seed=3_species.1.count=20");
+  REQUIRE(scenarios[5].trajectory_path == scenarios[5].name + ".traj");
+  REQUIRE(scenarios[2].initializer.seed == 2);
+  REQUIRE(scenarios[2].species[1].amount == 10);
+  REQUIRE(scenarios[3].species[1].amount == 20);
+  REQUIRE(scenarios[3].species[0].amount == 4);
+}
+
+TEST_CASE("Invalid scenarios") {
+  SECTION("Errors name the line") {
+    REQUIRE_THROWS_WITH(Parse("steps = 10\nsteps = 20\n"),
+                        "test:2: Key set twice: steps");
+    REQUIRE_THROWS_WITH(Parse(std::string("speed = 1\n") + kSpecies),
+                        "test:1: Unknown key: speed");
+  }
+
+  SECTION("Values are checked") {
+    REQUIRE_THROWS_AS(Parse(std::string("dt = -1\n") + kSpecies),
+                      std::invalid_argument);
+    REQUIRE_THROWS_AS(Parse(std::string("skin = -1\n") + kSpecies),
+                      std::invalid_argument);
+    REQUIRE_THROWS_AS(Parse(std::string("steps = 1.5\n") + kSpecies),
+                      std::invalid_argument);
+    REQUIRE_THROWS_AS(Parse(std::string("box = 0 0 10\n") + kSpecies),
+                      std::invalid_argument);
+    REQUIRE_THROWS_AS(Parse(std::string("box = 0 0 -10 10\n") + kSpecies),
+                      std::invalid_argument);
+    REQUIRE_THROWS_AS(Parse("[species]\ncolor = nope\ncount = 1\n"),
+                      std::invalid_argument);
+    REQUIRE_THROWS_AS(Parse("[species]\nmass = 0\ncount = 1\n"),
+                      std::invalid_argument);
+  }
+
+  SECTION("A scenario needs species with counts") {
+    REQUIRE_THROWS_AS(Parse("steps = 10\n"), std::invalid_argument);
+    REQUIRE_THROWS_AS(Parse("[species]\nmass = 2\n"), std::invalid_argument);
+  }
+
+  SECTION("Sweeps must name existing keys") {
+    REQUIRE_THROWS_AS(Parse(std::string("sweep species.3.count = 1\n") +
+                            kSpecies),
+                      std::invalid_argument);
+    REQUIRE_THROWS_AS(Parse(std::string("sweep speed = 1, 2\n") + kSpecies),
+                      std::invalid_argument);
+    REQUIRE_THROWS_AS(Parse(std::string("sweep seed = 1,,2\n") + kSpecies),
+                      std::invalid_argument);
+  }
+
+  SECTION("Missing files") {
+    REQUIRE_THROWS_AS(ScenarioFile::Load("/nonexistent/file.scenario"),
+                      std::runtime_error);
+  }
+}
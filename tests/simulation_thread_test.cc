@@ -0,0 +1,92 @@
+#include <catch2/catch.hpp>
+
+#include <chrono>
+#include <thread>
+
+#include "simulation_thread.h"
+
+using idealgas::GasContainer;
+using idealgas::SimulationSnapshot;
+using idealgas::SimulationThread;
+
+namespace {
+
+/**
+ * Waits until the thread has advanced at least the given number of frames.
+ */
+void WaitForSteps(const SimulationThread &simulation, size_t steps) {
+  while (simulation.GetStepCount() < steps) {
+    std::this_thread::sleep_for(std::chrono::milliseconds(1));
+  }
+}
+
+}  // namespace
+
+TEST_CASE("Simulation thread") {
+  GasContainer container(1000, 1000, 200, "white", 20, 20, 20);
+  SimulationThread::Options options;
+  options.snapshot_rate = 200;
+
+  SECTION("The first snapshot is published on start") {
+    SimulationThread simulation(container, options);
+    simulation.Start();
+    const SimulationSnapshot &snapshot = simulation.AcquireSnapshot();
+    REQUIRE(snapshot.particles.Size() == 60);
+    REQUIRE(snapshot.species_speeds.size() == 3);
+    REQUIRE(snapshot.species_speeds[0].size() == container.GetNumBins());
+    simulation.Stop();
+  }
+
+  SECTION("Snapshots follow the container") {
+    options.substeps = 3;
+    SimulationThread simulation(container, options);
+    simulation.Start();
+    WaitForSteps(simulation, 9);
+    simulation.Stop();
+
+    REQUIRE(simulation.GetStepCount() % 3 == 0);
+    REQUIRE(container.GetFrameCount() ==
+            static_cast<int>(simulation.GetStepCount()));
+    const SimulationSnapshot &snapshot = simulation.AcquireSnapshot();
+    REQUIRE(snapshot.frame == container.GetFrameCount());
+    REQUIRE(snapshot.particles.PositionX()[0] ==
+            container.GetParticles().PositionX()[0]);
+  }
+
+  SECTION("Posted commands run on the container") {
+    SimulationThread simulation(container, options);
+    simulation.Start();
+    bool ran = false;
+    simulation.Post([&ran](GasContainer &) {
+      ran = true;
+    });
+    simulation.Stop();
+    REQUIRE(ran);
+  }
+
+  SECTION("Commands run right away while stopped") {
+    SimulationThread simulation(container, options);
+    int frame = -1;
+    simulation.Post([&frame](GasContainer &posted) {
+      frame = posted.GetFrameCount();
+    });
+    REQUIRE(frame == 0);
+  }
+
+  SECTION("As fast as possible outruns a fixed rate") {
+    options.snapshot_rate = 20;
+    SimulationThread simulation(container, options);
+    simulation.Start();
+    std::this_thread::sleep_for(std::chrono::milliseconds(200));
+    size_t fixed_steps = simulation.GetStepCount();
+
+    simulation.SetAsFastAsPossible(true);
+    REQUIRE(simulation.IsAsFastAsPossible());
+    WaitForSteps(simulation, fixed_steps + 50);
+    simulation.Stop();
+
+    // About 5 snapshots at 20 per second, with room for a slow machine.
+    REQUIRE(fixed_steps <= 10);
+    REQUIRE(simulation.GetStepCount() >= fixed_steps + 50);
+  }
+}
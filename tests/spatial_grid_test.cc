@@ -0,0 +1,198 @@
+#include <catch2/catch.hpp>
+
+#include <algorithm>
+#include <vector>
+
+#include "physics_engine.h"
+#include "random_particles.h"
+#include "spatial_grid.h"
+#include "thread_pool.h"
+
+using idealgas::Boundary;
+using idealgas::Box;
+using idealgas::DoubleParticleStore;
+using idealgas::MakeRandomParticles;
+using idealgas::PhysicsEngine;
+using idealgas::Particle;
+using idealgas::ParticleStore;
+using idealgas::SpatialGrid;
+using idealgas::ThreadPool;
+using glm::vec2;
+
+namespace {
+
+template <typename Store>
+void Step(Store &particles) {
+  PhysicsEngine::MoveParticles(idealgas::Box(0, 0, 200, 200), particles);
+}
+
+}  // namespace
+
+TEST_CASE("Grid neighbors") {
+  ParticleStore particles;
+  particles.Add(Particle(vec2(10, 10), vec2(0, 0), 1, 2, "cyan"));
+  particles.Add(Particle(vec2(13, 10), vec2(0, 0), 1, 2, "cyan"));
+  particles.Add(Particle(vec2(100, 100), vec2(0, 0), 1, 2, "cyan"));
+  particles.Add(Particle(vec2(10, 14), vec2(0, 0), 1, 2, "cyan"));
+
+  SpatialGrid grid;
+  grid.Rebuild(particles);
+  std::vector<size_t> neighbors;
+
+  SECTION("Cell size comes from the largest radius") {
+    REQUIRE(grid.GetCellSize() >= 4.0f);
+  }
+
+  SECTION("Close particles with larger indices are neighbors") {
+    grid.FindNeighbors(0, neighbors);
+    REQUIRE(neighbors == std::vector<size_t>{1, 3});
+  }
+
+  SECTION("Smaller indices are not reported") {
+    grid.FindNeighbors(3, neighbors);
+    REQUIRE(neighbors.empty());
+  }
+
+  SECTION("Far particles are not neighbors") {
+    grid.FindNeighbors(2, neighbors);
+    REQUIRE(neighbors.empty());
+  }
+}
+
+TEST_CASE("Periodic grid neighbors") {
+  Box box(0, 0, 100, 100, Boundary::kPeriodic);
+  ParticleStore particles;
+  particles.Add(Particle(vec2(1, 50), vec2(-1, 0), 1, 2, "cyan"));
+  particles.Add(Particle(vec2(98, 50), vec2(1, 0), 1, 2, "cyan"));
+  particles.Add(Particle(vec2(50, 50), vec2(0, 0), 1, 2, "cyan"));
+  particles.Add(Particle(vec2(1, 99), vec2(0, 0), 1, 2, "cyan"));
+
+  SpatialGrid grid;
+  grid.Rebuild(particles, box);
+  std::vector<size_t> neighbors;
+
+  SECTION("The grid covers the box exactly") {
+    REQUIRE(grid.GetPeriodicBox() != nullptr);
+    REQUIRE(grid.GetColumns() * grid.GetCellSize() == Approx(100));
+  }
+
+  SECTION("Particles on opposite edges are neighbors") {
+    grid.FindNeighbors(0, neighbors);
+    REQUIRE(std::find(neighbors.begin(), neighbors.end(), 1) !=
+            neighbors.end());
+    REQUIRE(std::find(neighbors.begin(), neighbors.end(), 2) ==
+            neighbors.end());
+  }
+
+  SECTION("Colliding across an edge uses the nearest image") {
+    PhysicsEngine::AdjustVelocitiesOnCollision(particles, grid);
+    REQUIRE(particles.Get(0).GetVelocity() == vec2(1, 0));
+    REQUIRE(particles.Get(1).GetVelocity() == vec2(-1, 0));
+  }
+
+  SECTION("A reflecting box gives the unbounded grid") {
+    grid.Rebuild(particles, Box(0, 0, 100, 100));
+    REQUIRE(grid.GetPeriodicBox() == nullptr);
+    grid.FindNeighbors(0, neighbors);
+    REQUIRE(neighbors.empty());
+  }
+}
+
+TEST_CASE("Grid collisions match brute force") {
+  SECTION("Dense random particles over many frames") {
+    ParticleStore brute_force = MakeRandomParticles(400, 7);
+    ParticleStore with_grid = brute_force;
+    SpatialGrid grid;
+
+    for (size_t frame = 0; frame < 50; ++frame) {
+      PhysicsEngine::AdjustVelocitiesOnCollision(brute_force);
+      grid.Rebuild(with_grid);
+      PhysicsEngine::AdjustVelocitiesOnCollision(with_grid, grid);
+      Step(brute_force);
+      Step(with_grid);
+    }
+
+    for (size_t i = 0; i < brute_force.Size(); ++i) {
+      REQUIRE(brute_force.Get(i).GetPosition() == with_grid.Get(i).GetPosition());
+      REQUIRE(brute_force.Get(i).GetVelocity() == with_grid.Get(i).GetVelocity());
+    }
+  }
+
+  SECTION("Double precision stores") {
+    DoubleParticleStore brute_force =
+        MakeRandomParticles<DoubleParticleStore>(400, 7);
+    DoubleParticleStore with_grid = brute_force;
+    SpatialGrid grid;
+
+    for (size_t frame = 0; frame < 50; ++frame) {
+      PhysicsEngine::AdjustVelocitiesOnCollision(brute_force);
+      grid.Rebuild(with_grid);
+      PhysicsEngine::AdjustVelocitiesOnCollision(with_grid, grid);
+      Step(brute_force);
+      Step(with_grid);
+    }
+
+    for (size_t i = 0; i < brute_force.Size(); ++i) {
+      REQUIRE(brute_force.PositionX()[i] == with_grid.PositionX()[i]);
+      REQUIRE(brute_force.PositionY()[i] == with_grid.PositionY()[i]);
+      REQUIRE(brute_force.VelocityX()[i] == with_grid.VelocityX()[i]);
+      REQUIRE(brute_force.VelocityY()[i] == with_grid.VelocityY()[i]);
+    }
+  }
+}
+
+TEST_CASE("Parallel collisions do not depend on the thread count") {
+  ParticleStore serial = MakeRandomParticles(2000, 3);
+  ParticleStore start = serial;
+  SpatialGrid grid;
+
+  ThreadPool no_threads(0);
+  for (size_t frame = 0; frame < 20; ++frame) {
+    grid.Rebuild(serial);
+    PhysicsEngine::AdjustVelocitiesOnCollision(serial, grid, no_threads);
+    Step(serial);
+  }
+
+  size_t thread_count = GENERATE(1, 2, 7);
+  ThreadPool pool(thread_count);
+  ParticleStore parallel = start;
+  for (size_t frame = 0; frame < 20; ++frame) {
+    grid.Rebuild(parallel);
+    PhysicsEngine::AdjustVelocitiesOnCollision(parallel, grid, pool);
+    Step(parallel);
+  }
+
+  bool any_moved = false;
+  for (size_t i = 0; i < serial.Size(); ++i) {
+    REQUIRE(serial.Get(i).GetPosition() == parallel.Get(i).GetPosition());
+    REQUIRE(serial.Get(i).GetVelocity() == parallel.Get(i).GetVelocity());
+    any_moved = any_moved || start.Get(i).GetVelocity() != serial.Get(i).GetVelocity();
+  }
+  REQUIRE(any_moved);
+}
+
+TEST_CASE("Parallel periodic collisions do not depend on the thread count") {
+  // 16 cells across make 4 tiles, which colour all the way round; 20 cells
+  // make 5, which are resolved serially.
+  double length = GENERATE(200.0, 245.0);
+  Box box(0, 0, length, length, Boundary::kPeriodic);
+  ParticleStore serial = MakeRandomParticles(2000, 4);
+  SpatialGrid grid;
+  ThreadPool no_threads(0);
+  ThreadPool pool(4);
+  ParticleStore parallel = serial;
+  for (size_t frame = 0; frame < 20; ++frame) {
+    grid.Rebuild(serial, box);
+    PhysicsEngine::AdjustVelocitiesOnCollision(serial, grid, no_threads);
+    PhysicsEngine::MoveParticles(box, serial);
+
+    grid.Rebuild(parallel, box);
+    PhysicsEngine::AdjustVelocitiesOnCollision(parallel, grid, pool);
+    PhysicsEngine::MoveParticles(box, parallel);
+  }
+
+  for (size_t i = 0; i < serial.Size(); ++i) {
+    REQUIRE(serial.Get(i).GetPosition() == parallel.Get(i).GetPosition());
+    REQUIRE(serial.Get(i).GetVelocity() == parallel.Get(i).GetVelocity());
+  }
+}
@@ -0,0 +1,107 @@
+#include <catch2/catch.hpp>
+
+#include <cstdlib>
+
+#include "particle_store.h"
+#include "physics_engine.h"
+#include "spatial_grid.h"
+#include "speed_histogram.h"
+
+using idealgas::Particle;
+using idealgas::ParticleStore;
+using idealgas::PhysicsEngine;
+using idealgas::SpatialGrid;
+using idealgas::SpeedHistogram;
+using glm::vec2;
+
+namespace {
+
+/**
+ * The bin found by scanning every bin edge in order.
+ */
+size_t ScanForBin(double speed, int max_speed, size_t num_bins) {
+  for (size_t bin = 0; bin < num_bins; ++bin) {
+    if (speed <= max_speed * (static_cast<double>((bin + 1.0) / num_bins))) {
+      return bin;
+    }
+  }
+  return num_bins;
+}
+
+}  // namespace
+
+TEST_CASE("Speed histogram bins") {
+  ParticleStore store;
+  store.Add(Particle(vec2(100, 100), vec2(3, 4), 6, 3, "orange"));
+  store.Add(Particle(vec2(200, 100), vec2(1, 0), 6, 3, "orange"));
+  store.Add(Particle(vec2(300, 100), vec2(0, 0), 12, 5, "red"));
+  store.Add(Particle(vec2(400, 100), vec2(4, 4), 12, 5, "red"));
+  SpeedHistogram histogram(12);
+  histogram.Update(store);
+
+  SECTION("Max speed is the whole part of the fastest speed") {
+    REQUIRE(histogram.GetMaxSpeed() == 5);
+  }
+
+  SECTION("Particles are counted per species") {
+    REQUIRE(histogram.GetCount(0, 11) == 1);
+    REQUIRE(histogram.GetCount(0, 2) == 1);
+    REQUIRE(histogram.GetCount(1, 0) == 1);
+  }
+
+  SECTION("Particles faster than the last bin are not counted") {
+    size_t red_count = 0;
+    for (size_t bin = 0; bin < histogram.GetNumBins(); ++bin) {
+      red_count += histogram.GetCount(1, bin);
+    }
+    REQUIRE(red_count == 1);
+  }
+
+  SECTION("Bins match a scan over the bin edges") {
+    for (int speed = 0; speed <= 700; ++speed) {
+      REQUIRE(histogram.FindBin(speed / 100.0) ==
+              ScanForBin(speed / 100.0, 5, 12));
+    }
+  }
+
+  SECTION("Clear empties the bins until the next update") {
+    histogram.Clear();
+    REQUIRE(histogram.GetCount(0, 11) == 0);
+    histogram.Update(store);
+    REQUIRE(histogram.GetCount(0, 11) == 1);
+  }
+}
+
+TEST_CASE("Incremental speed histogram matches a full recount") {
+  srand(11);
+  ParticleStore store;
+  for (size_t i = 0; i < 300; ++i) {
+    vec2 position(rand() % 500 + 50, rand() % 500 + 50);
+    vec2 velocity(rand() % 9 - 4, rand() % 9 - 4);
+    if (i % 2 == 0) {
+      store.Add(Particle(position, velocity, 6, 6, "orange"));
+    } else {
+      store.Add(Particle(position, velocity, 12, 12, "red"));
+    }
+  }
+
+  SpeedHistogram incremental(12);
+  SpatialGrid grid;
+  for (size_t frame = 0; frame < 60; ++frame) {
+    grid.Rebuild(store);
+    PhysicsEngine::AdjustVelocitiesOnCollision(store, grid);
+    PhysicsEngine::MoveParticles(idealgas::Box::FromWindow(600, 50), store);
+    incremental.Update(store);
+
+    SpeedHistogram full(12);
+    ParticleStore copy = store;
+    full.Update(copy);
+    REQUIRE(incremental.GetMaxSpeed() == full.GetMaxSpeed());
+    for (uint8_t species = 0; species < 2; ++species) {
+      for (size_t bin = 0; bin < 12; ++bin) {
+        REQUIRE(incremental.GetCount(species, bin) ==
+                full.GetCount(species, bin));
+      }
+    }
+  }
+}
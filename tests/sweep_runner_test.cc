@@ -0,0 +1,91 @@
+#include <catch2/catch.hpp>
+
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include "scenario.h"
+#include "sweep_runner.h"
+#include "thread_pool.h"
+
+using idealgas::RunSummary;
+using idealgas::Scenario;
+using idealgas::ScenarioFile;
+using idealgas::SweepRunner;
+using idealgas::ThreadPool;
+
+namespace {
+
+std::vector<Scenario> Sweep() {
+  std::istringstream input(
+      "name = small\n"
+      "box = 0 0 300 300\n"
+      "steps = 40\n"
+      "temperature = 2\n"
+      "sweep seed = 1, 2\n"
+      "sweep engine = time-stepped, event-driven\n"
+      "[species]\n"
+      "color = red\n"
+      "radius = 3\n"
+      "count = 50\n");
+  return ScenarioFile::Parse(input, "test");
+}
+
+}  // namespace
+
+TEST_CASE("Sweeps run every scenario") {
+  std::vector<Scenario> scenarios = Sweep();
+  ThreadPool pool(3);
+  SweepRunner runner(&pool);
+  std::vector<RunSummary> summaries = runner.Run(scenarios);
+
+  REQUIRE(summaries.size() == 4);
+  for (size_t i = 0; i < summaries.size(); ++i) {
+    REQUIRE(summaries[i].succeeded);
+    REQUIRE(summaries[i].name == scenarios[i].name);
+    REQUIRE(summaries[i].particle_count == 50);
+    REQUIRE(summaries[i].steps == 40);
+    REQUIRE(summaries[i].mean_temperature > 0);
+    REQUIRE(summaries[i].mean_pressure > 0);
+  }
+
+  SECTION("A run in a sweep matches the same run alone") {
+    ThreadPool other_pool(1);
+    RunSummary alone = SweepRunner(&other_pool).Run(scenarios[2]);
+    REQUIRE(alone.statistics.kinetic_energy ==
+            summaries[2].statistics.kinetic_energy);
+    REQUIRE(alone.statistics.momentum_x ==
+            summaries[2].statistics.momentum_x);
+    REQUIRE(alone.mean_pressure == summaries[2].mean_pressure);
+  }
+
+  SECTION("Summaries have a header and a row per run") {
+    std::ostringstream output;
+    SweepRunner::WriteSummaries(output, summaries);
+    std::istringstream lines(output.str());
+    std::string line;
+    std::vector<std::string> rows;
+    while (std::getline(lines, line)) {
+      rows.push_back(line);
+    }
+    REQUIRE(rows.size() == 5);
+    REQUIRE(rows[0].compare(0, 11, "name\tstatus") == 0);
+    REQUIRE(rows[1].compare(0, scenarios[0].name.size() + 4,
+                            scenarios[0].name + "\tok\t") == 0);
+  }
+}
+
+TEST_CASE("A failed run does not stop the sweep") {
+  std::vector<Scenario> scenarios = Sweep();
+  // Far too many particles for Poisson-disk placement in the box.
+  scenarios[1].species[0].amount = 100000;
+  scenarios[1].initializer.max_attempts = 2;
+
+  std::vector<RunSummary> summaries = SweepRunner(nullptr).Run(scenarios);
+
+  REQUIRE(summaries[0].succeeded);
+  REQUIRE_FALSE(summaries[1].succeeded);
+  REQUIRE_FALSE(summaries[1].error.empty());
+  REQUIRE(summaries[2].succeeded);
+  REQUIRE(summaries[3].succeeded);
+}
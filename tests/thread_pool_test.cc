@@ -0,0 +1,51 @@
+#include <catch2/catch.hpp>
+
+#include <atomic>
+#include <stdexcept>
+#include <vector>
+
+#include "thread_pool.h"
+
+using idealgas::ThreadPool;
+
+TEST_CASE("Parallel for runs every index once") {
+  size_t thread_count = GENERATE(0, 1, 3, 8);
+  ThreadPool pool(thread_count);
+  REQUIRE(pool.GetThreadCount() == thread_count);
+
+  std::vector<std::atomic<int>> runs(1000);
+  for (auto &count : runs) {
+    count = 0;
+  }
+  pool.ParallelFor(runs.size(), [&runs](size_t i) {
+    ++runs[i];
+  });
+
+  for (auto &count : runs) {
+    REQUIRE(count == 1);
+  }
+}
+
+TEST_CASE("Parallel for can be nested") {
+  ThreadPool pool(4);
+  std::atomic<size_t> total(0);
+
+  pool.ParallelFor(8, [&pool, &total](size_t) {
+    pool.ParallelFor(100, [&total](size_t i) {
+      total += i;
+    });
+  });
+
+  REQUIRE(total == 8 * 4950);
+}
+
+TEST_CASE("Parallel for rethrows task exceptions") {
+  ThreadPool pool(2);
+  REQUIRE_THROWS_AS(pool.ParallelFor(10,
+                                     [](size_t i) {
+                                       if (i == 7) {
+                                         throw std::runtime_error("task");
+                                       }
+                                     }),
+                    std::runtime_error);
+}
@@ -0,0 +1,110 @@
+#include <catch2/catch.hpp>
+
+#include <cstdio>
+#include <fstream>
+
+#include "gas_container.h"
+#include "trajectory_recorder.h"
+
+using idealgas::GasContainer;
+using idealgas::ParticleStore;
+using idealgas::TrajectoryFrame;
+using idealgas::TrajectoryReader;
+using idealgas::TrajectoryRecorder;
+
+namespace {
+
+const char *kPath = "trajectory_test.traj";
+
+std::vector<TrajectoryFrame> ReadAll(const std::string &path) {
+  TrajectoryReader reader(path);
+  std::vector<TrajectoryFrame> frames;
+  TrajectoryFrame frame;
+  while (reader.Next(frame)) {
+    frames.push_back(frame);
+  }
+  return frames;
+}
+
+}  // namespace
+
+TEST_CASE("Trajectory round trip") {
+  srand(3);
+  GasContainer container(600, 960, 60, "white", 30, 30, 30);
+  std::vector<ParticleStore> expected;
+
+  TrajectoryRecorder::Options options;
+  options.decimation = 2;
+  options.species = {1};
+  options.frames_per_chunk = 3;
+  options.buffer_frames = 64;
+  {
+    TrajectoryRecorder recorder(kPath, options);
+    container.SetTrajectoryRecorder(&recorder);
+    for (size_t frame = 0; frame < 20; ++frame) {
+      container.AdvanceOneFrame();
+      if (container.GetFrameCount() % 2 == 0) {
+        expected.push_back(container.GetParticles());
+      }
+    }
+    container.SetTrajectoryRecorder(nullptr);
+    recorder.Close();
+    REQUIRE(recorder.GetRecordedFrameCount() == 10);
+    REQUIRE(recorder.GetDroppedFrameCount() == 0);
+  }
+
+  std::vector<TrajectoryFrame> frames = ReadAll(kPath);
+  REQUIRE(frames.size() == 10);
+  for (size_t f = 0; f < frames.size(); ++f) {
+    const ParticleStore &particles = expected[f];
+    REQUIRE(frames[f].frame == static_cast<int64_t>(2 * (f + 1)));
+    REQUIRE(frames[f].indices.size() == 30);
+    for (size_t k = 0; k < frames[f].indices.size(); ++k) {
+      uint32_t i = frames[f].indices[k];
+      REQUIRE(particles.SpeciesId()[i] == 1);
+      REQUIRE(frames[f].x[k] == particles.PositionX()[i]);
+      REQUIRE(frames[f].y[k] == particles.PositionY()[i]);
+      REQUIRE(frames[f].vx[k] == particles.VelocityX()[i]);
+      REQUIRE(frames[f].vy[k] == particles.VelocityY()[i]);
+    }
+  }
+  std::remove(kPath);
+}
+
+TEST_CASE("Trajectories are compressed") {
+  srand(3);
+  GasContainer container(600, 960, 60, "white", 30, 30, 30);
+  TrajectoryRecorder::Options options;
+  options.buffer_frames = 64;
+  {
+    TrajectoryRecorder recorder(kPath, options);
+    for (size_t frame = 0; frame < 60; ++frame) {
+      container.AdvanceOneFrame();
+      recorder.Record(container.GetParticles(), frame);
+    }
+  }
+
+  std::ifstream file(kPath, std::ios::binary | std::ios::ate);
+  size_t raw_size = 60 * 90 * 4 * sizeof(float);
+  REQUIRE(static_cast<size_t>(file.tellg()) < raw_size / 2);
+  REQUIRE(ReadAll(kPath).size() == 60);
+  file.close();
+  std::remove(kPath);
+}
+
+TEST_CASE("Frames are recorded or dropped but never block") {
+  srand(3);
+  GasContainer container(600, 960, 60, "white", 30, 30, 30);
+  TrajectoryRecorder::Options options;
+  options.buffer_frames = 1;
+  TrajectoryRecorder recorder(kPath, options);
+  for (size_t frame = 0; frame < 200; ++frame) {
+    recorder.Record(container.GetParticles(), frame);
+  }
+  recorder.Close();
+
+  REQUIRE(recorder.GetRecordedFrameCount() +
+              recorder.GetDroppedFrameCount() == 200);
+  REQUIRE(ReadAll(kPath).size() == recorder.GetRecordedFrameCount());
+  std::remove(kPath);
+}
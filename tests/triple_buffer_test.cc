@@ -0,0 +1,81 @@
+#include <catch2/catch.hpp>
+
+#include <thread>
+
+#include "triple_buffer.h"
+
+using idealgas::TripleBuffer;
+
+TEST_CASE("Triple buffer hands over the latest value") {
+  TripleBuffer<int> buffer;
+
+  SECTION("Nothing is read before a publish") {
+    REQUIRE_FALSE(buffer.Update());
+  }
+
+  SECTION("A published value is read once") {
+    buffer.GetWriteBuffer() = 5;
+    buffer.Publish();
+    REQUIRE(buffer.Update());
+    REQUIRE(buffer.GetReadBuffer() == 5);
+    REQUIRE_FALSE(buffer.Update());
+    REQUIRE(buffer.GetReadBuffer() == 5);
+  }
+
+  SECTION("Values the reader missed are skipped") {
+    for (int value = 1; value <= 4; ++value) {
+      buffer.GetWriteBuffer() = value;
+      buffer.Publish();
+    }
+    REQUIRE(buffer.Update());
+    REQUIRE(buffer.GetReadBuffer() == 4);
+  }
+
+  SECTION("The writer never gets the read buffer") {
+    buffer.GetWriteBuffer() = 1;
+    buffer.Publish();
+    buffer.Update();
+    for (int value = 2; value < 10; ++value) {
+      REQUIRE(&buffer.GetWriteBuffer() != &buffer.GetReadBuffer());
+      buffer.GetWriteBuffer() = value;
+      buffer.Publish();
+    }
+    REQUIRE(buffer.GetReadBuffer() == 1);
+  }
+}
+
+TEST_CASE("Triple buffer reads are consistent across threads") {
+  struct Pair {
+    int first = 0;
+    int second = 0;
+  };
+  TripleBuffer<Pair> buffer;
+  const int kValues = 100000;
+
+  std::thread writer([&buffer, kValues] {
+    for (int value = 1; value <= kValues; ++value) {
+      Pair &pair = buffer.GetWriteBuffer();
+      pair.first = value;
+      pair.second = -value;
+      buffer.Publish();
+    }
+  });
+
+  int last = 0;
+  bool consistent = true;
+  bool increasing = true;
+  while (last < kValues) {
+    if (buffer.Update()) {
+      const Pair &pair = buffer.GetReadBuffer();
+      consistent = consistent && pair.second == -pair.first;
+      increasing = increasing && pair.first > last;
+      last = pair.first;
+    } else {
+      std::this_thread::yield();
+    }
+  }
+  writer.join();
+
+  REQUIRE(consistent);
+  REQUIRE(increasing);
+}
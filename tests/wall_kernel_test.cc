@@ -0,0 +1,147 @@
+#include <catch2/catch.hpp>
+
+#include <cstring>
+#include <vector>
+
+#include "physics_engine.h"
+#include "wall_kernel.h"
+
+using idealgas::Box;
+using idealgas::Particle;
+using idealgas::PhysicsEngine;
+using idealgas::WallBounds;
+using idealgas::WallKernel;
+using glm::vec2;
+
+namespace {
+
+// Radii are whole numbers up to this, one species per radius.
+const int kMaxRadius = 6;
+
+template <typename T>
+struct Arrays {
+  std::vector<T> x, y, vx, vy, radius;
+  std::vector<uint8_t> species;  // radius - 1
+};
+
+// Mixes particles inside the box, exactly on a bound and outside the walls.
+template <typename T>
+Arrays<T> MakeArrays(size_t amount) {
+  srand(11);
+  Arrays<T> arrays;
+  for (size_t i = 0; i < amount; ++i) {
+    T radius = static_cast<T>(1 + rand() % kMaxRadius);
+    T x = static_cast<T>(rand() % 2200) / 10 - 10;
+    T y = static_cast<T>(rand() % 2200) / 10 - 10;
+    if (i % 7 == 0) {
+      x = radius;
+    } else if (i % 11 == 0) {
+      y = 200 - radius;
+    }
+    arrays.x.push_back(x);
+    arrays.y.push_back(y);
+    arrays.vx.push_back(static_cast<T>(rand() % 13 - 6) / 2);
+    arrays.vy.push_back(static_cast<T>(rand() % 13 - 6) / 2);
+    arrays.radius.push_back(radius);
+    arrays.species.push_back(static_cast<uint8_t>(radius - 1));
+  }
+  return arrays;
+}
+
+template <typename T>
+void Run(WallKernel::InstructionSet instruction_set, Arrays<T> &arrays,
+         const Box &box = Box(0, 0, 200, 200)) {
+  std::vector<WallBounds> bounds;
+  for (int radius = 1; radius <= kMaxRadius; ++radius) {
+    bounds.push_back(box.GetBounds(radius));
+  }
+  WallKernel::ReflectAndIntegrate(
+      instruction_set, box, bounds.data(), arrays.x.size(), arrays.x.data(),
+      arrays.y.data(), arrays.vx.data(), arrays.vy.data(),
+      arrays.radius.data(), arrays.species.data());
+}
+
+template <typename T>
+bool SameBits(const std::vector<T> &a, const std::vector<T> &b) {
+  return a.size() == b.size() &&
+         std::memcmp(a.data(), b.data(), a.size() * sizeof(T)) == 0;
+}
+
+}  // namespace
+
+TEST_CASE("Scalar kernel matches particle wall collisions") {
+  Arrays<float> arrays = MakeArrays<float>(100);
+  std::vector<Particle> particles;
+  for (size_t i = 0; i < arrays.x.size(); ++i) {
+    particles.push_back(Particle(vec2(arrays.x[i], arrays.y[i]),
+                                 vec2(arrays.vx[i], arrays.vy[i]), 1,
+                                 static_cast<int>(arrays.radius[i]), "cyan"));
+  }
+
+  Run(WallKernel::InstructionSet::kScalar, arrays);
+  for (size_t i = 0; i < particles.size(); ++i) {
+    PhysicsEngine::ParticleWallCollision(200, 0, particles[i]);
+    particles[i].SetPosition(particles[i].GetPosition() +
+                             particles[i].GetVelocity());
+
+    REQUIRE(particles[i].GetPosition() == vec2(arrays.x[i], arrays.y[i]));
+    REQUIRE(particles[i].GetVelocity() == vec2(arrays.vx[i], arrays.vy[i]));
+  }
+}
+
+TEST_CASE("Batched kernels match the scalar kernel") {
+  WallKernel::InstructionSet instruction_set = GENERATE(
+      WallKernel::InstructionSet::kSse2, WallKernel::InstructionSet::kAvx2,
+      WallKernel::InstructionSet::kAvx512);
+
+  // A square box and a narrow channel with walls at different offsets.
+  Box box = GENERATE(Box(0, 0, 200, 200), Box(-10, 40, 230, 90));
+
+  if (WallKernel::IsSupported(instruction_set)) {
+    // 103 is not a multiple of any batch width, so the tail runs too.
+    Arrays<float> scalar = MakeArrays<float>(103);
+    Arrays<float> batched = scalar;
+
+    for (size_t frame = 0; frame < 20; ++frame) {
+      Run(WallKernel::InstructionSet::kScalar, scalar, box);
+      Run(instruction_set, batched, box);
+    }
+
+    INFO(WallKernel::GetName(instruction_set));
+    REQUIRE(SameBits(scalar.x, batched.x));
+    REQUIRE(SameBits(scalar.y, batched.y));
+    REQUIRE(SameBits(scalar.vx, batched.vx));
+    REQUIRE(SameBits(scalar.vy, batched.vy));
+  }
+}
+
+TEST_CASE("Double batched kernels match the double scalar kernel") {
+  WallKernel::InstructionSet instruction_set = GENERATE(
+      WallKernel::InstructionSet::kSse2, WallKernel::InstructionSet::kAvx2,
+      WallKernel::InstructionSet::kAvx512);
+
+  // Walls that are not whole numbers, which the float kernels leave to the
+  // scalar loop.
+  Box box = GENERATE(Box(0, 0, 200, 200), Box(-10.25, 40.5, 230.1, 90.7));
+
+  if (WallKernel::IsSupported(instruction_set)) {
+    Arrays<double> scalar = MakeArrays<double>(103);
+    Arrays<double> batched = scalar;
+
+    for (size_t frame = 0; frame < 20; ++frame) {
+      Run(WallKernel::InstructionSet::kScalar, scalar, box);
+      Run(instruction_set, batched, box);
+    }
+
+    INFO(WallKernel::GetName(instruction_set));
+    REQUIRE(SameBits(scalar.x, batched.x));
+    REQUIRE(SameBits(scalar.y, batched.y));
+    REQUIRE(SameBits(scalar.vx, batched.vx));
+    REQUIRE(SameBits(scalar.vy, batched.vy));
+  }
+}
+
+TEST_CASE("Detected instruction set is supported") {
+  REQUIRE(WallKernel::IsSupported(WallKernel::Detect()));
+  REQUIRE(WallKernel::IsSupported(WallKernel::InstructionSet::kScalar));
+}